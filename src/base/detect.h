@@ -177,6 +177,13 @@
 #define CONF_ARCH_ENDIAN_LITTLE 1
 #endif
 
+/* vector instruction sets that every cpu of the target supports */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CONF_ARCH_SSE2 1
+#elif defined(CONF_ARCH_ENDIAN_LITTLE) && (defined(__ARM_NEON) || defined(_M_ARM64))
+#define CONF_ARCH_NEON 1
+#endif
+
 #ifndef CONF_FAMILY_STRING
 #define CONF_FAMILY_STRING "unknown"
 #endif
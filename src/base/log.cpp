@@ -1,9 +1,11 @@
 #include "logger.h"
 
 #include "color.h"
+#include "math.h"
 #include "system.h"
 
 #include <atomic>
+#include <cinttypes>
 #include <cstdio>
 
 #if defined(CONF_FAMILY_WINDOWS)
@@ -215,61 +217,430 @@ std::unique_ptr<ILogger> log_logger_collection(std::vector<std::shared_ptr<ILogg
 	return std::make_unique<CLoggerCollection>(std::move(vpLoggers));
 }
 
+/**
+ * Single-producer single-consumer byte ring holding preformatted log records.
+ *
+ * Every thread that logs through a `CLoggerAsync` owns one of these, so
+ * producers never contend with each other or with the writer thread.
+ */
+class CLogRing
+{
+public:
+	enum
+	{
+		SIZE = 64 * 1024,
+		ALIGN = 16,
+	};
+
+	struct CRecord
+	{
+		// total size of the record including this header, aligned to `ALIGN`
+		uint32_t m_Size;
+		// length of the text following the header, -1 for padding records
+		int32_t m_Length;
+		uint64_t m_Seq;
+	};
+
+	// both positions increase monotonically and wrap around at 2^32
+	std::atomic<uint32_t> m_WritePos{0};
+	std::atomic<uint32_t> m_ReadPos{0};
+	// references held by the logger and by the producing thread
+	std::atomic<int> m_Refs{2};
+	std::atomic<bool> m_ThreadGone{false};
+	std::atomic<bool> m_LoggerGone{false};
+	alignas(ALIGN) char m_aData[SIZE];
+
+	static uint32_t RecordSize(int Length)
+	{
+		return (sizeof(CRecord) + Length + ALIGN - 1) & ~(uint32_t)(ALIGN - 1);
+	}
+
+	void Release()
+	{
+		if(m_Refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			delete this;
+	}
+
+	// producer side, returns nullptr if the record does not fit
+	char *BeginWrite(int Length, uint32_t Reserve)
+	{
+		const uint32_t Write = m_WritePos.load(std::memory_order_relaxed);
+		const uint32_t Used = Write - m_ReadPos.load(std::memory_order_acquire);
+		const uint32_t Size = RecordSize(Length);
+		const uint32_t Contiguous = SIZE - Write % SIZE;
+		const uint32_t Need = Size + (Contiguous < Size ? Contiguous : 0);
+		if(Used + Need + Reserve > SIZE)
+			return nullptr;
+
+		if(Contiguous < Size)
+		{
+			CRecord *pPadding = (CRecord *)(m_aData + Write % SIZE);
+			pPadding->m_Size = Contiguous;
+			pPadding->m_Length = -1;
+			m_WritePos.store(Write + Contiguous, std::memory_order_release);
+			return m_aData + sizeof(CRecord);
+		}
+		return m_aData + Write % SIZE + sizeof(CRecord);
+	}
+
+	void EndWrite(int Length, uint64_t Seq)
+	{
+		const uint32_t Write = m_WritePos.load(std::memory_order_relaxed);
+		CRecord *pRecord = (CRecord *)(m_aData + Write % SIZE);
+		pRecord->m_Size = RecordSize(Length);
+		pRecord->m_Length = Length;
+		pRecord->m_Seq = Seq;
+		// sequentially consistent so that the writer thread can't miss it
+		// while going to sleep, see `CLoggerAsync::WriterThread`
+		m_WritePos.store(Write + pRecord->m_Size, std::memory_order_seq_cst);
+	}
+
+	uint32_t Used() const
+	{
+		return m_WritePos.load(std::memory_order_relaxed) - m_ReadPos.load(std::memory_order_acquire);
+	}
+
+	// consumer side, skips padding and returns the oldest record if any
+	const CRecord *Peek()
+	{
+		while(true)
+		{
+			const uint32_t Read = m_ReadPos.load(std::memory_order_relaxed);
+			if(Read == m_WritePos.load(std::memory_order_seq_cst))
+				return nullptr;
+			const CRecord *pRecord = (const CRecord *)(m_aData + Read % SIZE);
+			if(pRecord->m_Length >= 0)
+				return pRecord;
+			m_ReadPos.store(Read + pRecord->m_Size, std::memory_order_release);
+		}
+	}
+
+	void Pop(const CRecord *pRecord)
+	{
+		m_ReadPos.store(m_ReadPos.load(std::memory_order_relaxed) + pRecord->m_Size, std::memory_order_release);
+	}
+};
+
+class CLoggerAsync;
+
+/**
+ * Rings claimed by the current thread, released when the thread exits so
+ * that short-lived threads (e.g. SQL queries) can hand their ring over.
+ */
+class CLogThreadRings
+{
+public:
+	enum
+	{
+		MAX_LOGGERS = 8,
+	};
+	struct CEntry
+	{
+		const CLoggerAsync *m_pLogger;
+		CLogRing *m_pRing;
+	};
+	CEntry m_aEntries[MAX_LOGGERS] = {};
+
+	~CLogThreadRings()
+	{
+		for(auto &Entry : m_aEntries)
+		{
+			if(Entry.m_pRing)
+			{
+				Entry.m_pRing->m_ThreadGone.store(true, std::memory_order_release);
+				Entry.m_pRing->Release();
+			}
+		}
+	}
+};
+
+static thread_local CLogThreadRings s_LogThreadRings;
+static std::atomic<LOG_DROP_POLICY> s_LogDropPolicy = LOG_DROP_NEWEST;
+static std::atomic<uint64_t> s_LogDroppedTotal = 0;
+
+void log_set_drop_policy(LOG_DROP_POLICY policy)
+{
+	s_LogDropPolicy.store(policy, std::memory_order_release);
+}
+
+uint64_t log_dropped_messages()
+{
+	return s_LogDroppedTotal.load(std::memory_order_acquire);
+}
+
+/**
+ * Writes log messages from a dedicated thread. Producers format their
+ * records into their own lock-free ring and never wait: if the ring is full,
+ * the record is dropped according to the global drop policy and counted.
+ */
 class CLoggerAsync : public ILogger
 {
-	ASYNCIO *m_pAio;
+	enum
+	{
+		MAX_RINGS = 64,
+		BATCH_SIZE = 64 * 1024,
+		// room kept free for warnings and errors by `LOG_DROP_LESS_SEVERE`
+		SEVERE_RESERVE = CLogRing::SIZE / 4,
+	};
+
+	IOHANDLE m_File;
 	bool m_AnsiTruecolor;
 	bool m_Close;
 
+	std::atomic<CLogRing *> m_apRings[MAX_RINGS] = {};
+	std::atomic<int> m_NumRings{0};
+	std::atomic<uint64_t> m_NextSeq{0};
+	std::atomic<uint64_t> m_Dropped{0};
+
+	void *m_pThread;
+	SEMAPHORE m_Sphore;
+	std::atomic<bool> m_Sleeping{false};
+	std::atomic<bool> m_Finish{false};
+	bool m_Finished = false;
+
+	char m_aBatch[BATCH_SIZE];
+	int m_BatchLength = 0;
+
+	CLogRing *AcquireRing()
+	{
+		CLogThreadRings::CEntry *pFree = nullptr;
+		for(auto &Entry : s_LogThreadRings.m_aEntries)
+		{
+			// left over from a destroyed logger, possibly at the same address
+			if(Entry.m_pRing && Entry.m_pRing->m_LoggerGone.load(std::memory_order_acquire))
+			{
+				Entry.m_pRing->Release();
+				Entry.m_pRing = nullptr;
+				Entry.m_pLogger = nullptr;
+			}
+			if(Entry.m_pRing && Entry.m_pLogger == this)
+				return Entry.m_pRing;
+			if(!Entry.m_pRing && !pFree)
+				pFree = &Entry;
+		}
+		if(!pFree)
+			return nullptr;
+
+		CLogRing *pRing = nullptr;
+		// take over the ring of a thread that has exited
+		const int NumRings = m_NumRings.load(std::memory_order_acquire);
+		for(int i = 0; i < NumRings && !pRing; i++)
+		{
+			CLogRing *pCandidate = m_apRings[i].load(std::memory_order_acquire);
+			bool Gone = true;
+			if(pCandidate && pCandidate->m_ThreadGone.compare_exchange_strong(Gone, false, std::memory_order_acq_rel))
+			{
+				pCandidate->m_Refs.fetch_add(1, std::memory_order_relaxed);
+				pRing = pCandidate;
+			}
+		}
+		if(!pRing)
+		{
+			const int Index = m_NumRings.fetch_add(1, std::memory_order_acq_rel);
+			if(Index >= MAX_RINGS)
+			{
+				m_NumRings.fetch_sub(1, std::memory_order_acq_rel);
+				return nullptr;
+			}
+			pRing = new CLogRing();
+			m_apRings[Index].store(pRing, std::memory_order_release);
+		}
+		pFree->m_pLogger = this;
+		pFree->m_pRing = pRing;
+		return pRing;
+	}
+
+	void Drop()
+	{
+		m_Dropped.fetch_add(1, std::memory_order_relaxed);
+		s_LogDroppedTotal.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void Wake()
+	{
+		if(m_Sleeping.load(std::memory_order_seq_cst) && m_Sleeping.exchange(false, std::memory_order_seq_cst))
+			sphore_signal(&m_Sphore);
+	}
+
+	void FlushBatch()
+	{
+		if(m_BatchLength == 0)
+			return;
+		io_write(m_File, m_aBatch, m_BatchLength);
+		io_flush(m_File);
+		m_BatchLength = 0;
+	}
+
+	void Append(const char *pData, int Length)
+	{
+		if(m_BatchLength + Length > (int)sizeof(m_aBatch))
+			FlushBatch();
+		mem_copy(m_aBatch + m_BatchLength, pData, Length);
+		m_BatchLength += Length;
+	}
+
+	// moves all pending records into the batch buffer, oldest first
+	bool Drain()
+	{
+		bool Any = false;
+		const int NumRings = minimum((int)m_NumRings.load(std::memory_order_acquire), (int)MAX_RINGS);
+		while(true)
+		{
+			CLogRing *pOldest = nullptr;
+			const CLogRing::CRecord *pOldestRecord = nullptr;
+			for(int i = 0; i < NumRings; i++)
+			{
+				CLogRing *pRing = m_apRings[i].load(std::memory_order_acquire);
+				if(!pRing)
+					continue;
+				const CLogRing::CRecord *pRecord = pRing->Peek();
+				if(pRecord && (!pOldestRecord || pRecord->m_Seq < pOldestRecord->m_Seq))
+				{
+					pOldest = pRing;
+					pOldestRecord = pRecord;
+				}
+			}
+			if(!pOldest)
+				break;
+			Append((const char *)(pOldestRecord + 1), pOldestRecord->m_Length);
+			pOldest->Pop(pOldestRecord);
+			Any = true;
+		}
+
+		const uint64_t Dropped = m_Dropped.exchange(0, std::memory_order_relaxed);
+		if(Dropped)
+		{
+			char aTimestamp[80];
+			char aNotice[160];
+			str_timestamp_format(aTimestamp, sizeof(aTimestamp), FORMAT_SPACE);
+			str_format(aNotice, sizeof(aNotice), "[%s][log]: dropped %" PRIu64 " messages, logging can't keep up\n", aTimestamp, Dropped);
+			Append(aNotice, str_length(aNotice));
+		}
+		FlushBatch();
+		return Any;
+	}
+
+	bool HasPending()
+	{
+		const int NumRings = minimum((int)m_NumRings.load(std::memory_order_acquire), (int)MAX_RINGS);
+		for(int i = 0; i < NumRings; i++)
+		{
+			CLogRing *pRing = m_apRings[i].load(std::memory_order_acquire);
+			if(pRing && pRing->m_ReadPos.load(std::memory_order_relaxed) != pRing->m_WritePos.load(std::memory_order_seq_cst))
+				return true;
+		}
+		return m_Dropped.load(std::memory_order_relaxed) != 0;
+	}
+
+	static void WriterThread(void *pUser)
+	{
+		CLoggerAsync *pThis = (CLoggerAsync *)pUser;
+		while(true)
+		{
+			if(pThis->Drain())
+				continue;
+			if(pThis->m_Finish.load(std::memory_order_acquire))
+				break;
+			pThis->m_Sleeping.store(true, std::memory_order_seq_cst);
+			if(!pThis->HasPending() && !pThis->m_Finish.load(std::memory_order_seq_cst))
+				sphore_wait(&pThis->m_Sphore);
+			pThis->m_Sleeping.store(false, std::memory_order_relaxed);
+		}
+		pThis->Drain();
+	}
+
+	void Finish()
+	{
+		if(m_Finished)
+			return;
+		m_Finished = true;
+		m_Finish.store(true, std::memory_order_seq_cst);
+		sphore_signal(&m_Sphore);
+		thread_wait(m_pThread);
+		if(m_Close)
+			io_close(m_File);
+	}
+
 public:
 	CLoggerAsync(IOHANDLE File, bool AnsiTruecolor, bool Close) :
-		m_pAio(aio_new(File)),
+		m_File(File),
 		m_AnsiTruecolor(AnsiTruecolor),
 		m_Close(Close)
 	{
+		sphore_init(&m_Sphore);
+		m_pThread = thread_init(WriterThread, this, "logger");
 	}
 	void Log(const CLogMessage *pMessage) override
 	{
-		aio_lock(m_pAio);
-		if(m_AnsiTruecolor)
+		if(m_Finish.load(std::memory_order_relaxed))
 		{
-			// https://en.wikipedia.org/w/index.php?title=ANSI_escape_code&oldid=1077146479#24-bit
-			char aAnsi[32];
-			if(pMessage->m_HaveColor)
-			{
-				str_format(aAnsi, sizeof(aAnsi),
-					"\x1b[38;2;%d;%d;%dm",
-					pMessage->m_Color.r,
-					pMessage->m_Color.g,
-					pMessage->m_Color.b);
-				aio_write_unlocked(m_pAio, aAnsi, str_length(aAnsi));
-			}
+			Drop();
+			return;
 		}
-		aio_write_unlocked(m_pAio, pMessage->m_aLine, pMessage->m_LineLength);
-		if(m_AnsiTruecolor && pMessage->m_HaveColor)
+		CLogRing *pRing = AcquireRing();
+		if(!pRing)
 		{
-			const char aResetColor[] = "\x1b[0m";
-			aio_write_unlocked(m_pAio, aResetColor, str_length(aResetColor)); // reset
+			Drop();
+			return;
+		}
+
+		// https://en.wikipedia.org/w/index.php?title=ANSI_escape_code&oldid=1077146479#24-bit
+		char aAnsi[32];
+		int AnsiLength = 0;
+		const char aResetColor[] = "\x1b[0m";
+		const bool Color = m_AnsiTruecolor && pMessage->m_HaveColor;
+		if(Color)
+		{
+			str_format(aAnsi, sizeof(aAnsi),
+				"\x1b[38;2;%d;%d;%dm",
+				pMessage->m_Color.r,
+				pMessage->m_Color.g,
+				pMessage->m_Color.b);
+			AnsiLength = str_length(aAnsi);
+		}
+		const int Length = AnsiLength + pMessage->m_LineLength + (Color ? sizeof(aResetColor) - 1 : 0) + 1;
+
+		uint32_t Reserve = 0;
+		if(pMessage->m_Level > LEVEL_WARN && s_LogDropPolicy.load(std::memory_order_relaxed) == LOG_DROP_LESS_SEVERE)
+			Reserve = SEVERE_RESERVE;
+		char *pDst = pRing->BeginWrite(Length, Reserve);
+		if(!pDst)
+		{
+			Drop();
+			Wake();
+			return;
 		}
-		aio_write_newline_unlocked(m_pAio);
-		aio_unlock(m_pAio);
+		mem_copy(pDst, aAnsi, AnsiLength);
+		pDst += AnsiLength;
+		mem_copy(pDst, pMessage->m_aLine, pMessage->m_LineLength);
+		pDst += pMessage->m_LineLength;
+		if(Color)
+		{
+			mem_copy(pDst, aResetColor, sizeof(aResetColor) - 1);
+			pDst += sizeof(aResetColor) - 1;
+		}
+		*pDst = '\n';
+		pRing->EndWrite(Length, m_NextSeq.fetch_add(1, std::memory_order_relaxed));
+		Wake();
 	}
 	~CLoggerAsync()
 	{
-		if(m_Close)
+		Finish();
+		sphore_destroy(&m_Sphore);
+		const int NumRings = minimum((int)m_NumRings.load(std::memory_order_acquire), (int)MAX_RINGS);
+		for(int i = 0; i < NumRings; i++)
 		{
-			aio_close(m_pAio);
+			CLogRing *pRing = m_apRings[i].load(std::memory_order_acquire);
+			if(pRing)
+			{
+				pRing->m_LoggerGone.store(true, std::memory_order_release);
+				pRing->Release();
+			}
 		}
-		aio_wait(m_pAio);
-		aio_free(m_pAio);
 	}
 	void GlobalFinish() override
 	{
-		if(m_Close)
-		{
-			aio_close(m_pAio);
-		}
-		aio_wait(m_pAio);
+		Finish();
 	}
 };
 
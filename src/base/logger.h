@@ -91,6 +91,42 @@ public:
  */
 void log_set_loglevel(LEVEL level);
 
+/**
+ * @ingroup Log
+ *
+ * What asynchronous loggers discard when a thread produces log messages
+ * faster than they can be written.
+ */
+enum LOG_DROP_POLICY
+{
+	/**
+	 * Drop the message that doesn't fit anymore.
+	 */
+	LOG_DROP_NEWEST,
+	/**
+	 * Start dropping messages less severe than warnings earlier, keeping
+	 * room for warnings and errors.
+	 */
+	LOG_DROP_LESS_SEVERE,
+};
+
+/**
+ * @ingroup Log
+ *
+ * Sets the drop policy of all asynchronous loggers. Logging never blocks the
+ * calling thread, messages that can't be buffered are dropped and counted.
+ *
+ * @param policy The drop policy.
+ */
+void log_set_drop_policy(LOG_DROP_POLICY policy);
+
+/**
+ * @ingroup Log
+ *
+ * Total number of log messages dropped by asynchronous loggers so far.
+ */
+uint64_t log_dropped_messages();
+
 /**
  * @ingroup Log
  *
@@ -417,27 +417,14 @@ CClient::CClient() :
 	m_BenchmarkFile = 0;
 	m_BenchmarkStopTime = 0;
 
+	m_aPrevLayoutStats[0] = m_aPrevLayoutStats[1] = 0;
+	m_aLayoutStats[0] = m_aLayoutStats[1] = 0;
+	m_LastLayoutStats = 0;
+
 	mem_zero(&m_Checksum, sizeof(m_Checksum));
 }
 
 // ----- send functions -----
-static inline bool RepackMsg(const CMsgPacker *pMsg, CPacker &Packer)
-{
-	Packer.Reset();
-	if(pMsg->m_MsgID < OFFSET_UUID)
-	{
-		Packer.AddInt((pMsg->m_MsgID << 1) | (pMsg->m_System ? 1 : 0));
-	}
-	else
-	{
-		Packer.AddInt((0 << 1) | (pMsg->m_System ? 1 : 0)); // NETMSG_EX, NETMSGTYPE_EX
-		g_UuidManager.PackUuid(pMsg->m_MsgID, &Packer);
-	}
-	Packer.AddRaw(pMsg->Data(), pMsg->Size());
-
-	return false;
-}
-
 int CClient::SendMsg(int Conn, CMsgPacker *pMsg, int Flags)
 {
 	CNetChunk Packet;
@@ -445,15 +432,10 @@ int CClient::SendMsg(int Conn, CMsgPacker *pMsg, int Flags)
 	if(State() == IClient::STATE_OFFLINE)
 		return 0;
 
-	// repack message (inefficient)
-	CPacker Pack;
-	if(RepackMsg(pMsg, Pack))
-		return 0;
-
 	mem_zero(&Packet, sizeof(CNetChunk));
 	Packet.m_ClientID = 0;
-	Packet.m_pData = Pack.Data();
-	Packet.m_DataSize = Pack.Size();
+	Packet.m_pData = pMsg->NetData();
+	Packet.m_DataSize = pMsg->NetSize();
 
 	if(Flags & MSGFLAG_VITAL)
 		Packet.m_Flags |= NETSENDFLAG_VITAL;
@@ -1091,6 +1073,24 @@ void CClient::DebugRender()
 
 	str_format(aBuffer, sizeof(aBuffer), "pred: %d ms", GetPredictionTime());
 	Graphics()->QuadsText(2, 70, 16, aBuffer);
+
+	// text layout cache rates of the last second
+	{
+		int64_t Hits, Misses;
+		int Entries;
+		Kernel()->RequestInterface<IEngineTextRender>()->GetLayoutCacheStats(Hits, Misses, Entries);
+		if(time_get() - m_LastLayoutStats > time_freq())
+		{
+			m_LastLayoutStats = time_get();
+			m_aPrevLayoutStats[0] = m_aLayoutStats[0];
+			m_aPrevLayoutStats[1] = m_aLayoutStats[1];
+			m_aLayoutStats[0] = Hits;
+			m_aLayoutStats[1] = Misses;
+		}
+		const int64_t Lookups = maximum((m_aLayoutStats[0] - m_aPrevLayoutStats[0]) + (m_aLayoutStats[1] - m_aPrevLayoutStats[1]), (int64_t)1);
+		str_format(aBuffer, sizeof(aBuffer), "text layout cache: %d entries, %" PRId64 " lookups/s, %d%% hits", Entries, Lookups, (int)((m_aLayoutStats[0] - m_aPrevLayoutStats[0]) * 100 / Lookups));
+		Graphics()->QuadsText(2, 82, 16, aBuffer);
+	}
 	Graphics()->QuadsEnd();
 
 	// render graphs
@@ -3340,6 +3340,7 @@ void CClient::Run()
 
 	delete m_pEditor;
 	m_pInput->Shutdown();
+	Kernel()->RequestInterface<IEngineTextRender>()->Shutdown();
 	m_pGraphics->Shutdown();
 
 	// shutdown SDL
@@ -3703,7 +3704,7 @@ const char *CClient::DemoPlayer_Play(const char *pFilename, int StorageType)
 	// try to start playback
 	m_DemoPlayer.SetListener(this);
 
-	if(m_DemoPlayer.Load(Storage(), m_pConsole, pFilename, StorageType))
+	if(m_DemoPlayer.Load(Storage(), m_pConsole, pFilename, StorageType, Engine()))
 		return "error loading demo";
 
 	// load map
@@ -4204,6 +4205,12 @@ void CClient::ConchainLoglevel(IConsole::IResult *pResult, void *pUserData, ICon
 	log_set_loglevel((LEVEL)g_Config.m_Loglevel);
 }
 
+void CClient::ConchainLogDropPolicy(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+{
+	pfnCallback(pResult, pCallbackUserData);
+	log_set_drop_policy((LOG_DROP_POLICY)g_Config.m_LogDropPolicy);
+}
+
 void CClient::ConchainPassword(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
 {
 	CClient *pSelf = (CClient *)pUserData;
@@ -4285,6 +4292,7 @@ void CClient::RegisterCommands()
 	m_pConsole->Chain("cl_replays", ConchainReplays, this);
 
 	m_pConsole->Chain("loglevel", ConchainLoglevel, this);
+	m_pConsole->Chain("log_drop_policy", ConchainLogDropPolicy, this);
 	m_pConsole->Chain("password", ConchainPassword, this);
 
 	// used for server browser update
@@ -4545,6 +4553,7 @@ int main(int argc, const char **argv)
 		pConsole->ParseArguments(argc - 1, (const char **)&argv[1]);
 
 	log_set_loglevel((LEVEL)g_Config.m_Loglevel);
+	log_set_drop_policy((LOG_DROP_POLICY)g_Config.m_LogDropPolicy);
 	if(g_Config.m_Logfile[0])
 	{
 		IOHANDLE Logfile = io_open(g_Config.m_Logfile, IOFLAG_WRITE);
@@ -289,6 +289,11 @@ class CClient : public IClient, public CDemoPlayer::IListener
 	IOHANDLE m_BenchmarkFile;
 	int64_t m_BenchmarkStopTime;
 
+	// text layout cache hits and misses at the start of the last two seconds, for the debug view
+	int64_t m_aPrevLayoutStats[2];
+	int64_t m_aLayoutStats[2];
+	int64_t m_LastLayoutStats;
+
 	CChecksum m_Checksum;
 	int m_OwnExecutableSize = 0;
 	IOHANDLE m_OwnExecutable;
@@ -459,6 +464,7 @@ public:
 	static void ConchainWindowVSync(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainTimeoutSeed(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainLoglevel(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
+	static void ConchainLogDropPolicy(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainPassword(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainReplays(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 
@@ -8,9 +8,11 @@
 #include <pthread.h>
 #endif
 
+#include <base/lock_scope.h>
 #include <base/system.h>
 
 #include <engine/console.h>
+#include <engine/engine.h>
 #include <engine/gfx/image_loader.h>
 #include <engine/gfx/image_manipulation.h>
 #include <engine/graphics.h>
@@ -267,10 +269,23 @@ int CGraphics_Threaded::UnloadTexture(CTextureHandle *pIndex)
 	if(!pIndex->IsValid())
 		return 0;
 
-	CCommandBuffer::SCommand_Texture_Destroy Cmd;
-	Cmd.m_Slot = pIndex->Id();
-	AddCmd(
-		Cmd, [] { return true; }, "failed to unload texture.");
+	if(IsTextureLoading(*pIndex))
+	{
+		// the backend never saw this texture, the job result is dropped
+		for(auto &pJob : m_vpTextureLoadJobs)
+		{
+			if(pJob->m_Slot == pIndex->Id())
+				pJob->m_Slot = -1;
+		}
+		m_vTextureLoading[pIndex->Id()] = false;
+	}
+	else
+	{
+		CCommandBuffer::SCommand_Texture_Destroy Cmd;
+		Cmd.m_Slot = pIndex->Id();
+		AddCmd(
+			Cmd, [] { return true; }, "failed to unload texture.");
+	}
 
 	m_vTextureIndices[pIndex->Id()] = m_FirstFreeTexture;
 	m_FirstFreeTexture = pIndex->Id();
@@ -289,42 +304,6 @@ static int ImageFormatToPixelSize(int Format)
 	}
 }
 
-static bool ConvertToRGBA(uint8_t *pDest, const uint8_t *pSrc, size_t SrcWidth, size_t SrcHeight, int SrcFormat)
-{
-	if(SrcFormat == CImageInfo::FORMAT_RGBA)
-	{
-		mem_copy(pDest, pSrc, SrcWidth * SrcHeight * 4);
-		return true;
-	}
-	else
-	{
-		size_t SrcChannelCount = ImageFormatToPixelSize(SrcFormat);
-		size_t DstChannelCount = 4;
-		for(size_t Y = 0; Y < SrcHeight; ++Y)
-		{
-			for(size_t X = 0; X < SrcWidth; ++X)
-			{
-				size_t ImgOffsetSrc = (Y * SrcWidth * SrcChannelCount) + (X * SrcChannelCount);
-				size_t ImgOffsetDest = (Y * SrcWidth * DstChannelCount) + (X * DstChannelCount);
-				size_t CopySize = SrcChannelCount;
-				if(SrcChannelCount == 3)
-				{
-					mem_copy(&pDest[ImgOffsetDest], &pSrc[ImgOffsetSrc], CopySize);
-					pDest[ImgOffsetDest + 3] = 255;
-				}
-				else if(SrcChannelCount == 1)
-				{
-					pDest[ImgOffsetDest + 0] = 255;
-					pDest[ImgOffsetDest + 1] = 255;
-					pDest[ImgOffsetDest + 2] = 255;
-					pDest[ImgOffsetDest + 3] = pSrc[ImgOffsetSrc];
-				}
-			}
-		}
-		return false;
-	}
-}
-
 int CGraphics_Threaded::LoadTextureRawSub(CTextureHandle TextureID, int x, int y, int Width, int Height, int Format, const void *pData)
 {
 	CCommandBuffer::SCommand_Texture_Update Cmd;
@@ -340,7 +319,7 @@ int CGraphics_Threaded::LoadTextureRawSub(CTextureHandle TextureID, int x, int y
 
 	// copy texture data
 	void *pTmpData = malloc(MemSize);
-	ConvertToRGBA((uint8_t *)pTmpData, (const uint8_t *)pData, Width, Height, Format);
+	ConvertToRGBA((uint8_t *)pTmpData, (const uint8_t *)pData, Width, Height, ImageFormatToPixelSize(Format));
 	Cmd.m_pData = pTmpData;
 
 	AddCmd(
@@ -424,27 +403,27 @@ IGraphics::CTextureHandle CGraphics_Threaded::LoadTextureRaw(int Width, int Heig
 		return m_InvalidTexture;
 #endif
 
-	if((Flags & IGraphics::TEXLOAD_TO_2D_ARRAY_TEXTURE) != 0 || (Flags & IGraphics::TEXLOAD_TO_3D_TEXTURE) != 0)
-	{
-		if(Width == 0 || (Width % 16) != 0 || Height == 0 || (Height % 16) != 0)
-		{
-			SWarning NewWarning;
-			char aText[128];
-			aText[0] = '\0';
-			if(pTexName)
-			{
-				str_format(aText, sizeof(aText), "\"%s\"", pTexName);
-			}
-			str_format(NewWarning.m_aWarningMsg, sizeof(NewWarning.m_aWarningMsg), Localize("The width of texture %s is not divisible by %d, or the height is not divisible by %d, which might cause visual bugs."), aText, 16, 16);
-
-			m_vWarnings.emplace_back(NewWarning);
-		}
-	}
+	WarnTextureDivisibility(Width, Height, Flags, pTexName);
 
 	if(Width == 0 || Height == 0)
 		return IGraphics::CTextureHandle();
 
 	// grab texture
+	int Tex = AllocTextureSlot();
+
+	// copy texture data
+	void *pTmpData = malloc((size_t)Width * Height * 4);
+	if(!ConvertToRGBA((uint8_t *)pTmpData, (const uint8_t *)pData, Width, Height, ImageFormatToPixelSize(Format)))
+	{
+		dbg_msg("graphics", "converted image %s to RGBA, consider making its file format RGBA", pTexName ? pTexName : "(no name)");
+	}
+	CreateTexture(Tex, Width, Height, pTmpData, Flags);
+
+	return CreateTextureHandle(Tex);
+}
+
+int CGraphics_Threaded::AllocTextureSlot()
+{
 	int Tex = m_FirstFreeTexture;
 	if(Tex == -1)
 	{
@@ -460,9 +439,33 @@ IGraphics::CTextureHandle CGraphics_Threaded::LoadTextureRaw(int Width, int Heig
 	}
 	m_FirstFreeTexture = m_vTextureIndices[Tex];
 	m_vTextureIndices[Tex] = -1;
+	return Tex;
+}
+
+void CGraphics_Threaded::WarnTextureDivisibility(int Width, int Height, int Flags, const char *pTexName)
+{
+	if((Flags & IGraphics::TEXLOAD_TO_2D_ARRAY_TEXTURE) != 0 || (Flags & IGraphics::TEXLOAD_TO_3D_TEXTURE) != 0)
+	{
+		if(Width == 0 || (Width % 16) != 0 || Height == 0 || (Height % 16) != 0)
+		{
+			SWarning NewWarning;
+			char aText[128];
+			aText[0] = '\0';
+			if(pTexName)
+			{
+				str_format(aText, sizeof(aText), "\"%s\"", pTexName);
+			}
+			str_format(NewWarning.m_aWarningMsg, sizeof(NewWarning.m_aWarningMsg), Localize("The width of texture %s is not divisible by %d, or the height is not divisible by %d, which might cause visual bugs."), aText, 16, 16);
 
+			m_vWarnings.emplace_back(NewWarning);
+		}
+	}
+}
+
+void CGraphics_Threaded::CreateTexture(int Slot, int Width, int Height, void *pRGBAData, int Flags)
+{
 	CCommandBuffer::SCommand_Texture_Create Cmd;
-	Cmd.m_Slot = Tex;
+	Cmd.m_Slot = Slot;
 	Cmd.m_Width = Width;
 	Cmd.m_Height = Height;
 	Cmd.m_PixelSize = 4;
@@ -484,19 +487,10 @@ IGraphics::CTextureHandle CGraphics_Threaded::LoadTextureRaw(int Width, int Heig
 	if((Flags & IGraphics::TEXLOAD_NO_2D_TEXTURE) != 0)
 		Cmd.m_Flags |= CCommandBuffer::TEXFLAG_NO_2D_TEXTURE;
 
-	// copy texture data
-	int MemSize = Width * Height * Cmd.m_PixelSize;
-	void *pTmpData = malloc(MemSize);
-	if(!ConvertToRGBA((uint8_t *)pTmpData, (const uint8_t *)pData, Width, Height, Format))
-	{
-		dbg_msg("graphics", "converted image %s to RGBA, consider making its file format RGBA", pTexName ? pTexName : "(no name)");
-	}
-	Cmd.m_pData = pTmpData;
+	Cmd.m_pData = pRGBAData;
 
 	AddCmd(
 		Cmd, [] { return true; }, "failed to load raw texture.");
-
-	return CreateTextureHandle(Tex);
 }
 
 // simple uncompressed RGBA loaders
@@ -523,43 +517,121 @@ IGraphics::CTextureHandle CGraphics_Threaded::LoadTexture(const char *pFilename,
 	return m_InvalidTexture;
 }
 
-bool CGraphics_Threaded::LoadTextTextures(int Width, int Height, CTextureHandle &TextTexture, CTextureHandle &TextOutlineTexture, void *pTextData, void *pTextOutlineData)
+CGraphics_Threaded::CTextureLoadJob::CTextureLoadJob(IStorage *pStorage, const char *pFilename, int StorageType, int Slot, int Flags) :
+	m_pStorage(pStorage),
+	m_Abandoned(false),
+	m_StorageType(StorageType),
+	m_Slot(Slot),
+	m_Flags(Flags),
+	m_Width(0),
+	m_Height(0),
+	m_pData(nullptr)
 {
-	if(Width == 0 || Height == 0)
-		return false;
+	m_RunLock = lock_create();
+	str_copy(m_aFilename, pFilename, sizeof(m_aFilename));
+}
 
-	// grab texture
-	int Tex = m_FirstFreeTexture;
-	if(Tex == -1)
-	{
-		size_t CurSize = m_vTextureIndices.size();
-		m_vTextureIndices.resize(CurSize * 2);
-		for(size_t i = 0; i < CurSize - 1; ++i)
-		{
-			m_vTextureIndices[CurSize + i] = CurSize + i + 1;
-		}
-		m_vTextureIndices.back() = -1;
+CGraphics_Threaded::CTextureLoadJob::~CTextureLoadJob()
+{
+	lock_destroy(m_RunLock);
+	free(m_pData);
+}
 
-		Tex = CurSize;
-	}
-	m_FirstFreeTexture = m_vTextureIndices[Tex];
-	m_vTextureIndices[Tex] = -1;
+void CGraphics_Threaded::CTextureLoadJob::Run()
+{
+	CLockScope ls(m_RunLock);
+	if(m_Abandoned)
+		return;
 
-	int Tex2 = m_FirstFreeTexture;
-	if(Tex2 == -1)
+	EImageFormat SourceFormat;
+	if(!LoadPNGAsRGBA(m_pStorage, m_aFilename, m_StorageType, m_Width, m_Height, m_pData, SourceFormat))
+		return;
+	if(SourceFormat != IMAGE_FORMAT_RGBA)
+		dbg_msg("graphics", "converted image %s to RGBA, consider making its file format RGBA", m_aFilename);
+}
+
+void CGraphics_Threaded::CTextureLoadJob::Abandon()
+{
+	m_Abandoned = true;
+	CLockScope ls(m_RunLock);
+}
+
+IGraphics::CTextureHandle CGraphics_Threaded::LoadTextureAsync(const char *pFilename, int StorageType, int StoreFormat, int Flags)
+{
+	if(str_length(pFilename) < 3)
+		return CTextureHandle();
+
+	// don't waste memory on texture if we are stress testing
+#ifdef CONF_DEBUG
+	if(g_Config.m_DbgStress)
+		return m_InvalidTexture;
+#endif
+
+	int Tex = AllocTextureSlot();
+	if(Tex >= (int)m_vTextureLoading.size())
+		m_vTextureLoading.resize(m_vTextureIndices.size());
+	m_vTextureLoading[Tex] = true;
+
+	m_vpTextureLoadJobs.push_back(std::make_shared<CTextureLoadJob>(m_pStorage, pFilename, StorageType, Tex, Flags));
+	m_pEngine->AddJob(m_vpTextureLoadJobs.back());
+	return CreateTextureHandle(Tex);
+}
+
+bool CGraphics_Threaded::IsTextureLoading(CTextureHandle Texture) const
+{
+	return Texture.Id() >= 0 && Texture.Id() < (int)m_vTextureLoading.size() && m_vTextureLoading[Texture.Id()];
+}
+
+void CGraphics_Threaded::UploadLoadedTextures()
+{
+	for(auto it = m_vpTextureLoadJobs.begin(); it != m_vpTextureLoadJobs.end();)
 	{
-		size_t CurSize = m_vTextureIndices.size();
-		m_vTextureIndices.resize(CurSize * 2);
-		for(size_t i = 0; i < CurSize - 1; ++i)
+		CTextureLoadJob *pJob = it->get();
+		if(pJob->Status() != IJob::STATE_DONE)
 		{
-			m_vTextureIndices[CurSize + i] = CurSize + i + 1;
+			++it;
+			continue;
 		}
-		m_vTextureIndices.back() = -1;
 
-		Tex2 = CurSize;
+		if(pJob->m_Slot != -1)
+		{
+			if(pJob->m_pData)
+			{
+				WarnTextureDivisibility(pJob->m_Width, pJob->m_Height, pJob->m_Flags, pJob->m_aFilename);
+				CreateTexture(pJob->m_Slot, pJob->m_Width, pJob->m_Height, pJob->m_pData, pJob->m_Flags);
+				pJob->m_pData = nullptr;
+				if(g_Config.m_Debug)
+					dbg_msg("graphics/texture", "loaded %s", pJob->m_aFilename);
+			}
+			else
+			{
+				// the handle is already in use, fill it with the invalid texture pattern
+				static const int s_Size = 16;
+				uint8_t *pData = (uint8_t *)malloc(s_Size * s_Size * 4);
+				for(int y = 0; y < s_Size; y++)
+				{
+					for(int x = 0; x < s_Size; x++)
+					{
+						static const uint8_t s_aaColors[4][4] = {{0xff, 0x00, 0x00, 0xff}, {0x00, 0xff, 0x00, 0xff}, {0x00, 0x00, 0xff, 0xff}, {0xff, 0xff, 0x00, 0xff}};
+						mem_copy(&pData[(y * s_Size + x) * 4], s_aaColors[(y / 2 % 2) * 2 + x / 2 % 2], 4);
+					}
+				}
+				CreateTexture(pJob->m_Slot, s_Size, s_Size, pData, pJob->m_Flags);
+			}
+			m_vTextureLoading[pJob->m_Slot] = false;
+		}
+		it = m_vpTextureLoadJobs.erase(it);
 	}
-	m_FirstFreeTexture = m_vTextureIndices[Tex2];
-	m_vTextureIndices[Tex2] = -1;
+}
+
+bool CGraphics_Threaded::LoadTextTextures(int Width, int Height, CTextureHandle &TextTexture, CTextureHandle &TextOutlineTexture, void *pTextData, void *pTextOutlineData)
+{
+	if(Width == 0 || Height == 0)
+		return false;
+
+	// grab texture
+	int Tex = AllocTextureSlot();
+	int Tex2 = AllocTextureSlot();
 
 	CCommandBuffer::SCommand_TextTextures_Create Cmd;
 	Cmd.m_Slot = Tex;
@@ -824,7 +896,10 @@ bool CGraphics_Threaded::ScreenshotDirect()
 void CGraphics_Threaded::TextureSet(CTextureHandle TextureID)
 {
 	dbg_assert(m_Drawing == 0, "called Graphics()->TextureSet within begin");
-	m_State.m_Texture = TextureID.Id();
+	if(IsTextureLoading(TextureID))
+		m_State.m_Texture = m_LoadingTexture.Id();
+	else
+		m_State.m_Texture = TextureID.Id();
 }
 
 void CGraphics_Threaded::Clear(float r, float g, float b, bool ForceClearNow)
@@ -2435,6 +2510,7 @@ int CGraphics_Threaded::Init()
 	// fetch pointers
 	m_pStorage = Kernel()->RequestInterface<IStorage>();
 	m_pConsole = Kernel()->RequestInterface<IConsole>();
+	m_pEngine = Kernel()->RequestInterface<IEngine>();
 
 	// init textures
 	m_FirstFreeTexture = 0;
@@ -2472,6 +2548,10 @@ int CGraphics_Threaded::Init()
 
 	m_InvalidTexture = LoadTextureRaw(4, 4, CImageInfo::FORMAT_RGBA, s_aNullTextureData, CImageInfo::FORMAT_RGBA, 0);
 
+	// transparent placeholder for textures that are still loading, it can also stand in for map textures
+	static const unsigned char s_aLoadingTextureData[16 * 16 * 4] = {0};
+	m_LoadingTexture = LoadTextureRaw(16, 16, CImageInfo::FORMAT_RGBA, s_aLoadingTextureData, CImageInfo::FORMAT_RGBA, HasTextureArrays() ? IGraphics::TEXLOAD_TO_2D_ARRAY_TEXTURE : IGraphics::TEXLOAD_TO_3D_TEXTURE);
+
 	ColorRGBA GPUInfoPrintColor{0.6f, 0.5f, 1.0f, 1.0f};
 
 	char aBuf[256];
@@ -2491,6 +2571,11 @@ int CGraphics_Threaded::Init()
 
 void CGraphics_Threaded::Shutdown()
 {
+	// the results are not needed anymore, only jobs that are already reading files are waited for
+	for(auto &pJob : m_vpTextureLoadJobs)
+		pJob->Abandon();
+	m_vpTextureLoadJobs.clear();
+
 	// shutdown the backend
 	m_pBackend->Shutdown();
 	delete m_pBackend;
@@ -2688,6 +2773,9 @@ void CGraphics_Threaded::TakeCustomScreenshot(const char *pFilename)
 
 void CGraphics_Threaded::Swap()
 {
+	// the textures that finished decoding are created with this frame's commands
+	UploadLoadedTextures();
+
 	if(!m_vWarnings.empty())
 	{
 		SWarning *pCurWarning = GetCurWarning();
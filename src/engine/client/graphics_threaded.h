@@ -3,8 +3,11 @@
 
 #include <engine/graphics.h>
 #include <engine/shared/config.h>
+#include <engine/shared/jobs.h>
 
+#include <atomic>
 #include <cstddef>
+#include <memory>
 #include <vector>
 
 #define CMD_BUFFER_DATA_BUFFER_SIZE 1024 * 1024 * 2
@@ -799,6 +802,7 @@ class CGraphics_Threaded : public IEngineGraphics
 	//
 	class IStorage *m_pStorage;
 	class IConsole *m_pConsole;
+	class IEngine *m_pEngine;
 
 	int m_CurIndex;
 
@@ -822,6 +826,41 @@ class CGraphics_Threaded : public IEngineGraphics
 	int m_FirstFreeTexture;
 	int m_TextureMemoryUsage;
 
+	// decodes a png for LoadTextureAsync and converts it to RGBA
+	class CTextureLoadJob : public IJob
+	{
+		class IStorage *m_pStorage;
+		LOCK m_RunLock; // held while the job runs, so shutdown can wait for it
+
+		void Run() override;
+
+	public:
+		CTextureLoadJob(IStorage *pStorage, const char *pFilename, int StorageType, int Slot, int Flags);
+		~CTextureLoadJob() override;
+
+		// a job that didn't start yet skips its work, returns once a running one is done
+		void Abandon();
+
+		std::atomic<bool> m_Abandoned;
+
+		char m_aFilename[IO_MAX_PATH_LENGTH];
+		int m_StorageType;
+		int m_Slot; // -1 if the texture was unloaded before it was ready
+		int m_Flags;
+		int m_Width;
+		int m_Height;
+		uint8_t *m_pData;
+	};
+	std::vector<std::shared_ptr<CTextureLoadJob>> m_vpTextureLoadJobs;
+	std::vector<bool> m_vTextureLoading; // slots that use m_LoadingTexture until their job is done
+	CTextureHandle m_LoadingTexture;
+
+	int AllocTextureSlot();
+	void WarnTextureDivisibility(int Width, int Height, int Flags, const char *pTexName);
+	// takes the ownership of pRGBAData
+	void CreateTexture(int Slot, int Width, int Height, void *pRGBAData, int Flags);
+	void UploadLoadedTextures();
+
 	std::vector<uint8_t> m_vSpriteHelper;
 
 	std::vector<SWarning> m_vWarnings;
@@ -979,6 +1018,8 @@ public:
 
 	// simple uncompressed RGBA loaders
 	IGraphics::CTextureHandle LoadTexture(const char *pFilename, int StorageType, int StoreFormat, int Flags) override;
+	IGraphics::CTextureHandle LoadTextureAsync(const char *pFilename, int StorageType, int StoreFormat, int Flags) override;
+	bool IsTextureLoading(CTextureHandle Texture) const override;
 	int LoadPNG(CImageInfo *pImg, const char *pFilename, int StorageType) override;
 	void FreePNG(CImageInfo *pImg) override;
 
@@ -170,6 +170,36 @@ void CServerBrowser::Con_LeakIpAddress(IConsole::IResult *pResult, void *pUserDa
 	}
 }
 
+class CPlayerScoreNameLess
+{
+public:
+	bool operator()(const CServerInfo::CClient &p0, const CServerInfo::CClient &p1)
+	{
+		if(p0.m_Player && !p1.m_Player)
+			return true;
+		if(!p0.m_Player && p1.m_Player)
+			return false;
+
+		int Score0 = p0.m_Score;
+		int Score1 = p1.m_Score;
+		if(Score0 == -9999)
+			Score0 = INT_MIN;
+		if(Score1 == -9999)
+			Score1 = INT_MIN;
+
+		if(Score0 > Score1)
+			return true;
+		if(Score0 < Score1)
+			return false;
+		return str_comp_nocase(p0.m_aName, p1.m_aName) < 0;
+	}
+};
+
+static void SortClients(CServerInfo *pInfo)
+{
+	std::sort(pInfo->m_aClients, pInfo->m_aClients + pInfo->m_NumReceivedClients, CPlayerScoreNameLess());
+}
+
 const CServerInfo *CServerBrowser::SortedGet(int Index) const
 {
 	if(Index < 0 || Index >= m_NumSortedServers)
@@ -254,132 +284,161 @@ bool CServerBrowser::SortCompareNumPlayersAndPing(int Index1, int Index2) const
 		return a->m_Info.m_Latency > b->m_Info.m_Latency;
 }
 
-void CServerBrowser::Filter()
+void SetFilteredPlayers(const CServerInfo &Item)
 {
-	int i = 0, p = 0;
-	m_NumSortedServers = 0;
-
-	// allocate the sorted list
-	if(m_NumSortedServersCapacity < m_NumServers)
+	Item.m_NumFilteredPlayers = g_Config.m_BrFilterSpectators ? Item.m_NumPlayers : Item.m_NumClients;
+	if(g_Config.m_BrFilterConnectingPlayers)
 	{
-		free(m_pSortedServerlist);
-		m_NumSortedServersCapacity = m_NumServers;
-		m_pSortedServerlist = (int *)calloc(m_NumSortedServersCapacity, sizeof(int));
+		for(const auto &Client : Item.m_aClients)
+		{
+			if((!g_Config.m_BrFilterSpectators || Client.m_Player) && str_comp(Client.m_aName, "(connecting)") == 0 && Client.m_aClan[0] == '\0')
+				Item.m_NumFilteredPlayers--;
+		}
 	}
+}
 
-	// filter the servers
-	for(i = 0; i < m_NumServers; i++)
+void CServerBrowser::FilterEntry(CServerEntry *pEntry)
+{
+	int p = 0;
+	SetFilteredPlayers(pEntry->m_Info);
+
+	int Filtered = 0;
+
+	if(g_Config.m_BrFilterEmpty && pEntry->m_Info.m_NumFilteredPlayers == 0)
+		Filtered = 1;
+	else if(g_Config.m_BrFilterFull && Players(pEntry->m_Info) == Max(pEntry->m_Info))
+		Filtered = 1;
+	else if(g_Config.m_BrFilterPw && pEntry->m_Info.m_Flags & SERVER_FLAG_PASSWORD)
+		Filtered = 1;
+	else if(g_Config.m_BrFilterServerAddress[0] && !str_find_nocase(pEntry->m_Info.m_aAddress, g_Config.m_BrFilterServerAddress))
+		Filtered = 1;
+	else if(g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && str_comp_nocase(pEntry->m_Info.m_aGameType, g_Config.m_BrFilterGametype))
+		Filtered = 1;
+	else if(!g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && !str_utf8_find_nocase(pEntry->m_Info.m_aGameType, g_Config.m_BrFilterGametype))
+		Filtered = 1;
+	else if(g_Config.m_BrFilterUnfinishedMap && pEntry->m_Info.m_HasRank == 1)
+		Filtered = 1;
+	else
 	{
-		int Filtered = 0;
-
-		if(g_Config.m_BrFilterEmpty && m_ppServerlist[i]->m_Info.m_NumFilteredPlayers == 0)
-			Filtered = 1;
-		else if(g_Config.m_BrFilterFull && Players(m_ppServerlist[i]->m_Info) == Max(m_ppServerlist[i]->m_Info))
-			Filtered = 1;
-		else if(g_Config.m_BrFilterPw && m_ppServerlist[i]->m_Info.m_Flags & SERVER_FLAG_PASSWORD)
-			Filtered = 1;
-		else if(g_Config.m_BrFilterServerAddress[0] && !str_find_nocase(m_ppServerlist[i]->m_Info.m_aAddress, g_Config.m_BrFilterServerAddress))
-			Filtered = 1;
-		else if(g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && str_comp_nocase(m_ppServerlist[i]->m_Info.m_aGameType, g_Config.m_BrFilterGametype))
-			Filtered = 1;
-		else if(!g_Config.m_BrFilterGametypeStrict && g_Config.m_BrFilterGametype[0] && !str_utf8_find_nocase(m_ppServerlist[i]->m_Info.m_aGameType, g_Config.m_BrFilterGametype))
-			Filtered = 1;
-		else if(g_Config.m_BrFilterUnfinishedMap && m_ppServerlist[i]->m_Info.m_HasRank == 1)
-			Filtered = 1;
-		else
+		if(g_Config.m_BrFilterCountry)
 		{
-			if(g_Config.m_BrFilterCountry)
+			Filtered = 1;
+			// match against player country
+			for(p = 0; p < minimum(pEntry->m_Info.m_NumClients, (int)MAX_CLIENTS); p++)
 			{
-				Filtered = 1;
-				// match against player country
-				for(p = 0; p < minimum(m_ppServerlist[i]->m_Info.m_NumClients, (int)MAX_CLIENTS); p++)
+				if(pEntry->m_Info.m_aClients[p].m_Country == g_Config.m_BrFilterCountryIndex)
 				{
-					if(m_ppServerlist[i]->m_Info.m_aClients[p].m_Country == g_Config.m_BrFilterCountryIndex)
-					{
-						Filtered = 0;
-						break;
-					}
+					Filtered = 0;
+					break;
 				}
 			}
+		}
 
-			if(!Filtered && g_Config.m_BrFilterString[0] != 0)
-			{
-				int MatchFound = 0;
-
-				m_ppServerlist[i]->m_Info.m_QuickSearchHit = 0;
+		if(!Filtered && g_Config.m_BrFilterString[0] != 0)
+		{
+			int MatchFound = 0;
 
-				// match against server name
-				if(str_utf8_find_nocase(m_ppServerlist[i]->m_Info.m_aName, g_Config.m_BrFilterString))
-				{
-					MatchFound = 1;
-					m_ppServerlist[i]->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_SERVERNAME;
-				}
+			pEntry->m_Info.m_QuickSearchHit = 0;
 
-				// match against players
-				for(p = 0; p < minimum(m_ppServerlist[i]->m_Info.m_NumClients, (int)MAX_CLIENTS); p++)
-				{
-					if(str_utf8_find_nocase(m_ppServerlist[i]->m_Info.m_aClients[p].m_aName, g_Config.m_BrFilterString) ||
-						str_utf8_find_nocase(m_ppServerlist[i]->m_Info.m_aClients[p].m_aClan, g_Config.m_BrFilterString))
-					{
-						MatchFound = 1;
-						m_ppServerlist[i]->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_PLAYER;
-						break;
-					}
-				}
+			// match against server name
+			if(str_utf8_find_nocase(pEntry->m_Info.m_aName, g_Config.m_BrFilterString))
+			{
+				MatchFound = 1;
+				pEntry->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_SERVERNAME;
+			}
 
-				// match against map
-				if(str_utf8_find_nocase(m_ppServerlist[i]->m_Info.m_aMap, g_Config.m_BrFilterString))
+			// match against players
+			for(p = 0; p < minimum(pEntry->m_Info.m_NumClients, (int)MAX_CLIENTS); p++)
+			{
+				if(str_utf8_find_nocase(pEntry->m_Info.m_aClients[p].m_aName, g_Config.m_BrFilterString) ||
+					str_utf8_find_nocase(pEntry->m_Info.m_aClients[p].m_aClan, g_Config.m_BrFilterString))
 				{
 					MatchFound = 1;
-					m_ppServerlist[i]->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_MAPNAME;
+					pEntry->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_PLAYER;
+					break;
 				}
-
-				if(!MatchFound)
-					Filtered = 1;
 			}
 
-			if(!Filtered && g_Config.m_BrExcludeString[0] != 0)
+			// match against map
+			if(str_utf8_find_nocase(pEntry->m_Info.m_aMap, g_Config.m_BrFilterString))
 			{
-				int MatchFound = 0;
+				MatchFound = 1;
+				pEntry->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_MAPNAME;
+			}
 
-				// match against server name
-				if(str_utf8_find_nocase(m_ppServerlist[i]->m_Info.m_aName, g_Config.m_BrExcludeString))
-				{
-					MatchFound = 1;
-				}
+			if(!MatchFound)
+				Filtered = 1;
+		}
 
-				// match against map
-				if(str_utf8_find_nocase(m_ppServerlist[i]->m_Info.m_aMap, g_Config.m_BrExcludeString))
-				{
-					MatchFound = 1;
-				}
+		if(!Filtered && g_Config.m_BrExcludeString[0] != 0)
+		{
+			int MatchFound = 0;
 
-				// match against gametype
-				if(str_utf8_find_nocase(m_ppServerlist[i]->m_Info.m_aGameType, g_Config.m_BrExcludeString))
-				{
-					MatchFound = 1;
-				}
+			// match against server name
+			if(str_utf8_find_nocase(pEntry->m_Info.m_aName, g_Config.m_BrExcludeString))
+			{
+				MatchFound = 1;
+			}
 
-				if(MatchFound)
-					Filtered = 1;
+			// match against map
+			if(str_utf8_find_nocase(pEntry->m_Info.m_aMap, g_Config.m_BrExcludeString))
+			{
+				MatchFound = 1;
 			}
-		}
 
-		if(Filtered == 0)
-		{
-			// check for friend
-			m_ppServerlist[i]->m_Info.m_FriendState = IFriends::FRIEND_NO;
-			for(p = 0; p < minimum(m_ppServerlist[i]->m_Info.m_NumClients, (int)MAX_CLIENTS); p++)
+			// match against gametype
+			if(str_utf8_find_nocase(pEntry->m_Info.m_aGameType, g_Config.m_BrExcludeString))
 			{
-				m_ppServerlist[i]->m_Info.m_aClients[p].m_FriendState = m_pFriends->GetFriendState(m_ppServerlist[i]->m_Info.m_aClients[p].m_aName,
-					m_ppServerlist[i]->m_Info.m_aClients[p].m_aClan);
-				m_ppServerlist[i]->m_Info.m_FriendState = maximum(m_ppServerlist[i]->m_Info.m_FriendState, m_ppServerlist[i]->m_Info.m_aClients[p].m_FriendState);
+				MatchFound = 1;
 			}
 
-			if(!g_Config.m_BrFilterFriends || m_ppServerlist[i]->m_Info.m_FriendState != IFriends::FRIEND_NO)
-				m_pSortedServerlist[m_NumSortedServers++] = i;
+			if(MatchFound)
+				Filtered = 1;
 		}
 	}
+
+	pEntry->m_Visible = false;
+	if(Filtered == 0)
+	{
+		// check for friend
+		pEntry->m_Info.m_FriendState = IFriends::FRIEND_NO;
+		for(p = 0; p < minimum(pEntry->m_Info.m_NumClients, (int)MAX_CLIENTS); p++)
+		{
+			pEntry->m_Info.m_aClients[p].m_FriendState = m_pFriends->GetFriendState(pEntry->m_Info.m_aClients[p].m_aName,
+				pEntry->m_Info.m_aClients[p].m_aClan);
+			pEntry->m_Info.m_FriendState = maximum(pEntry->m_Info.m_FriendState, pEntry->m_Info.m_aClients[p].m_FriendState);
+		}
+
+		pEntry->m_Visible = !g_Config.m_BrFilterFriends || pEntry->m_Info.m_FriendState != IFriends::FRIEND_NO;
+	}
+
+	// only the client lists of listed servers are shown
+	if(pEntry->m_Visible && pEntry->m_ClientsUnsorted)
+	{
+		SortClients(&pEntry->m_Info);
+		pEntry->m_ClientsUnsorted = false;
+	}
+}
+
+void CServerBrowser::Filter()
+{
+	m_NumSortedServers = 0;
+
+	// allocate the sorted list
+	if(m_NumSortedServersCapacity < m_NumServers)
+	{
+		free(m_pSortedServerlist);
+		m_NumSortedServersCapacity = m_NumServers;
+		m_pSortedServerlist = (int *)calloc(m_NumSortedServersCapacity, sizeof(int));
+	}
+
+	// filter the servers
+	for(int i = 0; i < m_NumServers; i++)
+	{
+		FilterEntry(m_ppServerlist[i]);
+		if(m_ppServerlist[i]->m_Visible)
+			m_pSortedServerlist[m_NumSortedServers++] = i;
+	}
 }
 
 int CServerBrowser::SortHash() const
@@ -398,51 +457,107 @@ int CServerBrowser::SortHash() const
 	return i;
 }
 
-void SetFilteredPlayers(const CServerInfo &Item)
+CServerBrowser::FSortCompare CServerBrowser::SortCompare() const
 {
-	Item.m_NumFilteredPlayers = g_Config.m_BrFilterSpectators ? Item.m_NumPlayers : Item.m_NumClients;
-	if(g_Config.m_BrFilterConnectingPlayers)
-	{
-		for(const auto &Client : Item.m_aClients)
-		{
-			if((!g_Config.m_BrFilterSpectators || Client.m_Player) && str_comp(Client.m_aName, "(connecting)") == 0 && Client.m_aClan[0] == '\0')
-				Item.m_NumFilteredPlayers--;
-		}
-	}
+	if(g_Config.m_BrSortOrder == 2 && (g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS || g_Config.m_BrSort == IServerBrowser::SORT_PING))
+		return &CServerBrowser::SortCompareNumPlayersAndPing;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_NAME)
+		return &CServerBrowser::SortCompareName;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_PING)
+		return &CServerBrowser::SortComparePing;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_MAP)
+		return &CServerBrowser::SortCompareMap;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS)
+		return &CServerBrowser::SortCompareNumPlayers;
+	else if(g_Config.m_BrSort == IServerBrowser::SORT_GAMETYPE)
+		return &CServerBrowser::SortCompareGametype;
+	return nullptr;
 }
 
 void CServerBrowser::Sort()
 {
-	int i;
-
-	// fill m_NumFilteredPlayers
-	for(i = 0; i < m_NumServers; i++)
-	{
-		SetFilteredPlayers(m_ppServerlist[i]->m_Info);
-	}
-
 	// create filtered list
 	Filter();
 
 	// sort
-	if(g_Config.m_BrSortOrder == 2 && (g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS || g_Config.m_BrSort == IServerBrowser::SORT_PING))
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, SortWrap(this, &CServerBrowser::SortCompareNumPlayersAndPing));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_NAME)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, SortWrap(this, &CServerBrowser::SortCompareName));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_PING)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, SortWrap(this, &CServerBrowser::SortComparePing));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_MAP)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, SortWrap(this, &CServerBrowser::SortCompareMap));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_NUMPLAYERS)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, SortWrap(this, &CServerBrowser::SortCompareNumPlayers));
-	else if(g_Config.m_BrSort == IServerBrowser::SORT_GAMETYPE)
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, SortWrap(this, &CServerBrowser::SortCompareGametype));
+	FSortCompare pfnCompare = SortCompare();
+	if(pfnCompare)
+		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, SortWrap(this, pfnCompare));
+
+	for(int Index : m_vChangedServers)
+		m_ppServerlist[Index]->m_Changed = false;
+	m_vChangedServers.clear();
 
 	str_copy(m_aFilterGametypeString, g_Config.m_BrFilterGametype, sizeof(m_aFilterGametypeString));
 	str_copy(m_aFilterString, g_Config.m_BrFilterString, sizeof(m_aFilterString));
 	m_Sorthash = SortHash();
 }
 
+void CServerBrowser::SortChanged()
+{
+	if(m_vChangedServers.empty())
+		return;
+
+	// binary insertion needs a strict weak order, which the combined players and ping order is not.
+	// Each insertion moves the rest of the list, so many changes are cheaper to sort from scratch
+	FSortCompare pfnCompare = SortCompare();
+	if(pfnCompare == &CServerBrowser::SortCompareNumPlayersAndPing || (int)m_vChangedServers.size() > m_NumSortedServers / 4)
+	{
+		Sort();
+		return;
+	}
+
+	if(m_NumSortedServersCapacity < m_NumServers)
+	{
+		m_NumSortedServersCapacity = m_NumServerCapacity;
+		m_pSortedServerlist = (int *)realloc(m_pSortedServerlist, m_NumSortedServersCapacity * sizeof(int));
+	}
+
+	// take the changed servers out, the rest of the list stays in order
+	int NumKept = 0;
+	for(int i = 0; i < m_NumSortedServers; i++)
+	{
+		if(!m_ppServerlist[m_pSortedServerlist[i]]->m_Changed)
+			m_pSortedServerlist[NumKept++] = m_pSortedServerlist[i];
+	}
+	m_NumSortedServers = NumKept;
+
+	// and insert them again, equal servers stay in server order like with the stable sort
+	SortWrap Compare(this, pfnCompare);
+	auto Less = [&](int Index1, int Index2) {
+		if(pfnCompare)
+		{
+			if(Compare(Index1, Index2))
+				return true;
+			if(Compare(Index2, Index1))
+				return false;
+		}
+		return Index1 < Index2;
+	};
+	for(int Index : m_vChangedServers)
+	{
+		CServerEntry *pEntry = m_ppServerlist[Index];
+		pEntry->m_Changed = false;
+		FilterEntry(pEntry);
+		if(!pEntry->m_Visible)
+			continue;
+
+		int *pPos = std::lower_bound(m_pSortedServerlist, m_pSortedServerlist + m_NumSortedServers, Index, Less);
+		mem_move(pPos + 1, pPos, (m_pSortedServerlist + m_NumSortedServers - pPos) * sizeof(int));
+		*pPos = Index;
+		m_NumSortedServers++;
+	}
+	m_vChangedServers.clear();
+}
+
+void CServerBrowser::MarkChanged(CServerEntry *pEntry)
+{
+	if(pEntry->m_Changed)
+		return;
+	pEntry->m_Changed = true;
+	m_vChangedServers.push_back(pEntry->m_Info.m_ServerIndex);
+}
+
 void CServerBrowser::RemoveRequest(CServerEntry *pEntry)
 {
 	if(pEntry->m_pPrevReq || pEntry->m_pNextReq || m_pFirstReqServer == pEntry)
@@ -492,40 +607,17 @@ void CServerBrowser::SetInfo(CServerEntry *pEntry, const CServerInfo &Info)
 {
 	bool Fav = pEntry->m_Info.m_Favorite;
 	bool Off = pEntry->m_Info.m_Official;
+	int ServerIndex = pEntry->m_Info.m_ServerIndex;
 	pEntry->m_Info = Info;
 	pEntry->m_Info.m_Favorite = Fav;
 	pEntry->m_Info.m_Official = Off;
+	pEntry->m_Info.m_ServerIndex = ServerIndex;
 	pEntry->m_Info.m_NetAddr = pEntry->m_Addr;
 	net_addr_str(&pEntry->m_Info.m_NetAddr, pEntry->m_Info.m_aAddress, sizeof(pEntry->m_Info.m_aAddress), 1);
 
-	class CPlayerScoreNameLess
-	{
-	public:
-		bool operator()(const CServerInfo::CClient &p0, const CServerInfo::CClient &p1)
-		{
-			if(p0.m_Player && !p1.m_Player)
-				return true;
-			if(!p0.m_Player && p1.m_Player)
-				return false;
-
-			int Score0 = p0.m_Score;
-			int Score1 = p1.m_Score;
-			if(Score0 == -9999)
-				Score0 = INT_MIN;
-			if(Score1 == -9999)
-				Score1 = INT_MIN;
-
-			if(Score0 > Score1)
-				return true;
-			if(Score0 < Score1)
-				return false;
-			return str_comp_nocase(p0.m_aName, p1.m_aName) < 0;
-		}
-	};
-
-	std::sort(pEntry->m_Info.m_aClients, pEntry->m_Info.m_aClients + Info.m_NumReceivedClients, CPlayerScoreNameLess());
-
+	pEntry->m_ClientsUnsorted = true;
 	pEntry->m_GotInfo = 1;
+	MarkChanged(pEntry);
 }
 
 void CServerBrowser::SetLatency(NETADDR Addr, int Latency)
@@ -539,6 +631,7 @@ void CServerBrowser::SetLatency(NETADDR Addr, int Latency)
 		{
 			pEntry->m_Info.m_Latency = Latency;
 			pEntry->m_Info.m_LatencyIsEstimated = false;
+			MarkChanged(pEntry);
 		}
 	}
 	m_pPingCache->CachePing(Addr, Latency);
@@ -601,6 +694,7 @@ CServerBrowser::CServerEntry *CServerBrowser::Add(const NETADDR &Addr)
 	m_ppServerlist[m_NumServers] = pEntry;
 	pEntry->m_Info.m_ServerIndex = m_NumServers;
 	m_NumServers++;
+	MarkChanged(pEntry);
 
 	return pEntry;
 }
@@ -753,7 +847,8 @@ void CServerBrowser::Set(const NETADDR &Addr, int Type, int Token, const CServer
 		RemoveRequest(pEntry);
 	}
 
-	m_SortOnNextUpdate = true;
+	if(pEntry)
+		MarkChanged(pEntry);
 }
 
 void CServerBrowser::Refresh(int Type)
@@ -1157,6 +1252,7 @@ void CServerBrowser::CleanUp()
 	m_ServerlistHeap.Reset();
 	m_NumServers = 0;
 	m_NumSortedServers = 0;
+	m_vChangedServers.clear();
 	mem_zero(m_aServerlistIp, sizeof(m_aServerlistIp));
 	m_pFirstReqServer = 0;
 	m_pLastReqServer = 0;
@@ -1245,12 +1341,14 @@ void CServerBrowser::Update(bool ForceResort)
 		}
 	}
 
-	// check if we need to resort
+	// changed settings resort everything, updated servers are only moved to their new place
 	if(m_Sorthash != SortHash() || ForceResort || m_SortOnNextUpdate)
 	{
 		Sort();
 		m_SortOnNextUpdate = false;
 	}
+	else
+		SortChanged();
 }
 
 int CServerBrowser::FindFavorite(const NETADDR &Addr) const
@@ -1451,6 +1549,7 @@ void CServerBrowser::LoadDDNetRanks()
 		if(m_ppServerlist[i]->m_Info.m_aMap[0])
 			m_ppServerlist[i]->m_Info.m_HasRank = HasRank(m_ppServerlist[i]->m_Info.m_aMap);
 	}
+	m_SortOnNextUpdate = true;
 }
 
 int CServerBrowser::HasRank(const char *pMap)
@@ -11,6 +11,8 @@
 #include <engine/shared/http.h>
 #include <engine/shared/memheap.h>
 
+#include <vector>
+
 class CNetClient;
 class IConfigManager;
 class IServerBrowserHttp;
@@ -18,6 +20,8 @@ class IServerBrowserPingCache;
 
 class CServerBrowser : public IServerBrowser
 {
+	friend class CServerBrowserSortTest;
+
 public:
 	class CServerEntry
 	{
@@ -29,6 +33,10 @@ public:
 		bool m_Request64Legacy;
 		CServerInfo m_Info;
 
+		bool m_Visible; // passed the filter on the last update
+		bool m_Changed; // queued to be moved in the sorted list
+		bool m_ClientsUnsorted; // the client list is sorted when the server passes the filter
+
 		CServerEntry *m_pNextIp; // ip hashed list
 
 		CServerEntry *m_pPrevReq; // request list
@@ -197,6 +205,7 @@ private:
 	unsigned char m_aTokenSeed[16];
 
 	bool m_SortOnNextUpdate;
+	std::vector<int> m_vChangedServers;
 
 	int FindFavorite(const NETADDR &Addr) const;
 
@@ -205,6 +214,8 @@ private:
 	static int GetExtraToken(int Token);
 
 	// sorting criteria
+	typedef bool (CServerBrowser::*FSortCompare)(int Index1, int Index2) const;
+	FSortCompare SortCompare() const;
 	bool SortCompareName(int Index1, int Index2) const;
 	bool SortCompareMap(int Index1, int Index2) const;
 	bool SortComparePing(int Index1, int Index2) const;
@@ -214,8 +225,11 @@ private:
 	bool SortCompareNumPlayersAndPing(int Index1, int Index2) const;
 
 	//
+	void FilterEntry(CServerEntry *pEntry);
 	void Filter();
 	void Sort();
+	void SortChanged();
+	void MarkChanged(CServerEntry *pEntry);
 	int SortHash() const;
 
 	void CleanUp();
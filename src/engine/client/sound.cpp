@@ -13,6 +13,7 @@
 #include "SDL.h"
 
 #include "sound.h"
+#include "sound_mix.h"
 
 extern "C" {
 #if defined(CONF_VIDEORECORDER)
@@ -28,6 +29,7 @@ enum
 	NUM_SAMPLES = 512,
 	NUM_VOICES = 256,
 	NUM_CHANNELS = 16,
+	NUM_COMMANDS = 1024,
 };
 
 struct CSample
@@ -66,10 +68,48 @@ struct CVoice
 	};
 };
 
+// the client thread allocates voices and sends everything else to the mixer
+struct CVoiceSlot
+{
+	int m_Age;
+	int m_SampleID;
+	bool m_Used;
+};
+
+struct CVoiceCommand
+{
+	enum
+	{
+		PLAY,
+		STOP_VOICE,
+		STOP_SAMPLE,
+		STOP_ALL,
+		SET_VOLUME,
+		SET_FALLOFF,
+		SET_LOCATION,
+		SET_TIME_OFFSET,
+		SET_CIRCLE,
+		SET_RECTANGLE,
+	};
+
+	int m_Type;
+	int m_VoiceID;
+	int m_Age;
+	int m_SampleID;
+	int m_ChannelID;
+	int m_Flags;
+	float m_aValues[2];
+};
+
 static CSample m_aSamples[NUM_SAMPLES] = {{0}};
-static CVoice m_aVoices[NUM_VOICES] = {{0}};
+static CVoice m_aVoices[NUM_VOICES] = {{0}}; // only touched by the mixer
 static CChannel m_aChannels[NUM_CHANNELS] = {{255, 0}};
 
+static CVoiceSlot m_aVoiceSlots[NUM_VOICES] = {{0}}; // only touched by the client thread
+static std::atomic<int> m_aVoiceFinished[NUM_VOICES]; // age of the last voice that played to its end
+static CSpscQueue<CVoiceCommand, NUM_COMMANDS> m_VoiceCommands;
+
+// held by whoever consumes the voice commands, the audio callback, the video recorder or a flush
 static std::mutex m_SoundLock;
 
 static std::atomic<int> m_CenterX{0};
@@ -89,16 +129,6 @@ static int s_WVBufferSize = 0;
 const int DefaultDistance = 1500;
 int m_LastBreak = 0;
 
-// TODO: there should be a faster way todo this
-static short Int2Short(int i)
-{
-	if(i > 0x7fff)
-		return 0x7fff;
-	else if(i < -0x7fff)
-		return -0x7fff;
-	return i;
-}
-
 static int IntAbs(int i)
 {
 	if(i < 0)
@@ -106,27 +136,142 @@ static int IntAbs(int i)
 	return i;
 }
 
+static void StopMixerVoice(CVoice &Voice)
+{
+	if(Voice.m_Flags & ISound::FLAG_LOOP)
+		Voice.m_pSample->m_PausedAt = Voice.m_Tick;
+	else
+		Voice.m_pSample->m_PausedAt = 0;
+	Voice.m_pSample = 0;
+}
+
+static void SetMixerVoiceTimeOffset(CVoice &Voice, float offset)
+{
+	int Tick = 0;
+	bool IsLooping = Voice.m_Flags & ISound::FLAG_LOOP;
+	uint64_t TickOffset = Voice.m_pSample->m_Rate * offset;
+	if(Voice.m_pSample->m_NumFrames > 0 && IsLooping)
+		Tick = TickOffset % Voice.m_pSample->m_NumFrames;
+	else
+		Tick = clamp(TickOffset, (uint64_t)0, (uint64_t)Voice.m_pSample->m_NumFrames);
+
+	// at least 200msec off, else depend on buffer size
+	float Threshold = maximum(0.2f * Voice.m_pSample->m_Rate, (float)m_MaxFrames);
+	if(abs(Voice.m_Tick - Tick) > Threshold)
+	{
+		// take care of looping (modulo!)
+		if(!(IsLooping && (minimum(Voice.m_Tick, Tick) + Voice.m_pSample->m_NumFrames - maximum(Voice.m_Tick, Tick)) <= Threshold))
+		{
+			Voice.m_Tick = Tick;
+		}
+	}
+}
+
+// applies the queued commands to the mixer voices, the caller has to hold m_SoundLock
+static void ProcessVoiceCommands()
+{
+	CVoiceCommand Command;
+	while(m_VoiceCommands.Pop(&Command))
+	{
+		if(Command.m_Type == CVoiceCommand::STOP_SAMPLE || Command.m_Type == CVoiceCommand::STOP_ALL)
+		{
+			for(auto &Voice : m_aVoices)
+			{
+				if(Voice.m_pSample && (Command.m_Type == CVoiceCommand::STOP_ALL || Voice.m_pSample == &m_aSamples[Command.m_SampleID]))
+					StopMixerVoice(Voice);
+			}
+			continue;
+		}
+
+		CVoice &Voice = m_aVoices[Command.m_VoiceID];
+		if(Command.m_Type == CVoiceCommand::PLAY)
+		{
+			Voice.m_pSample = &m_aSamples[Command.m_SampleID];
+			Voice.m_pChannel = &m_aChannels[Command.m_ChannelID];
+			if(Command.m_Flags & ISound::FLAG_LOOP)
+				Voice.m_Tick = Voice.m_pSample->m_PausedAt;
+			else
+				Voice.m_Tick = 0;
+			Voice.m_Age = Command.m_Age;
+			Voice.m_Vol = 255;
+			Voice.m_Flags = Command.m_Flags;
+			Voice.m_X = (int)Command.m_aValues[0];
+			Voice.m_Y = (int)Command.m_aValues[1];
+			Voice.m_Falloff = 0.0f;
+			Voice.m_Shape = ISound::SHAPE_CIRCLE;
+			Voice.m_Circle.m_Radius = DefaultDistance;
+			continue;
+		}
+
+		// the voice may have played to its end in the meantime
+		if(!Voice.m_pSample || Voice.m_Age != Command.m_Age)
+			continue;
+
+		switch(Command.m_Type)
+		{
+		case CVoiceCommand::STOP_VOICE:
+			Voice.m_pSample = 0;
+			break;
+		case CVoiceCommand::SET_VOLUME:
+			Voice.m_Vol = (int)(Command.m_aValues[0] * 255.0f);
+			break;
+		case CVoiceCommand::SET_FALLOFF:
+			Voice.m_Falloff = Command.m_aValues[0];
+			break;
+		case CVoiceCommand::SET_LOCATION:
+			Voice.m_X = Command.m_aValues[0];
+			Voice.m_Y = Command.m_aValues[1];
+			break;
+		case CVoiceCommand::SET_TIME_OFFSET:
+			SetMixerVoiceTimeOffset(Voice, Command.m_aValues[0]);
+			break;
+		case CVoiceCommand::SET_CIRCLE:
+			Voice.m_Shape = ISound::SHAPE_CIRCLE;
+			Voice.m_Circle.m_Radius = Command.m_aValues[0];
+			break;
+		case CVoiceCommand::SET_RECTANGLE:
+			Voice.m_Shape = ISound::SHAPE_RECTANGLE;
+			Voice.m_Rectangle.m_Width = Command.m_aValues[0];
+			Voice.m_Rectangle.m_Height = Command.m_aValues[1];
+			break;
+		}
+	}
+}
+
+// applies the queued commands on the calling thread, used when the mixer might still read a sample
+static void FlushVoiceCommands()
+{
+	std::unique_lock<std::mutex> Lock(m_SoundLock);
+	ProcessVoiceCommands();
+}
+
+static void PushVoiceCommand(const CVoiceCommand &Command)
+{
+	// the queue only runs full when nothing mixes, e.g. while the audio device is paused
+	while(!m_VoiceCommands.Push(Command))
+		FlushVoiceCommands();
+}
+
 static void Mix(short *pFinalOut, unsigned Frames)
 {
 	int MasterVol;
 	Frames = minimum(Frames, m_MaxFrames);
 	mem_zero(m_pMixBuffer, Frames * 2 * sizeof(int));
 
-	// acquire lock while we are mixing
+	// the client thread does not take the lock, it only keeps the voices alive while mixing
 	m_SoundLock.lock();
 
+	ProcessVoiceCommands();
 	MasterVol = m_SoundVolume;
 
-	for(auto &Voice : m_aVoices)
+	for(int VoiceID = 0; VoiceID < NUM_VOICES; VoiceID++)
 	{
+		CVoice &Voice = m_aVoices[VoiceID];
 		if(Voice.m_pSample)
 		{
 			// mix voice
-			int *pOut = m_pMixBuffer;
-
 			int Step = Voice.m_pSample->m_Channels; // setup input sources
-			short *pInL = &Voice.m_pSample->m_pData[Voice.m_Tick * Step];
-			short *pInR = &Voice.m_pSample->m_pData[Voice.m_Tick * Step + 1];
+			const short *pIn = &Voice.m_pSample->m_pData[Voice.m_Tick * Step];
 
 			unsigned End = Voice.m_pSample->m_NumFrames - Voice.m_Tick;
 
@@ -137,10 +282,6 @@ static void Mix(short *pFinalOut, unsigned Frames)
 			if(Frames < End)
 				End = Frames;
 
-			// check if we have a mono sound
-			if(Voice.m_pSample->m_Channels == 1)
-				pInR = pInL;
-
 			// volume calculation
 			if(Voice.m_Flags & ISound::FLAG_POS && Voice.m_pChannel->m_Pan)
 			{
@@ -234,14 +375,8 @@ static void Mix(short *pFinalOut, unsigned Frames)
 			}
 
 			// process all frames
-			for(unsigned s = 0; s < End; s++)
-			{
-				*pOut++ += (*pInL) * Lvol;
-				*pOut++ += (*pInR) * Rvol;
-				pInL += Step;
-				pInR += Step;
-				Voice.m_Tick++;
-			}
+			MixVoice(m_pMixBuffer, pIn, Step, End, Lvol, Rvol);
+			Voice.m_Tick += End;
 
 			// free voice if not used any more
 			if(Voice.m_Tick == Voice.m_pSample->m_NumFrames)
@@ -251,7 +386,7 @@ static void Mix(short *pFinalOut, unsigned Frames)
 				else
 				{
 					Voice.m_pSample = 0;
-					Voice.m_Age++;
+					m_aVoiceFinished[VoiceID].store(Voice.m_Age, std::memory_order_relaxed);
 				}
 			}
 		}
@@ -260,21 +395,8 @@ static void Mix(short *pFinalOut, unsigned Frames)
 	// release the lock
 	m_SoundLock.unlock();
 
-	{
-		// clamp accumulated values
-		// TODO: this seams slow
-		for(unsigned i = 0; i < Frames; i++)
-		{
-			int j = i << 1;
-			int vl = ((m_pMixBuffer[j] * MasterVol) / 101) >> 8;
-			int vr = ((m_pMixBuffer[j + 1] * MasterVol) / 101) >> 8;
-
-			pFinalOut[j] = Int2Short(vl);
-			pFinalOut[j + 1] = Int2Short(vr);
-
-			// dbg_msg("sound", "the real shit: %d %d", pFinalOut[j], pFinalOut[j+1]);
-		}
-	}
+	// clamp accumulated values
+	ClampMix(pFinalOut, m_pMixBuffer, Frames * 2, MasterVol);
 
 #if defined(CONF_ARCH_ENDIAN_BIG)
 	swap_endian(pFinalOut, sizeof(short), Frames * 2);
@@ -357,11 +479,7 @@ int CSound::Update()
 	if(!m_pGraphics->WindowActive() && g_Config.m_SndNonactiveMute)
 		WantedVolume = 0;
 
-	if(WantedVolume != m_SoundVolume)
-	{
-		std::unique_lock<std::mutex> Lock(m_SoundLock);
-		m_SoundVolume = WantedVolume;
-	}
+	m_SoundVolume = WantedVolume;
 	return 0;
 }
 
@@ -729,7 +847,9 @@ void CSound::UnloadSample(int SampleID)
 	if(SampleID == -1 || SampleID >= NUM_SAMPLES)
 		return;
 
+	// the mixer has to be done with the sample before it is freed
 	Stop(SampleID);
+	FlushVoiceCommands();
 	free(m_aSamples[SampleID].m_pData);
 
 	m_aSamples[SampleID].m_pData = 0x0;
@@ -749,116 +869,68 @@ void CSound::SetListenerPos(float x, float y)
 	m_CenterY.store((int)y, std::memory_order_relaxed);
 }
 
-void CSound::SetVoiceVolume(CVoiceHandle Voice, float Volume)
+static bool IsVoiceActive(ISound::CVoiceHandle Voice)
 {
-	if(!Voice.IsValid())
-		return;
+	return Voice.IsValid() && m_aVoiceSlots[Voice.Id()].m_Used && m_aVoiceSlots[Voice.Id()].m_Age == Voice.Age();
+}
 
-	int VoiceID = Voice.Id();
+static void PushVoiceCommand(int Type, ISound::CVoiceHandle Voice, float Value0, float Value1 = 0.0f)
+{
+	CVoiceCommand Command = {0};
+	Command.m_Type = Type;
+	Command.m_VoiceID = Voice.Id();
+	Command.m_Age = Voice.Age();
+	Command.m_aValues[0] = Value0;
+	Command.m_aValues[1] = Value1;
+	PushVoiceCommand(Command);
+}
 
-	std::unique_lock<std::mutex> Lock(m_SoundLock);
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
+void CSound::SetVoiceVolume(CVoiceHandle Voice, float Volume)
+{
+	if(!IsVoiceActive(Voice))
 		return;
 
-	Volume = clamp(Volume, 0.0f, 1.0f);
-	m_aVoices[VoiceID].m_Vol = (int)(Volume * 255.0f);
+	PushVoiceCommand(CVoiceCommand::SET_VOLUME, Voice, clamp(Volume, 0.0f, 1.0f));
 }
 
 void CSound::SetVoiceFalloff(CVoiceHandle Voice, float Falloff)
 {
-	if(!Voice.IsValid())
-		return;
-
-	int VoiceID = Voice.Id();
-
-	std::unique_lock<std::mutex> Lock(m_SoundLock);
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
+	if(!IsVoiceActive(Voice))
 		return;
 
-	Falloff = clamp(Falloff, 0.0f, 1.0f);
-	m_aVoices[VoiceID].m_Falloff = Falloff;
+	PushVoiceCommand(CVoiceCommand::SET_FALLOFF, Voice, clamp(Falloff, 0.0f, 1.0f));
 }
 
 void CSound::SetVoiceLocation(CVoiceHandle Voice, float x, float y)
 {
-	if(!Voice.IsValid())
-		return;
-
-	int VoiceID = Voice.Id();
-
-	std::unique_lock<std::mutex> Lock(m_SoundLock);
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
+	if(!IsVoiceActive(Voice))
 		return;
 
-	m_aVoices[VoiceID].m_X = x;
-	m_aVoices[VoiceID].m_Y = y;
+	PushVoiceCommand(CVoiceCommand::SET_LOCATION, Voice, x, y);
 }
 
 void CSound::SetVoiceTimeOffset(CVoiceHandle Voice, float offset)
 {
-	if(!Voice.IsValid())
+	if(!IsVoiceActive(Voice))
 		return;
 
-	int VoiceID = Voice.Id();
-
-	std::unique_lock<std::mutex> Lock(m_SoundLock);
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
-		return;
-
-	{
-		if(m_aVoices[VoiceID].m_pSample)
-		{
-			int Tick = 0;
-			bool IsLooping = m_aVoices[VoiceID].m_Flags & ISound::FLAG_LOOP;
-			uint64_t TickOffset = m_aVoices[VoiceID].m_pSample->m_Rate * offset;
-			if(m_aVoices[VoiceID].m_pSample->m_NumFrames > 0 && IsLooping)
-				Tick = TickOffset % m_aVoices[VoiceID].m_pSample->m_NumFrames;
-			else
-				Tick = clamp(TickOffset, (uint64_t)0, (uint64_t)m_aVoices[VoiceID].m_pSample->m_NumFrames);
-
-			// at least 200msec off, else depend on buffer size
-			float Threshold = maximum(0.2f * m_aVoices[VoiceID].m_pSample->m_Rate, (float)m_MaxFrames);
-			if(abs(m_aVoices[VoiceID].m_Tick - Tick) > Threshold)
-			{
-				// take care of looping (modulo!)
-				if(!(IsLooping && (minimum(m_aVoices[VoiceID].m_Tick, Tick) + m_aVoices[VoiceID].m_pSample->m_NumFrames - maximum(m_aVoices[VoiceID].m_Tick, Tick)) <= Threshold))
-				{
-					m_aVoices[VoiceID].m_Tick = Tick;
-				}
-			}
-		}
-	}
+	PushVoiceCommand(CVoiceCommand::SET_TIME_OFFSET, Voice, offset);
 }
 
 void CSound::SetVoiceCircle(CVoiceHandle Voice, float Radius)
 {
-	if(!Voice.IsValid())
-		return;
-
-	int VoiceID = Voice.Id();
-
-	std::unique_lock<std::mutex> Lock(m_SoundLock);
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
+	if(!IsVoiceActive(Voice))
 		return;
 
-	m_aVoices[VoiceID].m_Shape = ISound::SHAPE_CIRCLE;
-	m_aVoices[VoiceID].m_Circle.m_Radius = maximum(0.0f, Radius);
+	PushVoiceCommand(CVoiceCommand::SET_CIRCLE, Voice, maximum(0.0f, Radius));
 }
 
 void CSound::SetVoiceRectangle(CVoiceHandle Voice, float Width, float Height)
 {
-	if(!Voice.IsValid())
+	if(!IsVoiceActive(Voice))
 		return;
 
-	int VoiceID = Voice.Id();
-
-	std::unique_lock<std::mutex> Lock(m_SoundLock);
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
-		return;
-
-	m_aVoices[VoiceID].m_Shape = ISound::SHAPE_RECTANGLE;
-	m_aVoices[VoiceID].m_Rectangle.m_Width = maximum(0.0f, Width);
-	m_aVoices[VoiceID].m_Rectangle.m_Height = maximum(0.0f, Height);
+	PushVoiceCommand(CVoiceCommand::SET_RECTANGLE, Voice, maximum(0.0f, Width), maximum(0.0f, Height));
 }
 
 void CSound::SetChannel(int ChannelID, float Vol, float Pan)
@@ -870,16 +942,13 @@ void CSound::SetChannel(int ChannelID, float Vol, float Pan)
 ISound::CVoiceHandle CSound::Play(int ChannelID, int SampleID, int Flags, float x, float y)
 {
 	int VoiceID = -1;
-	int Age = -1;
 	int i;
 
-	m_SoundLock.lock();
-
-	// search for voice
+	// search for voice, the mixer marks the ones that played to their end
 	for(i = 0; i < NUM_VOICES; i++)
 	{
 		int id = (m_NextVoice + i) % NUM_VOICES;
-		if(!m_aVoices[id].m_pSample)
+		if(!m_aVoiceSlots[id].m_Used || m_aVoiceFinished[id].load(std::memory_order_relaxed) == m_aVoiceSlots[id].m_Age)
 		{
 			VoiceID = id;
 			m_NextVoice = id + 1;
@@ -888,26 +957,25 @@ ISound::CVoiceHandle CSound::Play(int ChannelID, int SampleID, int Flags, float
 	}
 
 	// voice found, use it
-	if(VoiceID != -1)
-	{
-		m_aVoices[VoiceID].m_pSample = &m_aSamples[SampleID];
-		m_aVoices[VoiceID].m_pChannel = &m_aChannels[ChannelID];
-		if(Flags & FLAG_LOOP)
-			m_aVoices[VoiceID].m_Tick = m_aSamples[SampleID].m_PausedAt;
-		else
-			m_aVoices[VoiceID].m_Tick = 0;
-		m_aVoices[VoiceID].m_Vol = 255;
-		m_aVoices[VoiceID].m_Flags = Flags;
-		m_aVoices[VoiceID].m_X = (int)x;
-		m_aVoices[VoiceID].m_Y = (int)y;
-		m_aVoices[VoiceID].m_Falloff = 0.0f;
-		m_aVoices[VoiceID].m_Shape = ISound::SHAPE_CIRCLE;
-		m_aVoices[VoiceID].m_Circle.m_Radius = DefaultDistance;
-		Age = m_aVoices[VoiceID].m_Age;
-	}
-
-	m_SoundLock.unlock();
-	return CreateVoiceHandle(VoiceID, Age);
+	if(VoiceID == -1)
+		return CreateVoiceHandle(-1, -1);
+
+	CVoiceSlot &Slot = m_aVoiceSlots[VoiceID];
+	Slot.m_Age++;
+	Slot.m_SampleID = SampleID;
+	Slot.m_Used = true;
+
+	CVoiceCommand Command = {0};
+	Command.m_Type = CVoiceCommand::PLAY;
+	Command.m_VoiceID = VoiceID;
+	Command.m_Age = Slot.m_Age;
+	Command.m_SampleID = SampleID;
+	Command.m_ChannelID = ChannelID;
+	Command.m_Flags = Flags;
+	Command.m_aValues[0] = x;
+	Command.m_aValues[1] = y;
+	PushVoiceCommand(Command);
+	return CreateVoiceHandle(VoiceID, Slot.m_Age);
 }
 
 ISound::CVoiceHandle CSound::PlayAt(int ChannelID, int SampleID, int Flags, float x, float y)
@@ -923,53 +991,36 @@ ISound::CVoiceHandle CSound::Play(int ChannelID, int SampleID, int Flags)
 void CSound::Stop(int SampleID)
 {
 	// TODO: a nice fade out
-	std::unique_lock<std::mutex> Lock(m_SoundLock);
-	CSample *pSample = &m_aSamples[SampleID];
-	for(auto &Voice : m_aVoices)
+	for(auto &Slot : m_aVoiceSlots)
 	{
-		if(Voice.m_pSample == pSample)
-		{
-			if(Voice.m_Flags & FLAG_LOOP)
-				Voice.m_pSample->m_PausedAt = Voice.m_Tick;
-			else
-				Voice.m_pSample->m_PausedAt = 0;
-			Voice.m_pSample = 0;
-		}
+		if(Slot.m_SampleID == SampleID)
+			Slot.m_Used = false;
 	}
+
+	CVoiceCommand Command = {0};
+	Command.m_Type = CVoiceCommand::STOP_SAMPLE;
+	Command.m_SampleID = SampleID;
+	PushVoiceCommand(Command);
 }
 
 void CSound::StopAll()
 {
 	// TODO: a nice fade out
-	std::unique_lock<std::mutex> Lock(m_SoundLock);
-	for(auto &Voice : m_aVoices)
-	{
-		if(Voice.m_pSample)
-		{
-			if(Voice.m_Flags & FLAG_LOOP)
-				Voice.m_pSample->m_PausedAt = Voice.m_Tick;
-			else
-				Voice.m_pSample->m_PausedAt = 0;
-		}
-		Voice.m_pSample = 0;
-	}
+	for(auto &Slot : m_aVoiceSlots)
+		Slot.m_Used = false;
+
+	CVoiceCommand Command = {0};
+	Command.m_Type = CVoiceCommand::STOP_ALL;
+	PushVoiceCommand(Command);
 }
 
 void CSound::StopVoice(CVoiceHandle Voice)
 {
-	if(!Voice.IsValid())
-		return;
-
-	int VoiceID = Voice.Id();
-
-	std::unique_lock<std::mutex> Lock(m_SoundLock);
-	if(m_aVoices[VoiceID].m_Age != Voice.Age())
+	if(!IsVoiceActive(Voice))
 		return;
 
-	{
-		m_aVoices[VoiceID].m_pSample = 0;
-		m_aVoices[VoiceID].m_Age++;
-	}
+	m_aVoiceSlots[Voice.Id()].m_Used = false;
+	PushVoiceCommand(CVoiceCommand::STOP_VOICE, Voice, 0.0f);
 }
 
 ISoundMixFunc CSound::GetSoundMixFunc()
@@ -0,0 +1,120 @@
+#include "sound_mix.h"
+
+#include <base/math.h>
+#include <base/system.h>
+
+#if defined(CONF_ARCH_SSE2)
+#include <emmintrin.h>
+#elif defined(CONF_ARCH_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(CONF_ARCH_SSE2)
+// adds 4 interleaved frames, the 16 bit products are widened by combining their low and high halves
+static inline void MixFrames(int *pOut, __m128i In, __m128i Vol)
+{
+	const __m128i Lo = _mm_mullo_epi16(In, Vol);
+	const __m128i Hi = _mm_mulhi_epi16(In, Vol);
+	_mm_storeu_si128((__m128i *)pOut, _mm_add_epi32(_mm_loadu_si128((const __m128i *)pOut), _mm_unpacklo_epi16(Lo, Hi)));
+	_mm_storeu_si128((__m128i *)(pOut + 4), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(pOut + 4)), _mm_unpackhi_epi16(Lo, Hi)));
+}
+#endif
+
+void MixVoice(int *pOut, const short *pIn, int Channels, unsigned Frames, int Lvol, int Rvol)
+{
+	unsigned f = 0;
+	// the vector paths multiply in 16 bit, larger volumes are left to the scalar loop
+	if(Lvol >= 0 && Lvol <= 0x7fff && Rvol >= 0 && Rvol <= 0x7fff)
+	{
+#if defined(CONF_ARCH_SSE2)
+		const __m128i Vol = _mm_set1_epi32((int)(((unsigned)Rvol << 16) | (unsigned)Lvol));
+		if(Channels == 1)
+		{
+			for(; f + 8 <= Frames; f += 8)
+			{
+				const __m128i In = _mm_loadu_si128((const __m128i *)(pIn + f));
+				MixFrames(pOut + f * 2, _mm_unpacklo_epi16(In, In), Vol);
+				MixFrames(pOut + f * 2 + 8, _mm_unpackhi_epi16(In, In), Vol);
+			}
+		}
+		else
+		{
+			for(; f + 4 <= Frames; f += 4)
+				MixFrames(pOut + f * 2, _mm_loadu_si128((const __m128i *)(pIn + f * 2)), Vol);
+		}
+#elif defined(CONF_ARCH_NEON)
+		const int16_t aVol[4] = {(int16_t)Lvol, (int16_t)Rvol, (int16_t)Lvol, (int16_t)Rvol};
+		const int16x4_t Vol = vld1_s16(aVol);
+		if(Channels == 1)
+		{
+			for(; f + 4 <= Frames; f += 4)
+			{
+				const int16x4x2_t In = vzip_s16(vld1_s16(pIn + f), vld1_s16(pIn + f));
+				vst1q_s32(pOut + f * 2, vmlal_s16(vld1q_s32(pOut + f * 2), In.val[0], Vol));
+				vst1q_s32(pOut + f * 2 + 4, vmlal_s16(vld1q_s32(pOut + f * 2 + 4), In.val[1], Vol));
+			}
+		}
+		else
+		{
+			for(; f + 4 <= Frames; f += 4)
+			{
+				const int16x8_t In = vld1q_s16(pIn + f * 2);
+				vst1q_s32(pOut + f * 2, vmlal_s16(vld1q_s32(pOut + f * 2), vget_low_s16(In), Vol));
+				vst1q_s32(pOut + f * 2 + 4, vmlal_s16(vld1q_s32(pOut + f * 2 + 4), vget_high_s16(In), Vol));
+			}
+		}
+#endif
+	}
+	MixVoiceScalar(pOut + f * 2, pIn + f * Channels, Channels, Frames - f, Lvol, Rvol);
+}
+
+void MixVoiceScalar(int *pOut, const short *pIn, int Channels, unsigned Frames, int Lvol, int Rvol)
+{
+	const short *pInL = pIn;
+	const short *pInR = Channels == 1 ? pIn : pIn + 1;
+	for(unsigned s = 0; s < Frames; s++)
+	{
+		*pOut++ += (*pInL) * Lvol;
+		*pOut++ += (*pInR) * Rvol;
+		pInL += Channels;
+		pInR += Channels;
+	}
+}
+
+void ClampMix(short *pOut, const int *pIn, unsigned Samples, int MasterVol)
+{
+	unsigned i = 0;
+#if defined(CONF_ARCH_SSE2)
+	const __m128 Scale = _mm_set1_ps(MasterVol / (101.0f * 256.0f));
+	const __m128 Min = _mm_set1_ps(-32767.0f);
+	const __m128 Max = _mm_set1_ps(32767.0f);
+	for(; i + 8 <= Samples; i += 8)
+	{
+		const __m128 A = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(pIn + i))), Scale);
+		const __m128 B = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(pIn + i + 4))), Scale);
+		const __m128i IntA = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(A, Min), Max));
+		const __m128i IntB = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(B, Min), Max));
+		_mm_storeu_si128((__m128i *)(pOut + i), _mm_packs_epi32(IntA, IntB));
+	}
+#elif defined(CONF_ARCH_NEON)
+	const float32x4_t Min = vdupq_n_f32(-32767.0f);
+	const float32x4_t Max = vdupq_n_f32(32767.0f);
+	const float Scale = MasterVol / (101.0f * 256.0f);
+	for(; i + 8 <= Samples; i += 8)
+	{
+		const float32x4_t A = vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(pIn + i)), Scale);
+		const float32x4_t B = vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(pIn + i + 4)), Scale);
+		const int16x4_t ShortA = vqmovn_s32(vcvtq_s32_f32(vminq_f32(vmaxq_f32(A, Min), Max)));
+		const int16x4_t ShortB = vqmovn_s32(vcvtq_s32_f32(vminq_f32(vmaxq_f32(B, Min), Max)));
+		vst1q_s16(pOut + i, vcombine_s16(ShortA, ShortB));
+	}
+#endif
+	ClampMixScalar(pOut + i, pIn + i, Samples - i, MasterVol);
+}
+
+void ClampMixScalar(short *pOut, const int *pIn, unsigned Samples, int MasterVol)
+{
+	const float Scale = MasterVol / (101.0f * 256.0f);
+	for(unsigned i = 0; i < Samples; i++)
+		pOut[i] = (short)clamp((float)pIn[i] * Scale, -32767.0f, 32767.0f);
+}
@@ -0,0 +1,46 @@
+#ifndef ENGINE_CLIENT_SOUND_MIX_H
+#define ENGINE_CLIENT_SOUND_MIX_H
+
+#include <atomic>
+
+// adds a voice to the interleaved stereo mix buffer, mono samples are played on both sides
+void MixVoice(int *pOut, const short *pIn, int Channels, unsigned Frames, int Lvol, int Rvol);
+void MixVoiceScalar(int *pOut, const short *pIn, int Channels, unsigned Frames, int Lvol, int Rvol);
+
+// scales the accumulated samples by the master volume (0 - 100) and saturates them to 16 bit
+void ClampMix(short *pOut, const int *pIn, unsigned Samples, int MasterVol);
+void ClampMixScalar(short *pOut, const int *pIn, unsigned Samples, int MasterVol);
+
+// lock-free ring for exactly one producer and one consumer thread
+template<typename T, int SIZE>
+class CSpscQueue
+{
+	static_assert((SIZE & (SIZE - 1)) == 0, "queue size must be a power of two");
+
+	T m_aItems[SIZE];
+	alignas(64) std::atomic<unsigned> m_Head{0}; // written by the consumer
+	alignas(64) std::atomic<unsigned> m_Tail{0}; // written by the producer
+
+public:
+	bool Push(const T &Item)
+	{
+		const unsigned Tail = m_Tail.load(std::memory_order_relaxed);
+		if(Tail - m_Head.load(std::memory_order_acquire) == (unsigned)SIZE)
+			return false;
+		m_aItems[Tail & (SIZE - 1)] = Item;
+		m_Tail.store(Tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool Pop(T *pItem)
+	{
+		const unsigned Head = m_Head.load(std::memory_order_relaxed);
+		if(Head == m_Tail.load(std::memory_order_acquire))
+			return false;
+		*pItem = m_aItems[Head & (SIZE - 1)];
+		m_Head.store(Head + 1, std::memory_order_release);
+		return true;
+	}
+};
+
+#endif
@@ -4,16 +4,22 @@
 #include <base/system.h>
 #include <cstddef>
 #include <cstdint>
+#include <engine/engine.h>
 #include <engine/graphics.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 #include <engine/textrender.h>
 
+#include "text_atlas_cache.h"
+
 // ft2 texture
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
 #include <limits>
 
+#include <zlib.h>
+
 // TODO: Refactor: clean this up
 enum
 {
@@ -21,29 +27,36 @@ enum
 };
 
 #include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
 #include <vector>
 
 #include <chrono>
+#include <list>
+#include <string>
+#include <string_view>
 
 using namespace std::chrono_literals;
 
-struct SFontSizeChar
+// a glyph rasterized by freetype, not yet placed in the atlas
+struct SRasterizedGlyph
 {
-	int m_ID;
-
-	// these values are scaled to the pFont size
-	// width * font_size == real_size
-	float m_Width;
-	float m_Height;
-	float m_CharWidth;
-	float m_CharHeight;
+	int m_Chr;
+	bool m_Valid;
+	FT_UInt m_GlyphIndex;
+
+	// size including the outline padding
+	int m_Width;
+	int m_Height;
+	int m_CharWidth;
+	int m_CharHeight;
 	float m_OffsetX;
 	float m_OffsetY;
 	float m_AdvanceX;
 
-	float m_aUVs[4];
-	int64_t m_TouchTime;
-	FT_UInt m_GlyphIndex;
+	std::vector<unsigned char> m_vData;
+	std::vector<unsigned char> m_vDataOutlined;
 };
 
 struct STextCharQuadVertexColor
@@ -80,12 +93,12 @@ struct CFontSizeData
 	FT_Face *m_pFace;
 
 	std::map<int, SFontSizeChar> m_Chars;
+	// characters that are being rasterized in the background
+	std::set<int> m_QueuedChars;
+	// kerning in pixels, keyed by the left glyph index in the upper 32 bits
+	std::unordered_map<uint64_t, float> m_Kerning;
 };
 
-#define MIN_FONT_SIZE 6
-#define MAX_FONT_SIZE 128
-#define NUM_FONT_SIZES MAX_FONT_SIZE - MIN_FONT_SIZE + 1
-
 class CFont
 {
 public:
@@ -107,6 +120,8 @@ public:
 			m_aFontSizes[i].m_FontSize = i + MIN_FONT_SIZE;
 			m_aFontSizes[i].m_pFace = &this->m_FtFace;
 			m_aFontSizes[i].m_Chars.clear();
+			m_aFontSizes[i].m_QueuedChars.clear();
+			m_aFontSizes[i].m_Kerning.clear();
 		}
 	}
 
@@ -118,12 +133,14 @@ public:
 	}
 
 	void *m_pBuf;
+	size_t m_Size;
 	char m_aFilename[IO_MAX_PATH_LENGTH];
 	FT_Face m_FtFace;
 
 	struct SFontFallBack
 	{
 		void *m_pBuf;
+		size_t m_Size;
 		char m_aFilename[IO_MAX_PATH_LENGTH];
 		FT_Face m_FtFace;
 	};
@@ -140,6 +157,13 @@ public:
 	int m_CurTextureDimensions[2];
 
 	STextureSkyline m_TextureSkyline[2];
+
+	// area of the texture data that still has to be uploaded, x0 y0 x1 y1
+	int m_aDirtyRect[2][4];
+
+	// the atlas cache is read when the first glyph is needed, so fallback fonts are known
+	bool m_AtlasCacheLoaded;
+	bool m_AtlasChanged;
 };
 
 struct STextString
@@ -209,10 +233,60 @@ struct STextContainer
 	}
 };
 
+// the input of a TextEx call that affects the layout, the text is compared separately.
+// The position and the color are not part of it, cached layouts are moved and tinted
+struct STextLayoutParams
+{
+	CFont *m_pFont;
+	float m_FontSize;
+	int m_Flags;
+	int m_LineCount;
+	int m_GlyphCount;
+	int m_CharCount;
+	int m_MaxLines;
+	// relative to the position
+	float m_StartX;
+	float m_StartY;
+	float m_LineWidth;
+	float m_MaxCharacterHeight;
+	float m_LongestLineWidth;
+	unsigned m_RenderFlags;
+	float m_aScreenSize[2];
+	int m_ScreenWidth;
+	int m_ScreenHeight;
+};
+
+struct STextLayoutEntry
+{
+	uint64_t m_Hash;
+	STextLayoutParams m_Params;
+	std::string m_Text;
+
+	// -1 if nothing is rendered or the layout was only used once so far
+	int m_TextContainerIndex;
+	bool m_Retained;
+	// the position the text container was created at
+	float m_OriginX;
+	float m_OriginY;
+
+	// the cursor fields written by the layout, the position relative to the start
+	float m_X;
+	float m_Y;
+	int m_Flags;
+	int m_LineCount;
+	int m_GlyphCount;
+	int m_CharCount;
+	float m_MaxCharacterHeight;
+	float m_LongestLineWidth;
+	float m_AlignedFontSize;
+};
+
 class CTextRender : public IEngineTextRender
 {
 	IGraphics *m_pGraphics;
 	IGraphics *Graphics() { return m_pGraphics; }
+	IStorage *m_pStorage;
+	IEngine *m_pEngine;
 
 	unsigned int m_RenderFlags;
 
@@ -227,6 +301,16 @@ class CTextRender : public IEngineTextRender
 
 	std::chrono::nanoseconds m_CursorRenderTime;
 
+	// layouts of recent TextEx calls, the most recently used first
+	enum
+	{
+		MAX_LAYOUT_CACHE_ENTRIES = 1024,
+	};
+	std::list<STextLayoutEntry> m_LayoutCache;
+	std::unordered_map<uint64_t, std::list<STextLayoutEntry>::iterator> m_LayoutCacheIndex;
+	int64_t m_LayoutCacheHits;
+	int64_t m_LayoutCacheMisses;
+
 	int GetFreeTextContainerIndex()
 	{
 		if(m_FirstFreeTextContainerIndex == -1)
@@ -298,7 +382,7 @@ class CTextRender : public IEngineTextRender
 		return m_RenderFlags;
 	}
 
-	void Grow(unsigned char *pIn, unsigned char *pOut, int w, int h, int OutlineCount)
+	static void Grow(const unsigned char *pIn, unsigned char *pOut, int w, int h, int OutlineCount)
 	{
 		for(int y = 0; y < h; y++)
 			for(int x = 0; x < w; x++)
@@ -364,10 +448,13 @@ class CTextRender : public IEngineTextRender
 		IncreaseFontTextureImpl(pFont, 0, NewDimensions);
 		IncreaseFontTextureImpl(pFont, 1, NewDimensions);
 
+		// the new textures are created with the complete data
 		InitTextures(NewDimensions, NewDimensions, pFont->m_aTextures, pFont->m_TextureData);
+		ResetDirtyRect(pFont, 0);
+		ResetDirtyRect(pFont, 1);
 	}
 
-	int AdjustOutlineThicknessToFontSize(int OutlineThickness, int FontSize)
+	static int AdjustOutlineThicknessToFontSize(int OutlineThickness, int FontSize)
 	{
 		if(FontSize > 48)
 			OutlineThickness *= 4;
@@ -385,12 +472,54 @@ class CTextRender : public IEngineTextRender
 				pFont->m_TextureData[TextureIndex][x + PosX + ((y + PosY) * pFont->m_CurTextureDimensions[TextureIndex])] = pData[x + y * Width];
 			}
 		}
-		Graphics()->UpdateTextTexture(pFont->m_aTextures[TextureIndex], PosX, PosY, Width, Height, pData);
+
+		// the texture is updated once before the next text is rendered
+		int *pDirty = pFont->m_aDirtyRect[TextureIndex];
+		if(pDirty[2] <= pDirty[0])
+		{
+			pDirty[0] = PosX;
+			pDirty[1] = PosY;
+			pDirty[2] = PosX + Width;
+			pDirty[3] = PosY + Height;
+		}
+		else
+		{
+			pDirty[0] = minimum(pDirty[0], PosX);
+			pDirty[1] = minimum(pDirty[1], PosY);
+			pDirty[2] = maximum(pDirty[2], PosX + Width);
+			pDirty[3] = maximum(pDirty[3], PosY + Height);
+		}
+	}
+
+	void FlushGlyphUploads(CFont *pFont)
+	{
+		for(int TextureIndex = 0; TextureIndex < 2; TextureIndex++)
+		{
+			int *pDirty = pFont->m_aDirtyRect[TextureIndex];
+			if(pDirty[2] <= pDirty[0])
+				continue;
+
+			const int Width = pDirty[2] - pDirty[0];
+			const int Height = pDirty[3] - pDirty[1];
+			const int Dimensions = pFont->m_CurTextureDimensions[TextureIndex];
+			m_vUploadBuffer.resize((size_t)Width * Height);
+			for(int y = 0; y < Height; ++y)
+				mem_copy(&m_vUploadBuffer[(size_t)y * Width], &pFont->m_TextureData[TextureIndex][pDirty[0] + (size_t)(y + pDirty[1]) * Dimensions], Width);
+			Graphics()->UpdateTextTexture(pFont->m_aTextures[TextureIndex], pDirty[0], pDirty[1], Width, Height, m_vUploadBuffer.data());
+			ResetDirtyRect(pFont, TextureIndex);
+		}
 	}
 
-	// 128k * 2 of data used for rendering glyphs
+	static void ResetDirtyRect(CFont *pFont, int TextureIndex)
+	{
+		for(int &Coord : pFont->m_aDirtyRect[TextureIndex])
+			Coord = 0;
+	}
+
+	std::vector<unsigned char> m_vUploadBuffer;
+
+	// 64k of data used for rendering entity layer glyphs
 	unsigned char ms_aGlyphData[(1024 / 4) * (1024 / 4)];
-	unsigned char ms_aGlyphDataOutlined[(1024 / 4) * (1024 / 4)];
 
 	bool GetCharacterSpace(CFont *pFont, int TextureIndex, int Width, int Height, int &PosX, int &PosY)
 	{
@@ -468,17 +597,14 @@ class CTextRender : public IEngineTextRender
 			return false;
 	}
 
-	void RenderGlyph(CFont *pFont, CFontSizeData *pSizeData, int Chr)
+	// only touches the given faces, so the background jobs can use it with their own freetype instance
+	static void RasterizeGlyph(FT_Face *pFaces, int NumFaces, int FontSize, int Chr, SRasterizedGlyph &Glyph)
 	{
-		FT_Bitmap *pBitmap;
+		Glyph.m_Chr = Chr;
+		Glyph.m_Valid = false;
 
-		int x = 0;
-		int y = 0;
-		unsigned int px, py;
-
-		FT_Face FtFace = pFont->m_FtFace;
-
-		FT_Set_Pixel_Sizes(FtFace, 0, pSizeData->m_FontSize);
+		FT_Face FtFace = pFaces[0];
+		FT_Set_Pixel_Sizes(FtFace, 0, FontSize);
 
 		FT_UInt GlyphIndex = 0;
 		if(FtFace->charmap)
@@ -486,10 +612,10 @@ class CTextRender : public IEngineTextRender
 
 		if(GlyphIndex == 0)
 		{
-			for(CFont::SFontFallBack &FallbackFont : pFont->m_vFtFallbackFonts)
+			for(int i = 1; i < NumFaces; i++)
 			{
-				FtFace = FallbackFont.m_FtFace;
-				FT_Set_Pixel_Sizes(FtFace, 0, pSizeData->m_FontSize);
+				FtFace = pFaces[i];
+				FT_Set_Pixel_Sizes(FtFace, 0, FontSize);
 
 				if(FtFace->charmap)
 					GlyphIndex = FT_Get_Char_Index(FtFace, (FT_ULong)Chr);
@@ -501,7 +627,7 @@ class CTextRender : public IEngineTextRender
 			if(GlyphIndex == 0)
 			{
 				const int ReplacementChr = 0x25a1; // White square to indicate missing glyph
-				FtFace = pFont->m_FtFace;
+				FtFace = pFaces[0];
 				GlyphIndex = FT_Get_Char_Index(FtFace, (FT_ULong)ReplacementChr);
 
 				if(GlyphIndex == 0)
@@ -518,16 +644,18 @@ class CTextRender : public IEngineTextRender
 			return;
 		}
 
-		pBitmap = &FtFace->glyph->bitmap;
+		FT_Bitmap *pBitmap = &FtFace->glyph->bitmap;
 
 		unsigned int RealWidth = pBitmap->width;
 		unsigned int RealHeight = pBitmap->rows;
 
 		// adjust spacing
 		int OutlineThickness = 0;
+		int x = 0;
+		int y = 0;
 		if(RealWidth > 0)
 		{
-			OutlineThickness = AdjustOutlineThicknessToFontSize(1, pSizeData->m_FontSize);
+			OutlineThickness = AdjustOutlineThicknessToFontSize(1, FontSize);
 
 			x += (OutlineThickness + 1);
 			y += (OutlineThickness + 1);
@@ -536,68 +664,178 @@ class CTextRender : public IEngineTextRender
 		unsigned int Width = RealWidth + x * 2;
 		unsigned int Height = RealHeight + y * 2;
 
-		int X = 0;
-		int Y = 0;
-
 		if(Width > 0 && Height > 0)
 		{
 			// prepare glyph data
-			mem_zero(ms_aGlyphData, Width * Height);
+			Glyph.m_vData.assign((size_t)Width * Height, 0);
+			for(unsigned py = 0; py < pBitmap->rows; py++)
+				for(unsigned px = 0; px < pBitmap->width; px++)
+					Glyph.m_vData[(py + y) * Width + px + x] = pBitmap->buffer[py * pBitmap->width + px];
+
+			Glyph.m_vDataOutlined.resize(Glyph.m_vData.size());
+			Grow(Glyph.m_vData.data(), Glyph.m_vDataOutlined.data(), Width, Height, OutlineThickness);
+		}
 
-			for(py = 0; py < pBitmap->rows; py++)
-				for(px = 0; px < pBitmap->width; px++)
-					ms_aGlyphData[(py + y) * Width + px + x] = pBitmap->buffer[py * pBitmap->width + px];
+		Glyph.m_Valid = true;
+		Glyph.m_GlyphIndex = GlyphIndex;
+		Glyph.m_Width = Width;
+		Glyph.m_Height = Height;
+		Glyph.m_CharWidth = RealWidth;
+		Glyph.m_CharHeight = RealHeight;
+		Glyph.m_OffsetX = (FtFace->glyph->metrics.horiBearingX >> 6);
+		Glyph.m_OffsetY = -((FtFace->glyph->metrics.height >> 6) - (FtFace->glyph->metrics.horiBearingY >> 6));
+		Glyph.m_AdvanceX = (FtFace->glyph->advance.x >> 6);
+	}
+
+	// rasterizes a batch of characters of one font size with a separate freetype instance
+	class CGlyphJob : public IJob
+	{
+		void Run() override
+		{
+			FT_Library Library;
+			if(FT_Init_FreeType(&Library))
+				return;
 
-			// upload the glyph
-			while(!GetCharacterSpace(pFont, 0, (int)Width, (int)Height, X, Y))
+			std::vector<FT_Face> vFaces;
+			for(const auto &Buffer : m_vFontBuffers)
 			{
-				IncreaseFontTexture(pFont);
+				FT_Face Face;
+				if(FT_New_Memory_Face(Library, (const FT_Byte *)Buffer.first, Buffer.second, 0, &Face) == 0)
+					vFaces.push_back(Face);
+			}
+
+			if(!vFaces.empty())
+			{
+				m_vGlyphs.resize(m_vChars.size());
+				for(size_t i = 0; i < m_vChars.size(); i++)
+					RasterizeGlyph(vFaces.data(), (int)vFaces.size(), m_FontSize, m_vChars[i], m_vGlyphs[i]);
 			}
-			UploadGlyph(pFont, 0, X, Y, (int)Width, (int)Height, ms_aGlyphData);
 
-			Grow(ms_aGlyphData, ms_aGlyphDataOutlined, Width, Height, OutlineThickness);
+			for(FT_Face Face : vFaces)
+				FT_Done_Face(Face);
+			FT_Done_FreeType(Library);
+		}
+
+	public:
+		CGlyphJob(CFont *pFont, int FontSize, std::vector<int> &&vChars) :
+			m_pFont(pFont), m_FontSize(FontSize), m_vChars(std::move(vChars))
+		{
+			// the font buffers stay alive until the text render is destroyed, which waits for the jobs
+			m_vFontBuffers.emplace_back(pFont->m_pBuf, pFont->m_Size);
+			for(const auto &FallbackFont : pFont->m_vFtFallbackFonts)
+				m_vFontBuffers.emplace_back(FallbackFont.m_pBuf, FallbackFont.m_Size);
+		}
+
+		CFont *m_pFont;
+		int m_FontSize;
+		std::vector<int> m_vChars;
+		std::vector<std::pair<const void *, size_t>> m_vFontBuffers;
+		std::vector<SRasterizedGlyph> m_vGlyphs;
+	};
+
+	std::vector<std::shared_ptr<CGlyphJob>> m_vpGlyphJobs;
+
+	void PlaceGlyph(CFont *pFont, CFontSizeData *pSizeData, const SRasterizedGlyph &Glyph)
+	{
+		SFontSizeChar *pFontchr = &pSizeData->m_Chars[Glyph.m_Chr];
+		if(!Glyph.m_Valid)
+			return;
+
+		int X = 0;
+		int Y = 0;
+		if(Glyph.m_Width > 0 && Glyph.m_Height > 0)
+		{
+			while(!GetCharacterSpace(pFont, 0, Glyph.m_Width, Glyph.m_Height, X, Y))
+			{
+				IncreaseFontTexture(pFont);
+			}
+			UploadGlyph(pFont, 0, X, Y, Glyph.m_Width, Glyph.m_Height, Glyph.m_vData.data());
 
-			while(!GetCharacterSpace(pFont, 1, (int)Width, (int)Height, X, Y))
+			while(!GetCharacterSpace(pFont, 1, Glyph.m_Width, Glyph.m_Height, X, Y))
 			{
 				IncreaseFontTexture(pFont);
 			}
-			UploadGlyph(pFont, 1, X, Y, (int)Width, (int)Height, ms_aGlyphDataOutlined);
+			UploadGlyph(pFont, 1, X, Y, Glyph.m_Width, Glyph.m_Height, Glyph.m_vDataOutlined.data());
 		}
 
 		// set char info
+		pFontchr->m_ID = Glyph.m_Chr;
+		pFontchr->m_Height = Glyph.m_Height;
+		pFontchr->m_Width = Glyph.m_Width;
+		pFontchr->m_CharHeight = Glyph.m_CharHeight;
+		pFontchr->m_CharWidth = Glyph.m_CharWidth;
+		pFontchr->m_OffsetX = Glyph.m_OffsetX;
+		pFontchr->m_OffsetY = Glyph.m_OffsetY;
+		pFontchr->m_AdvanceX = Glyph.m_AdvanceX;
+
+		pFontchr->m_aUVs[0] = X;
+		pFontchr->m_aUVs[1] = Y;
+		pFontchr->m_aUVs[2] = pFontchr->m_aUVs[0] + Glyph.m_Width;
+		pFontchr->m_aUVs[3] = pFontchr->m_aUVs[1] + Glyph.m_Height;
+		pFontchr->m_GlyphIndex = Glyph.m_GlyphIndex;
+
+		pFont->m_AtlasChanged = true;
+	}
+
+	void RenderGlyph(CFont *pFont, CFontSizeData *pSizeData, int Chr)
+	{
+		std::vector<FT_Face> vFaces;
+		vFaces.push_back(pFont->m_FtFace);
+		for(const auto &FallbackFont : pFont->m_vFtFallbackFonts)
+			vFaces.push_back(FallbackFont.m_FtFace);
+
+		SRasterizedGlyph Glyph;
+		RasterizeGlyph(vFaces.data(), (int)vFaces.size(), pSizeData->m_FontSize, Chr, Glyph);
+		PlaceGlyph(pFont, pSizeData, Glyph);
+	}
+
+	// moves the glyphs of finished background jobs into the atlas
+	void PlaceRasterizedGlyphs()
+	{
+		for(auto it = m_vpGlyphJobs.begin(); it != m_vpGlyphJobs.end();)
 		{
-			SFontSizeChar *pFontchr = &pSizeData->m_Chars[Chr];
-			int BMPHeight = pBitmap->rows + y * 2;
-			int BMPWidth = pBitmap->width + x * 2;
+			CGlyphJob *pJob = it->get();
+			if(pJob->Status() != IJob::STATE_DONE)
+			{
+				++it;
+				continue;
+			}
 
-			pFontchr->m_ID = Chr;
-			pFontchr->m_Height = Height;
-			pFontchr->m_Width = Width;
-			pFontchr->m_CharHeight = RealHeight;
-			pFontchr->m_CharWidth = RealWidth;
-			pFontchr->m_OffsetX = (FtFace->glyph->metrics.horiBearingX >> 6);
-			pFontchr->m_OffsetY = -((FtFace->glyph->metrics.height >> 6) - (FtFace->glyph->metrics.horiBearingY >> 6));
-			pFontchr->m_AdvanceX = (FtFace->glyph->advance.x >> 6);
+			CFontSizeData *pSizeData = pJob->m_pFont->GetFontSize(pJob->m_FontSize);
+			for(const auto &Glyph : pJob->m_vGlyphs)
+			{
+				// the character might have been needed before the job finished
+				if(pSizeData->m_Chars.find(Glyph.m_Chr) == pSizeData->m_Chars.end())
+					PlaceGlyph(pJob->m_pFont, pSizeData, Glyph);
+			}
+			for(int Chr : pJob->m_vChars)
+				pSizeData->m_QueuedChars.erase(Chr);
+			it = m_vpGlyphJobs.erase(it);
+		}
+	}
 
-			pFontchr->m_aUVs[0] = X;
-			pFontchr->m_aUVs[1] = Y;
-			pFontchr->m_aUVs[2] = pFontchr->m_aUVs[0] + BMPWidth;
-			pFontchr->m_aUVs[3] = pFontchr->m_aUVs[1] + BMPHeight;
-			pFontchr->m_GlyphIndex = GlyphIndex;
+	void WaitForGlyphJobs()
+	{
+		for(auto &pJob : m_vpGlyphJobs)
+		{
+			while(pJob->Status() != IJob::STATE_DONE)
+				thread_yield();
 		}
+		m_vpGlyphJobs.clear();
 	}
 
 	SFontSizeChar *GetChar(CFont *pFont, CFontSizeData *pSizeData, int Chr)
 	{
+		if(!pFont->m_AtlasCacheLoaded)
+			LoadAtlasCache(pFont);
+
 		std::map<int, SFontSizeChar>::iterator it = pSizeData->m_Chars.find(Chr);
 		if(it == pSizeData->m_Chars.end())
 		{
 			// render and add character
-			SFontSizeChar &FontSizeChr = pSizeData->m_Chars[Chr];
-
 			RenderGlyph(pFont, pSizeData, Chr);
 
-			return &FontSizeChr;
+			return &pSizeData->m_Chars[Chr];
 		}
 		else
 		{
@@ -605,17 +843,136 @@ class CTextRender : public IEngineTextRender
 		}
 	}
 
-	float Kerning(CFont *pFont, FT_UInt GlyphIndexLeft, FT_UInt GlyphIndexRight)
+	float Kerning(CFont *pFont, CFontSizeData *pSizeData, FT_UInt GlyphIndexLeft, FT_UInt GlyphIndexRight)
 	{
+		const uint64_t Key = ((uint64_t)GlyphIndexLeft << 32) | GlyphIndexRight;
+		auto it = pSizeData->m_Kerning.find(Key);
+		if(it != pSizeData->m_Kerning.end())
+			return it->second;
+
 		FT_Vector Kerning = {0, 0};
+		FT_Set_Pixel_Sizes(pFont->m_FtFace, 0, pSizeData->m_FontSize);
 		FT_Get_Kerning(pFont->m_FtFace, GlyphIndexLeft, GlyphIndexRight, FT_KERNING_DEFAULT, &Kerning);
-		return (Kerning.x >> 6);
+		const float Result = (Kerning.x >> 6);
+		pSizeData->m_Kerning.emplace(Key, Result);
+		return Result;
+	}
+
+	// the atlas cache is keyed by the content of the font files
+	static unsigned AtlasCacheKey(const CFont *pFont)
+	{
+		uLong Key = crc32(0L, Z_NULL, 0);
+		Key = crc32(Key, (const Bytef *)pFont->m_pBuf, pFont->m_Size);
+		for(const auto &FallbackFont : pFont->m_vFtFallbackFonts)
+			Key = crc32(Key, (const Bytef *)FallbackFont.m_pBuf, FallbackFont.m_Size);
+		return (unsigned)Key;
+	}
+
+	void LoadAtlasCache(CFont *pFont)
+	{
+		pFont->m_AtlasCacheLoaded = true;
+		if(!m_pStorage)
+			return;
+
+		// glyphs that were placed in the meantime would be overwritten
+		for(const auto &SizeData : pFont->m_aFontSizes)
+		{
+			if(!SizeData.m_Chars.empty())
+				return;
+		}
+
+		const unsigned Key = AtlasCacheKey(pFont);
+		char aPath[IO_MAX_PATH_LENGTH];
+		str_format(aPath, sizeof(aPath), "fontcache/%08x.atlas", Key);
+
+		void *pFileData;
+		unsigned FileSize;
+		if(!m_pStorage->ReadFile(aPath, IStorage::TYPE_SAVE, &pFileData, &FileSize))
+			return;
+
+		CAtlasCache Cache;
+		const bool Valid = Cache.Deserialize(pFileData, FileSize, Key, pFont->m_CurTextureDimensions[0]);
+		free(pFileData);
+		if(!Valid)
+		{
+			dbg_msg("textrender", "ignoring invalid atlas cache '%s'", aPath);
+			return;
+		}
+
+		const size_t Dimensions = Cache.m_Dimensions;
+		if(Cache.m_Dimensions != pFont->m_CurTextureDimensions[0])
+		{
+			UnloadTextures(pFont->m_aTextures);
+			for(int i = 0; i < 2; i++)
+			{
+				delete[] pFont->m_TextureData[i];
+				pFont->m_TextureData[i] = new unsigned char[Dimensions * Dimensions];
+				pFont->m_CurTextureDimensions[i] = Dimensions;
+			}
+		}
+		for(int i = 0; i < 2; i++)
+		{
+			mem_copy(pFont->m_TextureData[i], Cache.m_avPixels[i].data(), Dimensions * Dimensions);
+			pFont->m_TextureSkyline[i].m_vCurHeightOfPixelColumn = std::move(Cache.m_avSkyline[i]);
+		}
+		for(const auto &Char : Cache.m_vChars)
+			pFont->GetFontSize(Char.m_FontSize)->m_Chars[Char.m_Char.m_ID] = Char.m_Char;
+
+		if(!pFont->m_aTextures[0].IsValid())
+			InitTextures(Dimensions, Dimensions, pFont->m_aTextures, pFont->m_TextureData);
+		else
+		{
+			for(int i = 0; i < 2; i++)
+				Graphics()->UpdateTextTexture(pFont->m_aTextures[i], 0, 0, Dimensions, Dimensions, pFont->m_TextureData[i]);
+		}
+		ResetDirtyRect(pFont, 0);
+		ResetDirtyRect(pFont, 1);
+		pFont->m_AtlasChanged = false;
+
+		dbg_msg("textrender", "loaded %d glyphs from atlas cache '%s'", (int)Cache.m_vChars.size(), aPath);
+	}
+
+	void SaveAtlasCache(CFont *pFont)
+	{
+		if(!m_pStorage || !pFont->m_AtlasCacheLoaded || !pFont->m_AtlasChanged || pFont->m_CurTextureDimensions[0] > CAtlasCache::MAX_DIMENSIONS)
+			return;
+
+		CAtlasCache Cache;
+		Cache.m_FontKey = AtlasCacheKey(pFont);
+		Cache.m_Dimensions = pFont->m_CurTextureDimensions[0];
+		const size_t Dimensions = Cache.m_Dimensions;
+		for(int i = 0; i < 2; i++)
+		{
+			Cache.m_avPixels[i].assign(pFont->m_TextureData[i], pFont->m_TextureData[i] + Dimensions * Dimensions);
+			Cache.m_avSkyline[i] = pFont->m_TextureSkyline[i].m_vCurHeightOfPixelColumn;
+		}
+		for(const auto &SizeData : pFont->m_aFontSizes)
+		{
+			for(const auto &Char : SizeData.m_Chars)
+				Cache.m_vChars.push_back({SizeData.m_FontSize, Char.second});
+		}
+
+		std::vector<unsigned char> vData;
+		if(!Cache.Serialize(&vData))
+			return;
+
+		char aPath[IO_MAX_PATH_LENGTH];
+		str_format(aPath, sizeof(aPath), "fontcache/%08x.atlas", Cache.m_FontKey);
+		m_pStorage->CreateFolder("fontcache", IStorage::TYPE_SAVE);
+		IOHANDLE File = m_pStorage->OpenFile(aPath, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		if(!File)
+			return;
+		io_write(File, vData.data(), vData.size());
+		io_close(File);
+		pFont->m_AtlasChanged = false;
 	}
 
 public:
 	CTextRender()
 	{
 		m_pGraphics = 0;
+		m_pStorage = 0;
+		m_pEngine = 0;
 
 		m_Color = DefaultTextColor();
 		m_OutlineColor = DefaultTextOutlineColor();
@@ -627,10 +984,15 @@ public:
 
 		m_RenderFlags = 0;
 		m_CursorRenderTime = time_get_nanoseconds();
+
+		m_LayoutCacheHits = 0;
+		m_LayoutCacheMisses = 0;
 	}
 
 	virtual ~CTextRender()
 	{
+		WaitForGlyphJobs();
+
 		for(auto *pTextCont : m_vpTextContainers)
 		{
 			pTextCont->Reset();
@@ -657,6 +1019,8 @@ public:
 	void Init() override
 	{
 		m_pGraphics = Kernel()->RequestInterface<IGraphics>();
+		m_pStorage = Kernel()->RequestInterface<IStorage>();
+		m_pEngine = Kernel()->RequestInterface<IEngine>();
 		FT_Init_FreeType(&m_FTLibrary);
 		// print freetype version
 		{
@@ -693,10 +1057,9 @@ public:
 		pAttr->m_pOffset = (void *)(sizeof(float) * 2 + sizeof(float) * 2);
 		pAttr->m_Type = GRAPHICS_TYPE_UNSIGNED_BYTE;
 
-		IStorage *pStorage = Kernel()->RequestInterface<IStorage>();
 		char aFilename[IO_MAX_PATH_LENGTH];
 		const char *pFontFile = "fonts/Icons.otf";
-		IOHANDLE File = pStorage->OpenFile(pFontFile, IOFLAG_READ, IStorage::TYPE_ALL, aFilename, sizeof(aFilename));
+		IOHANDLE File = m_pStorage->OpenFile(pFontFile, IOFLAG_READ, IStorage::TYPE_ALL, aFilename, sizeof(aFilename));
 		if(File)
 		{
 			void *pBuf;
@@ -722,6 +1085,7 @@ public:
 		dbg_msg("textrender", "loaded pFont from '%s'", pFilename);
 
 		pFont->m_pBuf = (void *)pBuf;
+		pFont->m_Size = Size;
 		pFont->m_CurTextureDimensions[0] = 1024;
 		pFont->m_TextureData[0] = new unsigned char[pFont->m_CurTextureDimensions[0] * pFont->m_CurTextureDimensions[0]];
 		mem_zero(pFont->m_TextureData[0], (size_t)pFont->m_CurTextureDimensions[0] * pFont->m_CurTextureDimensions[0] * sizeof(unsigned char));
@@ -733,6 +1097,10 @@ public:
 
 		pFont->m_TextureSkyline[0].m_vCurHeightOfPixelColumn.resize(pFont->m_CurTextureDimensions[0], 0);
 		pFont->m_TextureSkyline[1].m_vCurHeightOfPixelColumn.resize(pFont->m_CurTextureDimensions[1], 0);
+		ResetDirtyRect(pFont, 0);
+		ResetDirtyRect(pFont, 1);
+		pFont->m_AtlasCacheLoaded = false;
+		pFont->m_AtlasChanged = false;
 
 		pFont->InitFontSizes();
 
@@ -745,12 +1113,14 @@ public:
 	{
 		CFont::SFontFallBack FallbackFont;
 		FallbackFont.m_pBuf = (void *)pBuf;
+		FallbackFont.m_Size = Size;
 		str_copy(FallbackFont.m_aFilename, pFilename, sizeof(FallbackFont.m_aFilename));
 
 		if(FT_New_Memory_Face(m_FTLibrary, pBuf, Size, 0, &FallbackFont.m_FtFace) == 0)
 		{
 			dbg_msg("textrender", "loaded fallback font from '%s'", pFilename);
 			pFont->m_vFtFallbackFonts.emplace_back(FallbackFont);
+			ClearLayoutCache();
 
 			return true;
 		}
@@ -780,6 +1150,8 @@ public:
 	void SetDefaultFont(CFont *pFont) override
 	{
 		dbg_msg("textrender", "default pFont set %p", pFont);
+		if(pFont != m_pDefaultFont)
+			ClearLayoutCache();
 		m_pDefaultFont = pFont;
 		m_pCurFont = m_pDefaultFont;
 	}
@@ -905,7 +1277,74 @@ public:
 	ColorRGBA GetTextOutlineColor() override { return m_OutlineColor; }
 	ColorRGBA GetTextSelectionColor() override { return m_SelectionColor; }
 
-	void TextEx(CTextCursor *pCursor, const char *pText, int Length) override
+	// layouts that depend on the mouse can't be reused, invisible text has no quads
+	bool LayoutParams(const CTextCursor *pCursor, STextLayoutParams &Params)
+	{
+		if(pCursor->m_CalculateSelectionMode != TEXT_CURSOR_SELECTION_MODE_NONE || pCursor->m_CursorMode != TEXT_CURSOR_CURSOR_MODE_NONE)
+			return false;
+		if((pCursor->m_Flags & TEXTFLAG_RENDER) && m_Color.a == 0.0f)
+			return false;
+
+		// zeroed so the padding can be hashed and compared
+		mem_zero(&Params, sizeof(Params));
+		Params.m_pFont = pCursor->m_pFont ? pCursor->m_pFont : m_pCurFont;
+		if(!Params.m_pFont)
+			return false;
+
+		Params.m_FontSize = pCursor->m_FontSize;
+		Params.m_Flags = pCursor->m_Flags;
+		Params.m_LineCount = pCursor->m_LineCount;
+		Params.m_GlyphCount = pCursor->m_GlyphCount;
+		Params.m_CharCount = pCursor->m_CharCount;
+		Params.m_MaxLines = pCursor->m_MaxLines;
+		Params.m_StartX = pCursor->m_StartX - pCursor->m_X;
+		Params.m_StartY = pCursor->m_StartY - pCursor->m_Y;
+		Params.m_LineWidth = pCursor->m_LineWidth;
+		Params.m_MaxCharacterHeight = pCursor->m_MaxCharacterHeight;
+		Params.m_LongestLineWidth = pCursor->m_LongestLineWidth;
+		Params.m_RenderFlags = m_RenderFlags;
+		float aScreen[4];
+		Graphics()->GetScreen(&aScreen[0], &aScreen[1], &aScreen[2], &aScreen[3]);
+		Params.m_aScreenSize[0] = aScreen[2] - aScreen[0];
+		Params.m_aScreenSize[1] = aScreen[3] - aScreen[1];
+		Params.m_ScreenWidth = Graphics()->ScreenWidth();
+		Params.m_ScreenHeight = Graphics()->ScreenHeight();
+		return true;
+	}
+
+	void ClearLayoutCache()
+	{
+		for(auto &Entry : m_LayoutCache)
+		{
+			if(Entry.m_TextContainerIndex != -1)
+				DeleteTextContainer(Entry.m_TextContainerIndex);
+		}
+		m_LayoutCache.clear();
+		m_LayoutCacheIndex.clear();
+	}
+
+	void RemoveLayoutCacheEntry(std::list<STextLayoutEntry>::iterator it)
+	{
+		if(it->m_TextContainerIndex != -1)
+			DeleteTextContainer(it->m_TextContainerIndex);
+		auto IndexIt = m_LayoutCacheIndex.find(it->m_Hash);
+		if(IndexIt != m_LayoutCacheIndex.end() && IndexIt->second == it)
+			m_LayoutCacheIndex.erase(IndexIt);
+		m_LayoutCache.erase(it);
+	}
+
+	std::list<STextLayoutEntry>::iterator AddLayoutCacheEntry(STextLayoutEntry &&Entry)
+	{
+		// the layout of the words might have taken the slot
+		auto IndexIt = m_LayoutCacheIndex.find(Entry.m_Hash);
+		if(IndexIt != m_LayoutCacheIndex.end())
+			RemoveLayoutCacheEntry(IndexIt->second);
+		m_LayoutCache.push_front(std::move(Entry));
+		m_LayoutCacheIndex[m_LayoutCache.front().m_Hash] = m_LayoutCache.begin();
+		return m_LayoutCache.begin();
+	}
+
+	void TextExOneTimeUse(CTextCursor *pCursor, const char *pText, int Length)
 	{
 		int OldRenderFlags = m_RenderFlags;
 		m_RenderFlags |= TEXT_RENDER_FLAG_ONE_TIME_USE;
@@ -923,6 +1362,112 @@ public:
 		}
 	}
 
+	void TextEx(CTextCursor *pCursor, const char *pText, int Length) override
+	{
+		if(Length < 0)
+			Length = str_length(pText);
+
+		STextLayoutParams Params;
+		if(!LayoutParams(pCursor, Params))
+		{
+			TextExOneTimeUse(pCursor, pText, Length);
+			return;
+		}
+
+		const std::string_view Text(pText, Length);
+		const uint64_t Hash = std::hash<std::string_view>()(std::string_view((const char *)&Params, sizeof(Params))) * 31 + std::hash<std::string_view>()(Text);
+		const float StartX = pCursor->m_X;
+		const float StartY = pCursor->m_Y;
+
+		std::list<STextLayoutEntry>::iterator Entry;
+		auto IndexIt = m_LayoutCacheIndex.find(Hash);
+		if(IndexIt != m_LayoutCacheIndex.end() && mem_comp(&IndexIt->second->m_Params, &Params, sizeof(Params)) == 0 && IndexIt->second->m_Text == Text)
+		{
+			m_LayoutCacheHits++;
+			Entry = IndexIt->second;
+			m_LayoutCache.splice(m_LayoutCache.begin(), m_LayoutCache, Entry);
+		}
+		else
+		{
+			m_LayoutCacheMisses++;
+			if(IndexIt != m_LayoutCacheIndex.end())
+				RemoveLayoutCacheEntry(IndexIt->second);
+			else if(m_LayoutCache.size() >= MAX_LAYOUT_CACHE_ENTRIES)
+				RemoveLayoutCacheEntry(std::prev(m_LayoutCache.end()));
+
+			// most text is only shown once, so only the layout is remembered for now
+			CTextCursor Cursor = *pCursor;
+			TextExOneTimeUse(&Cursor, pText, Length);
+
+			STextLayoutEntry NewEntry;
+			NewEntry.m_Hash = Hash;
+			NewEntry.m_Params = Params;
+			NewEntry.m_Text = Text;
+			NewEntry.m_TextContainerIndex = -1;
+			NewEntry.m_Retained = false;
+			NewEntry.m_OriginX = StartX;
+			NewEntry.m_OriginY = StartY;
+			NewEntry.m_X = Cursor.m_X - StartX;
+			NewEntry.m_Y = Cursor.m_Y - StartY;
+			NewEntry.m_Flags = Cursor.m_Flags;
+			NewEntry.m_LineCount = Cursor.m_LineCount;
+			NewEntry.m_GlyphCount = Cursor.m_GlyphCount;
+			NewEntry.m_CharCount = Cursor.m_CharCount;
+			NewEntry.m_MaxCharacterHeight = Cursor.m_MaxCharacterHeight;
+			NewEntry.m_LongestLineWidth = Cursor.m_LongestLineWidth;
+			NewEntry.m_AlignedFontSize = Cursor.m_AlignedFontSize;
+			AddLayoutCacheEntry(std::move(NewEntry));
+
+			*pCursor = Cursor;
+			return;
+		}
+
+		// used again, keep the quads with a neutral color from now on. The entry is
+		// taken out meanwhile, because the layout of the words goes through the cache
+		if(!Entry->m_Retained && (pCursor->m_Flags & TEXTFLAG_RENDER))
+		{
+			STextLayoutEntry UsedEntry = std::move(*Entry);
+			RemoveLayoutCacheEntry(Entry);
+
+			const ColorRGBA OldColor = m_Color;
+			m_Color = DefaultTextColor();
+			CTextCursor Cursor = *pCursor;
+			UsedEntry.m_TextContainerIndex = CreateTextContainer(&Cursor, pText, Length);
+			m_Color = OldColor;
+			UsedEntry.m_OriginX = StartX;
+			UsedEntry.m_OriginY = StartY;
+			UsedEntry.m_Retained = true;
+			Entry = AddLayoutCacheEntry(std::move(UsedEntry));
+		}
+
+		pCursor->m_X = StartX + Entry->m_X;
+		pCursor->m_Y = StartY + Entry->m_Y;
+		pCursor->m_Flags = Entry->m_Flags;
+		pCursor->m_LineCount = Entry->m_LineCount;
+		pCursor->m_GlyphCount = Entry->m_GlyphCount;
+		pCursor->m_CharCount = Entry->m_CharCount;
+		pCursor->m_MaxCharacterHeight = Entry->m_MaxCharacterHeight;
+		pCursor->m_LongestLineWidth = Entry->m_LongestLineWidth;
+		pCursor->m_AlignedFontSize = Entry->m_AlignedFontSize;
+
+		if(Entry->m_TextContainerIndex != -1)
+		{
+			STextRenderColor TextColor = m_Color;
+			STextRenderColor TextColorOutline = DefaultTextOutlineColor();
+			// without text buffering the outline is tinted by the vertex colors
+			if(!Graphics()->IsTextBufferingEnabled())
+				TextColorOutline.m_A *= m_Color.a;
+			RenderTextContainer(Entry->m_TextContainerIndex, &TextColor, &TextColorOutline, StartX - Entry->m_OriginX, StartY - Entry->m_OriginY);
+		}
+	}
+
+	void GetLayoutCacheStats(int64_t &Hits, int64_t &Misses, int &Entries) override
+	{
+		Hits = m_LayoutCacheHits;
+		Misses = m_LayoutCacheMisses;
+		Entries = m_LayoutCache.size();
+	}
+
 	int CreateTextContainer(CTextCursor *pCursor, const char *pText, int Length = -1) override
 	{
 		CFont *pFont = pCursor->m_pFont;
@@ -934,6 +1479,8 @@ public:
 		if(!pFont)
 			return -1;
 
+		PlaceRasterizedGlyphs();
+
 		bool IsRendered = (pCursor->m_Flags & TEXTFLAG_RENDER) != 0;
 
 		int ContainerIndex = GetFreeTextContainerIndex();
@@ -1254,7 +1801,7 @@ public:
 
 					float CharKerning = 0.f;
 					if((RenderFlags & TEXT_RENDER_FLAG_KERNING) != 0)
-						CharKerning = Kerning(TextContainer.m_pFont, LastCharGlyphIndex, pChr->m_GlyphIndex) * Scale * Size;
+						CharKerning = Kerning(TextContainer.m_pFont, pSizeData, LastCharGlyphIndex, pChr->m_GlyphIndex) * Scale * Size;
 					LastCharGlyphIndex = pChr->m_GlyphIndex;
 
 					if(pEllipsisChr != nullptr && pCursor->m_Flags & TEXTFLAG_ELLIPSIS_AT_END && pCurrent < pBatchEnd && pCurrent != pEllipsis)
@@ -1263,7 +1810,7 @@ public:
 						float CharKerningEllipsis = 0.f;
 						if((RenderFlags & TEXT_RENDER_FLAG_KERNING) != 0)
 						{
-							CharKerningEllipsis = Kerning(TextContainer.m_pFont, pChr->m_GlyphIndex, pEllipsisChr->m_GlyphIndex) * Scale * Size;
+							CharKerningEllipsis = Kerning(TextContainer.m_pFont, pSizeData, pChr->m_GlyphIndex, pEllipsisChr->m_GlyphIndex) * Scale * Size;
 						}
 						if(DrawX + CharKerning + Advance + CharKerningEllipsis + AdvanceEllipsis - pCursor->m_StartX > pCursor->m_LineWidth)
 						{
@@ -1577,6 +2124,8 @@ public:
 		STextContainer &TextContainer = GetTextContainer(TextContainerIndex);
 		CFont *pFont = TextContainer.m_pFont;
 
+		FlushGlyphUploads(pFont);
+
 		if(TextContainer.m_StringInfo.m_SelectionQuadContainerIndex != -1)
 		{
 			if(TextContainer.m_HasSelection)
@@ -1939,6 +2488,9 @@ public:
 
 	void OnWindowResize() override
 	{
+		// the cached layouts reference glyphs of the old atlas
+		ClearLayoutCache();
+
 		bool HasNonEmptyTextContainer = false;
 		for(auto *pTextContainer : m_vpTextContainers)
 		{
@@ -1953,6 +2505,8 @@ public:
 
 		for(auto &pFont : m_vpFonts)
 		{
+			SaveAtlasCache(pFont);
+
 			// reset the skylines
 			for(int j = 0; j < 2; ++j)
 			{
@@ -1961,11 +2515,60 @@ public:
 
 				mem_zero(pFont->m_TextureData[j], (size_t)pFont->m_CurTextureDimensions[j] * pFont->m_CurTextureDimensions[j] * sizeof(unsigned char));
 				Graphics()->UpdateTextTexture(pFont->m_aTextures[j], 0, 0, pFont->m_CurTextureDimensions[j], pFont->m_CurTextureDimensions[j], pFont->m_TextureData[j]);
+				ResetDirtyRect(pFont, j);
 			}
 
 			pFont->InitFontSizes();
+			pFont->m_AtlasCacheLoaded = false;
 		}
 	}
+
+	bool PrepareGlyphs(const char *pText, float FontSize) override
+	{
+		CFont *pFont = m_pCurFont;
+		if(!pFont || !m_pEngine)
+			return true;
+
+		if(!pFont->m_AtlasCacheLoaded)
+			LoadAtlasCache(pFont);
+		PlaceRasterizedGlyphs();
+
+		// same size calculation as for text containers
+		float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
+		Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
+		float FakeToScreenY = (Graphics()->ScreenHeight() / (ScreenY1 - ScreenY0));
+		CFontSizeData *pSizeData = pFont->GetFontSize((int)(FontSize * FakeToScreenY));
+
+		bool Ready = true;
+		std::vector<int> vChars;
+		const char *pCurrent = pText;
+		while(*pCurrent)
+		{
+			int Chr = str_utf8_decode(&pCurrent);
+			if(Chr <= 0 || Chr == '\n' || pSizeData->m_Chars.find(Chr) != pSizeData->m_Chars.end())
+				continue;
+
+			Ready = false;
+			if(pSizeData->m_QueuedChars.insert(Chr).second)
+				vChars.push_back(Chr);
+		}
+
+		if(!vChars.empty())
+		{
+			std::shared_ptr<CGlyphJob> pJob = std::make_shared<CGlyphJob>(pFont, pSizeData->m_FontSize, std::move(vChars));
+			m_pEngine->AddJob(pJob);
+			m_vpGlyphJobs.push_back(pJob);
+		}
+		return Ready;
+	}
+
+	void Shutdown() override
+	{
+		ClearLayoutCache();
+		WaitForGlyphJobs();
+		for(auto &pFont : m_vpFonts)
+			SaveAtlasCache(pFont);
+	}
 };
 
 IEngineTextRender *CreateEngineTextRender() { return new CTextRender; }
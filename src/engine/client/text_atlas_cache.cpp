@@ -0,0 +1,112 @@
+#include "text_atlas_cache.h"
+
+#include <base/system.h>
+
+#include <zlib.h>
+
+struct SAtlasCacheHeader
+{
+	char m_aMagic[4];
+	int m_Version;
+	unsigned m_FontKey;
+	int m_Dimensions;
+	int m_aCompressedSize[2];
+	int m_NumChars;
+};
+
+static const char s_aAtlasCacheMagic[4] = {'F', 'A', 'T', 'L'};
+
+bool CAtlasCache::Serialize(std::vector<unsigned char> *pvData) const
+{
+	const size_t Dimensions = m_Dimensions;
+	SAtlasCacheHeader Header;
+	mem_copy(Header.m_aMagic, s_aAtlasCacheMagic, sizeof(Header.m_aMagic));
+	Header.m_Version = VERSION;
+	Header.m_FontKey = m_FontKey;
+	Header.m_Dimensions = m_Dimensions;
+	Header.m_NumChars = m_vChars.size();
+
+	std::vector<unsigned char> avCompressed[2];
+	for(int i = 0; i < 2; i++)
+	{
+		if(m_avPixels[i].size() != Dimensions * Dimensions || m_avSkyline[i].size() != Dimensions)
+			return false;
+		uLongf CompressedSize = compressBound(Dimensions * Dimensions);
+		avCompressed[i].resize(CompressedSize);
+		if(compress2(avCompressed[i].data(), &CompressedSize, m_avPixels[i].data(), Dimensions * Dimensions, Z_BEST_SPEED) != Z_OK)
+			return false;
+		avCompressed[i].resize(CompressedSize);
+		Header.m_aCompressedSize[i] = CompressedSize;
+	}
+
+	pvData->clear();
+	pvData->insert(pvData->end(), (const unsigned char *)&Header, (const unsigned char *)(&Header + 1));
+	for(const auto &vCompressed : avCompressed)
+		pvData->insert(pvData->end(), vCompressed.begin(), vCompressed.end());
+	for(const auto &vSkyline : m_avSkyline)
+		pvData->insert(pvData->end(), (const unsigned char *)vSkyline.data(), (const unsigned char *)(vSkyline.data() + vSkyline.size()));
+	pvData->insert(pvData->end(), (const unsigned char *)m_vChars.data(), (const unsigned char *)(m_vChars.data() + m_vChars.size()));
+	return true;
+}
+
+bool CAtlasCache::Deserialize(const void *pData, size_t DataSize, unsigned FontKey, int MinDimensions)
+{
+	const unsigned char *pBytes = (const unsigned char *)pData;
+	SAtlasCacheHeader Header;
+	if(DataSize < sizeof(Header))
+		return false;
+	mem_copy(&Header, pBytes, sizeof(Header));
+	if(mem_comp(Header.m_aMagic, s_aAtlasCacheMagic, sizeof(Header.m_aMagic)) != 0 || Header.m_Version != VERSION || Header.m_FontKey != FontKey ||
+		Header.m_Dimensions < MinDimensions || Header.m_Dimensions <= 0 || Header.m_Dimensions > MAX_DIMENSIONS || (Header.m_Dimensions & (Header.m_Dimensions - 1)) != 0 ||
+		Header.m_aCompressedSize[0] <= 0 || Header.m_aCompressedSize[1] <= 0 || Header.m_NumChars < 0)
+		return false;
+
+	const size_t Dimensions = Header.m_Dimensions;
+	const size_t SkylineOffset = sizeof(Header) + (size_t)Header.m_aCompressedSize[0] + Header.m_aCompressedSize[1];
+	const size_t CharsOffset = SkylineOffset + 2 * Dimensions * sizeof(int);
+	if(DataSize != CharsOffset + (size_t)Header.m_NumChars * sizeof(SChar))
+		return false;
+
+	std::vector<unsigned char> avPixels[2];
+	std::vector<int> avSkyline[2];
+	size_t CompressedOffset = sizeof(Header);
+	for(int i = 0; i < 2; i++)
+	{
+		avPixels[i].resize(Dimensions * Dimensions);
+		uLongf PixelsSize = avPixels[i].size();
+		if(uncompress(avPixels[i].data(), &PixelsSize, pBytes + CompressedOffset, Header.m_aCompressedSize[i]) != Z_OK || PixelsSize != avPixels[i].size())
+			return false;
+		CompressedOffset += Header.m_aCompressedSize[i];
+
+		avSkyline[i].resize(Dimensions);
+		mem_copy(avSkyline[i].data(), pBytes + SkylineOffset + i * Dimensions * sizeof(int), Dimensions * sizeof(int));
+		for(int Height : avSkyline[i])
+		{
+			if(Height < 0 || Height > Header.m_Dimensions)
+				return false;
+		}
+	}
+
+	// comparisons are written so that NaN fails them
+	std::vector<SChar> vChars(Header.m_NumChars);
+	mem_copy(vChars.data(), pBytes + CharsOffset, vChars.size() * sizeof(SChar));
+	for(const SChar &Char : vChars)
+	{
+		if(Char.m_FontSize < MIN_FONT_SIZE || Char.m_FontSize > MAX_FONT_SIZE)
+			return false;
+		const float *pUVs = Char.m_Char.m_aUVs;
+		if(!(pUVs[0] >= 0.0f && pUVs[0] <= pUVs[2] && pUVs[2] <= Header.m_Dimensions &&
+			   pUVs[1] >= 0.0f && pUVs[1] <= pUVs[3] && pUVs[3] <= Header.m_Dimensions))
+			return false;
+	}
+
+	m_FontKey = FontKey;
+	m_Dimensions = Header.m_Dimensions;
+	for(int i = 0; i < 2; i++)
+	{
+		m_avPixels[i] = std::move(avPixels[i]);
+		m_avSkyline[i] = std::move(avSkyline[i]);
+	}
+	m_vChars = std::move(vChars);
+	return true;
+}
@@ -0,0 +1,63 @@
+#ifndef ENGINE_CLIENT_TEXT_ATLAS_CACHE_H
+#define ENGINE_CLIENT_TEXT_ATLAS_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#define MIN_FONT_SIZE 6
+#define MAX_FONT_SIZE 128
+#define NUM_FONT_SIZES MAX_FONT_SIZE - MIN_FONT_SIZE + 1
+
+struct SFontSizeChar
+{
+	int m_ID;
+
+	// these values are scaled to the pFont size
+	// width * font_size == real_size
+	float m_Width;
+	float m_Height;
+	float m_CharWidth;
+	float m_CharHeight;
+	float m_OffsetX;
+	float m_OffsetY;
+	float m_AdvanceX;
+
+	// in pixels of the atlas
+	float m_aUVs[4];
+	int64_t m_TouchTime;
+	unsigned m_GlyphIndex; // FT_UInt
+};
+
+// rasterized atlases are kept between sessions, keyed by the content of the font files
+class CAtlasCache
+{
+public:
+	enum
+	{
+		VERSION = 1,
+		MAX_DIMENSIONS = 8192,
+	};
+
+	struct SChar
+	{
+		int m_FontSize;
+		SFontSizeChar m_Char;
+	};
+
+	unsigned m_FontKey = 0;
+	// width and height of both atlases
+	int m_Dimensions = 0;
+	std::vector<unsigned char> m_avPixels[2];
+	std::vector<int> m_avSkyline[2];
+	std::vector<SChar> m_vChars;
+
+	bool Serialize(std::vector<unsigned char> *pvData) const;
+
+	// fails if the data is not a complete cache for the font with at least the given
+	// dimensions, or if anything in it lies outside of the atlas
+	bool Deserialize(const void *pData, size_t DataSize, unsigned FontKey, int MinDimensions);
+};
+
+#endif
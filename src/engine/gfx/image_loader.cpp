@@ -1,6 +1,8 @@
 #include "image_loader.h"
+#include "image_manipulation.h"
 #include <base/log.h>
 #include <base/system.h>
+#include <engine/storage.h>
 #include <cstdlib>
 
 #include <png.h>
@@ -275,6 +277,37 @@ static int ImageLoaderHelperFormatToColorChannel(EImageFormat Format)
 	return 4;
 }
 
+bool LoadPNGAsRGBA(IStorage *pStorage, const char *pFileName, int StorageType, int &Width, int &Height, uint8_t *&pRGBAData, EImageFormat &SourceFormat)
+{
+	void *pFileData;
+	unsigned FileSize;
+	if(!pStorage->ReadFile(pFileName, StorageType, &pFileData, &FileSize))
+	{
+		dbg_msg("game/png", "failed to open file. filename='%s'", pFileName);
+		return false;
+	}
+	TImageByteBuffer ByteBuffer((uint8_t *)pFileData, (uint8_t *)pFileData + FileSize);
+	free(pFileData);
+
+	SImageByteBuffer ImageByteBuffer(&ByteBuffer);
+	uint8_t *pImage = nullptr;
+	if(!LoadPNG(ImageByteBuffer, pFileName, Width, Height, pImage, SourceFormat))
+	{
+		dbg_msg("game/png", "image had unsupported image format. filename='%s'", pFileName);
+		return false;
+	}
+	if((SourceFormat != IMAGE_FORMAT_RGB && SourceFormat != IMAGE_FORMAT_RGBA) || Width <= 0 || Height <= 0)
+	{
+		free(pImage);
+		return false;
+	}
+
+	pRGBAData = (uint8_t *)malloc((size_t)Width * Height * 4);
+	ConvertToRGBA(pRGBAData, pImage, Width, Height, SourceFormat == IMAGE_FORMAT_RGBA ? 4 : 3);
+	free(pImage);
+	return true;
+}
+
 bool SavePNG(EImageFormat ImageFormat, const uint8_t *pRawBuffer, SImageByteBuffer &WrittenBytes, int Width, int Height)
 {
 	png_structp pPNGStruct = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
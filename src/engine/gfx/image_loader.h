@@ -23,6 +23,9 @@ struct SImageByteBuffer
 };
 
 bool LoadPNG(SImageByteBuffer &ByteLoader, const char *pFileName, int &Width, int &Height, uint8_t *&pImageBuff, EImageFormat &ImageFormat);
+// reads a RGB or RGBA png and converts it to RGBA like LoadTextureRaw does, for the texture
+// loading jobs. pRGBAData is allocated with malloc, SourceFormat is the format of the file
+bool LoadPNGAsRGBA(class IStorage *pStorage, const char *pFileName, int StorageType, int &Width, int &Height, uint8_t *&pRGBAData, EImageFormat &SourceFormat);
 bool SavePNG(EImageFormat ImageFormat, const uint8_t *pRawBuffer, SImageByteBuffer &WrittenBytes, int Width, int Height);
 
 #endif // ENGINE_GFX_IMAGE_LOADER_H
@@ -2,6 +2,12 @@
 #include <base/math.h>
 #include <base/system.h>
 
+#if defined(CONF_ARCH_SSE2)
+#include <emmintrin.h>
+#elif defined(CONF_ARCH_NEON)
+#include <arm_neon.h>
+#endif
+
 #define TW_DILATE_ALPHA_THRESHOLD 10
 
 static void Dilate(int w, int h, int BPP, unsigned char *pSrc, unsigned char *pDest, unsigned char AlphaThreshold = TW_DILATE_ALPHA_THRESHOLD)
@@ -249,3 +255,76 @@ int HighestBit(int OfVar)
 
 	return RetV;
 }
+
+// zeroes the pixels with zero alpha, 4 pixels at a time where possible.
+// pDest may equal pSrc
+static void MaskTransparentPixels(uint8_t *pDest, const uint8_t *pSrc, size_t NumPixels)
+{
+	size_t i = 0;
+#if defined(CONF_ARCH_SSE2)
+	const __m128i Zero = _mm_setzero_si128();
+	for(; i + 4 <= NumPixels; i += 4)
+	{
+		const __m128i Pixels = _mm_loadu_si128((const __m128i *)(pSrc + i * 4));
+		const __m128i Transparent = _mm_cmpeq_epi32(_mm_srli_epi32(Pixels, 24), Zero);
+		_mm_storeu_si128((__m128i *)(pDest + i * 4), _mm_andnot_si128(Transparent, Pixels));
+	}
+#elif defined(CONF_ARCH_NEON)
+	const uint32x4_t Zero = vdupq_n_u32(0);
+	for(; i + 4 <= NumPixels; i += 4)
+	{
+		const uint32x4_t Pixels = vreinterpretq_u32_u8(vld1q_u8(pSrc + i * 4));
+		const uint32x4_t Transparent = vceqq_u32(vshrq_n_u32(Pixels, 24), Zero);
+		vst1q_u8(pDest + i * 4, vreinterpretq_u8_u32(vbicq_u32(Pixels, Transparent)));
+	}
+#endif
+	for(; i < NumPixels; i++)
+	{
+		if(pSrc[i * 4 + 3] == 0)
+			mem_zero(&pDest[i * 4], 4);
+		else if(pDest != pSrc)
+			mem_copy(&pDest[i * 4], &pSrc[i * 4], 4);
+	}
+}
+
+void ClearTransparentPixels(uint8_t *pImg, int Width, int Height)
+{
+	MaskTransparentPixels(pImg, pImg, (size_t)Width * Height);
+}
+
+void CopyOpaquePixels(uint8_t *pDestImg, const uint8_t *pSrcImg, int Width, int Height)
+{
+	MaskTransparentPixels(pDestImg, pSrcImg, (size_t)Width * Height);
+}
+
+bool ConvertToRGBA(uint8_t *pDest, const uint8_t *pSrc, size_t SrcWidth, size_t SrcHeight, size_t SrcChannelCount)
+{
+	if(SrcChannelCount == 4)
+	{
+		mem_copy(pDest, pSrc, SrcWidth * SrcHeight * 4);
+		return true;
+	}
+
+	const size_t DstChannelCount = 4;
+	for(size_t Y = 0; Y < SrcHeight; ++Y)
+	{
+		for(size_t X = 0; X < SrcWidth; ++X)
+		{
+			size_t ImgOffsetSrc = (Y * SrcWidth * SrcChannelCount) + (X * SrcChannelCount);
+			size_t ImgOffsetDest = (Y * SrcWidth * DstChannelCount) + (X * DstChannelCount);
+			if(SrcChannelCount == 3)
+			{
+				mem_copy(&pDest[ImgOffsetDest], &pSrc[ImgOffsetSrc], 3);
+				pDest[ImgOffsetDest + 3] = 255;
+			}
+			else if(SrcChannelCount == 1)
+			{
+				pDest[ImgOffsetDest + 0] = 255;
+				pDest[ImgOffsetDest + 1] = 255;
+				pDest[ImgOffsetDest + 2] = 255;
+				pDest[ImgOffsetDest + 3] = pSrc[ImgOffsetSrc];
+			}
+		}
+	}
+	return false;
+}
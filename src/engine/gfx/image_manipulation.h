@@ -1,6 +1,7 @@
 #ifndef ENGINE_GFX_IMAGE_MANIPULATION_H
 #define ENGINE_GFX_IMAGE_MANIPULATION_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 void DilateImage(unsigned char *pImageBuff, int w, int h, int BPP);
@@ -11,4 +12,12 @@ uint8_t *ResizeImage(const uint8_t *pImageData, int Width, int Height, int NewWi
 
 int HighestBit(int OfVar);
 
+// expands 1 (alpha only) and 3 channel images to RGBA, returns false if it had to convert
+bool ConvertToRGBA(uint8_t *pDest, const uint8_t *pSrc, size_t SrcWidth, size_t SrcHeight, size_t SrcChannelCount);
+
+// RGBA only, zeroes the color of fully transparent pixels
+void ClearTransparentPixels(uint8_t *pImg, int Width, int Height);
+// RGBA only, copies the image with fully transparent pixels zeroed
+void CopyOpaquePixels(uint8_t *pDestImg, const uint8_t *pSrcImg, int Width, int Height);
+
 #endif // ENGINE_GFX_IMAGE_MANIPULATION_H
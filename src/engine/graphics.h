@@ -306,6 +306,9 @@ public:
 	virtual CTextureHandle LoadTextureRaw(int Width, int Height, int Format, const void *pData, int StoreFormat, int Flags, const char *pTexName = nullptr) = 0;
 	virtual int LoadTextureRawSub(CTextureHandle TextureID, int x, int y, int Width, int Height, int Format, const void *pData) = 0;
 	virtual CTextureHandle LoadTexture(const char *pFilename, int StorageType, int StoreFormat, int Flags) = 0;
+	// returns the handle right away and decodes the png on the job pool, a transparent placeholder is used until it is uploaded
+	virtual CTextureHandle LoadTextureAsync(const char *pFilename, int StorageType, int StoreFormat, int Flags) = 0;
+	virtual bool IsTextureLoading(CTextureHandle Texture) const = 0;
 	virtual void TextureSet(CTextureHandle Texture) = 0;
 	void TextureClear() { TextureSet(CTextureHandle()); }
 
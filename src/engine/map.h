@@ -31,12 +31,17 @@ class IEngineMap : public IMap
 	MACRO_INTERFACE("enginemap", 0)
 public:
 	virtual bool Load(const char *pMapName) = 0;
+	virtual bool Load(class IStorage *pStorage, const char *pMapName) = 0;
+	virtual bool Load(const char *pMapName, const void *pData, unsigned DataSize) = 0;
 	virtual bool IsLoaded() = 0;
 	virtual void Unload() = 0;
 	virtual SHA256_DIGEST Sha256() = 0;
 	virtual unsigned Crc() = 0;
 	virtual int MapSize() = 0;
 	virtual IOHANDLE File() = 0;
+
+	// decompresses the data used by the game (all except embedded images and sounds) on the job pool
+	virtual void PreloadData(class IEngine *pEngine) = 0;
 };
 
 extern IEngineMap *CreateEngineMap();
@@ -3,11 +3,34 @@
 #ifndef ENGINE_MESSAGE_H
 #define ENGINE_MESSAGE_H
 
+#include <base/system.h>
+#include <engine/shared/compression.h>
 #include <engine/shared/packer.h>
 #include <engine/shared/uuid_manager.h>
 
 class CMsgPacker : public CPacker
 {
+	int m_HeaderSize;
+
+	void PackMsgHeader()
+	{
+		unsigned char aHeader[PACKER_HEADER_SIZE];
+		unsigned char *pEnd;
+		if(m_MsgID < OFFSET_UUID)
+		{
+			pEnd = CVariableInt::Pack(aHeader, (m_MsgID << 1) | (m_System ? 1 : 0), sizeof(aHeader));
+		}
+		else
+		{
+			pEnd = CVariableInt::Pack(aHeader, (0 << 1) | (m_System ? 1 : 0), sizeof(aHeader)); // NETMSG_EX, NETMSGTYPE_EX
+			CUuid Uuid = g_UuidManager.GetUuid(m_MsgID);
+			mem_copy(pEnd, &Uuid, sizeof(Uuid));
+			pEnd += sizeof(Uuid);
+		}
+		m_HeaderSize = (int)(pEnd - aHeader);
+		PackHeader(aHeader, m_HeaderSize);
+	}
+
 public:
 	int m_MsgID;
 	bool m_System;
@@ -16,7 +39,14 @@ public:
 		m_MsgID(Type), m_System(System), m_NoTranslate(NoTranslate)
 	{
 		Reset();
+		PackMsgHeader();
 	}
+
+	// the message as it is queued on a connection: the message id (and uuid of
+	// extended messages) is packed in place in front of the payload, so the
+	// message can be sent to any number of clients without repacking it
+	const unsigned char *NetData() const { return Data() - m_HeaderSize; }
+	int NetSize() const { return Size() + m_HeaderSize; }
 };
 
 #endif
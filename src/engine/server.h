@@ -72,7 +72,17 @@ public:
 	{
 		int Result = 0;
 		T tmp;
-		if(ClientID == -1)
+		if(ClientID == -1 && !NeedsTranslation(pMsg))
+		{
+			// same message for everyone, pack it once
+			CMsgPacker Packer(pMsg->MsgID(), false);
+			if(pMsg->Pack(&Packer))
+				return -1;
+			for(int i = 0; i < MaxClients(); i++)
+				if(ClientIngame(i))
+					Result = SendMsg(&Packer, Flags, i);
+		}
+		else if(ClientID == -1)
 		{
 			for(int i = 0; i < MaxClients(); i++)
 				if(ClientIngame(i))
@@ -89,6 +99,15 @@ public:
 		return Result;
 	}
 
+	template<class T>
+	static bool NeedsTranslation(const T *pMsg)
+	{
+		return false;
+	}
+	static bool NeedsTranslation(const CNetMsg_Sv_Emoticon *pMsg) { return true; }
+	static bool NeedsTranslation(const CNetMsg_Sv_Chat *pMsg) { return true; }
+	static bool NeedsTranslation(const CNetMsg_Sv_KillMsg *pMsg) { return true; }
+
 	template<class T>
 	int SendPackMsgTranslate(T *pMsg, int Flags, int ClientID)
 	{
@@ -186,8 +205,8 @@ public:
 	virtual int GetClientWorldID(int ClientID) = 0;
 	virtual const char *GetWorldName(int WorldID) = 0;
 
-	virtual int SnapNewID() = 0;
-	virtual void SnapFreeID(int ID) = 0;
+	virtual int SnapNewID(int WorldID) = 0;
+	virtual void SnapFreeID(int WorldID, int ID) = 0;
 	virtual void *SnapNewItem(int Type, int ID, int Size) = 0;
 
 	virtual void SnapSetStaticsize(int ItemType, int Size) = 0;
@@ -1,8 +1,10 @@
 #include "multi_worlds.h"
 
 #include <engine/console.h>
+#include <engine/engine.h>
 #include <engine/map.h>
 #include <engine/server.h>
+#include <engine/storage.h>
 #include <engine/external/json-parser/json.h>
 
 bool CMultiWorlds::Add(int WorldID, IKernel* pKernel, IServer *pServer)
@@ -11,9 +13,11 @@ bool CMultiWorlds::Add(int WorldID, IKernel* pKernel, IServer *pServer)
 
 	CWorldGameServer& pNewWorld = m_Worlds[WorldID];
 	pNewWorld.m_pGameServer = CreateGameServer();
+	pNewWorld.m_Population = 0;
+	pNewWorld.m_LastTick = 0;
 
 	bool RegisterFail = false;
-	if(m_NextIsReloading) // reregister
+	if(WorldID < m_NumRegistered) // reregister
 	{
 		RegisterFail = RegisterFail || !pKernel->ReregisterInterface(pNewWorld.m_pLoadedMap, WorldID);
 		RegisterFail = RegisterFail || !pKernel->ReregisterInterface(static_cast<IMap*>(pNewWorld.m_pLoadedMap), WorldID);
@@ -25,17 +29,15 @@ bool CMultiWorlds::Add(int WorldID, IKernel* pKernel, IServer *pServer)
 		RegisterFail = RegisterFail || !pKernel->RegisterInterface(pNewWorld.m_pLoadedMap, false, WorldID);
 		RegisterFail = RegisterFail || !pKernel->RegisterInterface(static_cast<IMap*>(pNewWorld.m_pLoadedMap), false, WorldID);
 		RegisterFail = RegisterFail || !pKernel->RegisterInterface(pNewWorld.m_pGameServer, true, WorldID);
+		m_NumRegistered = WorldID + 1;
 	}
 
 	m_WasInitilized++;
 	return RegisterFail;
 }
 
-bool CMultiWorlds::LoadWorlds(IServer* pServer, IKernel* pKernel, IStorage* pStorage, IConsole* pConsole)
+bool CMultiWorlds::ReadDefinitions(IStorage* pStorage, IConsole* pConsole, std::vector<CWorldDefinition>& vDefinitions)
 {
-	// clear old worlds
-	Clear(false);
-
 	// read file data into buffer
 	char aFileBuf[512];
 	str_format(aFileBuf, sizeof(aFileBuf), "maps/worlds.json");
@@ -45,7 +47,7 @@ bool CMultiWorlds::LoadWorlds(IServer* pServer, IKernel* pKernel, IStorage* pSto
 		pConsole->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "maps/worlds.json", "Probably deleted or error when the file is invalid.");
 		return false;
 	}
-	
+
 	const int FileSize = (int)io_length(File);
 	char* pFileData = (char*)malloc(FileSize);
 	io_read(File, pFileData, FileSize);
@@ -62,29 +64,196 @@ bool CMultiWorlds::LoadWorlds(IServer* pServer, IKernel* pKernel, IStorage* pSto
 		pConsole->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "worlds.json", aError);
 		return false;
 	}
-	
+
 	// extract data
 	const json_value& rStart = (*pJsonData)["worlds"];
 	if(rStart.type == json_array)
 	{
-		for(unsigned i = 0; i < rStart.u.array.length; ++i)
+		for(unsigned i = 0; i < rStart.u.array.length && i < ENGINE_MAX_WORLDS; ++i)
 		{
-			const char* pWorldName = rStart[i]["name"];
-			const char* pPath = rStart[i]["path"];
-
-			// here set worlds name
-			Add(i, pKernel, pServer);
-			str_copy(m_Worlds[i].m_aName, pWorldName, sizeof(m_Worlds[i].m_aName));
-			str_copy(m_Worlds[i].m_aPath, pPath, sizeof(m_Worlds[i].m_aPath));
+			CWorldDefinition Definition;
+			str_copy(Definition.m_aName, rStart[i]["name"], sizeof(Definition.m_aName));
+			str_copy(Definition.m_aPath, rStart[i]["path"], sizeof(Definition.m_aPath));
+			vDefinitions.push_back(Definition);
 		}
 	}
 
 	// clean up
-	m_NextIsReloading = true;
 	json_value_free(pJsonData);
 	return true;
 }
 
+bool CMultiWorlds::LoadWorlds(IServer* pServer, IKernel* pKernel, IStorage* pStorage, IConsole* pConsole)
+{
+	// clear old worlds
+	Clear(false);
+
+	std::vector<CWorldDefinition> vDefinitions;
+	if(!ReadDefinitions(pStorage, pConsole, vDefinitions))
+		return false;
+
+	for(int i = 0; i < (int)vDefinitions.size(); ++i)
+	{
+		// here set worlds name
+		Add(i, pKernel, pServer);
+		str_copy(m_Worlds[i].m_aName, vDefinitions[i].m_aName, sizeof(m_Worlds[i].m_aName));
+		str_copy(m_Worlds[i].m_aPath, vDefinitions[i].m_aPath, sizeof(m_Worlds[i].m_aPath));
+	}
+	return true;
+}
+
+CMultiWorlds::CReloadJob::CReloadJob(IStorage *pStorage, IEngine *pEngine, std::vector<CPendingWorld> &&vWorlds) :
+	m_pStorage(pStorage),
+	m_pEngine(pEngine),
+	m_vWorlds(std::move(vWorlds)),
+	m_Failed(false)
+{
+	m_aError[0] = '\0';
+}
+
+CMultiWorlds::CReloadJob::~CReloadJob()
+{
+	// worlds that were never swapped in
+	for(auto &World : m_vWorlds)
+	{
+		delete World.m_pMap;
+		free(World.m_pMapData);
+	}
+}
+
+void CMultiWorlds::CReloadJob::Run()
+{
+	for(auto &World : m_vWorlds)
+	{
+		char aPath[IO_MAX_PATH_LENGTH];
+		str_format(aPath, sizeof(aPath), "maps/%s", World.m_Definition.m_aPath);
+
+		void *pData;
+		unsigned DataSize;
+		if(!m_pStorage->ReadFile(aPath, IStorage::TYPE_ALL, &pData, &DataSize))
+		{
+			str_format(m_aError, sizeof(m_aError), "%s the map is not loaded...", aPath);
+			m_Failed = true;
+			return;
+		}
+
+		// an untouched definition with the same map content keeps running
+		if(!World.m_Changed && World.m_HaveCurrent && sha256(pData, DataSize) == World.m_CurrentSha256)
+		{
+			free(pData);
+			continue;
+		}
+
+		World.m_pMap = CreateEngineMap();
+		if(!World.m_pMap->Load(aPath, pData, DataSize))
+		{
+			free(pData);
+			str_format(m_aError, sizeof(m_aError), "%s the map is not loaded...", aPath);
+			m_Failed = true;
+			return;
+		}
+		World.m_pMap->PreloadData(m_pEngine);
+		World.m_pMapData = (unsigned char *)pData;
+		World.m_Changed = true;
+	}
+}
+
+bool CMultiWorlds::StartReload(IStorage* pStorage, IConsole* pConsole, IEngine* pEngine)
+{
+	if(IsReloading())
+	{
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "worlds", "a reload is already in progress");
+		return true;
+	}
+
+	std::vector<CWorldDefinition> vDefinitions;
+	if(!ReadDefinitions(pStorage, pConsole, vDefinitions))
+		return true;
+
+	// kernel interfaces can't be unregistered, removing worlds needs a full reload
+	if((int)vDefinitions.size() < m_WasInitilized)
+		return false;
+
+	std::vector<CReloadJob::CPendingWorld> vWorlds;
+	for(int i = 0; i < (int)vDefinitions.size(); i++)
+	{
+		CReloadJob::CPendingWorld World;
+		World.m_WorldID = i;
+		World.m_Definition = vDefinitions[i];
+		World.m_HaveCurrent = IsValid(i) && m_Worlds[i].m_pLoadedMap->IsLoaded();
+		World.m_Changed = !World.m_HaveCurrent ||
+				  str_comp(m_Worlds[i].m_aName, vDefinitions[i].m_aName) != 0 ||
+				  str_comp(m_Worlds[i].m_aPath, vDefinitions[i].m_aPath) != 0;
+		World.m_CurrentSha256 = World.m_HaveCurrent ? m_Worlds[i].m_pLoadedMap->Sha256() : SHA256_ZEROED;
+		World.m_pMap = nullptr;
+		World.m_pMapData = nullptr;
+		vWorlds.push_back(World);
+	}
+
+	m_pReloadJob = std::make_shared<CReloadJob>(pStorage, pEngine, std::move(vWorlds));
+	pEngine->AddJob(m_pReloadJob);
+	return true;
+}
+
+std::vector<int> CMultiWorlds::FinishReload(IKernel* pKernel, IConsole* pConsole)
+{
+	std::vector<int> vRebuilt;
+	std::shared_ptr<CReloadJob> pJob = std::move(m_pReloadJob);
+	m_pReloadJob = nullptr;
+	if(pJob->m_Failed)
+	{
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "worlds", pJob->m_aError);
+		return vRebuilt;
+	}
+
+	for(auto &World : pJob->m_vWorlds)
+	{
+		if(!World.m_pMap)
+			continue;
+
+		const int WorldID = World.m_WorldID;
+		CWorldGameServer &Target = m_Worlds[WorldID];
+		const bool Existing = WorldID < m_WasInitilized;
+		if(Existing)
+		{
+			delete Target.m_pGameServer;
+			Target.m_pGameServer = nullptr;
+			Target.m_pLoadedMap->Unload();
+			delete Target.m_pLoadedMap;
+			free(Target.m_pLoadedMapData);
+		}
+
+		Target.m_pLoadedMap = World.m_pMap;
+		Target.m_pLoadedMapData = World.m_pMapData;
+		Target.m_pGameServer = CreateGameServer();
+		str_copy(Target.m_aName, World.m_Definition.m_aName, sizeof(Target.m_aName));
+		str_copy(Target.m_aPath, World.m_Definition.m_aPath, sizeof(Target.m_aPath));
+		World.m_pMap = nullptr;
+		World.m_pMapData = nullptr;
+
+		bool RegisterFail = false;
+		if(WorldID < m_NumRegistered)
+		{
+			RegisterFail = RegisterFail || !pKernel->ReregisterInterface(Target.m_pLoadedMap, WorldID);
+			RegisterFail = RegisterFail || !pKernel->ReregisterInterface(static_cast<IMap*>(Target.m_pLoadedMap), WorldID);
+			RegisterFail = RegisterFail || !pKernel->ReregisterInterface(Target.m_pGameServer, WorldID);
+		}
+		else
+		{
+			RegisterFail = RegisterFail || !pKernel->RegisterInterface(Target.m_pLoadedMap, false, WorldID);
+			RegisterFail = RegisterFail || !pKernel->RegisterInterface(static_cast<IMap*>(Target.m_pLoadedMap), false, WorldID);
+			RegisterFail = RegisterFail || !pKernel->RegisterInterface(Target.m_pGameServer, true, WorldID);
+			m_NumRegistered = WorldID + 1;
+		}
+		dbg_assert(!RegisterFail, "interfaces for world reload could not be updated");
+
+		if(!Existing)
+			m_WasInitilized++;
+		vRebuilt.push_back(WorldID);
+	}
+	return vRebuilt;
+}
+
 void CMultiWorlds::Clear(bool Shutdown)
 {
 	for(int i = 0; i < m_WasInitilized; i++)
@@ -106,4 +275,4 @@ void CMultiWorlds::Clear(bool Shutdown)
 		m_Worlds[i].m_pGameServer = nullptr;
 	}
 	m_WasInitilized = 0;
-}
\ No newline at end of file
+}
@@ -1,8 +1,14 @@
 #ifndef ENGINE_SERVER_MULTI_WORLDS_H
 #define ENGINE_SERVER_MULTI_WORLDS_H
 
+#include <base/hash.h>
+
+#include <engine/shared/jobs.h>
 #include <engine/shared/protocol.h>
 
+#include <memory>
+#include <vector>
+
 class CMultiWorlds
 {
 	bool Add(int WorldID, class IKernel* pKernel, class IServer* pServer);
@@ -16,29 +22,80 @@ public:
 		class IGameServer* m_pGameServer;
 		class IEngineMap* m_pLoadedMap;
 		unsigned char *m_pLoadedMapData;
+		int m_Population; // clients that are in or entering the world
+		int m_LastTick; // last tick the world was simulated
+	};
+
+	struct CWorldDefinition
+	{
+		char m_aName[64];
+		char m_aPath[512];
+	};
+
+	// loads the maps of changed worlds off the tick thread
+	class CReloadJob : public IJob
+	{
+		class IStorage *m_pStorage;
+		class IEngine *m_pEngine;
+
+		void Run() override;
+
+	public:
+		struct CPendingWorld
+		{
+			int m_WorldID;
+			CWorldDefinition m_Definition;
+			bool m_Changed;
+			bool m_HaveCurrent;
+			SHA256_DIGEST m_CurrentSha256;
+			class IEngineMap *m_pMap;
+			unsigned char *m_pMapData;
+		};
+
+		CReloadJob(class IStorage *pStorage, class IEngine *pEngine, std::vector<CPendingWorld> &&vWorlds);
+		~CReloadJob() override;
+
+		std::vector<CPendingWorld> m_vWorlds;
+		bool m_Failed;
+		char m_aError[256];
 	};
 
 	CMultiWorlds()
 	{
 		m_WasInitilized = 0;
-		m_NextIsReloading = false;
+		m_NumRegistered = 0;
 		mem_zero(m_Worlds, sizeof(m_Worlds));
 	}
 	~CMultiWorlds()
 	{
 		Clear(true);
 	}
-	
+
 	CWorldGameServer* GetWorld(int WorldID) { return &m_Worlds[WorldID]; };
 	bool IsValid(int WorldID) const { return WorldID >= 0 && WorldID < m_WasInitilized && m_Worlds[WorldID].m_pGameServer; }
 	int GetSizeInitilized() const { return m_WasInitilized; }
 	bool LoadWorlds(class IServer* pServer, class IKernel* pKernel, class IStorage* pStorage, class IConsole* pConsole);
 
+	/*
+		Incremental reload: reads maps/worlds.json and starts loading the maps of
+		all worlds whose definition or map file changed on the job pool. Returns
+		false if the definitions can't be applied incrementally (e.g. worlds were
+		removed), in that case a full reload is required.
+	*/
+	bool StartReload(class IStorage* pStorage, class IConsole* pConsole, class IEngine* pEngine);
+	bool IsReloading() const { return m_pReloadJob != nullptr; }
+	bool IsReloadReady() const { return m_pReloadJob && m_pReloadJob->Status() == IJob::STATE_DONE; }
+	// swaps the prepared worlds in, returns the ids of the rebuilt worlds
+	std::vector<int> FinishReload(class IKernel* pKernel, class IConsole* pConsole);
+
 private:
+	static bool ReadDefinitions(class IStorage* pStorage, class IConsole* pConsole, std::vector<CWorldDefinition>& vDefinitions);
+
 	int m_WasInitilized;
-	bool m_NextIsReloading;
+	int m_NumRegistered;
 	CWorldGameServer m_Worlds[ENGINE_MAX_WORLDS];
+	std::shared_ptr<CReloadJob> m_pReloadJob;
 };
 
 
-#endif
\ No newline at end of file
+#endif
@@ -1,5 +1,10 @@
 #include "name_ban.h"
 
+#include <base/math.h>
+
+#include <algorithm>
+#include <functional>
+
 CNameBan *IsNameBanned(const char *pName, std::vector<CNameBan> &vNameBans)
 {
 	char aTrimmed[MAX_NAME_LENGTH];
@@ -19,3 +24,243 @@ CNameBan *IsNameBanned(const char *pName, std::vector<CNameBan> &vNameBans)
 	}
 	return pResult;
 }
+
+// same as str_utf32_dist_buffer(...) <= Max, but gives up as soon as a row exceeds Max
+static bool SkeletonWithinDistance(const int *pA, int LenA, const int *pB, int LenB, int Max)
+{
+	if(absolute(LenA - LenB) > Max)
+		return false;
+
+	int aaRows[2][MAX_NAME_SKELETON_LENGTH + 1];
+	for(int i = 0; i <= LenA; i++)
+		aaRows[0][i] = i;
+	for(int j = 1; j <= LenB; j++)
+	{
+		const int *pPrev = aaRows[(j - 1) & 1];
+		int *pCur = aaRows[j & 1];
+		pCur[0] = j;
+		int RowMin = j;
+		for(int i = 1; i <= LenA; i++)
+		{
+			pCur[i] = minimum(minimum(pPrev[i] + 1, pCur[i - 1] + 1), pPrev[i - 1] + (pA[i - 1] != pB[j - 1]));
+			RowMin = minimum(RowMin, pCur[i]);
+		}
+		// the minimum of a row never decreases
+		if(RowMin > Max)
+			return false;
+	}
+	return aaRows[LenB & 1][LenA] <= Max;
+}
+
+CNameBans::CNameBans() :
+	m_EmptySubstring(-1),
+	m_AutomatonDirty(true)
+{
+	for(int &MaxDistance : m_aBucketMaxDistance)
+		MaxDistance = -1;
+}
+
+CNameBan *CNameBans::Find(const char *pName)
+{
+	for(CNameBan &Ban : m_vBans)
+	{
+		if(str_comp(Ban.m_aName, pName) == 0)
+			return &Ban;
+	}
+	return nullptr;
+}
+
+void CNameBans::Ban(const char *pName, int Distance, int IsSubstring, const char *pReason)
+{
+	if(CNameBan *pBan = Find(pName))
+	{
+		if((pBan->m_IsSubstring == 1) != (IsSubstring == 1))
+			m_AutomatonDirty = true;
+		pBan->m_Distance = Distance;
+		pBan->m_IsSubstring = IsSubstring;
+		str_copy(pBan->m_aReason, pReason, sizeof(pBan->m_aReason));
+		UpdateBucketMaxDistance(pBan->m_SkeletonLength);
+		return;
+	}
+
+	m_vBans.emplace_back(pName, Distance, IsSubstring, pReason);
+	AddToBucket(m_vBans.size() - 1);
+	if(IsSubstring == 1)
+		m_AutomatonDirty = true;
+}
+
+bool CNameBans::Unban(const char *pName)
+{
+	CNameBan *pBan = Find(pName);
+	if(!pBan)
+		return false;
+
+	const int Index = pBan - m_vBans.data();
+	RemoveFromBucket(Index);
+	m_vBans.erase(m_vBans.begin() + Index);
+
+	// the following bans moved down by one
+	for(auto &vBucket : m_avBuckets)
+	{
+		for(int &BanIndex : vBucket)
+		{
+			if(BanIndex > Index)
+				BanIndex--;
+		}
+	}
+	m_AutomatonDirty = true;
+	return true;
+}
+
+void CNameBans::AddToBucket(int Index)
+{
+	const int Length = m_vBans[Index].m_SkeletonLength;
+	std::vector<int> &vBucket = m_avBuckets[Length];
+	vBucket.insert(std::lower_bound(vBucket.begin(), vBucket.end(), Index), Index);
+	m_aBucketMaxDistance[Length] = maximum(m_aBucketMaxDistance[Length], m_vBans[Index].m_Distance);
+}
+
+void CNameBans::RemoveFromBucket(int Index)
+{
+	const int Length = m_vBans[Index].m_SkeletonLength;
+	std::vector<int> &vBucket = m_avBuckets[Length];
+	vBucket.erase(std::lower_bound(vBucket.begin(), vBucket.end(), Index));
+	UpdateBucketMaxDistance(Length);
+}
+
+void CNameBans::UpdateBucketMaxDistance(int Length)
+{
+	m_aBucketMaxDistance[Length] = -1;
+	for(int Index : m_avBuckets[Length])
+		m_aBucketMaxDistance[Length] = maximum(m_aBucketMaxDistance[Length], m_vBans[Index].m_Distance);
+}
+
+void CNameBans::BuildAutomaton()
+{
+	m_vNodes.clear();
+	m_vNodes.push_back({{}, 0, -1});
+	m_EmptySubstring = -1;
+
+	// trie of the lowercased substring bans
+	for(int Index = 0; Index < (int)m_vBans.size(); Index++)
+	{
+		if(m_vBans[Index].m_IsSubstring != 1)
+			continue;
+		if(!m_vBans[Index].m_aName[0])
+		{
+			m_EmptySubstring = Index;
+			continue;
+		}
+
+		int Node = 0;
+		const char *pStr = m_vBans[Index].m_aName;
+		while(*pStr)
+		{
+			const int Code = str_utf8_tolower(str_utf8_decode(&pStr));
+			auto Next = m_vNodes[Node].m_Next.find(Code);
+			if(Next == m_vNodes[Node].m_Next.end())
+			{
+				m_vNodes.push_back({{}, 0, -1});
+				Next = m_vNodes[Node].m_Next.emplace(Code, m_vNodes.size() - 1).first;
+			}
+			Node = Next->second;
+		}
+		m_vNodes[Node].m_Output = maximum(m_vNodes[Node].m_Output, Index);
+	}
+
+	// fail links in breadth-first order
+	std::vector<int> vQueue;
+	for(const auto &[Code, Child] : m_vNodes[0].m_Next)
+		vQueue.push_back(Child);
+	for(size_t i = 0; i < vQueue.size(); i++)
+	{
+		const int Node = vQueue[i];
+		for(const auto &[Code, Child] : m_vNodes[Node].m_Next)
+		{
+			int Fail = m_vNodes[Node].m_Fail;
+			while(true)
+			{
+				auto Next = m_vNodes[Fail].m_Next.find(Code);
+				if(Next != m_vNodes[Fail].m_Next.end())
+				{
+					Fail = Next->second;
+					break;
+				}
+				if(Fail == 0)
+					break;
+				Fail = m_vNodes[Fail].m_Fail;
+			}
+			m_vNodes[Child].m_Fail = Fail;
+			m_vNodes[Child].m_Output = maximum(m_vNodes[Child].m_Output, m_vNodes[Fail].m_Output);
+			vQueue.push_back(Child);
+		}
+	}
+	m_AutomatonDirty = false;
+}
+
+int CNameBans::FindSubstring(const char *pName)
+{
+	if(m_AutomatonDirty)
+		BuildAutomaton();
+
+	int Result = pName[0] ? m_EmptySubstring : -1;
+	int Node = 0;
+	while(*pName)
+	{
+		const int Code = str_utf8_tolower(str_utf8_decode(&pName));
+		while(true)
+		{
+			auto Next = m_vNodes[Node].m_Next.find(Code);
+			if(Next != m_vNodes[Node].m_Next.end())
+			{
+				Node = Next->second;
+				break;
+			}
+			if(Node == 0)
+				break;
+			Node = m_vNodes[Node].m_Fail;
+		}
+		Result = maximum(Result, m_vNodes[Node].m_Output);
+	}
+	return Result;
+}
+
+CNameBan *CNameBans::IsBanned(const char *pName)
+{
+	int Result = FindSubstring(pName);
+
+	char aTrimmed[MAX_NAME_LENGTH];
+	str_copy(aTrimmed, str_utf8_skip_whitespaces(pName), sizeof(aTrimmed));
+	str_utf8_trim_right(aTrimmed);
+
+	int aSkeleton[MAX_NAME_SKELETON_LENGTH];
+	const int SkeletonLength = str_utf8_to_skeleton(aTrimmed, aSkeleton, std::size(aSkeleton));
+
+	// only bans after the substring match and within reach of the length difference
+	m_vCandidates.clear();
+	for(int Length = 0; Length <= MAX_NAME_SKELETON_LENGTH; Length++)
+	{
+		const int LengthDiff = absolute(Length - SkeletonLength);
+		if(m_aBucketMaxDistance[Length] < LengthDiff)
+			continue;
+		const std::vector<int> &vBucket = m_avBuckets[Length];
+		for(auto It = std::upper_bound(vBucket.begin(), vBucket.end(), Result); It != vBucket.end(); ++It)
+		{
+			if(m_vBans[*It].m_Distance >= LengthDiff)
+				m_vCandidates.push_back(*It);
+		}
+	}
+
+	// the last matching ban wins, so test from the back
+	std::sort(m_vCandidates.begin(), m_vCandidates.end(), std::greater<int>());
+	for(int Index : m_vCandidates)
+	{
+		const CNameBan &Ban = m_vBans[Index];
+		if(SkeletonWithinDistance(aSkeleton, SkeletonLength, Ban.m_aSkeleton, Ban.m_SkeletonLength, Ban.m_Distance))
+		{
+			Result = Index;
+			break;
+		}
+	}
+	return Result < 0 ? nullptr : &m_vBans[Result];
+}
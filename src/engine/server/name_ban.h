@@ -4,6 +4,7 @@
 #include <base/system.h>
 #include <engine/shared/protocol.h>
 
+#include <map>
 #include <vector>
 
 enum
@@ -33,4 +34,49 @@ public:
 
 CNameBan *IsNameBanned(const char *pName, std::vector<CNameBan> &vNameBans);
 
+/*
+	Class: CNameBans
+		Name ban list with an index for matching names against it. Distance
+		bans are bucketed by skeleton length, substring bans are compiled into
+		an Aho-Corasick automaton. Matches the same ban as IsNameBanned, the
+		last one in the list.
+*/
+class CNameBans
+{
+	struct CNode
+	{
+		std::map<int, int> m_Next;
+		int m_Fail;
+		int m_Output; // highest ban index ending here, including the fail chain
+	};
+
+	std::vector<CNameBan> m_vBans;
+	// ban indices by skeleton length, sorted ascending
+	std::vector<int> m_avBuckets[MAX_NAME_SKELETON_LENGTH + 1];
+	int m_aBucketMaxDistance[MAX_NAME_SKELETON_LENGTH + 1];
+
+	std::vector<CNode> m_vNodes;
+	int m_EmptySubstring;
+	bool m_AutomatonDirty;
+
+	std::vector<int> m_vCandidates;
+
+	void AddToBucket(int Index);
+	void RemoveFromBucket(int Index);
+	void UpdateBucketMaxDistance(int Length);
+	void BuildAutomaton();
+	int FindSubstring(const char *pName);
+
+public:
+	CNameBans();
+
+	const std::vector<CNameBan> &All() const { return m_vBans; }
+	CNameBan *Find(const char *pName);
+	// adds a ban or changes the existing one with the same name
+	void Ban(const char *pName, int Distance, int IsSubstring, const char *pReason);
+	bool Unban(const char *pName);
+
+	CNameBan *IsBanned(const char *pName);
+};
+
 #endif // ENGINE_SERVER_NAME_BAN_H
@@ -58,95 +58,6 @@
 
 volatile sig_atomic_t InterruptSignaled = 0;
 
-CSnapIDPool::CSnapIDPool()
-{
-	Reset();
-}
-
-void CSnapIDPool::Reset()
-{
-	for(int i = 0; i < MAX_IDS; i++)
-	{
-		m_aIDs[i].m_Next = i + 1;
-		m_aIDs[i].m_State = ID_FREE;
-	}
-
-	m_aIDs[MAX_IDS - 1].m_Next = -1;
-	m_FirstFree = 0;
-	m_FirstTimed = -1;
-	m_LastTimed = -1;
-	m_Usage = 0;
-	m_InUsage = 0;
-}
-
-void CSnapIDPool::RemoveFirstTimeout()
-{
-	int NextTimed = m_aIDs[m_FirstTimed].m_Next;
-
-	// add it to the free list
-	m_aIDs[m_FirstTimed].m_Next = m_FirstFree;
-	m_aIDs[m_FirstTimed].m_State = ID_FREE;
-	m_FirstFree = m_FirstTimed;
-
-	// remove it from the timed list
-	m_FirstTimed = NextTimed;
-	if(m_FirstTimed == -1)
-		m_LastTimed = -1;
-
-	m_Usage--;
-}
-
-int CSnapIDPool::NewID()
-{
-	int64_t Now = time_get();
-
-	// process timed ids
-	while(m_FirstTimed != -1 && m_aIDs[m_FirstTimed].m_Timeout < Now)
-		RemoveFirstTimeout();
-
-	int ID = m_FirstFree;
-	if(ID == -1)
-	{
-		dbg_msg("server", "invalid id");
-		return ID;
-	}
-	m_FirstFree = m_aIDs[m_FirstFree].m_Next;
-	m_aIDs[ID].m_State = ID_ALLOCATED;
-	m_Usage++;
-	m_InUsage++;
-	return ID;
-}
-
-void CSnapIDPool::TimeoutIDs()
-{
-	// process timed ids
-	while(m_FirstTimed != -1)
-		RemoveFirstTimeout();
-}
-
-void CSnapIDPool::FreeID(int ID)
-{
-	if(ID < 0)
-		return;
-	dbg_assert(m_aIDs[ID].m_State == ID_ALLOCATED, "id is not allocated");
-
-	m_InUsage--;
-	m_aIDs[ID].m_State = ID_TIMED;
-	m_aIDs[ID].m_Timeout = time_get() + time_freq() * 5;
-	m_aIDs[ID].m_Next = -1;
-
-	if(m_LastTimed != -1)
-	{
-		m_aIDs[m_LastTimed].m_Next = ID;
-		m_LastTimed = ID;
-	}
-	else
-	{
-		m_FirstTimed = ID;
-		m_LastTimed = ID;
-	}
-}
-
 void CServerBan::InitServerBan(IConsole *pConsole, IStorage *pStorage, CServer *pServer)
 {
 	CNetBan::Init(pConsole, pStorage);
@@ -441,7 +352,7 @@ bool CServer::SetClientNameImpl(int ClientID, const char *pNameRequest, bool Set
 	if(m_aClients[ClientID].m_State < CClient::STATE_READY)
 		return false;
 
-	if(CNameBan *pBanned = IsNameBanned(pNameRequest, m_vNameBans))
+	if(CNameBan *pBanned = m_NameBans.IsBanned(pNameRequest))
 	{
 		if(m_aClients[ClientID].m_State == CClient::STATE_READY && Set)
 		{
@@ -504,6 +415,9 @@ void CServer::SetClientClan(int ClientID, const char *pClan)
 	if(ClientID < 0 || ClientID >= MAX_CLIENTS || m_aClients[ClientID].m_State < CClient::STATE_READY || !pClan)
 		return;
 
+	if(str_comp(m_aClients[ClientID].m_aClan, pClan) != 0)
+		ExpireServerInfo();
+
 	str_copy(m_aClients[ClientID].m_aClan, pClan, MAX_CLAN_LENGTH);
 }
 
@@ -512,6 +426,9 @@ void CServer::SetClientCountry(int ClientID, int Country)
 	if(ClientID < 0 || ClientID >= MAX_CLIENTS || m_aClients[ClientID].m_State < CClient::STATE_READY)
 		return;
 
+	if(m_aClients[ClientID].m_Country != Country)
+		ExpireServerInfo();
+
 	m_aClients[ClientID].m_Country = Country;
 }
 
@@ -628,6 +545,7 @@ int CServer::Init()
 		Client.m_ShowIps = false;
 		Client.m_AuthKey = -1;
 		Client.m_Latency = 0;
+		Client.m_InfoEntry.m_Valid = false;
 	}
 
 	m_CurrentGameTick = 0;
@@ -806,25 +724,6 @@ int CServer::DistinctClientCount() const
 	return ClientCount;
 }
 
-static inline bool RepackMsg(const CMsgPacker *pMsg, CPacker &Packer)
-{
-	int MsgId = pMsg->m_MsgID;
-	Packer.Reset();
-
-	if(MsgId < OFFSET_UUID)
-	{
-		Packer.AddInt((MsgId << 1) | (pMsg->m_System ? 1 : 0));
-	}
-	else
-	{
-		Packer.AddInt((0 << 1) | (pMsg->m_System ? 1 : 0)); // NETMSG_EX, NETMSGTYPE_EX
-		g_UuidManager.PackUuid(MsgId, &Packer);
-	}
-	Packer.AddRaw(pMsg->Data(), pMsg->Size());
-
-	return false;
-}
-
 int CServer::SendMsg(CMsgPacker *pMsg, int Flags, int ClientID, int64_t Mask, int WorldID)
 {
 	CNetChunk Packet;
@@ -837,11 +736,12 @@ int CServer::SendMsg(CMsgPacker *pMsg, int Flags, int ClientID, int64_t Mask, in
 	if(Flags & MSGFLAG_FLUSH)
 		Packet.m_Flags |= NETSENDFLAG_FLUSH;
 
+	// the header is already packed in front of the payload, every recipient queues the same bytes
+	Packet.m_pData = pMsg->NetData();
+	Packet.m_DataSize = pMsg->NetSize();
+
 	if(ClientID < 0)
 	{
-		CPacker Pack;
-		if(RepackMsg(pMsg, Pack))
-			return -1;
 		if(!(Flags & MSGFLAG_NOSEND))
 		{
 			for(int i = 0; i < MAX_CLIENTS; i++)
@@ -856,16 +756,12 @@ int CServer::SendMsg(CMsgPacker *pMsg, int Flags, int ClientID, int64_t Mask, in
 					{
 						if(m_aClients[i].m_WorldID == WorldID)
 						{
-							Packet.m_pData = Pack.Data();
-							Packet.m_DataSize = Pack.Size();
 							Packet.m_ClientID = i;
 							Antibot()->OnEngineServerMessage(i, Packet.m_pData, Packet.m_DataSize, Flags);
 						}
 						continue;
 					}
 
-					Packet.m_pData = Pack.Data();
-					Packet.m_DataSize = Pack.Size();
 					Packet.m_ClientID = i;
 					if(Antibot()->OnEngineServerMessage(i, Packet.m_pData, Packet.m_DataSize, Flags))
 					{
@@ -878,13 +774,7 @@ int CServer::SendMsg(CMsgPacker *pMsg, int Flags, int ClientID, int64_t Mask, in
 	}
 	else
 	{
-		CPacker Pack;
-		if(RepackMsg(pMsg, Pack))
-			return -1;
-
 		Packet.m_ClientID = ClientID;
-		Packet.m_pData = Pack.Data();
-		Packet.m_DataSize = Pack.Size();
 
 		if(Antibot()->OnEngineServerMessage(ClientID, Packet.m_pData, Packet.m_DataSize, Flags))
 		{
@@ -917,8 +807,58 @@ void CServer::SendMsgRaw(int ClientID, const void *pData, int Size, int Flags)
 	m_NetServer.Send(&Packet);
 }
 
+void CServer::UpdateWorldsPopulation()
+{
+	for(int i = 0; i < MultiWorlds()->GetSizeInitilized(); i++)
+		MultiWorlds()->GetWorld(i)->m_Population = 0;
+
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(m_aClients[i].m_State < CClient::STATE_CONNECTING || !MultiWorlds()->IsValid(m_aClients[i].m_WorldID))
+			continue;
+		MultiWorlds()->GetWorld(m_aClients[i].m_WorldID)->m_Population++;
+	}
+}
+
+bool CServer::WorldNeedsTick(int WorldID) const
+{
+	const CMultiWorlds::CWorldGameServer *pWorld = MultiWorlds()->GetWorld(WorldID);
+	if(pWorld->m_Population > 0)
+		return true;
+
+	// maintenance ticks are spread over the interval so idle worlds don't all tick at once
+	const int Interval = Config()->m_SvIdleWorldTickInterval;
+	return Interval > 0 && (m_CurrentGameTick + WorldID) % Interval == 0;
+}
+
+void CServer::TickWorld(int WorldID)
+{
+	CMultiWorlds::CWorldGameServer *pWorld = MultiWorlds()->GetWorld(WorldID);
+	const int CurrentTick = m_CurrentGameTick;
+
+	// a world that was idle replays the skipped ticks with their own tick numbers,
+	// so its state doesn't depend on when the server got around to waking it
+	if(pWorld->m_Population > 0)
+	{
+		const int From = maximum(pWorld->m_LastTick + 1, CurrentTick - Config()->m_SvIdleWorldCatchup);
+		for(m_CurrentGameTick = From; m_CurrentGameTick < CurrentTick; m_CurrentGameTick++)
+			pWorld->m_pGameServer->OnTick();
+		m_CurrentGameTick = CurrentTick;
+	}
+
+	pWorld->m_pGameServer->OnTick();
+	pWorld->m_LastTick = CurrentTick;
+}
+
 void CServer::DoSnapshot(int WorldID)
 {
+	// nobody can receive the snapshot, only drop the events of maintenance ticks
+	if(MultiWorlds()->GetWorld(WorldID)->m_Population == 0)
+	{
+		GameServer(WorldID)->OnPostSnap();
+		return;
+	}
+
 	GameServer(WorldID)->OnPreSnap();
 
 	// create snapshots for all clients
@@ -1830,6 +1770,42 @@ void CServer::CCache::Clear()
 	m_Cache.clear();
 }
 
+const CServer::CClient::CInfoEntry &CServer::ServerInfoEntry(int ClientID)
+{
+	CClient::CInfoEntry &Entry = m_aClients[ClientID].m_InfoEntry;
+	const char *pName = ClientName(ClientID);
+	const char *pClan = ClientClan(ClientID);
+	const int Country = m_aClients[ClientID].m_Country;
+	const int Score = m_aClients[ClientID].m_Score;
+	const bool IsPlayer = GameServer()->IsClientPlayer(ClientID);
+
+	if(Entry.m_Valid && Entry.m_Country == Country && Entry.m_Score == Score && Entry.m_IsPlayer == IsPlayer &&
+		str_comp(Entry.m_aName, pName) == 0 && str_comp(Entry.m_aClan, pClan) == 0)
+		return Entry;
+
+	CPacker p;
+	char aBuf[16];
+	p.Reset();
+	p.AddString(pName, MAX_NAME_LENGTH); // client name
+	p.AddString(pClan, MAX_CLAN_LENGTH); // client clan
+	str_format(aBuf, sizeof(aBuf), "%d", Country);
+	p.AddString(aBuf, 0); // client country
+	str_format(aBuf, sizeof(aBuf), "%d", Score);
+	p.AddString(aBuf, 0); // client score
+	p.AddString(IsPlayer ? "1" : "0", 0); // is player?
+	dbg_assert(!p.Error() && p.Size() <= (int)sizeof(Entry.m_aData), "server info entry too large");
+
+	str_copy(Entry.m_aName, pName, sizeof(Entry.m_aName));
+	str_copy(Entry.m_aClan, pClan, sizeof(Entry.m_aClan));
+	Entry.m_Country = Country;
+	Entry.m_Score = Score;
+	Entry.m_IsPlayer = IsPlayer;
+	mem_copy(Entry.m_aData, p.Data(), p.Size());
+	Entry.m_DataSize = p.Size();
+	Entry.m_Valid = true;
+	return Entry;
+}
+
 void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
 {
 	pCache->Clear();
@@ -1994,12 +1970,8 @@ void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
 
 			int PreviousSize = q.Size();
 
-			q.AddString(ClientName(i), MAX_NAME_LENGTH); // client name
-			q.AddString(ClientClan(i), MAX_CLAN_LENGTH); // client clan
-
-			ADD_INT(q, m_aClients[i].m_Country); // client country
-			ADD_INT(q, m_aClients[i].m_Score); // client score
-			ADD_INT(q, GameServer()->IsClientPlayer(i) ? 1 : 0); // is player?
+			const CClient::CInfoEntry &Entry = ServerInfoEntry(i);
+			q.AddRaw(Entry.m_aData, Entry.m_DataSize);
 			if(Type == SERVERINFO_EXTENDED)
 				q.AddString("", 0); // extra info, reserved
 
@@ -2029,54 +2001,53 @@ void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
 
 void CServer::SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients)
 {
-	CPacker p;
-	char aBuf[128];
-	p.Reset();
-
 	CCache *pCache = &m_aServerInfoCache[GetCacheIndex(Type, SendClients)];
 
-#define ADD_RAW(p, x) (p).AddRaw(x, sizeof(x))
-#define ADD_INT(p, x) \
-	do \
-	{ \
-		str_format(aBuf, sizeof(aBuf), "%d", x); \
-		(p).AddString(aBuf, 0); \
-	} while(0)
+	// the chunks are prebuilt, only the header with the token differs per request
+	char aToken[16];
+	str_format(aToken, sizeof(aToken), "%d", Token);
+	const int TokenSize = str_length(aToken) + 1;
+
+	const unsigned char *pHeader;
+	const unsigned char *pHeaderMore = nullptr;
+	if(Type == SERVERINFO_EXTENDED)
+	{
+		pHeader = SERVERBROWSE_INFO_EXTENDED;
+		pHeaderMore = SERVERBROWSE_INFO_EXTENDED_MORE;
+	}
+	else if(Type == SERVERINFO_64_LEGACY)
+	{
+		pHeader = SERVERBROWSE_INFO_64_LEGACY;
+	}
+	else if(Type == SERVERINFO_VANILLA || Type == SERVERINFO_INGAME)
+	{
+		pHeader = SERVERBROWSE_INFO;
+	}
+	else
+	{
+		dbg_assert(false, "unknown serverinfo type");
+		return;
+	}
+	const int HeaderSize = SERVERBROWSE_SIZE;
 
 	CNetChunk Packet;
 	Packet.m_ClientID = -1;
 	Packet.m_Address = *pAddr;
 	Packet.m_Flags = NETSENDFLAG_CONNLESS;
 
+	unsigned char aData[NET_MAX_PAYLOAD];
 	for(const auto &Chunk : pCache->m_Cache)
 	{
-		p.Reset();
-		if(Type == SERVERINFO_EXTENDED)
-		{
-			if(&Chunk == &pCache->m_Cache.front())
-				p.AddRaw(SERVERBROWSE_INFO_EXTENDED, sizeof(SERVERBROWSE_INFO_EXTENDED));
-			else
-				p.AddRaw(SERVERBROWSE_INFO_EXTENDED_MORE, sizeof(SERVERBROWSE_INFO_EXTENDED_MORE));
-			ADD_INT(p, Token);
-		}
-		else if(Type == SERVERINFO_64_LEGACY)
-		{
-			ADD_RAW(p, SERVERBROWSE_INFO_64_LEGACY);
-			ADD_INT(p, Token);
-		}
-		else if(Type == SERVERINFO_VANILLA || Type == SERVERINFO_INGAME)
-		{
-			ADD_RAW(p, SERVERBROWSE_INFO);
-			ADD_INT(p, Token);
-		}
-		else
-		{
-			dbg_assert(false, "unknown serverinfo type");
-		}
+		const int Size = HeaderSize + TokenSize + (int)Chunk.m_vData.size();
+		if(Size > (int)sizeof(aData))
+			continue;
 
-		p.AddRaw(Chunk.m_vData.data(), Chunk.m_vData.size());
-		Packet.m_pData = p.Data();
-		Packet.m_DataSize = p.Size();
+		const unsigned char *pChunkHeader = pHeaderMore && &Chunk != &pCache->m_Cache.front() ? pHeaderMore : pHeader;
+		mem_copy(aData, pChunkHeader, HeaderSize);
+		mem_copy(aData + HeaderSize, aToken, TokenSize);
+		mem_copy(aData + HeaderSize + TokenSize, Chunk.m_vData.data(), Chunk.m_vData.size());
+		Packet.m_pData = aData;
+		Packet.m_DataSize = Size;
 		m_NetServer.Send(&Packet);
 	}
 }
@@ -2283,17 +2254,13 @@ bool CServer::LoadMap(int ID)
 	if(!pMap->Load(aBuf))
 		return false;
 
+	// decompress the map data while the other worlds are loaded
+	pMap->PreloadData(Kernel()->RequestInterface<IEngine>());
+
 	// reinit snapshot ids
-	m_IDPool.TimeoutIDs();
+	m_aIDPools[ID].TimeoutIDs();
 
-	// get the sha256 and crc of the map
-	char aSha256[SHA256_MAXSTRSIZE];
-	sha256_str(pMap->Sha256(), aSha256, sizeof(aSha256));
-	char aBufMsg[256];
-	str_format(aBufMsg, sizeof(aBufMsg), "%s sha256 is %s", aBuf, aSha256);
-	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBufMsg);
-	str_format(aBufMsg, sizeof(aBufMsg), "%s crc is %08x", aBuf, pMap->Crc());
-	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBufMsg);
+	PrintMapInfo(ID);
 
 	// load complete map into memory for download
 	{
@@ -2305,6 +2272,68 @@ bool CServer::LoadMap(int ID)
 	return true;
 }
 
+void CServer::PrintMapInfo(int ID)
+{
+	// get the sha256 and crc of the map
+	IEngineMap *pMap = MultiWorlds()->GetWorld(ID)->m_pLoadedMap;
+	char aSha256[SHA256_MAXSTRSIZE];
+	sha256_str(pMap->Sha256(), aSha256, sizeof(aSha256));
+	char aBufMsg[256];
+	str_format(aBufMsg, sizeof(aBufMsg), "maps/%s sha256 is %s", MultiWorlds()->GetWorld(ID)->m_aPath, aSha256);
+	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBufMsg);
+	str_format(aBufMsg, sizeof(aBufMsg), "maps/%s crc is %08x", MultiWorlds()->GetWorld(ID)->m_aPath, pMap->Crc());
+	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBufMsg);
+}
+
+void CServer::FinishWorldsReload()
+{
+	// the maps were loaded on the job pool, only the swap happens on the tick thread
+	const std::vector<int> vRebuilt = MultiWorlds()->FinishReload(Kernel(), Console());
+	for(const int WorldID : vRebuilt)
+	{
+		m_aIDPools[WorldID].TimeoutIDs();
+		PrintMapInfo(WorldID);
+
+		IGameServer *pGameServer = MultiWorlds()->GetWorld(WorldID)->m_pGameServer;
+		pGameServer->OnInit(WorldID);
+		MultiWorlds()->GetWorld(WorldID)->m_LastTick = Tick();
+
+		// clients in other worlds keep their connection and snapshots
+		for(int ClientID = 0; ClientID < MAX_PLAYERS; ClientID++)
+		{
+			CClient &Client = m_aClients[ClientID];
+			if(Client.m_State <= CClient::STATE_AUTH)
+				continue;
+
+			// still downloading the initial map, restart with the new one
+			if(Client.m_State == CClient::STATE_CONNECTING && !Client.m_ChangeMap)
+			{
+				if(Client.m_WorldID == WorldID)
+					SendMap(ClientID);
+				continue;
+			}
+
+			pGameServer->PrepareClientChangeWorld(ClientID);
+			if(Client.m_WorldID != WorldID)
+				continue;
+
+			Client.Reset();
+			Client.m_ChangeMap = true;
+			Client.m_State = CClient::STATE_CONNECTING;
+			SendMap(ClientID);
+		}
+
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "world '%s' (%d) was reloaded", MultiWorlds()->GetWorld(WorldID)->m_aName, WorldID);
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	}
+
+	if(!vRebuilt.empty())
+		ExpireServerInfo();
+	else
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "no world changed");
+}
+
 int CServer::Run()
 {
 	if(m_RunServer == UNINITIALIZED)
@@ -2492,11 +2521,12 @@ int CServer::Run()
 						GameServer(ClientWorldID)->OnClientPredictedInput(c, nullptr);
 				}
 
-				// update gamecontext tick
+				// update gamecontext tick, worlds without clients only get maintenance ticks
+				UpdateWorldsPopulation();
 				for(int i = 0; i < MultiWorlds()->GetSizeInitilized(); i++)
 				{
-					IGameServer *pGameServer = MultiWorlds()->GetWorld(i)->m_pGameServer;
-					pGameServer->OnTick();
+					if(WorldNeedsTick(i))
+						TickWorld(i);
 				}
 
 				// handle error
@@ -2504,11 +2534,15 @@ int CServer::Run()
 					break;
 			}
 
+			// swap in worlds that finished reloading
+			if(MultiWorlds()->IsReloadReady())
+				FinishWorldsReload();
+
 			// snap game
 			if(NewTicks)
 			{
 				// heavy reset server ((24 * 60) * 60) * SERVER_TICK_SPEED = 4320000 tick in day i think
-				if((NonActive && m_CurrentGameTick > (200)) || m_HeavyReload)
+				if(((NonActive && m_CurrentGameTick > (200)) || m_HeavyReload) && !MultiWorlds()->IsReloading())
 				{
 					m_CurrentGameTick = 0;
 					m_GameStartTime = time_get();
@@ -2658,6 +2692,55 @@ void CServer::ConTestingCommands(CConsole::IResult *pResult, void *pUser)
 	pThis->Print(CConsole::OUTPUT_LEVEL_STANDARD, "console", aBuf);
 }
 
+void CServer::ConReloadWorlds(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+	IEngine *pEngine = pThis->Kernel()->RequestInterface<IEngine>();
+	// map files are usually replaced behind the server's back
+	pThis->Storage()->RefreshIndex();
+	if(!pThis->MultiWorlds()->StartReload(pThis->Storage(), pThis->Console(), pEngine))
+	{
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "worlds were removed, falling back to a heavy reload");
+		pThis->m_HeavyReload = true;
+	}
+}
+
+void CServer::ConNetSendStats(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+	const CNetSendStats &Stats = CNetBase::SendStats();
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "chunks=%llu payload=%llu bytes copied=%llu bytes (%.2f per payload byte)",
+		(unsigned long long)Stats.m_NumChunks, (unsigned long long)Stats.m_PayloadBytes, (unsigned long long)Stats.m_CopiedBytes,
+		Stats.m_PayloadBytes ? (double)Stats.m_CopiedBytes / Stats.m_PayloadBytes : 0.0);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+}
+
+void CServer::ConStorageRefresh(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+	int Hits, Misses, NumDirs;
+	pThis->Storage()->GetIndexStats(&Hits, &Misses, &NumDirs);
+	pThis->Storage()->RefreshIndex();
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "path index refreshed, dropped %d directories (hits=%d misses=%d)", NumDirs, Hits, Misses);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "storage", aBuf);
+}
+
+void CServer::ConSnapIDs(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+	for(int i = 0; i < pThis->MultiWorlds()->GetSizeInitilized(); i++)
+	{
+		const CSnapIDPool &Pool = pThis->m_aIDPools[i];
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "world=%d name='%s' allocated=%d reserved=%d peak=%d max=%d",
+			i, pThis->GetWorldName(i), Pool.InUsage(), Pool.Usage() - Pool.InUsage(), Pool.PeakUsage(), (int)CSnapIDPool::MAX_IDS);
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	}
+}
+
 void CServer::ConKick(IConsole::IResult *pResult, void *pUser)
 {
 	if(pResult->NumArguments() > 1)
@@ -2941,20 +3024,15 @@ void CServer::ConNameBan(IConsole::IResult *pResult, void *pUser)
 	int Distance = pResult->NumArguments() > 1 ? pResult->GetInteger(1) : str_length(pName) / 3;
 	int IsSubstring = pResult->NumArguments() > 2 ? pResult->GetInteger(2) : 0;
 
-	for(auto &Ban : pThis->m_vNameBans)
+	if(CNameBan *pBan = pThis->m_NameBans.Find(pName))
 	{
-		if(str_comp(Ban.m_aName, pName) == 0)
-		{
-			str_format(aBuf, sizeof(aBuf), "changed name='%s' distance=%d old_distance=%d is_substring=%d old_is_substring=%d reason='%s' old_reason='%s'", pName, Distance, Ban.m_Distance, IsSubstring, Ban.m_IsSubstring, pReason, Ban.m_aReason);
-			pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "name_ban", aBuf);
-			Ban.m_Distance = Distance;
-			Ban.m_IsSubstring = IsSubstring;
-			str_copy(Ban.m_aReason, pReason, sizeof(Ban.m_aReason));
-			return;
-		}
+		str_format(aBuf, sizeof(aBuf), "changed name='%s' distance=%d old_distance=%d is_substring=%d old_is_substring=%d reason='%s' old_reason='%s'", pName, Distance, pBan->m_Distance, IsSubstring, pBan->m_IsSubstring, pReason, pBan->m_aReason);
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "name_ban", aBuf);
+		pThis->m_NameBans.Ban(pName, Distance, IsSubstring, pReason);
+		return;
 	}
 
-	pThis->m_vNameBans.emplace_back(pName, Distance, IsSubstring, pReason);
+	pThis->m_NameBans.Ban(pName, Distance, IsSubstring, pReason);
 	str_format(aBuf, sizeof(aBuf), "added name='%s' distance=%d is_substring=%d reason='%s'", pName, Distance, IsSubstring, pReason);
 	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "name_ban", aBuf);
 }
@@ -2964,16 +3042,12 @@ void CServer::ConNameUnban(IConsole::IResult *pResult, void *pUser)
 	CServer *pThis = (CServer *)pUser;
 	const char *pName = pResult->GetString(0);
 
-	for(size_t i = 0; i < pThis->m_vNameBans.size(); i++)
+	if(CNameBan *pBan = pThis->m_NameBans.Find(pName))
 	{
-		CNameBan *pBan = &pThis->m_vNameBans[i];
-		if(str_comp(pBan->m_aName, pName) == 0)
-		{
-			char aBuf[128];
-			str_format(aBuf, sizeof(aBuf), "removed name='%s' distance=%d is_substring=%d reason='%s'", pBan->m_aName, pBan->m_Distance, pBan->m_IsSubstring, pBan->m_aReason);
-			pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "name_ban", aBuf);
-			pThis->m_vNameBans.erase(pThis->m_vNameBans.begin() + i);
-		}
+		char aBuf[128];
+		str_format(aBuf, sizeof(aBuf), "removed name='%s' distance=%d is_substring=%d reason='%s'", pBan->m_aName, pBan->m_Distance, pBan->m_IsSubstring, pBan->m_aReason);
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "name_ban", aBuf);
+		pThis->m_NameBans.Unban(pName);
 	}
 }
 
@@ -2981,7 +3055,7 @@ void CServer::ConNameBans(IConsole::IResult *pResult, void *pUser)
 {
 	CServer *pThis = (CServer *)pUser;
 
-	for(auto &Ban : pThis->m_vNameBans)
+	for(const auto &Ban : pThis->m_NameBans.All())
 	{
 		char aBuf[128];
 		str_format(aBuf, sizeof(aBuf), "name='%s' distance=%d is_substring=%d reason='%s'", Ban.m_aName, Ban.m_Distance, Ban.m_IsSubstring, Ban.m_aReason);
@@ -3038,6 +3112,12 @@ void CServer::ConchainLoglevel(IConsole::IResult *pResult, void *pUserData, ICon
 	log_set_loglevel((LEVEL)g_Config.m_Loglevel);
 }
 
+void CServer::ConchainLogDropPolicy(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+{
+	pfnCallback(pResult, pCallbackUserData);
+	log_set_drop_policy((LOG_DROP_POLICY)g_Config.m_LogDropPolicy);
+}
+
 void CServer::ConchainSpecialInfoupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
 {
 	pfnCallback(pResult, pCallbackUserData);
@@ -3218,6 +3298,10 @@ void CServer::RegisterCommands()
 	Console()->Register("shutdown", "?r[reason]", CFGFLAG_SERVER, ConShutdown, this, "Shut down");
 	Console()->Register("logout", "", CFGFLAG_SERVER, ConLogout, this, "Logout of rcon");
 	Console()->Register("show_ips", "?i[show]", CFGFLAG_SERVER, ConShowIps, this, "Show IP addresses in rcon commands (1 = on, 0 = off)");
+	Console()->Register("reload_worlds", "", CFGFLAG_SERVER, ConReloadWorlds, this, "Reload only the worlds whose definition or map changed in maps/worlds.json");
+	Console()->Register("net_send_stats", "", CFGFLAG_SERVER, ConNetSendStats, this, "Show how many payload bytes were copied while queueing messages");
+	Console()->Register("snap_ids", "", CFGFLAG_SERVER, ConSnapIDs, this, "Show the snapshot id usage of every world");
+	Console()->Register("storage_refresh", "", CFGFLAG_SERVER, ConStorageRefresh, this, "Refresh the storage path index and show its hits and misses");
 
 	Console()->Register("auth_add", "s[ident] s[level] r[pw]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAuthAdd, this, "Add a rcon key");
 	Console()->Register("auth_add_p", "s[ident] s[level] s[hash] s[salt]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAuthAddHashed, this, "Add a prehashed rcon key");
@@ -3232,6 +3316,7 @@ void CServer::RegisterCommands()
 
 	Console()->Chain("sv_name", ConchainSpecialInfoupdate, this);
 	Console()->Chain("loglevel", ConchainLoglevel, this);
+	Console()->Chain("log_drop_policy", ConchainLogDropPolicy, this);
 	Console()->Chain("password", ConchainSpecialInfoupdate, this);
 
 	Console()->Chain("sv_max_clients_per_ip", ConchainMaxclientsperipUpdate, this);
@@ -3254,14 +3339,22 @@ void CServer::RegisterCommands()
 	}
 }
 
-int CServer::SnapNewID()
+int CServer::SnapNewID(int WorldID)
 {
-	return m_IDPool.NewID();
+	CSnapIDPool &Pool = m_aIDPools[WorldID];
+	const int ID = Pool.NewID();
+	if(Pool.Usage() == CSnapIDPool::WARN_USAGE && Pool.PeakUsage() == CSnapIDPool::WARN_USAGE)
+	{
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "world '%s' uses %d of %d snapshot ids", GetWorldName(WorldID), Pool.Usage(), (int)CSnapIDPool::MAX_IDS);
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	}
+	return ID;
 }
 
-void CServer::SnapFreeID(int ID)
+void CServer::SnapFreeID(int WorldID, int ID)
 {
-	m_IDPool.FreeID(ID);
+	m_aIDPools[WorldID].FreeID(ID);
 }
 
 void *CServer::SnapNewItem(int Type, int ID, int Size)
@@ -3400,6 +3493,7 @@ int main(int argc, const char **argv)
 	pConsole->Register("sv_test_cmds", "", CFGFLAG_SERVER, CServer::ConTestingCommands, pConsole, "Turns testing commands aka cheats on/off (setting only works in initial config)");
 
 	log_set_loglevel((LEVEL)g_Config.m_Loglevel);
+	log_set_drop_policy((LOG_DROP_POLICY)g_Config.m_LogDropPolicy);
 	if(g_Config.m_Logfile[0])
 	{
 		IOHANDLE Logfile = io_open(g_Config.m_Logfile, IOFLAG_WRITE);
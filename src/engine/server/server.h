@@ -23,6 +23,7 @@
 #include "antibot.h"
 #include "authmanager.h"
 #include "name_ban.h"
+#include "snap_id_pool.h"
 
 #if defined(CONF_UPNP)
 #include "upnp.h"
@@ -34,47 +35,6 @@ class CLogMessage;
 class CMsgPacker;
 class CPacker;
 
-class CSnapIDPool
-{
-	enum
-	{
-		MAX_IDS = 32 * 1024,
-	};
-
-	// State of a Snap ID
-	enum
-	{
-		ID_FREE = 0,
-		ID_ALLOCATED = 1,
-		ID_TIMED = 2,
-	};
-
-	class CID
-	{
-	public:
-		short m_Next;
-		short m_State; // 0 = free, 1 = allocated, 2 = timed
-		int m_Timeout;
-	};
-
-	CID m_aIDs[MAX_IDS];
-
-	int m_FirstFree;
-	int m_FirstTimed;
-	int m_LastTimed;
-	int m_Usage;
-	int m_InUsage;
-
-public:
-	CSnapIDPool();
-
-	void Reset();
-	void RemoveFirstTimeout();
-	int NewID();
-	void TimeoutIDs();
-	void FreeID(int ID);
-};
-
 class CServerBan : public CNetBan
 {
 	class CServer *m_pServer;
@@ -192,6 +152,22 @@ public:
 
 		const IConsole::CCommandInfo *m_pRconCmdToSend;
 
+		// packed player entry of the server info, repacked only when one of its fields changes
+		class CInfoEntry
+		{
+		public:
+			char m_aName[MAX_NAME_LENGTH];
+			char m_aClan[MAX_CLAN_LENGTH];
+			int m_Country;
+			int m_Score;
+			bool m_IsPlayer;
+			bool m_Valid;
+
+			unsigned char m_aData[128];
+			int m_DataSize;
+		};
+		CInfoEntry m_InfoEntry;
+
 		void Reset();
 
 		// DDRace
@@ -212,7 +188,7 @@ public:
 
 	CSnapshotDelta m_SnapshotDelta;
 	CSnapshotBuilder m_SnapshotBuilder;
-	CSnapIDPool m_IDPool;
+	CSnapIDPool m_aIDPools[ENGINE_MAX_WORLDS];
 	CNetServer m_NetServer;
 	CEcon m_Econ;
 #if defined(CONF_FAMILY_UNIX)
@@ -245,7 +221,7 @@ public:
 
 	char m_aErrorShutdownReason[128];
 
-	std::vector<CNameBan> m_vNameBans;
+	CNameBans m_NameBans;
 
 	CServer();
 	~CServer();
@@ -296,6 +272,9 @@ public:
 	virtual int SendMsg(CMsgPacker *pMsg, int Flags, int ClientID, int64_t Mask = -1, int WorldID = -1);
 
 	void DoSnapshot(int WorldID);
+	void UpdateWorldsPopulation();
+	bool WorldNeedsTick(int WorldID) const;
+	void TickWorld(int WorldID);
 
 	static int NewClientCallback(int ClientID, void *pUser);
 	static int NewClientNoAuthCallback(int ClientID, void *pUser);
@@ -342,6 +321,7 @@ public:
 	bool m_ServerInfoNeedsUpdate;
 
 	void ExpireServerInfo() override;
+	const CClient::CInfoEntry &ServerInfoEntry(int ClientID);
 	void CacheServerInfo(CCache *pCache, int Type, bool SendClients);
 	void SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients);
 	bool RateLimitServerInfoConnless();
@@ -352,6 +332,8 @@ public:
 	void PumpNetwork(bool PacketWaiting);
 
 	bool LoadMap(int ID);
+	void PrintMapInfo(int ID);
+	void FinishWorldsReload();
 	int Run();
 
 	static void ConTestingCommands(IConsole::IResult *pResult, void *pUser);
@@ -360,6 +342,10 @@ public:
 	static void ConShutdown(IConsole::IResult *pResult, void *pUser);
 	static void ConLogout(IConsole::IResult *pResult, void *pUser);
 	static void ConShowIps(IConsole::IResult *pResult, void *pUser);
+	static void ConReloadWorlds(IConsole::IResult *pResult, void *pUser);
+	static void ConNetSendStats(IConsole::IResult *pResult, void *pUser);
+	static void ConStorageRefresh(IConsole::IResult *pResult, void *pUser);
+	static void ConSnapIDs(IConsole::IResult *pResult, void *pUser);
 
 	static void ConAuthAdd(IConsole::IResult *pResult, void *pUser);
 	static void ConAuthAddHashed(IConsole::IResult *pResult, void *pUser);
@@ -373,6 +359,7 @@ public:
 	static void ConNameBans(IConsole::IResult *pResult, void *pUser);
 
 	static void ConchainLoglevel(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
+	static void ConchainLogDropPolicy(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainSpecialInfoupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainMaxclientsperipUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainCommandAccessUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
@@ -391,8 +378,8 @@ public:
 
 	void RegisterCommands();
 
-	int SnapNewID() override;
-	void SnapFreeID(int ID) override;
+	int SnapNewID(int WorldID) override;
+	void SnapFreeID(int WorldID, int ID) override;
 	void *SnapNewItem(int Type, int ID, int Size) override;
 	void SnapSetStaticsize(int ItemType, int Size) override;
 
@@ -0,0 +1,108 @@
+#include "snap_id_pool.h"
+
+#include <base/math.h>
+
+CSnapIDPool::CSnapIDPool()
+{
+	Reset();
+}
+
+void CSnapIDPool::Reset()
+{
+	for(auto &Bucket : m_aWheel)
+	{
+		Bucket.m_First = -1;
+		Bucket.m_Last = -1;
+		Bucket.m_Num = 0;
+	}
+
+	m_NextStep = 0;
+	m_FirstFree = -1;
+	m_NumCreated = 0;
+	m_Usage = 0;
+	m_InUsage = 0;
+	m_PeakUsage = 0;
+}
+
+void CSnapIDPool::ReleaseBucket(CBucket *pBucket)
+{
+	if(pBucket->m_First == -1)
+		return;
+
+	// move the whole list in front of the free list
+	m_aIDs[pBucket->m_Last].m_Next = m_FirstFree;
+	m_FirstFree = pBucket->m_First;
+	m_Usage -= pBucket->m_Num;
+
+	pBucket->m_First = -1;
+	pBucket->m_Last = -1;
+	pBucket->m_Num = 0;
+}
+
+void CSnapIDPool::Advance(int64_t Now)
+{
+	const int64_t Step = Now / (time_freq() / WHEEL_RESOLUTION);
+	if(Step - m_NextStep >= WHEEL_SIZE)
+	{
+		TimeoutIDs();
+		m_NextStep = Step + 1;
+		return;
+	}
+
+	for(; m_NextStep <= Step; m_NextStep++)
+		ReleaseBucket(&m_aWheel[m_NextStep % WHEEL_SIZE]);
+}
+
+int CSnapIDPool::NewID(int64_t Now)
+{
+	Advance(Now);
+
+	int ID = m_FirstFree;
+	if(ID != -1)
+	{
+		m_FirstFree = m_aIDs[ID].m_Next;
+	}
+	else if(m_NumCreated < MAX_IDS)
+	{
+		ID = m_NumCreated++;
+	}
+	else
+	{
+		dbg_msg("server", "invalid id");
+		return -1;
+	}
+
+	m_aIDs[ID].m_State = ID_ALLOCATED;
+	m_Usage++;
+	m_InUsage++;
+	m_PeakUsage = maximum(m_PeakUsage, m_Usage);
+	return ID;
+}
+
+void CSnapIDPool::FreeID(int ID, int64_t Now)
+{
+	if(ID < 0)
+		return;
+	dbg_assert(ID < m_NumCreated && m_aIDs[ID].m_State == ID_ALLOCATED, "id is not allocated");
+
+	// advancing first keeps all pending steps within one turn of the wheel
+	Advance(Now);
+
+	m_InUsage--;
+	m_aIDs[ID].m_State = ID_TIMED;
+	m_aIDs[ID].m_Next = -1;
+
+	CBucket &Bucket = m_aWheel[(Now / (time_freq() / WHEEL_RESOLUTION) + ID_TIMEOUT * WHEEL_RESOLUTION + 1) % WHEEL_SIZE];
+	if(Bucket.m_Last != -1)
+		m_aIDs[Bucket.m_Last].m_Next = ID;
+	else
+		Bucket.m_First = ID;
+	Bucket.m_Last = ID;
+	Bucket.m_Num++;
+}
+
+void CSnapIDPool::TimeoutIDs()
+{
+	for(auto &Bucket : m_aWheel)
+		ReleaseBucket(&Bucket);
+}
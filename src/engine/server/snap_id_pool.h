@@ -0,0 +1,84 @@
+#ifndef ENGINE_SERVER_SNAP_ID_POOL_H
+#define ENGINE_SERVER_SNAP_ID_POOL_H
+
+#include <base/system.h>
+
+/*
+	Snapshot item ids of one world. Only the thread that simulates the world
+	uses its pool, so there's no locking. Freed ids stay reserved for a few
+	seconds, so clients drop them from their snapshots before they're reused.
+	They're kept in a timeout wheel where a whole time step is released at
+	once.
+*/
+class CSnapIDPool
+{
+public:
+	enum
+	{
+		MAX_IDS = 32 * 1024,
+		// usage at which the server warns about the world
+		WARN_USAGE = MAX_IDS / 10 * 9,
+	};
+
+private:
+	enum
+	{
+		// seconds a freed id stays reserved
+		ID_TIMEOUT = 5,
+		// steps per second of the timeout wheel
+		WHEEL_RESOLUTION = 8,
+		// must be larger than ID_TIMEOUT * WHEEL_RESOLUTION + 1
+		WHEEL_SIZE = 64,
+	};
+
+	// State of a Snap ID
+	enum
+	{
+		ID_ALLOCATED = 1,
+		ID_TIMED = 2, // kept by released ids until they're handed out again
+	};
+
+	struct CID
+	{
+		int m_Next;
+		int m_State;
+	};
+
+	struct CBucket
+	{
+		int m_First;
+		int m_Last;
+		int m_Num;
+	};
+
+	// ids at or above m_NumCreated were never handed out and are untouched
+	CID m_aIDs[MAX_IDS];
+	CBucket m_aWheel[WHEEL_SIZE];
+
+	int64_t m_NextStep; // steps before this one were released
+	int m_FirstFree;
+	int m_NumCreated;
+	int m_Usage; // allocated and timed ids
+	int m_InUsage; // allocated ids
+	int m_PeakUsage;
+
+	void ReleaseBucket(CBucket *pBucket);
+	void Advance(int64_t Now);
+
+public:
+	CSnapIDPool();
+
+	void Reset();
+	int NewID() { return NewID(time_get()); }
+	int NewID(int64_t Now);
+	void FreeID(int ID) { FreeID(ID, time_get()); }
+	void FreeID(int ID, int64_t Now);
+	// releases all timed ids right away
+	void TimeoutIDs();
+
+	int Usage() const { return m_Usage; }
+	int InUsage() const { return m_InUsage; }
+	int PeakUsage() const { return m_PeakUsage; }
+};
+
+#endif
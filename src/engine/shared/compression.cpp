@@ -6,6 +6,12 @@
 
 #include <iterator> // std::size
 
+#if defined(CONF_ARCH_SSE2)
+#include <emmintrin.h>
+#elif defined(CONF_ARCH_NEON)
+#include <arm_neon.h>
+#endif
+
 // Format: ESDDDDDD EDDDDDDD EDD... Extended, Data, Sign
 unsigned char *CVariableInt::Pack(unsigned char *pDst, int i, int DstSize)
 {
@@ -65,6 +71,92 @@ const unsigned char *CVariableInt::Unpack(const unsigned char *pSrc, int *pInOut
 	return pSrc;
 }
 
+// packs 4 ints if all of them fit into a single byte, which covers the
+// runs of zeros and small deltas that make up most of a snapshot delta
+static inline bool PackSmall4(const int *pSrc, unsigned char *pDst)
+{
+#if defined(CONF_ARCH_SSE2)
+	const __m128i Value = _mm_loadu_si128((const __m128i *)pSrc);
+	const __m128i InRange = _mm_and_si128(_mm_cmpgt_epi32(Value, _mm_set1_epi32(-65)), _mm_cmplt_epi32(Value, _mm_set1_epi32(64)));
+	if(_mm_movemask_epi8(InRange) != 0xFFFF)
+		return false;
+
+	const __m128i Sign = _mm_srai_epi32(Value, 31);
+	__m128i Bytes = _mm_or_si128(_mm_and_si128(_mm_xor_si128(Value, Sign), _mm_set1_epi32(0x3F)), _mm_and_si128(Sign, _mm_set1_epi32(0x40)));
+	Bytes = _mm_packs_epi32(Bytes, Bytes);
+	Bytes = _mm_packus_epi16(Bytes, Bytes);
+	const int Packed = _mm_cvtsi128_si32(Bytes);
+	mem_copy(pDst, &Packed, sizeof(Packed));
+	return true;
+#elif defined(CONF_ARCH_NEON)
+	const int32x4_t Value = vld1q_s32(pSrc);
+	const uint32x4_t InRange = vandq_u32(vcgeq_s32(Value, vdupq_n_s32(-64)), vcleq_s32(Value, vdupq_n_s32(63)));
+	const uint32x2_t InRangeHalf = vand_u32(vget_low_u32(InRange), vget_high_u32(InRange));
+	if((vget_lane_u32(InRangeHalf, 0) & vget_lane_u32(InRangeHalf, 1)) != 0xFFFFFFFF)
+		return false;
+
+	const int32x4_t Sign = vshrq_n_s32(Value, 31);
+	const int32x4_t Bytes = vorrq_s32(vandq_s32(veorq_s32(Value, Sign), vdupq_n_s32(0x3F)), vandq_s32(Sign, vdupq_n_s32(0x40)));
+	const int16x4_t Bytes16 = vmovn_s32(Bytes);
+	const int8x8_t Bytes8 = vmovn_s16(vcombine_s16(Bytes16, Bytes16));
+	const int Packed = vget_lane_s32(vreinterpret_s32_s8(Bytes8), 0);
+	mem_copy(pDst, &Packed, sizeof(Packed));
+	return true;
+#else
+	for(int i = 0; i < 4; i++)
+	{
+		if(pSrc[i] < -64 || pSrc[i] > 63)
+			return false;
+	}
+	for(int i = 0; i < 4; i++)
+		pDst[i] = pSrc[i] < 0 ? (0x40 | (~pSrc[i] & 0x3F)) : pSrc[i];
+	return true;
+#endif
+}
+
+// unpacks 16 bytes if none of them has the extend bit set
+static inline bool UnpackSmall16(const unsigned char *pSrc, int *pDst)
+{
+#if defined(CONF_ARCH_SSE2)
+	const __m128i Bytes = _mm_loadu_si128((const __m128i *)pSrc);
+	if(_mm_movemask_epi8(Bytes) != 0)
+		return false;
+
+	const __m128i Zero = _mm_setzero_si128();
+	const __m128i aWords[2] = {_mm_unpacklo_epi8(Bytes, Zero), _mm_unpackhi_epi8(Bytes, Zero)};
+	for(int i = 0; i < 4; i++)
+	{
+		const __m128i Value = i & 1 ? _mm_unpackhi_epi16(aWords[i / 2], Zero) : _mm_unpacklo_epi16(aWords[i / 2], Zero);
+		const __m128i Sign = _mm_srai_epi32(_mm_slli_epi32(Value, 25), 31);
+		_mm_storeu_si128((__m128i *)(pDst + i * 4), _mm_xor_si128(_mm_and_si128(Value, _mm_set1_epi32(0x3F)), Sign));
+	}
+	return true;
+#elif defined(CONF_ARCH_NEON)
+	const uint8x16_t Bytes = vld1q_u8(pSrc);
+	const uint64x2_t Extend = vreinterpretq_u64_u8(vandq_u8(Bytes, vdupq_n_u8(0x80)));
+	if(vgetq_lane_u64(Extend, 0) | vgetq_lane_u64(Extend, 1))
+		return false;
+
+	const uint16x8_t aWords[2] = {vmovl_u8(vget_low_u8(Bytes)), vmovl_u8(vget_high_u8(Bytes))};
+	for(int i = 0; i < 4; i++)
+	{
+		const int32x4_t Value = vreinterpretq_s32_u32(vmovl_u16(i & 1 ? vget_high_u16(aWords[i / 2]) : vget_low_u16(aWords[i / 2])));
+		const int32x4_t Sign = vshrq_n_s32(vshlq_n_s32(Value, 25), 31);
+		vst1q_s32(pDst + i * 4, veorq_s32(vandq_s32(Value, vdupq_n_s32(0x3F)), Sign));
+	}
+	return true;
+#else
+	for(int i = 0; i < 16; i++)
+	{
+		if(pSrc[i] & 0x80)
+			return false;
+	}
+	for(int i = 0; i < 16; i++)
+		pDst[i] = (pSrc[i] & 0x3F) ^ -((pSrc[i] >> 6) & 1);
+	return true;
+#endif
+}
+
 long CVariableInt::Decompress(const void *pSrc_, int SrcSize, void *pDst_, int DstSize)
 {
 	dbg_assert(DstSize % sizeof(int) == 0, "invalid bounds");
@@ -75,8 +167,21 @@ long CVariableInt::Decompress(const void *pSrc_, int SrcSize, void *pDst_, int D
 	const int *pDstEnd = pDst + DstSize / sizeof(int);
 	while(pSrc < pSrcEnd)
 	{
+		if(pSrcEnd - pSrc >= 16 && pDstEnd - pDst >= 16 && UnpackSmall16(pSrc, pDst))
+		{
+			pSrc += 16;
+			pDst += 16;
+			continue;
+		}
+
 		if(pDst >= pDstEnd)
 			return -1;
+		if(!(*pSrc & 0x80))
+		{
+			*pDst++ = (*pSrc & 0x3F) ^ -((*pSrc >> 6) & 1);
+			pSrc++;
+			continue;
+		}
 		pSrc = CVariableInt::Unpack(pSrc, pDst, pSrcEnd - pSrc);
 		if(!pSrc)
 			return -1;
@@ -89,6 +194,58 @@ long CVariableInt::Compress(const void *pSrc_, int SrcSize, void *pDst_, int Dst
 {
 	dbg_assert(SrcSize % sizeof(int) == 0, "invalid bounds");
 
+	const int *pSrc = (int *)pSrc_;
+	const int *pSrcEnd = pSrc + SrcSize / sizeof(int);
+	unsigned char *pDst = (unsigned char *)pDst_;
+	const unsigned char *pDstEnd = pDst + DstSize;
+	while(pSrc < pSrcEnd)
+	{
+		if(pSrcEnd - pSrc >= 4 && pDstEnd - pDst >= 4 && PackSmall4(pSrc, pDst))
+		{
+			pSrc += 4;
+			pDst += 4;
+			continue;
+		}
+
+		const int Value = *pSrc;
+		if(Value >= -64 && Value <= 63 && pDst < pDstEnd)
+		{
+			*pDst++ = Value < 0 ? (0x40 | (~Value & 0x3F)) : Value;
+			pSrc++;
+			continue;
+		}
+		pDst = CVariableInt::Pack(pDst, Value, pDstEnd - pDst);
+		if(!pDst)
+			return -1;
+		pSrc++;
+	}
+	return (long)(pDst - (unsigned char *)pDst_);
+}
+
+long CVariableInt::DecompressScalar(const void *pSrc_, int SrcSize, void *pDst_, int DstSize)
+{
+	dbg_assert(DstSize % sizeof(int) == 0, "invalid bounds");
+
+	const unsigned char *pSrc = (unsigned char *)pSrc_;
+	const unsigned char *pSrcEnd = pSrc + SrcSize;
+	int *pDst = (int *)pDst_;
+	const int *pDstEnd = pDst + DstSize / sizeof(int);
+	while(pSrc < pSrcEnd)
+	{
+		if(pDst >= pDstEnd)
+			return -1;
+		pSrc = CVariableInt::Unpack(pSrc, pDst, pSrcEnd - pSrc);
+		if(!pSrc)
+			return -1;
+		pDst++;
+	}
+	return (long)((unsigned char *)pDst - (unsigned char *)pDst_);
+}
+
+long CVariableInt::CompressScalar(const void *pSrc_, int SrcSize, void *pDst_, int DstSize)
+{
+	dbg_assert(SrcSize % sizeof(int) == 0, "invalid bounds");
+
 	const int *pSrc = (int *)pSrc_;
 	unsigned char *pDst = (unsigned char *)pDst_;
 	const unsigned char *pDstEnd = pDst + DstSize;
@@ -17,6 +17,10 @@ public:
 
 	static long Compress(const void *pSrc, int SrcSize, void *pDst, int DstSize);
 	static long Decompress(const void *pSrc, int SrcSize, void *pDst, int DstSize);
+
+	// reference implementations without the vectorized fast paths
+	static long CompressScalar(const void *pSrc, int SrcSize, void *pDst, int DstSize);
+	static long DecompressScalar(const void *pSrc, int SrcSize, void *pDst, int DstSize);
 };
 
 #endif
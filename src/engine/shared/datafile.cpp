@@ -3,13 +3,20 @@
 
 #include "datafile.h"
 
-#include <base/hash_ctxt.h>
+#include <base/math.h>
 #include <base/system.h>
 #include <engine/storage.h>
 
 #include "uuid_manager.h"
 
+#include <engine/engine.h>
+
+#include <atomic>
 #include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 static const int DEBUG = 0;
 
@@ -91,19 +98,50 @@ struct CDatafileInfo
 	char *m_pDataStart;
 };
 
+// decompressed data, shared by the readers that load identical compressed data
+struct CDatafileBlock
+{
+	void *m_pData = nullptr;
+	~CDatafileBlock() { free(m_pData); }
+};
+
+enum
+{
+	DATA_NOT_LOADED = 0,
+	DATA_LOADED,
+	DATA_UNLOADED,
+	DATA_CLOSED,
+
+	MAX_PRELOAD_JOBS = 8,
+};
+
+// load states of the data, shared with the preload jobs that may outlive the reader
+struct CDatafileLoader
+{
+	struct CDatafile *m_pDataFile;
+	std::unique_ptr<std::atomic<int>[]> m_pStates;
+	// held while the data is loaded or unloaded
+	std::unique_ptr<std::mutex[]> m_pLocks;
+};
+
 struct CDatafile
 {
 	IOHANDLE m_File;
+	unsigned char *m_pFileData;
+	unsigned m_FileSize;
+	bool m_ShareData;
 	SHA256_DIGEST m_Sha256;
 	unsigned m_Crc;
 	CDatafileInfo m_Info;
 	CDatafileHeader m_Header;
 	int m_DataStartOffset;
-	char **m_ppDataPtrs;
+	std::vector<char *> m_vpDataPtrs;
+	std::vector<std::shared_ptr<CDatafileBlock>> m_vpDataBlocks;
+	std::shared_ptr<CDatafileLoader> m_pLoader;
 	char *m_pData;
 };
 
-bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int StorageType)
+bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int StorageType, bool ShareData)
 {
 	dbg_msg("datafile", "loading. filename='%s'", pFilename);
 
@@ -114,44 +152,50 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		return false;
 	}
 
-	// take the CRC of the file and store it
-	unsigned Crc = 0;
-	SHA256_DIGEST Sha256;
+	// read the whole file, items and uncompressed data are used in place and
+	// stay valid if the file is replaced or truncated on disk
+	void *pRead;
+	unsigned FileSize;
+	io_read_all(File, &pRead, &FileSize);
+	if(!OpenFileData(pFilename, (unsigned char *)pRead, FileSize, File, ShareData))
 	{
-		enum
-		{
-			BUFFER_SIZE = 64 * 1024
-		};
+		io_close(File);
+		return false;
+	}
+	return true;
+}
 
-		SHA256_CTX Sha256Ctxt;
-		sha256_init(&Sha256Ctxt);
-		unsigned char aBuffer[BUFFER_SIZE];
+bool CDataFileReader::Open(const char *pFilename, const void *pData, unsigned DataSize, bool ShareData)
+{
+	dbg_msg("datafile", "loading. filename='%s'", pFilename);
 
-		while(true)
-		{
-			unsigned Bytes = io_read(File, aBuffer, BUFFER_SIZE);
-			if(Bytes <= 0)
-				break;
-			Crc = crc32(Crc, aBuffer, Bytes);
-			sha256_update(&Sha256Ctxt, aBuffer, Bytes);
-		}
-		Sha256 = sha256_finish(&Sha256Ctxt);
+	// the reader owns its copy, the data is swapped in place on big endian
+	unsigned char *pFileData = (unsigned char *)malloc(maximum(DataSize, 1u));
+	mem_copy(pFileData, pData, DataSize);
+	return OpenFileData(pFilename, pFileData, DataSize, 0, ShareData);
+}
 
-		io_seek(File, 0, IOSEEK_START);
-	}
+bool CDataFileReader::OpenFileData(const char *pFilename, unsigned char *pFileData, unsigned FileSize, IOHANDLE File, bool ShareData)
+{
+	// take the CRC of the file and store it
+	const unsigned Crc = crc32(0, pFileData, FileSize);
+	const SHA256_DIGEST Sha256 = sha256(pFileData, FileSize);
 
 	// TODO: change this header
 	CDatafileHeader Header;
-	if(sizeof(Header) != io_read(File, &Header, sizeof(Header)))
+	if(FileSize < sizeof(Header))
 	{
 		dbg_msg("datafile", "couldn't load header");
+		free(pFileData);
 		return false;
 	}
+	mem_copy(&Header, pFileData, sizeof(Header));
 	if(Header.m_aID[0] != 'A' || Header.m_aID[1] != 'T' || Header.m_aID[2] != 'A' || Header.m_aID[3] != 'D')
 	{
 		if(Header.m_aID[0] != 'D' || Header.m_aID[1] != 'A' || Header.m_aID[2] != 'T' || Header.m_aID[3] != 'A')
 		{
 			dbg_msg("datafile", "wrong signature. %x %x %x %x", Header.m_aID[0], Header.m_aID[1], Header.m_aID[2], Header.m_aID[3]);
+			free(pFileData);
 			return false;
 		}
 	}
@@ -162,10 +206,11 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	if(Header.m_Version != 3 && Header.m_Version != 4)
 	{
 		dbg_msg("datafile", "wrong version. version=%x", Header.m_Version);
+		free(pFileData);
 		return false;
 	}
 
-	// read in the rest except the data
+	// the types, offsets, sizes and item data follow the header
 	unsigned Size = 0;
 	Size += Header.m_NumItemTypes * sizeof(CDatafileItemType);
 	Size += (Header.m_NumItems + Header.m_NumRawData) * sizeof(int);
@@ -173,35 +218,38 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		Size += Header.m_NumRawData * sizeof(int); // v4 has uncompressed data sizes as well
 	Size += Header.m_ItemSize;
 
-	unsigned AllocSize = Size;
-	AllocSize += sizeof(CDatafile); // add space for info structure
-	AllocSize += Header.m_NumRawData * sizeof(void *); // add space for data pointers
-
-	CDatafile *pTmpDataFile = (CDatafile *)malloc(AllocSize);
-	pTmpDataFile->m_Header = Header;
-	pTmpDataFile->m_DataStartOffset = sizeof(CDatafileHeader) + Size;
-	pTmpDataFile->m_ppDataPtrs = (char **)(pTmpDataFile + 1);
-	pTmpDataFile->m_pData = (char *)(pTmpDataFile + 1) + Header.m_NumRawData * sizeof(char *);
-	pTmpDataFile->m_File = File;
-	pTmpDataFile->m_Sha256 = Sha256;
-	pTmpDataFile->m_Crc = Crc;
-
-	// clear the data pointers
-	mem_zero(pTmpDataFile->m_ppDataPtrs, Header.m_NumRawData * sizeof(void *));
-
-	// read types, offsets, sizes and item data
-	unsigned ReadSize = io_read(File, pTmpDataFile->m_pData, Size);
-	if(ReadSize != Size)
-	{
-		io_close(pTmpDataFile->m_File);
-		free(pTmpDataFile);
-		pTmpDataFile = 0;
-		dbg_msg("datafile", "couldn't load the whole thing, wanted=%d got=%d", Size, ReadSize);
+	if(Header.m_NumItemTypes < 0 || Header.m_NumItems < 0 || Header.m_NumRawData < 0 || Header.m_ItemSize < 0 ||
+		Size > FileSize - sizeof(CDatafileHeader))
+	{
+		dbg_msg("datafile", "couldn't load the whole thing, wanted=%d got=%d", Size, (int)(FileSize - sizeof(CDatafileHeader)));
+		free(pFileData);
 		return false;
 	}
 
 	Close();
-	m_pDataFile = pTmpDataFile;
+	m_pDataFile = new CDatafile;
+	m_pDataFile->m_Header = Header;
+	m_pDataFile->m_DataStartOffset = sizeof(CDatafileHeader) + Size;
+	m_pDataFile->m_File = File;
+	m_pDataFile->m_pFileData = pFileData;
+	m_pDataFile->m_FileSize = FileSize;
+#if defined(CONF_ARCH_ENDIAN_BIG)
+	// data is swapped in place on first access
+	m_pDataFile->m_ShareData = false;
+#else
+	m_pDataFile->m_ShareData = ShareData;
+#endif
+	m_pDataFile->m_Sha256 = Sha256;
+	m_pDataFile->m_Crc = Crc;
+	m_pDataFile->m_pData = (char *)pFileData + sizeof(CDatafileHeader);
+	m_pDataFile->m_vpDataPtrs.resize(Header.m_NumRawData, nullptr);
+	m_pDataFile->m_vpDataBlocks.resize(Header.m_NumRawData);
+	m_pDataFile->m_pLoader = std::make_shared<CDatafileLoader>();
+	m_pDataFile->m_pLoader->m_pDataFile = m_pDataFile;
+	m_pDataFile->m_pLoader->m_pStates = std::make_unique<std::atomic<int>[]>(Header.m_NumRawData);
+	m_pDataFile->m_pLoader->m_pLocks = std::make_unique<std::mutex[]>(Header.m_NumRawData);
+	for(int i = 0; i < Header.m_NumRawData; i++)
+		m_pDataFile->m_pLoader->m_pStates[i] = DATA_NOT_LOADED;
 
 #if defined(CONF_ARCH_ENDIAN_BIG)
 	swap_endian(m_pDataFile->m_pData, sizeof(int), minimum(static_cast<unsigned>(Header.m_Swaplen), Size) / sizeof(int));
@@ -209,8 +257,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 
 	if(DEBUG)
 	{
-		dbg_msg("datafile", "allocsize=%d", AllocSize);
-		dbg_msg("datafile", "readsize=%d", ReadSize);
+		dbg_msg("datafile", "filesize=%d", FileSize);
 		dbg_msg("datafile", "swaplen=%d", Header.m_Swaplen);
 		dbg_msg("datafile", "item_size=%d", m_pDataFile->m_Header.m_ItemSize);
 	}
@@ -241,16 +288,20 @@ int CDataFileReader::NumData() const
 }
 
 // returns the size in the file
+static int FileDataSize(const CDatafile *pDataFile, int Index)
+{
+	if(Index == pDataFile->m_Header.m_NumRawData - 1)
+		return pDataFile->m_Header.m_DataSize - pDataFile->m_Info.m_pDataOffsets[Index];
+	return pDataFile->m_Info.m_pDataOffsets[Index + 1] - pDataFile->m_Info.m_pDataOffsets[Index];
+}
+
 int CDataFileReader::GetFileDataSize(int Index)
 {
 	if(!m_pDataFile)
 	{
 		return 0;
 	}
-
-	if(Index == m_pDataFile->m_Header.m_NumRawData - 1)
-		return m_pDataFile->m_Header.m_DataSize - m_pDataFile->m_Info.m_pDataOffsets[Index];
-	return m_pDataFile->m_Info.m_pDataOffsets[Index + 1] - m_pDataFile->m_Info.m_pDataOffsets[Index];
+	return FileDataSize(m_pDataFile, Index);
 }
 
 // returns the size of the resulting data
@@ -267,65 +318,145 @@ int CDataFileReader::GetDataSize(int Index)
 		return GetFileDataSize(Index);
 }
 
-void *CDataFileReader::GetDataImpl(int Index, int Swap)
+struct CDatafileBlockKey
 {
-	if(!m_pDataFile)
+	SHA256_DIGEST m_Sha256;
+	unsigned long m_Size;
+
+	bool operator<(const CDatafileBlockKey &Other) const
 	{
-		return 0;
+		if(m_Size != Other.m_Size)
+			return m_Size < Other.m_Size;
+		return mem_comp(m_Sha256.data, Other.m_Sha256.data, sizeof(m_Sha256.data)) < 0;
 	}
+};
 
-	if(Index < 0 || Index >= m_pDataFile->m_Header.m_NumRawData)
-		return 0;
+static std::mutex gs_DataBlocksMutex;
+static std::map<CDatafileBlockKey, std::weak_ptr<CDatafileBlock>> gs_DataBlocks;
 
-	// load it if needed
-	if(!m_pDataFile->m_ppDataPtrs[Index])
+static std::shared_ptr<CDatafileBlock> DecompressData(const unsigned char *pSrc, int SrcSize, unsigned long UncompressedSize, bool Share)
+{
+	CDatafileBlockKey Key;
+	if(Share)
 	{
-		// fetch the data size
-		int DataSize = GetFileDataSize(Index);
-#if defined(CONF_ARCH_ENDIAN_BIG)
-		int SwapSize = DataSize;
-#endif
-
-		if(m_pDataFile->m_Header.m_Version == 4)
+		Key.m_Sha256 = sha256(pSrc, SrcSize);
+		Key.m_Size = UncompressedSize;
+		std::lock_guard<std::mutex> Lock(gs_DataBlocksMutex);
+		auto It = gs_DataBlocks.find(Key);
+		if(It != gs_DataBlocks.end())
 		{
-			// v4 has compressed data
-			void *pTemp = malloc(DataSize);
-			unsigned long UncompressedSize = m_pDataFile->m_Info.m_pDataSizes[Index];
-			unsigned long s;
+			std::shared_ptr<CDatafileBlock> pBlock = It->second.lock();
+			if(pBlock)
+				return pBlock;
+		}
+	}
 
-			dbg_msg("datafile", "loading data index=%d size=%d uncompressed=%lu", Index, DataSize, UncompressedSize);
-			m_pDataFile->m_ppDataPtrs[Index] = (char *)malloc(UncompressedSize);
+	std::shared_ptr<CDatafileBlock> pBlock = std::make_shared<CDatafileBlock>();
+	pBlock->m_pData = malloc(maximum(UncompressedSize, 1ul));
+	unsigned long s = UncompressedSize;
+	const int Result = uncompress((Bytef *)pBlock->m_pData, &s, (const Bytef *)pSrc, SrcSize);
+	if(Result != Z_OK)
+	{
+		dbg_msg("datafile", "failed to decompress data. error=%d", Result);
+		mem_zero(pBlock->m_pData, UncompressedSize);
+		return pBlock;
+	}
+	if(s < UncompressedSize)
+		mem_zero((char *)pBlock->m_pData + s, UncompressedSize - s);
 
-			// read the compressed data
-			io_seek(m_pDataFile->m_File, m_pDataFile->m_DataStartOffset + m_pDataFile->m_Info.m_pDataOffsets[Index], IOSEEK_START);
-			io_read(m_pDataFile->m_File, pTemp, DataSize);
+	if(Share)
+	{
+		std::lock_guard<std::mutex> Lock(gs_DataBlocksMutex);
+		for(auto It = gs_DataBlocks.begin(); It != gs_DataBlocks.end();)
+		{
+			if(It->second.expired())
+				It = gs_DataBlocks.erase(It);
+			else
+				++It;
+		}
 
-			// decompress the data, TODO: check for errors
-			s = UncompressedSize;
-			uncompress((Bytef *)m_pDataFile->m_ppDataPtrs[Index], &s, (Bytef *)pTemp, DataSize);
+		// another reader may have decompressed the same data meanwhile
+		std::weak_ptr<CDatafileBlock> &Entry = gs_DataBlocks[Key];
+		std::shared_ptr<CDatafileBlock> pExisting = Entry.lock();
+		if(pExisting)
+			return pExisting;
+		Entry = pBlock;
+	}
+	return pBlock;
+}
+
+// must only be called with the lock of the data held
+static void LoadData(CDatafile *pDataFile, int Index, int Swap)
+{
+	// fetch the data size
+	const int DataSize = FileDataSize(pDataFile, Index);
+	const int Offset = pDataFile->m_DataStartOffset + pDataFile->m_Info.m_pDataOffsets[Index];
+	if(DataSize < 0 || pDataFile->m_Info.m_pDataOffsets[Index] < 0 || (unsigned)Offset + (unsigned)DataSize > pDataFile->m_FileSize ||
+		(pDataFile->m_Header.m_Version == 4 && pDataFile->m_Info.m_pDataSizes[Index] < 0))
+	{
+		dbg_msg("datafile", "data index=%d is out of the file", Index);
+		return;
+	}
+	const unsigned char *pSrc = pDataFile->m_pFileData + Offset;
 #if defined(CONF_ARCH_ENDIAN_BIG)
-			SwapSize = s;
+	int SwapSize = DataSize;
 #endif
 
-			// clean up the temporary buffers
-			free(pTemp);
-		}
-		else
-		{
-			// load the data
-			dbg_msg("datafile", "loading data index=%d size=%d", Index, DataSize);
-			m_pDataFile->m_ppDataPtrs[Index] = (char *)malloc(DataSize);
-			io_seek(m_pDataFile->m_File, m_pDataFile->m_DataStartOffset + m_pDataFile->m_Info.m_pDataOffsets[Index], IOSEEK_START);
-			io_read(m_pDataFile->m_File, m_pDataFile->m_ppDataPtrs[Index], DataSize);
-		}
+	if(pDataFile->m_Header.m_Version == 4)
+	{
+		// v4 has compressed data
+		const unsigned long UncompressedSize = pDataFile->m_Info.m_pDataSizes[Index];
+		dbg_msg("datafile", "loading data index=%d size=%d uncompressed=%lu", Index, DataSize, UncompressedSize);
+		pDataFile->m_vpDataBlocks[Index] = DecompressData(pSrc, DataSize, UncompressedSize, pDataFile->m_ShareData);
+		pDataFile->m_vpDataPtrs[Index] = (char *)pDataFile->m_vpDataBlocks[Index]->m_pData;
+#if defined(CONF_ARCH_ENDIAN_BIG)
+		SwapSize = UncompressedSize;
+#endif
+	}
+	else
+	{
+		dbg_msg("datafile", "loading data index=%d size=%d", Index, DataSize);
+#if defined(CONF_ARCH_ENDIAN_BIG)
+		// copy, so unloading and loading it again doesn't swap it twice
+		pDataFile->m_vpDataBlocks[Index] = std::make_shared<CDatafileBlock>();
+		pDataFile->m_vpDataBlocks[Index]->m_pData = malloc(maximum(DataSize, 1));
+		mem_copy(pDataFile->m_vpDataBlocks[Index]->m_pData, pSrc, DataSize);
+		pDataFile->m_vpDataPtrs[Index] = (char *)pDataFile->m_vpDataBlocks[Index]->m_pData;
+#else
+		// the file was read into memory, so the data can be used in place
+		pDataFile->m_vpDataPtrs[Index] = (char *)pSrc;
+#endif
+	}
 
 #if defined(CONF_ARCH_ENDIAN_BIG)
-		if(Swap && SwapSize)
-			swap_endian(m_pDataFile->m_ppDataPtrs[Index], sizeof(int), SwapSize / sizeof(int));
+	if(Swap && SwapSize)
+		swap_endian(pDataFile->m_vpDataPtrs[Index], sizeof(int), SwapSize / sizeof(int));
 #endif
+}
+
+void *CDataFileReader::GetDataImpl(int Index, int Swap)
+{
+	if(!m_pDataFile)
+	{
+		return 0;
 	}
 
-	return m_pDataFile->m_ppDataPtrs[Index];
+	if(Index < 0 || Index >= m_pDataFile->m_Header.m_NumRawData)
+		return 0;
+
+	// load it if needed, or wait for the preload job that is loading it
+	CDatafileLoader *pLoader = m_pDataFile->m_pLoader.get();
+	if(pLoader->m_pStates[Index].load() != DATA_LOADED)
+	{
+		std::lock_guard<std::mutex> Lock(pLoader->m_pLocks[Index]);
+		if(pLoader->m_pStates[Index].load() != DATA_LOADED)
+		{
+			LoadData(m_pDataFile, Index, Swap);
+			pLoader->m_pStates[Index].store(DATA_LOADED);
+		}
+	}
+
+	return m_pDataFile->m_vpDataPtrs[Index];
 }
 
 void *CDataFileReader::GetData(int Index)
@@ -343,9 +474,76 @@ void CDataFileReader::UnloadData(int Index)
 	if(Index < 0 || Index >= m_pDataFile->m_Header.m_NumRawData)
 		return;
 
+	CDatafileLoader *pLoader = m_pDataFile->m_pLoader.get();
+	std::lock_guard<std::mutex> Lock(pLoader->m_pLocks[Index]);
+	if(pLoader->m_pStates[Index].load() != DATA_LOADED)
+		return;
+
 	//
-	free(m_pDataFile->m_ppDataPtrs[Index]);
-	m_pDataFile->m_ppDataPtrs[Index] = 0x0;
+	m_pDataFile->m_vpDataBlocks[Index] = nullptr;
+	m_pDataFile->m_vpDataPtrs[Index] = 0x0;
+	pLoader->m_pStates[Index].store(DATA_UNLOADED);
+}
+
+class CDatafilePreloadJob : public IJob
+{
+public:
+	struct CPreload
+	{
+		std::shared_ptr<CDatafileLoader> m_pLoader;
+		std::vector<int> m_vIndices;
+		std::atomic<int> m_Next;
+	};
+
+private:
+	std::shared_ptr<CPreload> m_pPreload;
+
+	void Run() override
+	{
+		const int Num = m_pPreload->m_vIndices.size();
+		for(int i = m_pPreload->m_Next++; i < Num; i = m_pPreload->m_Next++)
+		{
+			// skip data that is being loaded, was loaded already or whose reader was closed
+			const int Index = m_pPreload->m_vIndices[i];
+			CDatafileLoader *pLoader = m_pPreload->m_pLoader.get();
+			std::unique_lock<std::mutex> Lock(pLoader->m_pLocks[Index], std::try_to_lock);
+			if(!Lock.owns_lock() || pLoader->m_pStates[Index].load() != DATA_NOT_LOADED)
+				continue;
+			LoadData(pLoader->m_pDataFile, Index, 0);
+			pLoader->m_pStates[Index].store(DATA_LOADED);
+		}
+	}
+
+public:
+	CDatafilePreloadJob(std::shared_ptr<CPreload> pPreload) :
+		m_pPreload(std::move(pPreload))
+	{
+	}
+};
+
+void CDataFileReader::PreloadData(IEngine *pEngine, const std::vector<int> &vIndices)
+{
+	if(!m_pDataFile)
+		return;
+#if defined(CONF_ARCH_ENDIAN_BIG)
+	// GetDataSwapped swaps the data when it's loaded
+	return;
+#endif
+
+	std::shared_ptr<CDatafilePreloadJob::CPreload> pPreload = std::make_shared<CDatafilePreloadJob::CPreload>();
+	pPreload->m_pLoader = m_pDataFile->m_pLoader;
+	for(int Index : vIndices)
+	{
+		if(Index >= 0 && Index < m_pDataFile->m_Header.m_NumRawData)
+			pPreload->m_vIndices.push_back(Index);
+	}
+	pPreload->m_Next = 0;
+	if(pPreload->m_vIndices.empty())
+		return;
+
+	const int NumJobs = minimum((int)pPreload->m_vIndices.size(), (int)MAX_PRELOAD_JOBS);
+	for(int i = 0; i < NumJobs; i++)
+		pEngine->AddJob(std::make_shared<CDatafilePreloadJob>(pPreload));
 }
 
 int CDataFileReader::GetItemSize(int Index) const
@@ -484,13 +682,20 @@ bool CDataFileReader::Close()
 	if(!m_pDataFile)
 		return true;
 
-	// free the data that is loaded
-	int i;
-	for(i = 0; i < m_pDataFile->m_Header.m_NumRawData; i++)
-		free(m_pDataFile->m_ppDataPtrs[i]);
+	// keep preload jobs away from the data and wait for the ones still loading
+	CDatafileLoader *pLoader = m_pDataFile->m_pLoader.get();
+	for(int i = 0; i < m_pDataFile->m_Header.m_NumRawData; i++)
+	{
+		std::lock_guard<std::mutex> Lock(pLoader->m_pLocks[i]);
+		pLoader->m_pStates[i].store(DATA_CLOSED);
+	}
+	m_pDataFile->m_pLoader->m_pDataFile = nullptr;
 
-	io_close(m_pDataFile->m_File);
-	free(m_pDataFile);
+	// free the data that is loaded
+	free(m_pDataFile->m_pFileData);
+	if(m_pDataFile->m_File)
+		io_close(m_pDataFile->m_File);
+	delete m_pDataFile;
 	m_pDataFile = 0;
 	return true;
 }
@@ -533,6 +738,7 @@ IOHANDLE CDataFileReader::File()
 CDataFileWriter::CDataFileWriter()
 {
 	m_File = 0;
+	m_NumCompressionThreads = 0;
 	m_pItemTypes = static_cast<CItemTypeInfo *>(calloc(MAX_ITEM_TYPES, sizeof(CItemTypeInfo)));
 	m_pItems = static_cast<CItemInfo *>(calloc(MAX_ITEMS, sizeof(CItemInfo)));
 	m_pDatas = static_cast<CDataInfo *>(calloc(MAX_DATAS, sizeof(CDataInfo)));
@@ -545,7 +751,10 @@ CDataFileWriter::~CDataFileWriter()
 	for(int i = 0; i < m_NumItems; i++)
 		free(m_pItems[i].m_pData);
 	for(int i = 0; i < m_NumDatas; ++i)
+	{
+		free(m_pDatas[i].m_pUncompressedData);
 		free(m_pDatas[i].m_pCompressedData);
+	}
 	free(m_pItems);
 	m_pItems = 0;
 	free(m_pDatas);
@@ -646,24 +855,60 @@ int CDataFileWriter::AddData(int Size, void *pData, int CompressionLevel)
 	dbg_assert(m_NumDatas < 1024, "too much data");
 
 	CDataInfo *pInfo = &m_pDatas[m_NumDatas];
-	unsigned long s = compressBound(Size);
-	void *pCompData = malloc(s); // temporary buffer that we use during compression
+	pInfo->m_pUncompressedData = malloc(Size);
+	mem_copy(pInfo->m_pUncompressedData, pData, Size);
+	pInfo->m_UncompressedSize = Size;
+	pInfo->m_CompressionLevel = CompressionLevel;
+	pInfo->m_CompressedSize = 0;
+	pInfo->m_pCompressedData = 0;
+
+	m_NumDatas++;
+	return m_NumDatas - 1;
+}
 
-	int Result = compress2((Bytef *)pCompData, &s, (Bytef *)pData, Size, CompressionLevel);
+void CDataFileWriter::CompressData(int Index)
+{
+	CDataInfo *pInfo = &m_pDatas[Index];
+	unsigned long s = compressBound(pInfo->m_UncompressedSize);
+	void *pCompData = malloc(s);
+
+	int Result = compress2((Bytef *)pCompData, &s, (Bytef *)pInfo->m_pUncompressedData, pInfo->m_UncompressedSize, pInfo->m_CompressionLevel);
 	if(Result != Z_OK)
 	{
 		dbg_msg("datafile", "compression error %d", Result);
 		dbg_assert(0, "zlib error");
 	}
 
-	pInfo->m_UncompressedSize = Size;
 	pInfo->m_CompressedSize = (int)s;
-	pInfo->m_pCompressedData = malloc(pInfo->m_CompressedSize);
-	mem_copy(pInfo->m_pCompressedData, pCompData, pInfo->m_CompressedSize);
-	free(pCompData);
+	pInfo->m_pCompressedData = realloc(pCompData, maximum<unsigned long>(s, 1));
+	free(pInfo->m_pUncompressedData);
+	pInfo->m_pUncompressedData = 0;
+}
 
-	m_NumDatas++;
-	return m_NumDatas - 1;
+void CDataFileWriter::CompressAllData()
+{
+	int NumThreads = m_NumCompressionThreads > 0 ? m_NumCompressionThreads : (int)std::thread::hardware_concurrency();
+	NumThreads = minimum(NumThreads, m_NumDatas);
+	if(NumThreads <= 1)
+	{
+		for(int i = 0; i < m_NumDatas; i++)
+			CompressData(i);
+		return;
+	}
+
+	// every item is compressed on its own, so the order in which the
+	// workers pick them up doesn't change the written file
+	std::atomic<int> Next(0);
+	auto &&Worker = [this, &Next]() {
+		for(int i = Next++; i < m_NumDatas; i = Next++)
+			CompressData(i);
+	};
+	std::vector<std::thread> vThreads;
+	for(int i = 0; i < NumThreads - 1; i++)
+		vThreads.emplace_back(Worker);
+	Worker();
+	for(auto &Thread : vThreads)
+		Thread.join();
 }
 
 int CDataFileWriter::AddDataSwapped(int Size, void *pData)
@@ -687,6 +932,8 @@ int CDataFileWriter::Finish()
 	if(!m_File)
 		return 1;
 
+	CompressAllData();
+
 	int ItemSize = 0;
 	int TypesSize, HeaderSize, OffsetSize, FileSize, SwapSize;
 	int DataSize = 0;
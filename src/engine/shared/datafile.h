@@ -10,6 +10,8 @@
 
 #include <zlib.h>
 
+#include <vector>
+
 enum
 {
 	ITEMTYPE_EX = 0xffff,
@@ -21,6 +23,8 @@ class CDataFileReader
 	struct CDatafile *m_pDataFile;
 	void *GetDataImpl(int Index, int Swap);
 	int GetFileDataSize(int Index);
+	// takes ownership of the file data
+	bool OpenFileData(const char *pFilename, unsigned char *pFileData, unsigned FileSize, IOHANDLE File, bool ShareData);
 
 	int GetExternalItemType(int InternalType);
 	int GetInternalItemType(int ExternalType);
@@ -32,13 +36,25 @@ public:
 
 	bool IsOpen() const { return m_pDataFile != nullptr; }
 
-	bool Open(class IStorage *pStorage, const char *pFilename, int StorageType);
+	/*
+		Reads the file into memory. With ShareData, decompressed data is shared
+		with other readers that opened identical data with ShareData, so it's
+		only for readers that never modify the data.
+	*/
+	bool Open(class IStorage *pStorage, const char *pFilename, int StorageType, bool ShareData = false);
+	// like above, but from a file that was already read into memory, File() is 0 then
+	bool Open(const char *pFilename, const void *pData, unsigned DataSize, bool ShareData = false);
 	bool Close();
 
 	void *GetData(int Index);
 	void *GetDataSwapped(int Index); // makes sure that the data is 32bit LE ints when saved
 	int GetDataSize(int Index);
 	void UnloadData(int Index);
+	/*
+		Decompresses the data items on the job pool. GetData waits for items
+		that are still being loaded, so this only starts the work early.
+	*/
+	void PreloadData(class IEngine *pEngine, const std::vector<int> &vIndices);
 	void *GetItem(int Index, int *pType, int *pID);
 	int GetItemSize(int Index) const;
 	void GetType(int Type, int *pStart, int *pNum);
@@ -59,7 +75,9 @@ class CDataFileWriter
 {
 	struct CDataInfo
 	{
+		void *m_pUncompressedData;
 		int m_UncompressedSize;
+		int m_CompressionLevel;
 		int m_CompressedSize;
 		void *m_pCompressedData;
 	};
@@ -94,12 +112,15 @@ class CDataFileWriter
 	int m_NumDatas;
 	int m_NumItemTypes;
 	int m_NumExtendedItemTypes;
+	int m_NumCompressionThreads;
 	CItemTypeInfo *m_pItemTypes;
 	CItemInfo *m_pItems;
 	CDataInfo *m_pDatas;
 	int m_aExtendedItemTypes[MAX_EXTENDED_ITEM_TYPES];
 
 	int GetExtendedItemTypeIndex(int Type);
+	void CompressData(int Index);
+	void CompressAllData();
 
 public:
 	CDataFileWriter();
@@ -107,9 +128,16 @@ public:
 	void Init();
 	bool OpenFile(class IStorage *pStorage, const char *pFilename, int StorageType = IStorage::TYPE_SAVE);
 	bool Open(class IStorage *pStorage, const char *pFilename, int StorageType = IStorage::TYPE_SAVE);
+	/*
+		Data is copied and compressed when the file is finished, so the
+		items can be compressed concurrently. The output doesn't depend on
+		the number of threads.
+	*/
 	int AddData(int Size, void *pData, int CompressionLevel = Z_DEFAULT_COMPRESSION);
 	int AddDataSwapped(int Size, void *pData);
 	int AddItem(int Type, int ID, int Size, void *pData);
+	// 0 uses all hardware threads
+	void SetCompressionThreads(int NumThreads) { m_NumCompressionThreads = NumThreads; }
 	int Finish();
 };
 
@@ -4,6 +4,7 @@
 #include <base/system.h>
 
 #include <engine/console.h>
+#include <engine/engine.h>
 #include <engine/storage.h>
 
 #include <engine/shared/config.h>
@@ -18,6 +19,12 @@
 #include "network.h"
 #include "snapshot.h"
 
+#include <zlib.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
 const double g_aSpeeds[g_DemoSpeeds] = {0.1, 0.25, 0.5, 0.75, 1.0, 1.25, 1.5, 2.0, 3.0, 4.0, 6.0, 8.0, 12.0, 16.0, 20.0, 24.0, 28.0, 32.0, 40.0, 48.0, 56.0, 64.0};
 const CUuid SHA256_EXTENSION =
 	{{0x6b, 0xe6, 0xda, 0x4a, 0xce, 0xbd, 0x38, 0x0c,
@@ -30,6 +37,10 @@ static const unsigned char s_Sha256Version = 6;
 static const unsigned char s_VersionTickCompression = 5; // demo files with this version or higher will use `CHUNKTICKFLAG_TICK_COMPRESSED`
 static const int s_LengthOffset = 152;
 static const int s_NumMarkersOffset = 176;
+static const char s_aIndexMarker[4] = {'T', 'W', 'D', 'X'};
+static const int s_IndexVersion = 1;
+static const int s_IndexInterval = SERVER_TICK_SPEED; // ticks between two seek points of the index
+static const int64_t s_MaxIndexDirectorySize = 256 * 1024 * 1024;
 
 static const ColorRGBA gs_DemoPrintColor{0.75f, 0.7f, 0.7f, 1.0f};
 
@@ -402,7 +413,9 @@ CDemoPlayer::CDemoPlayer(class CSnapshotDelta *pSnapshotDelta)
 void CDemoPlayer::Construct(class CSnapshotDelta *pSnapshotDelta)
 {
 	m_File = 0;
+	m_pStorage = 0;
 	m_pKeyFrames = 0;
+	m_IndexFile = 0;
 	m_SpeedIndex = 4;
 
 	m_pSnapshotDelta = pSnapshotDelta;
@@ -415,16 +428,21 @@ void CDemoPlayer::SetListener(IListener *pListener)
 }
 
 int CDemoPlayer::ReadChunkHeader(int *pType, int *pSize, int *pTick)
+{
+	return ReadChunkHeader(m_File, m_Info.m_Header.m_Version, pType, pSize, pTick);
+}
+
+int CDemoPlayer::ReadChunkHeader(IOHANDLE File, int Version, int *pType, int *pSize, int *pTick)
 {
 	unsigned char Chunk = 0;
 
 	*pSize = 0;
 	*pType = 0;
 
-	if(m_File == NULL)
+	if(File == NULL)
 		return -1;
 
-	if(io_read(m_File, &Chunk, sizeof(Chunk)) != sizeof(Chunk))
+	if(io_read(File, &Chunk, sizeof(Chunk)) != sizeof(Chunk))
 		return -1;
 
 	if(Chunk & CHUNKTYPEFLAG_TICKMARKER)
@@ -433,7 +451,7 @@ int CDemoPlayer::ReadChunkHeader(int *pType, int *pSize, int *pTick)
 		int Tickdelta_legacy = Chunk & (CHUNKMASK_TICK_LEGACY); // compatibility
 		*pType = Chunk & (CHUNKTYPEFLAG_TICKMARKER | CHUNKTICKFLAG_KEYFRAME);
 
-		if(m_Info.m_Header.m_Version < s_VersionTickCompression && Tickdelta_legacy != 0)
+		if(Version < s_VersionTickCompression && Tickdelta_legacy != 0)
 		{
 			*pTick += Tickdelta_legacy;
 		}
@@ -445,7 +463,7 @@ int CDemoPlayer::ReadChunkHeader(int *pType, int *pSize, int *pTick)
 		else
 		{
 			unsigned char aTickdata[4];
-			if(io_read(m_File, aTickdata, sizeof(aTickdata)) != sizeof(aTickdata))
+			if(io_read(File, aTickdata, sizeof(aTickdata)) != sizeof(aTickdata))
 				return -1;
 			*pTick = bytes_be_to_int(aTickdata);
 		}
@@ -459,14 +477,14 @@ int CDemoPlayer::ReadChunkHeader(int *pType, int *pSize, int *pTick)
 		if(*pSize == 30)
 		{
 			unsigned char aSizedata[1];
-			if(io_read(m_File, aSizedata, sizeof(aSizedata)) != sizeof(aSizedata))
+			if(io_read(File, aSizedata, sizeof(aSizedata)) != sizeof(aSizedata))
 				return -1;
 			*pSize = aSizedata[0];
 		}
 		else if(*pSize == 31)
 		{
 			unsigned char aSizedata[2];
-			if(io_read(m_File, aSizedata, sizeof(aSizedata)) != sizeof(aSizedata))
+			if(io_read(File, aSizedata, sizeof(aSizedata)) != sizeof(aSizedata))
 				return -1;
 			*pSize = (aSizedata[1] << 8) | aSizedata[0];
 		}
@@ -532,6 +550,287 @@ void CDemoPlayer::ScanFile()
 	io_seek(m_File, StartPos, IOSEEK_START);
 }
 
+CDemoPlayer::CIndexHeader CDemoPlayer::IndexHeader() const
+{
+	CIndexHeader Header;
+	mem_zero(&Header, sizeof(Header));
+	mem_copy(Header.m_aMarker, s_aIndexMarker, sizeof(Header.m_aMarker));
+	Header.m_Version = s_IndexVersion;
+	Header.m_DemoSize = m_DemoSize;
+	Header.m_DemoHeader = m_Info.m_Header;
+	Header.m_TimelineMarkers = m_Info.m_TimelineMarkers;
+	Header.m_FirstTick = -1;
+	Header.m_LastTick = -1;
+	return Header;
+}
+
+bool CDemoPlayer::LoadIndex()
+{
+	IOHANDLE File = m_pStorage->OpenFile(m_aIndexFilename, IOFLAG_READ, IStorage::TYPE_SAVE);
+	if(!File)
+		return false;
+
+	const CIndexHeader Expected = IndexHeader();
+	CIndexHeader Header;
+	bool Valid = io_read(File, &Header, sizeof(Header)) == sizeof(Header) &&
+		     mem_comp(Header.m_aMarker, Expected.m_aMarker, sizeof(Header.m_aMarker)) == 0 && Header.m_Version == Expected.m_Version && Header.m_DemoSize == Expected.m_DemoSize &&
+		     mem_comp(&Header.m_DemoHeader, &Expected.m_DemoHeader, sizeof(Header.m_DemoHeader)) == 0 &&
+		     mem_comp(&Header.m_TimelineMarkers, &Expected.m_TimelineMarkers, sizeof(Header.m_TimelineMarkers)) == 0 &&
+		     Header.m_NumEntries > 0 && Header.m_EntriesOffset >= (int64_t)sizeof(Header) &&
+		     Header.m_EntriesOffset + (int64_t)Header.m_NumEntries * (int64_t)sizeof(CIndexEntry) == (int64_t)io_length(File) &&
+		     io_seek(File, Header.m_EntriesOffset, IOSEEK_START) == 0;
+	std::vector<CIndexEntry> vIndex(Valid ? Header.m_NumEntries : 0);
+	Valid = Valid && io_read(File, vIndex.data(), vIndex.size() * sizeof(CIndexEntry)) == vIndex.size() * sizeof(CIndexEntry);
+	for(size_t i = 0; i < vIndex.size() && Valid; i++)
+		Valid = vIndex[i].m_DataSize >= 0 && vIndex[i].m_DataSize <= CSnapshot::MAX_SIZE && (i == 0 || vIndex[i].m_Tick > vIndex[i - 1].m_Tick);
+	if(!Valid)
+	{
+		dbg_msg("demo", "ignoring invalid index '%s'", m_aIndexFilename);
+		io_close(File);
+		return false;
+	}
+
+	if(m_IndexFile)
+		io_close(m_IndexFile);
+	m_IndexFile = File;
+	m_vIndex = std::move(vIndex);
+
+	// every entry of the index is a seek point
+	free(m_pKeyFrames);
+	m_pKeyFrames = (CKeyFrame *)calloc(m_vIndex.size(), sizeof(CKeyFrame));
+	for(size_t i = 0; i < m_vIndex.size(); i++)
+	{
+		m_pKeyFrames[i].m_Filepos = m_vIndex[i].m_Filepos;
+		m_pKeyFrames[i].m_Tick = m_vIndex[i].m_Tick;
+	}
+	m_Info.m_SeekablePoints = m_vIndex.size();
+	m_Info.m_Info.m_FirstTick = Header.m_FirstTick;
+	m_Info.m_Info.m_LastTick = Header.m_LastTick;
+	return true;
+}
+
+void CDemoPlayer::UpdateIndexJob()
+{
+	if(!m_pIndexJob || m_pIndexJob->Status() != IJob::STATE_DONE)
+		return;
+	m_pIndexJob = nullptr;
+	LoadIndex();
+}
+
+bool CDemoPlayer::IsIndexed()
+{
+	UpdateIndexJob();
+	return !m_vIndex.empty();
+}
+
+bool CDemoPlayer::ReadIndexSnapshot(const CIndexEntry &Entry)
+{
+	char aCompressed[CSnapshot::MAX_SIZE];
+	char aDecompressed[CSnapshot::MAX_SIZE];
+	if(io_seek(m_IndexFile, Entry.m_DataOffset, IOSEEK_START) != 0 || io_read(m_IndexFile, aCompressed, Entry.m_DataSize) != (unsigned)Entry.m_DataSize)
+		return false;
+	int DataSize = CNetBase::Decompress(aCompressed, Entry.m_DataSize, aDecompressed, sizeof(aDecompressed));
+	if(DataSize < 0)
+		return false;
+	DataSize = CVariableInt::Decompress(aDecompressed, DataSize, m_aLastSnapshotData, sizeof(m_aLastSnapshotData));
+	if(DataSize < 0)
+		return false;
+	m_LastSnapshotDataSize = DataSize;
+	return true;
+}
+
+CDemoPlayer::CIndexJob::CIndexJob(class IStorage *pStorage, const char *pFilename, int StorageType, const char *pIndexFilename, long DataStart, const CIndexHeader &Header, const CSnapshotDelta &SnapshotDelta) :
+	m_pStorage(pStorage),
+	m_StorageType(StorageType),
+	m_DataStart(DataStart),
+	m_Header(Header),
+	m_SnapshotDelta(SnapshotDelta)
+{
+	str_copy(m_aFilename, pFilename, sizeof(m_aFilename));
+	str_copy(m_aIndexFilename, pIndexFilename, sizeof(m_aIndexFilename));
+}
+
+bool CDemoPlayer::CIndexJob::Build(IOHANDLE File, IOHANDLE IndexFile)
+{
+	// the header is written again with the entry table offset at the end
+	io_write(IndexFile, &m_Header, sizeof(m_Header));
+	int64_t Offset = sizeof(m_Header);
+
+	std::vector<CIndexEntry> vEntries;
+	int ChunkType, ChunkSize, ChunkTick = 0;
+	int DataSize = 0;
+	int SnapshotSize = -1;
+	int PrevTick = -1;
+	int LastEntryTick = -1;
+
+	io_seek(File, m_DataStart, IOSEEK_START);
+	while(true)
+	{
+		const long CurrentPos = io_tell(File);
+		if(ReadChunkHeader(File, m_Header.m_DemoHeader.m_Version, &ChunkType, &ChunkSize, &ChunkTick))
+			break;
+
+		if(ChunkType & CHUNKTYPEFLAG_TICKMARKER)
+		{
+			CIndexEntry Entry;
+			Entry.m_Tick = ChunkTick;
+			Entry.m_PrevTick = PrevTick;
+			Entry.m_Filepos = CurrentPos;
+			Entry.m_DataOffset = 0;
+			Entry.m_DataSize = 0;
+			if(ChunkType & CHUNKTICKFLAG_KEYFRAME)
+			{
+				vEntries.push_back(Entry);
+				LastEntryTick = ChunkTick;
+			}
+			else if(SnapshotSize >= 0 && ChunkTick - LastEntryTick >= s_IndexInterval)
+			{
+				// store the snapshot the chunks of this tick are based on
+				int Size = CVariableInt::Compress(m_aSnapshot, SnapshotSize, m_aDecompressed, sizeof(m_aDecompressed));
+				if(Size < 0)
+					return false;
+				Size = CNetBase::Compress(m_aDecompressed, Size, m_aCompressed, sizeof(m_aCompressed));
+				if(Size < 0)
+					return false;
+				io_write(IndexFile, m_aCompressed, Size);
+				Entry.m_DataOffset = Offset;
+				Entry.m_DataSize = Size;
+				Offset += Size;
+				vEntries.push_back(Entry);
+				LastEntryTick = ChunkTick;
+			}
+
+			if(m_Header.m_FirstTick == -1)
+				m_Header.m_FirstTick = ChunkTick;
+			m_Header.m_LastTick = ChunkTick;
+			PrevTick = ChunkTick;
+		}
+		else if(ChunkType == CHUNKTYPE_SNAPSHOT || ChunkType == CHUNKTYPE_DELTA)
+		{
+			// follow the snapshots the same way as DoTick
+			if(ChunkSize)
+			{
+				if(io_read(File, m_aCompressed, ChunkSize) != (unsigned)ChunkSize)
+					return false;
+				DataSize = CNetBase::Decompress(m_aCompressed, ChunkSize, m_aDecompressed, sizeof(m_aDecompressed));
+				if(DataSize < 0)
+					return false;
+				DataSize = CVariableInt::Decompress(m_aDecompressed, DataSize, m_aData, sizeof(m_aData));
+				if(DataSize < 0)
+					return false;
+			}
+
+			if(ChunkType == CHUNKTYPE_SNAPSHOT)
+			{
+				SnapshotSize = DataSize;
+				mem_copy(m_aSnapshot, m_aData, DataSize);
+			}
+			else if(SnapshotSize >= 0)
+			{
+				const int NewSize = m_SnapshotDelta.UnpackDelta((CSnapshot *)m_aSnapshot, (CSnapshot *)m_aNewSnapshot, m_aData, DataSize);
+				if(NewSize >= 0)
+				{
+					SnapshotSize = NewSize;
+					mem_copy(m_aSnapshot, m_aNewSnapshot, NewSize);
+				}
+			}
+		}
+		else if(ChunkSize)
+			io_skip(File, ChunkSize);
+	}
+
+	if(vEntries.empty())
+		return false;
+
+	m_Header.m_NumEntries = vEntries.size();
+	m_Header.m_EntriesOffset = Offset;
+	io_write(IndexFile, vEntries.data(), vEntries.size() * sizeof(CIndexEntry));
+	io_seek(IndexFile, 0, IOSEEK_START);
+	io_write(IndexFile, &m_Header, sizeof(m_Header));
+	return true;
+}
+
+void CDemoPlayer::CIndexJob::Run()
+{
+	IOHANDLE File = m_pStorage->OpenFile(m_aFilename, IOFLAG_READ, m_StorageType);
+	if(!File)
+		return;
+
+	char aTmpFilename[IO_MAX_PATH_LENGTH];
+	str_format(aTmpFilename, sizeof(aTmpFilename), "%s.tmp", m_aIndexFilename);
+	m_pStorage->CreateFolder("demoindex", IStorage::TYPE_SAVE);
+	IOHANDLE IndexFile = m_pStorage->OpenFile(aTmpFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!IndexFile)
+	{
+		io_close(File);
+		return;
+	}
+
+	const bool Success = Build(File, IndexFile);
+	io_close(IndexFile);
+	io_close(File);
+	if(!Success || !m_pStorage->RenameFile(aTmpFilename, m_aIndexFilename, IStorage::TYPE_SAVE))
+	{
+		m_pStorage->RemoveFile(aTmpFilename, IStorage::TYPE_SAVE);
+		return;
+	}
+	PruneIndexDirectory(m_pStorage, m_aIndexFilename, s_MaxIndexDirectorySize);
+}
+
+struct SIndexFileInfo
+{
+	std::string m_Filename;
+	time_t m_Modified;
+	int64_t m_Size;
+};
+
+struct SIndexListData
+{
+	IStorage *m_pStorage;
+	std::vector<SIndexFileInfo> m_vFiles;
+};
+
+static int IndexListCallback(const CFsFileInfo *pInfo, int IsDir, int StorageType, void *pUser)
+{
+	SIndexListData *pData = (SIndexListData *)pUser;
+	if(IsDir || !str_endswith(pInfo->m_pName, ".idx"))
+		return 0;
+
+	SIndexFileInfo File;
+	File.m_Filename = std::string("demoindex/") + pInfo->m_pName;
+	File.m_Modified = pInfo->m_TimeModified;
+	IOHANDLE Handle = pData->m_pStorage->OpenFile(File.m_Filename.c_str(), IOFLAG_READ, IStorage::TYPE_SAVE);
+	if(!Handle)
+		return 0;
+	File.m_Size = io_length(Handle);
+	io_close(Handle);
+	pData->m_vFiles.push_back(File);
+	return 0;
+}
+
+void CDemoPlayer::PruneIndexDirectory(IStorage *pStorage, const char *pKeepFilename, int64_t MaxSize)
+{
+	SIndexListData Data;
+	Data.m_pStorage = pStorage;
+	pStorage->ListDirectoryInfo(IStorage::TYPE_SAVE, "demoindex", IndexListCallback, &Data);
+
+	int64_t TotalSize = 0;
+	for(const auto &File : Data.m_vFiles)
+		TotalSize += File.m_Size;
+	if(TotalSize <= MaxSize)
+		return;
+
+	std::sort(Data.m_vFiles.begin(), Data.m_vFiles.end(), [](const SIndexFileInfo &a, const SIndexFileInfo &b) { return a.m_Modified < b.m_Modified; });
+	for(const auto &File : Data.m_vFiles)
+	{
+		if(TotalSize <= MaxSize)
+			break;
+		// files that are still open for playback can't be removed on some systems
+		if(File.m_Filename != pKeepFilename && pStorage->RemoveFile(File.m_Filename.c_str(), IStorage::TYPE_SAVE))
+			TotalSize -= File.m_Size;
+	}
+}
+
 void CDemoPlayer::DoTick()
 {
 	static char s_aCompresseddata[CSnapshot::MAX_SIZE];
@@ -689,9 +988,10 @@ void CDemoPlayer::Unpause()
 #endif
 }
 
-int CDemoPlayer::Load(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, int StorageType)
+int CDemoPlayer::Load(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, int StorageType, class IEngine *pEngine)
 {
 	m_pConsole = pConsole;
+	m_pStorage = pStorage;
 	m_File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType);
 	if(!m_File)
 	{
@@ -719,6 +1019,12 @@ int CDemoPlayer::Load(class IStorage *pStorage, class IConsole *pConsole, const
 
 	m_LastSnapshotDataSize = -1;
 
+	if(m_IndexFile)
+		io_close(m_IndexFile);
+	m_IndexFile = 0;
+	m_vIndex.clear();
+	m_pIndexJob = nullptr;
+
 	// read the header
 	io_read(m_File, &m_Info.m_Header, sizeof(m_Info.m_Header));
 	if(mem_comp(m_Info.m_Header.m_aMarker, s_aHeaderMarker, sizeof(s_aHeaderMarker)) != 0)
@@ -803,8 +1109,24 @@ int CDemoPlayer::Load(class IStorage *pStorage, class IConsole *pConsole, const
 		}
 	}
 
-	// scan the file for interesting points
-	ScanFile();
+	// use the index of an earlier playback, the file only has to be scanned for the first one
+	const long DataStart = io_tell(m_File);
+	m_DemoSize = io_length(m_File);
+	io_seek(m_File, DataStart, IOSEEK_START);
+	uLong Key = crc32(0L, Z_NULL, 0);
+	Key = crc32(Key, (const Bytef *)&m_DemoSize, sizeof(m_DemoSize));
+	Key = crc32(Key, (const Bytef *)&m_Info.m_Header, sizeof(m_Info.m_Header));
+	Key = crc32(Key, (const Bytef *)&m_Info.m_TimelineMarkers, sizeof(m_Info.m_TimelineMarkers));
+	str_format(m_aIndexFilename, sizeof(m_aIndexFilename), "demoindex/%08x.idx", (unsigned)Key);
+	if(!LoadIndex())
+	{
+		ScanFile();
+		if(pEngine)
+		{
+			m_pIndexJob = std::make_shared<CIndexJob>(pStorage, pFilename, StorageType, m_aIndexFilename, DataStart, IndexHeader(), *m_pSnapshotDelta);
+			pEngine->AddJob(m_pIndexJob);
+		}
+	}
 
 	// reset slice markers
 	g_Config.m_ClDemoSliceBegin = -1;
@@ -926,6 +1248,8 @@ int CDemoPlayer::SetPos(int WantedTick)
 	if(!m_File)
 		return -1;
 
+	UpdateIndexJob();
+
 	// -5 because we have to have a current tick and previous tick when we do the playback
 	WantedTick = clamp(WantedTick, m_Info.m_Info.m_FirstTick, m_Info.m_Info.m_LastTick) - 5;
 
@@ -940,10 +1264,23 @@ int CDemoPlayer::SetPos(int WantedTick)
 		KeyFrame--;
 	}
 
+	// seek points of the index between keyframes continue from the stored snapshot
+	int NextTick = -1;
+	if(!m_vIndex.empty() && m_vIndex[KeyFrame].m_DataSize > 0)
+	{
+		if(ReadIndexSnapshot(m_vIndex[KeyFrame]))
+			NextTick = m_vIndex[KeyFrame].m_PrevTick;
+		else
+		{
+			while(KeyFrame > 0 && m_vIndex[KeyFrame].m_DataSize > 0)
+				KeyFrame--;
+		}
+	}
+
 	// seek to the correct key frame
 	io_seek(m_File, m_pKeyFrames[KeyFrame].m_Filepos, IOSEEK_START);
 
-	m_Info.m_NextTick = -1;
+	m_Info.m_NextTick = NextTick;
 	m_Info.m_Info.m_CurrentTick = -1;
 	m_Info.m_PreviousTick = -1;
 
@@ -1041,6 +1378,11 @@ int CDemoPlayer::Stop()
 	m_File = 0;
 	free(m_pKeyFrames);
 	m_pKeyFrames = 0;
+	if(m_IndexFile)
+		io_close(m_IndexFile);
+	m_IndexFile = 0;
+	m_vIndex.clear();
+	m_pIndexJob = nullptr;
 	str_copy(m_aFilename, "", sizeof(m_aFilename));
 	return 0;
 }
@@ -6,8 +6,11 @@
 #include <base/hash.h>
 
 #include <engine/demo.h>
+#include <engine/shared/jobs.h>
 #include <engine/shared/protocol.h>
 #include <functional>
+#include <memory>
+#include <vector>
 
 #include "snapshot.h"
 
@@ -100,11 +103,64 @@ private:
 		CKeyFrameSearch *m_pNext;
 	};
 
+	// seek points with the reconstructed snapshot at the start of the tick,
+	// kept in demoindex/ and built in the background on the first playback
+	struct CIndexHeader
+	{
+		char m_aMarker[4];
+		int m_Version;
+		int64_t m_DemoSize;
+		CDemoHeader m_DemoHeader;
+		CTimelineMarkers m_TimelineMarkers;
+		int m_FirstTick;
+		int m_LastTick;
+		int m_NumEntries;
+		int64_t m_EntriesOffset;
+	};
+
+	struct CIndexEntry
+	{
+		int m_Tick;
+		int m_PrevTick; // needed to decode a compressed tick marker
+		int64_t m_Filepos;
+		int64_t m_DataOffset;
+		int m_DataSize; // 0 at keyframes, the demo contains the full snapshot
+	};
+
+	class CIndexJob : public IJob
+	{
+		class IStorage *m_pStorage;
+		char m_aFilename[IO_MAX_PATH_LENGTH];
+		int m_StorageType;
+		char m_aIndexFilename[IO_MAX_PATH_LENGTH];
+		long m_DataStart;
+		CIndexHeader m_Header;
+		CSnapshotDelta m_SnapshotDelta;
+
+		char m_aCompressed[CSnapshot::MAX_SIZE];
+		char m_aDecompressed[CSnapshot::MAX_SIZE];
+		char m_aData[CSnapshot::MAX_SIZE];
+		char m_aSnapshot[CSnapshot::MAX_SIZE];
+		char m_aNewSnapshot[CSnapshot::MAX_SIZE];
+
+		bool Build(IOHANDLE File, IOHANDLE IndexFile);
+		void Run() override;
+
+	public:
+		CIndexJob(class IStorage *pStorage, const char *pFilename, int StorageType, const char *pIndexFilename, long DataStart, const CIndexHeader &Header, const CSnapshotDelta &SnapshotDelta);
+	};
+
 	class IConsole *m_pConsole;
+	class IStorage *m_pStorage;
 	IOHANDLE m_File;
 	long m_MapOffset;
 	char m_aFilename[IO_MAX_PATH_LENGTH];
 	CKeyFrame *m_pKeyFrames;
+	IOHANDLE m_IndexFile;
+	std::vector<CIndexEntry> m_vIndex;
+	std::shared_ptr<CIndexJob> m_pIndexJob;
+	char m_aIndexFilename[IO_MAX_PATH_LENGTH];
+	int64_t m_DemoSize;
 	CMapInfo m_MapInfo;
 	int m_SpeedIndex;
 
@@ -114,11 +170,17 @@ private:
 	int m_LastSnapshotDataSize;
 	class CSnapshotDelta *m_pSnapshotDelta;
 
+	static int ReadChunkHeader(IOHANDLE File, int Version, int *pType, int *pSize, int *pTick);
 	int ReadChunkHeader(int *pType, int *pSize, int *pTick);
 	void DoTick();
 	void ScanFile();
 	int NextFrame();
 
+	CIndexHeader IndexHeader() const;
+	bool LoadIndex();
+	void UpdateIndexJob();
+	bool ReadIndexSnapshot(const CIndexEntry &Entry);
+
 	int64_t time();
 
 public:
@@ -129,7 +191,10 @@ public:
 
 	void SetListener(IListener *pListener);
 
-	int Load(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, int StorageType);
+	// deletes the least recently written indices until demoindex/ is at most MaxSize bytes
+	static void PruneIndexDirectory(class IStorage *pStorage, const char *pKeepFilename, int64_t MaxSize);
+
+	int Load(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, int StorageType, class IEngine *pEngine = nullptr);
 	unsigned char *GetMapData(class IStorage *pStorage);
 	bool ExtractMap(class IStorage *pStorage);
 	int Play();
@@ -151,6 +216,7 @@ public:
 
 	const CPlaybackInfo *Info() const { return &m_Info; }
 	bool IsPlaying() const override { return m_File != nullptr; }
+	bool IsIndexed();
 	const CMapInfo *GetMapInfo() { return &m_MapInfo; }
 };
 
@@ -2,6 +2,7 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include "huffman.h"
 #include <algorithm>
+#include <base/math.h>
 #include <base/system.h>
 
 const unsigned CHuffman::ms_aFreqTable[HUFFMAN_MAX_SYMBOLS] = {
@@ -125,10 +126,65 @@ void CHuffman::Init(const unsigned *pFrequencies)
 		if(k == HUFFMAN_LUTBITS)
 			m_apDecodeLut[i] = pNode;
 	}
+
+	BuildFastTables();
+}
+
+void CHuffman::BuildFastTables()
+{
+	unsigned MaxCodeLength = 0;
+	for(int i = 0; i < HUFFMAN_MAX_SYMBOLS; i++)
+		MaxCodeLength = maximum(MaxCodeLength, m_aNodes[i].m_NumBits);
+	m_FastPath = MaxCodeLength <= HUFFMAN_FAST_MAX_CODE_LENGTH;
+	if(!m_FastPath)
+		return;
+
+	// as many whole codes as fit into the looked up bits, stopping after eof
+	for(int i = 0; i < HUFFMAN_MULTI_LUTSIZE; i++)
+	{
+		uint64_t Symbols = 0;
+		unsigned NumSymbols = 0;
+		unsigned NumBits = 0;
+		bool Eof = false;
+		while(NumSymbols < HUFFMAN_MULTI_MAX_SYMBOLS)
+		{
+			const CNode *pNode = m_pStartNode;
+			unsigned Length = 0;
+			while(!pNode->m_NumBits && NumBits + Length < HUFFMAN_MULTI_LUTBITS)
+			{
+				pNode = &m_aNodes[pNode->m_aLeafs[(i >> (NumBits + Length)) & 1]];
+				Length++;
+			}
+			if(!pNode->m_NumBits)
+				break;
+
+			NumBits += Length;
+			if(pNode == &m_aNodes[HUFFMAN_EOF_SYMBOL])
+			{
+				Eof = true;
+				break;
+			}
+			Symbols |= (uint64_t)pNode->m_Symbol << (NumSymbols * 8);
+			NumSymbols++;
+		}
+		m_aMultiDecodeLut[i] = Symbols | ((uint64_t)NumBits << 56) | ((uint64_t)NumSymbols << 60) | ((uint64_t)Eof << 63);
+	}
+
+	for(int First = 0; First < 256; First++)
+	{
+		for(int Second = 0; Second < 256; Second++)
+		{
+			const unsigned Length = m_aNodes[First].m_NumBits + m_aNodes[Second].m_NumBits;
+			uint32_t Pair = 0;
+			if(Length <= HUFFMAN_PAIR_CODEBITS)
+				Pair = m_aNodes[First].m_Bits | (m_aNodes[Second].m_Bits << m_aNodes[First].m_NumBits) | (Length << HUFFMAN_PAIR_CODEBITS);
+			m_aPairEncodeLut[First | (Second << 8)] = Pair;
+		}
+	}
 }
 
 //***************************************************************
-int CHuffman::Compress(const void *pInput, int InputSize, void *pOutput, int OutputSize) const
+int CHuffman::CompressReference(const void *pInput, int InputSize, void *pOutput, int OutputSize) const
 {
 	// this macro loads a symbol for a byte into bits and bitcount
 #define HUFFMAN_MACRO_LOADSYMBOL(Sym) \
@@ -195,17 +251,15 @@ int CHuffman::Compress(const void *pInput, int InputSize, void *pOutput, int Out
 }
 
 //***************************************************************
-int CHuffman::Decompress(const void *pInput, int InputSize, void *pOutput, int OutputSize) const
+int CHuffman::DecompressReference(const void *pInput, int InputSize, void *pOutput, int OutputSize) const
 {
-	// setup buffer pointers
+	const unsigned char *pSrc = (const unsigned char *)pInput;
 	unsigned char *pDst = (unsigned char *)pOutput;
-	unsigned char *pSrc = (unsigned char *)pInput;
-	unsigned char *pDstEnd = pDst + OutputSize;
-	unsigned char *pSrcEnd = pSrc + InputSize;
-
-	unsigned Bits = 0;
-	unsigned Bitcount = 0;
+	return DecompressTail(pSrc, pSrc + InputSize, pDst, pDst + OutputSize, 0, 0, pDst);
+}
 
+int CHuffman::DecompressTail(const unsigned char *pSrc, const unsigned char *pSrcEnd, unsigned char *pDst, unsigned char *pDstEnd, unsigned Bits, unsigned Bitcount, const unsigned char *pOutput) const
+{
 	const CNode *pEof = &m_aNodes[HUFFMAN_EOF_SYMBOL];
 	const CNode *pNode = 0;
 
@@ -274,5 +328,168 @@ int CHuffman::Decompress(const void *pInput, int InputSize, void *pOutput, int O
 	}
 
 	// return the size of the decompressed buffer
+	return (int)(pDst - pOutput);
+}
+
+static inline uint64_t Load64(const unsigned char *pSrc)
+{
+	uint64_t Value;
+#if defined(CONF_ARCH_ENDIAN_LITTLE)
+	mem_copy(&Value, pSrc, sizeof(Value));
+#else
+	Value = 0;
+	for(int i = 0; i < 8; i++)
+		Value |= (uint64_t)pSrc[i] << (i * 8);
+#endif
+	return Value;
+}
+
+static inline void Store64(unsigned char *pDst, uint64_t Value)
+{
+#if defined(CONF_ARCH_ENDIAN_LITTLE)
+	mem_copy(pDst, &Value, sizeof(Value));
+#else
+	for(int i = 0; i < 8; i++)
+		pDst[i] = Value >> (i * 8);
+#endif
+}
+
+//***************************************************************
+int CHuffman::Compress(const void *pInput, int InputSize, void *pOutput, int OutputSize) const
+{
+	if(!m_FastPath)
+		return CompressReference(pInput, InputSize, pOutput, OutputSize);
+	if(OutputSize <= 0)
+		return -1;
+
+	const unsigned char *pSrc = (const unsigned char *)pInput;
+	const unsigned char *pSrcEnd = pSrc + InputSize;
+	unsigned char *pDst = (unsigned char *)pOutput;
+	unsigned char *pDstEnd = pDst + OutputSize;
+
+	// the output is a plain bit stream, so writing 32 bits at once gives the same bytes. A
+	// full output fails as soon as one more whole byte is pending, like in the reference.
+	uint64_t Bits = 0;
+	unsigned Bitcount = 0;
+#define HUFFMAN_MACRO_FLUSH32() \
+	if(Bitcount >= 32) \
+	{ \
+		if(pDstEnd - pDst < 4) \
+			return -1; \
+		pDst[0] = Bits; \
+		pDst[1] = Bits >> 8; \
+		pDst[2] = Bits >> 16; \
+		pDst[3] = Bits >> 24; \
+		pDst += 4; \
+		Bits >>= 32; \
+		Bitcount -= 32; \
+	}
+
+	while(pSrcEnd - pSrc >= 2)
+	{
+		const uint32_t Pair = m_aPairEncodeLut[pSrc[0] | (pSrc[1] << 8)];
+		if(Pair)
+		{
+			Bits |= (uint64_t)(Pair & ((1u << HUFFMAN_PAIR_CODEBITS) - 1)) << Bitcount;
+			Bitcount += Pair >> HUFFMAN_PAIR_CODEBITS;
+		}
+		else
+		{
+			Bits |= (uint64_t)m_aNodes[pSrc[0]].m_Bits << Bitcount;
+			Bitcount += m_aNodes[pSrc[0]].m_NumBits;
+			HUFFMAN_MACRO_FLUSH32()
+			Bits |= (uint64_t)m_aNodes[pSrc[1]].m_Bits << Bitcount;
+			Bitcount += m_aNodes[pSrc[1]].m_NumBits;
+		}
+		HUFFMAN_MACRO_FLUSH32()
+		pSrc += 2;
+	}
+
+	if(pSrc != pSrcEnd)
+	{
+		Bits |= (uint64_t)m_aNodes[*pSrc].m_Bits << Bitcount;
+		Bitcount += m_aNodes[*pSrc].m_NumBits;
+		HUFFMAN_MACRO_FLUSH32()
+	}
+
+	// write EOF symbol
+	Bits |= (uint64_t)m_aNodes[HUFFMAN_EOF_SYMBOL].m_Bits << Bitcount;
+	Bitcount += m_aNodes[HUFFMAN_EOF_SYMBOL].m_NumBits;
+#undef HUFFMAN_MACRO_FLUSH32
+
+	// write out the whole bytes and the last bits
+	while(true)
+	{
+		if(pDst == pDstEnd)
+			return -1;
+		*pDst++ = Bits;
+		if(Bitcount < 8)
+			break;
+		Bits >>= 8;
+		Bitcount -= 8;
+	}
+
+	// return the size of the output
 	return (int)(pDst - (const unsigned char *)pOutput);
 }
+
+//***************************************************************
+int CHuffman::Decompress(const void *pInput, int InputSize, void *pOutput, int OutputSize) const
+{
+	if(!m_FastPath)
+		return DecompressReference(pInput, InputSize, pOutput, OutputSize);
+
+	const unsigned char *pSrc = (const unsigned char *)pInput;
+	const unsigned char *pSrcEnd = pSrc + InputSize;
+	unsigned char *pDst = (unsigned char *)pOutput;
+	unsigned char *pDstEnd = pDst + OutputSize;
+
+	uint64_t Bits = 0;
+	unsigned Bitcount = 0;
+
+	// decode several symbols per lookup while there is room to refill and write without checks
+	while(pSrcEnd - pSrc >= 8 && pDstEnd - pDst >= 8)
+	{
+		// refill to at least 56 bits, bits above Bitcount are read again on the next refill
+		Bits |= Load64(pSrc) << Bitcount;
+		pSrc += (63 - Bitcount) >> 3;
+		Bitcount |= 56;
+
+		const uint64_t Entry = m_aMultiDecodeLut[Bits & HUFFMAN_MULTI_LUTMASK];
+		const unsigned NumBits = (Entry >> 56) & 0xf;
+		if(NumBits)
+		{
+			Store64(pDst, Entry);
+			pDst += (Entry >> 60) & 0x7;
+			Bits >>= NumBits;
+			Bitcount -= NumBits;
+			if(Entry >> 63)
+				return (int)(pDst - (const unsigned char *)pOutput);
+		}
+		else
+		{
+			// the code is longer than the table, walk the rest of the tree
+			const CNode *pNode = m_apDecodeLut[Bits & HUFFMAN_LUTMASK];
+			Bits >>= HUFFMAN_LUTBITS;
+			Bitcount -= HUFFMAN_LUTBITS;
+			while(!pNode->m_NumBits)
+			{
+				pNode = &m_aNodes[pNode->m_aLeafs[Bits & 1]];
+				Bits >>= 1;
+				Bitcount--;
+			}
+
+			if(pNode == &m_aNodes[HUFFMAN_EOF_SYMBOL])
+				return (int)(pDst - (const unsigned char *)pOutput);
+			*pDst++ = pNode->m_Symbol;
+		}
+	}
+
+	// hand the rest over at a byte boundary, the end of the input is handled like in the reference
+	while(Bitcount >= 8)
+	{
+		pSrc--;
+		Bitcount -= 8;
+	}
+	return DecompressTail(pSrc, pSrcEnd, pDst, pDstEnd, (unsigned)(Bits & ((1u << Bitcount) - 1)), Bitcount, (const unsigned char *)pOutput);
+}
@@ -3,6 +3,8 @@
 #ifndef ENGINE_SHARED_HUFFMAN_H
 #define ENGINE_SHARED_HUFFMAN_H
 
+#include <cstdint>
+
 class CHuffman
 {
 	enum
@@ -14,7 +16,19 @@ class CHuffman
 
 		HUFFMAN_LUTBITS = 10,
 		HUFFMAN_LUTSIZE = (1 << HUFFMAN_LUTBITS),
-		HUFFMAN_LUTMASK = (HUFFMAN_LUTSIZE - 1)
+		HUFFMAN_LUTMASK = (HUFFMAN_LUTSIZE - 1),
+
+		// multi-symbol decode table, see BuildFastTables
+		HUFFMAN_MULTI_LUTBITS = 12,
+		HUFFMAN_MULTI_LUTSIZE = (1 << HUFFMAN_MULTI_LUTBITS),
+		HUFFMAN_MULTI_LUTMASK = (HUFFMAN_MULTI_LUTSIZE - 1),
+		HUFFMAN_MULTI_MAX_SYMBOLS = 7,
+
+		// codes of up to 27 bits for a byte pair, the length goes into the top 5 bits
+		HUFFMAN_PAIR_CODEBITS = 27,
+
+		// the fast paths keep the reference bit layout only for codes up to this length
+		HUFFMAN_FAST_MAX_CODE_LENGTH = 24,
 	};
 
 	struct CNode
@@ -37,8 +51,17 @@ class CHuffman
 	CNode *m_pStartNode;
 	int m_NumNodes;
 
+	bool m_FastPath;
+	// symbols in the low 56 bits, then the consumed bits (4), the number of symbols (3) and an eof flag
+	uint64_t m_aMultiDecodeLut[HUFFMAN_MULTI_LUTSIZE];
+	// code of both bytes of a pair and its length, 0 if it doesn't fit
+	uint32_t m_aPairEncodeLut[256 * 256];
+
 	void Setbits_r(CNode *pNode, int Bits, unsigned Depth);
 	void ConstructTree(const unsigned *pFrequencies);
+	void BuildFastTables();
+
+	int DecompressTail(const unsigned char *pSrc, const unsigned char *pSrcEnd, unsigned char *pDst, unsigned char *pDstEnd, unsigned Bits, unsigned Bitcount, const unsigned char *pOutput) const;
 
 public:
 	/*
@@ -51,6 +74,7 @@ public:
 		Remarks:
 			- Does no allocation whatsoever.
 			- You don't have to call any cleanup functions when you are done with it.
+			- The encode and decode tables make the object about 300 KiB large.
 	*/
 	void Init(const unsigned *pFrequencies = ms_aFreqTable);
 
@@ -83,5 +107,9 @@ public:
 			Returns the size of the uncompressed data. Negative value on failure.
 	*/
 	int Decompress(const void *pInput, int InputSize, void *pOutput, int OutputSize) const;
+
+	// reference implementations encoding and decoding one symbol at a time
+	int CompressReference(const void *pInput, int InputSize, void *pOutput, int OutputSize) const;
+	int DecompressReference(const void *pInput, int InputSize, void *pOutput, int OutputSize) const;
 };
 #endif // ENGINE_SHARED_HUFFMAN_H
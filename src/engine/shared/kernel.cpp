@@ -92,13 +92,15 @@ public:
 
 	bool ReregisterInterfaceImpl(const char *pName, IInterface *pInterface, int ID = 0) override
 	{
-		if(FindInterfaceInfo(pName, ID) == nullptr)
+		CInterfaceInfo *pInfo = FindInterfaceInfo(pName, ID);
+		if(pInfo == nullptr)
 		{
 			dbg_msg("kernel", "ERROR: couldn't reregister interface '%s'. interface doesn't exist", pName);
 			return false;
 		}
 
 		pInterface->m_pKernel = this;
+		pInfo->m_pInterface = pInterface;
 
 		return true;
 	}
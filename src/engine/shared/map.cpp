@@ -4,6 +4,8 @@
 
 #include <engine/storage.h>
 
+#include <game/mapitems.h>
+
 CMap::CMap() = default;
 CMap::~CMap() = default;
 
@@ -54,9 +56,19 @@ bool CMap::Load(const char *pMapName)
 	IStorage *pStorage = Kernel()->RequestInterface<IStorage>();
 	if(!pStorage)
 		return false;
+	return Load(pStorage, pMapName);
+}
+
+bool CMap::Load(IStorage *pStorage, const char *pMapName)
+{
 	return m_DataFile.Open(pStorage, pMapName, IStorage::TYPE_ALL);
 }
 
+bool CMap::Load(const char *pMapName, const void *pData, unsigned DataSize)
+{
+	return m_DataFile.Open(pMapName, pData, DataSize);
+}
+
 bool CMap::IsLoaded()
 {
 	return m_DataFile.IsOpen();
@@ -82,4 +94,34 @@ IOHANDLE CMap::File()
 	return m_DataFile.File();
 }
 
+void CMap::PreloadData(IEngine *pEngine)
+{
+	std::vector<bool> vSkip(m_DataFile.NumData(), false);
+	int Start, Num;
+	m_DataFile.GetType(MAPITEMTYPE_IMAGE, &Start, &Num);
+	for(int i = Start; i < Start + Num; i++)
+	{
+		if(m_DataFile.GetItemSize(i) < (int)sizeof(CMapItemImage))
+			continue;
+		const CMapItemImage *pImage = static_cast<CMapItemImage *>(m_DataFile.GetItem(i, nullptr, nullptr));
+		if(pImage->m_ImageData >= 0 && pImage->m_ImageData < (int)vSkip.size())
+			vSkip[pImage->m_ImageData] = true;
+	}
+	m_DataFile.GetType(MAPITEMTYPE_SOUND, &Start, &Num);
+	for(int i = Start; i < Start + Num; i++)
+	{
+		if(m_DataFile.GetItemSize(i) < (int)sizeof(CMapItemSound))
+			continue;
+		const CMapItemSound *pSound = static_cast<CMapItemSound *>(m_DataFile.GetItem(i, nullptr, nullptr));
+		if(pSound->m_SoundData >= 0 && pSound->m_SoundData < (int)vSkip.size())
+			vSkip[pSound->m_SoundData] = true;
+	}
+
+	std::vector<int> vIndices;
+	for(int i = 0; i < (int)vSkip.size(); i++)
+		if(!vSkip[i])
+			vIndices.push_back(i);
+	m_DataFile.PreloadData(pEngine, vIndices);
+}
+
 extern IEngineMap *CreateEngineMap() { return new CMap; }
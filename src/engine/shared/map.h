@@ -29,6 +29,8 @@ public:
 	void Unload() override;
 
 	bool Load(const char *pMapName) override;
+	bool Load(IStorage *pStorage, const char *pMapName) override;
+	bool Load(const char *pMapName, const void *pData, unsigned DataSize) override;
 
 	bool IsLoaded() override;
 
@@ -39,6 +41,8 @@ public:
 	int MapSize() override;
 
 	IOHANDLE File() override;
+
+	void PreloadData(class IEngine *pEngine) override;
 };
 
 #endif
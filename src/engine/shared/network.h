@@ -149,6 +149,15 @@ public:
 	int64_t m_FirstSendTime;
 };
 
+// payload bytes moved while queueing chunks on connections
+class CNetSendStats
+{
+public:
+	uint64_t m_NumChunks;
+	uint64_t m_PayloadBytes;
+	uint64_t m_CopiedBytes; // into the packet construct and the resend buffer
+};
+
 class CNetPacketConstruct
 {
 public:
@@ -514,6 +523,7 @@ class CNetBase
 	static IOHANDLE ms_DataLogSent;
 	static IOHANDLE ms_DataLogRecv;
 	static CHuffman ms_Huffman;
+	static CNetSendStats ms_SendStats;
 
 public:
 	static void OpenLog(IOHANDLE DataLogSent, IOHANDLE DataLogRecv);
@@ -530,6 +540,14 @@ public:
 
 	// The backroom is ack-NET_MAX_SEQUENCE/2. Used for knowing if we acked a packet or not
 	static int IsSeqInBackroom(int Seq, int Ack);
+
+	static void CountQueuedChunk(int DataSize, int CopiedSize)
+	{
+		ms_SendStats.m_NumChunks++;
+		ms_SendStats.m_PayloadBytes += DataSize;
+		ms_SendStats.m_CopiedBytes += CopiedSize;
+	}
+	static const CNetSendStats &SendStats() { return ms_SendStats; }
 };
 
 #endif
@@ -98,8 +98,12 @@ int CNetConnection::Flush()
 	// update send times
 	m_LastSendTime = time_get();
 
-	// clear construct so we can start building a new package
-	mem_zero(&m_Construct, sizeof(m_Construct));
+	// clear construct so we can start building a new package, the chunk data
+	// is only read up to its size
+	m_Construct.m_Flags = 0;
+	m_Construct.m_Ack = 0;
+	m_Construct.m_NumChunks = 0;
+	m_Construct.m_DataSize = 0;
 	return NumChunks;
 }
 
@@ -143,13 +147,17 @@ int CNetConnection::QueueChunkEx(int Flags, int DataSize, const void *pData, int
 			pResend->m_FirstSendTime = time_get();
 			pResend->m_LastSendTime = pResend->m_FirstSendTime;
 			mem_copy(pResend->m_pData, pData, DataSize);
+			CNetBase::CountQueuedChunk(DataSize, 2 * DataSize);
 		}
 		else
 		{
 			// out of buffer, don't save the packet and hope nobody will ask for resend
+			CNetBase::CountQueuedChunk(DataSize, DataSize);
 			return -1;
 		}
 	}
+	else
+		CNetBase::CountQueuedChunk(DataSize, DataSize);
 
 	return 0;
 }
@@ -8,10 +8,18 @@
 void CPacker::Reset()
 {
 	m_Error = 0;
-	m_pCurrent = m_aBuffer;
+	m_pCurrent = m_aBuffer + PACKER_HEADER_SIZE;
 	m_pEnd = m_pCurrent + PACKER_BUFFER_SIZE;
 }
 
+const unsigned char *CPacker::PackHeader(const void *pHeader, int Size)
+{
+	dbg_assert(Size >= 0 && Size <= PACKER_HEADER_SIZE, "packer header too big");
+	unsigned char *pStart = m_aBuffer + PACKER_HEADER_SIZE - Size;
+	mem_copy(pStart, pHeader, Size);
+	return pStart;
+}
+
 void CPacker::AddInt(int i)
 {
 	if(m_Error)
@@ -72,12 +80,8 @@ void CPacker::AddRaw(const void *pData, int Size)
 		return;
 	}
 
-	const unsigned char *pSrc = (const unsigned char *)pData;
-	while(Size)
-	{
-		*m_pCurrent++ = *pSrc++;
-		Size--;
-	}
+	mem_copy(m_pCurrent, pData, Size);
+	m_pCurrent += Size;
 }
 
 void CUnpacker::Reset(const void *pData, int Size)
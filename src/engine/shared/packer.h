@@ -8,23 +8,29 @@ class CPacker
 public:
 	enum
 	{
-		PACKER_BUFFER_SIZE = 1024 * 2
+		PACKER_BUFFER_SIZE = 1024 * 2,
+		// reserved in front of the data for a header that is packed afterwards
+		PACKER_HEADER_SIZE = 32,
 	};
 
 private:
-	unsigned char m_aBuffer[PACKER_BUFFER_SIZE];
+	unsigned char m_aBuffer[PACKER_HEADER_SIZE + PACKER_BUFFER_SIZE];
 	unsigned char *m_pCurrent;
 	unsigned char *m_pEnd;
 	int m_Error;
 
+protected:
+	// copies the header directly in front of the data, returns its start
+	const unsigned char *PackHeader(const void *pHeader, int Size);
+
 public:
 	void Reset();
 	void AddInt(int i);
 	void AddString(const char *pStr, int Limit);
 	void AddRaw(const void *pData, int Size);
 
-	int Size() const { return (int)(m_pCurrent - m_aBuffer); }
-	const unsigned char *Data() const { return m_aBuffer; }
+	int Size() const { return (int)(m_pCurrent - Data()); }
+	const unsigned char *Data() const { return m_aBuffer + PACKER_HEADER_SIZE; }
 	bool Error() const { return m_Error; }
 };
 
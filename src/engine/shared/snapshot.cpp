@@ -9,6 +9,12 @@
 
 #include <base/system.h>
 
+#if defined(CONF_ARCH_SSE2)
+#include <emmintrin.h>
+#elif defined(CONF_ARCH_NEON)
+#include <arm_neon.h>
+#endif
+
 // CSnapshot
 
 CSnapshotItem *CSnapshot::GetItem(int Index) const
@@ -162,6 +168,87 @@ static int GetItemIndexHashed(int Key, const CItemList *pHashlist)
 }
 
 int CSnapshotDelta::DiffItem(int *pPast, int *pCurrent, int *pOut, int Size)
+{
+	int Needed = 0;
+	int i = 0;
+#if defined(CONF_ARCH_SSE2)
+	__m128i Accum = _mm_setzero_si128();
+	for(; i + 4 <= Size; i += 4)
+	{
+		const __m128i Diff = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(pCurrent + i)), _mm_loadu_si128((const __m128i *)(pPast + i)));
+		_mm_storeu_si128((__m128i *)(pOut + i), Diff);
+		Accum = _mm_or_si128(Accum, Diff);
+	}
+	Accum = _mm_or_si128(Accum, _mm_shuffle_epi32(Accum, _MM_SHUFFLE(1, 0, 3, 2)));
+	Accum = _mm_or_si128(Accum, _mm_shuffle_epi32(Accum, _MM_SHUFFLE(2, 3, 0, 1)));
+	Needed = _mm_cvtsi128_si32(Accum);
+#elif defined(CONF_ARCH_NEON)
+	int32x4_t Accum = vdupq_n_s32(0);
+	for(; i + 4 <= Size; i += 4)
+	{
+		const int32x4_t Diff = vsubq_s32(vld1q_s32(pCurrent + i), vld1q_s32(pPast + i));
+		vst1q_s32(pOut + i, Diff);
+		Accum = vorrq_s32(Accum, Diff);
+	}
+	const int32x2_t AccumHalf = vorr_s32(vget_low_s32(Accum), vget_high_s32(Accum));
+	Needed = vget_lane_s32(AccumHalf, 0) | vget_lane_s32(AccumHalf, 1);
+#endif
+	for(; i < Size; i++)
+	{
+		pOut[i] = pCurrent[i] - pPast[i];
+		Needed |= pOut[i];
+	}
+
+	return Needed;
+}
+
+void CSnapshotDelta::UndiffItem(int *pPast, int *pDiff, int *pOut, int Size, int *pDataRate)
+{
+	int i = 0;
+#if defined(CONF_ARCH_SSE2)
+	// the data rate counts 1 bit for unchanged ints and the packed size of the diff otherwise,
+	// the packed size is 1 byte plus one per 7 bit group beyond the first 6 bits
+	__m128i Rate = _mm_setzero_si128();
+	for(; i + 4 <= Size; i += 4)
+	{
+		const __m128i Diff = _mm_loadu_si128((const __m128i *)(pDiff + i));
+		_mm_storeu_si128((__m128i *)(pOut + i), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(pPast + i)), Diff));
+
+		const __m128i Value = _mm_xor_si128(Diff, _mm_srai_epi32(Diff, 31));
+		__m128i Bytes = _mm_set1_epi32(1);
+		Bytes = _mm_sub_epi32(Bytes, _mm_cmpgt_epi32(Value, _mm_set1_epi32((1 << 6) - 1)));
+		Bytes = _mm_sub_epi32(Bytes, _mm_cmpgt_epi32(Value, _mm_set1_epi32((1 << 13) - 1)));
+		Bytes = _mm_sub_epi32(Bytes, _mm_cmpgt_epi32(Value, _mm_set1_epi32((1 << 20) - 1)));
+		Bytes = _mm_sub_epi32(Bytes, _mm_cmpgt_epi32(Value, _mm_set1_epi32((1 << 27) - 1)));
+		const __m128i Unchanged = _mm_cmpeq_epi32(Diff, _mm_setzero_si128());
+		Rate = _mm_add_epi32(Rate, _mm_or_si128(_mm_andnot_si128(Unchanged, _mm_slli_epi32(Bytes, 3)), _mm_and_si128(Unchanged, _mm_set1_epi32(1))));
+	}
+	Rate = _mm_add_epi32(Rate, _mm_shuffle_epi32(Rate, _MM_SHUFFLE(1, 0, 3, 2)));
+	Rate = _mm_add_epi32(Rate, _mm_shuffle_epi32(Rate, _MM_SHUFFLE(2, 3, 0, 1)));
+	*pDataRate += _mm_cvtsi128_si32(Rate);
+#elif defined(CONF_ARCH_NEON)
+	int32x4_t Rate = vdupq_n_s32(0);
+	for(; i + 4 <= Size; i += 4)
+	{
+		const int32x4_t Diff = vld1q_s32(pDiff + i);
+		vst1q_s32(pOut + i, vaddq_s32(vld1q_s32(pPast + i), Diff));
+
+		const int32x4_t Value = veorq_s32(Diff, vshrq_n_s32(Diff, 31));
+		int32x4_t Bytes = vdupq_n_s32(1);
+		Bytes = vsubq_s32(Bytes, vreinterpretq_s32_u32(vcgtq_s32(Value, vdupq_n_s32((1 << 6) - 1))));
+		Bytes = vsubq_s32(Bytes, vreinterpretq_s32_u32(vcgtq_s32(Value, vdupq_n_s32((1 << 13) - 1))));
+		Bytes = vsubq_s32(Bytes, vreinterpretq_s32_u32(vcgtq_s32(Value, vdupq_n_s32((1 << 20) - 1))));
+		Bytes = vsubq_s32(Bytes, vreinterpretq_s32_u32(vcgtq_s32(Value, vdupq_n_s32((1 << 27) - 1))));
+		const uint32x4_t Unchanged = vceqq_s32(Diff, vdupq_n_s32(0));
+		Rate = vaddq_s32(Rate, vbslq_s32(Unchanged, vdupq_n_s32(1), vshlq_n_s32(Bytes, 3)));
+	}
+	const int32x2_t RateHalf = vadd_s32(vget_low_s32(Rate), vget_high_s32(Rate));
+	*pDataRate += vget_lane_s32(RateHalf, 0) + vget_lane_s32(RateHalf, 1);
+#endif
+	UndiffItemScalar(pPast + i, pDiff + i, pOut + i, Size - i, pDataRate);
+}
+
+int CSnapshotDelta::DiffItemScalar(int *pPast, int *pCurrent, int *pOut, int Size)
 {
 	int Needed = 0;
 	while(Size)
@@ -177,7 +264,7 @@ int CSnapshotDelta::DiffItem(int *pPast, int *pCurrent, int *pOut, int Size)
 	return Needed;
 }
 
-void CSnapshotDelta::UndiffItem(int *pPast, int *pDiff, int *pOut, int Size, int *pDataRate)
+void CSnapshotDelta::UndiffItemScalar(int *pPast, int *pDiff, int *pOut, int Size, int *pDataRate)
 {
 	while(Size)
 	{
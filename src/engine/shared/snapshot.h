@@ -78,10 +78,12 @@ private:
 	int m_aSnapshotDataUpdates[CSnapshot::MAX_TYPE + 1];
 	CData m_Empty;
 
-	static void UndiffItem(int *pPast, int *pDiff, int *pOut, int Size, int *pDataRate);
-
 public:
 	static int DiffItem(int *pPast, int *pCurrent, int *pOut, int Size);
+	static void UndiffItem(int *pPast, int *pDiff, int *pOut, int Size, int *pDataRate);
+	// reference implementations without the vectorized fast paths
+	static int DiffItemScalar(int *pPast, int *pCurrent, int *pOut, int Size);
+	static void UndiffItemScalar(int *pPast, int *pDiff, int *pOut, int Size, int *pDataRate);
 	CSnapshotDelta();
 	CSnapshotDelta(const CSnapshotDelta &Old);
 	int GetDataRate(int Index) const { return m_aSnapshotDataRate[Index]; }
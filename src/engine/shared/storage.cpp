@@ -10,6 +10,12 @@
 #include <stdlib.h>
 #endif
 
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 class CStorage : public IStorage
 {
 public:
@@ -20,12 +26,40 @@ public:
 	char m_aCurrentdir[IO_MAX_PATH_LENGTH];
 	char m_aBinarydir[IO_MAX_PATH_LENGTH];
 
+	enum
+	{
+		// seconds a cached directory listing is trusted
+		INDEX_LIFETIME = 10,
+	};
+
+	struct CIndexEntry
+	{
+		std::string m_Name;
+		bool m_IsDir;
+	};
+
+	struct CIndexedDir
+	{
+		int64_t m_ListedAt;
+		std::vector<CIndexEntry> m_vEntries; // in listing order
+		std::unordered_set<std::string> m_Files; // index keys
+	};
+
+	bool m_UseIndex;
+	std::mutex m_IndexLock;
+	std::unordered_map<std::string, CIndexedDir> m_aIndex[MAX_PATHS];
+	int m_IndexHits;
+	int m_IndexMisses;
+
 	CStorage()
 	{
 		mem_zero(m_aaStoragePaths, sizeof(m_aaStoragePaths));
 		m_NumPaths = 0;
 		m_aDatadir[0] = 0;
 		m_aUserdir[0] = 0;
+		m_UseIndex = false;
+		m_IndexHits = 0;
+		m_IndexMisses = 0;
 	}
 
 	int Init(int StorageType, int NumArgs, const char **ppArguments)
@@ -53,6 +87,9 @@ public:
 		// load paths from storage.cfg
 		LoadPaths(ppArguments[0]);
 
+		// the server resolves many files at startup and owns its storage paths
+		m_UseIndex = StorageType == STORAGETYPE_SERVER;
+
 		if(!m_NumPaths)
 		{
 			dbg_msg("storage", "using standard paths");
@@ -309,6 +346,126 @@ public:
 		// no binary directory found, use $PATH on Posix, $PWD on Windows
 	}
 
+	// file systems of these platforms ignore case, so must the index
+	static std::string IndexKey(const char *pPath)
+	{
+		std::string Key(pPath);
+#if defined(CONF_FAMILY_WINDOWS) || defined(CONF_PLATFORM_MACOS)
+		for(char &c : Key)
+		{
+			if(c >= 'A' && c <= 'Z')
+				c += 'a' - 'A';
+		}
+#endif
+		return Key;
+	}
+
+	// paths the index can't map to a single directory are resolved directly
+	static bool IsIndexable(const char *pPath)
+	{
+		return str_find(pPath, "//") == nullptr && str_find(pPath, "./") == nullptr && str_find(pPath, "\\") == nullptr && !str_endswith(pPath, "/");
+	}
+
+	static int IndexCallback(const char *pName, int IsDir, int Type, void *pUser)
+	{
+		if(!str_comp(pName, ".") || !str_comp(pName, ".."))
+			return 0;
+
+		CIndexedDir *pDir = static_cast<CIndexedDir *>(pUser);
+		pDir->m_vEntries.push_back({pName, IsDir != 0});
+		if(!IsDir)
+			pDir->m_Files.insert(IndexKey(pName));
+		return 0;
+	}
+
+	// returns the listing of a directory, listing it if needed. m_IndexLock must be held
+	const CIndexedDir &IndexedDir(int Type, const char *pDir)
+	{
+		const int64_t Now = time_get();
+		auto it = m_aIndex[Type].find(IndexKey(pDir));
+		if(it != m_aIndex[Type].end() && Now - it->second.m_ListedAt < time_freq() * INDEX_LIFETIME)
+		{
+			m_IndexHits++;
+			return it->second;
+		}
+
+		m_IndexMisses++;
+		CIndexedDir &Dir = m_aIndex[Type][IndexKey(pDir)];
+		Dir.m_ListedAt = Now;
+		Dir.m_vEntries.clear();
+		Dir.m_Files.clear();
+		char aBuf[IO_MAX_PATH_LENGTH];
+		GetPath(Type, pDir, aBuf, sizeof(aBuf));
+		fs_listdir(aBuf[0] ? aBuf : ".", IndexCallback, Type, &Dir);
+		return Dir;
+	}
+
+	static void SplitIndexPath(const char *pFilename, char *pDir, int DirSize, const char **ppName)
+	{
+		const char *pSlash = str_rchr(pFilename, '/');
+		if(pSlash)
+		{
+			str_truncate(pDir, DirSize, pFilename, pSlash - pFilename);
+			*ppName = pSlash + 1;
+		}
+		else
+		{
+			pDir[0] = 0;
+			*ppName = pFilename;
+		}
+	}
+
+	// false only if the index knows that the file doesn't exist
+	bool IndexMayContain(int Type, const char *pFilename)
+	{
+		if(!m_UseIndex || !IsIndexable(pFilename))
+			return true;
+
+		char aDir[IO_MAX_PATH_LENGTH];
+		const char *pName;
+		SplitIndexPath(pFilename, aDir, sizeof(aDir), &pName);
+		std::lock_guard<std::mutex> Lock(m_IndexLock);
+		const CIndexedDir &Dir = IndexedDir(Type, aDir);
+		return Dir.m_Files.count(IndexKey(pName)) != 0;
+	}
+
+	// drops the listing of the directory that contains the path, in every storage path
+	void InvalidateIndex(const char *pPath)
+	{
+		if(!m_UseIndex)
+			return;
+
+		char aDir[IO_MAX_PATH_LENGTH];
+		const char *pName;
+		SplitIndexPath(pPath, aDir, sizeof(aDir), &pName);
+		std::lock_guard<std::mutex> Lock(m_IndexLock);
+		for(auto &Index : m_aIndex)
+			Index.erase(IndexKey(aDir));
+	}
+
+	void SetIndexEnabled(bool Enabled) override
+	{
+		RefreshIndex();
+		m_UseIndex = Enabled;
+	}
+
+	void RefreshIndex() override
+	{
+		std::lock_guard<std::mutex> Lock(m_IndexLock);
+		for(auto &Index : m_aIndex)
+			Index.clear();
+	}
+
+	void GetIndexStats(int *pHits, int *pMisses, int *pNumDirs) override
+	{
+		std::lock_guard<std::mutex> Lock(m_IndexLock);
+		*pHits = m_IndexHits;
+		*pMisses = m_IndexMisses;
+		*pNumDirs = 0;
+		for(auto &Index : m_aIndex)
+			*pNumDirs += Index.size();
+	}
+
 	void ListDirectoryInfo(int Type, const char *pPath, FS_LISTDIR_CALLBACK_FILEINFO pfnCallback, void *pUser) override
 	{
 		char aBuffer[IO_MAX_PATH_LENGTH];
@@ -365,6 +522,9 @@ public:
 
 		if(Type == TYPE_ABSOLUTE)
 		{
+			// there's no telling which storage path an absolute write touches
+			if(Flags & IOFLAG_WRITE)
+				RefreshIndex();
 			return io_open(pFilename, Flags);
 		}
 		if(str_startswith(pFilename, "mapres/../skins/"))
@@ -381,7 +541,9 @@ public:
 		}
 		else if(Flags & IOFLAG_WRITE)
 		{
-			return io_open(GetPath(TYPE_SAVE, pFilename, pBuffer, BufferSize), Flags);
+			IOHANDLE Handle = io_open(GetPath(TYPE_SAVE, pFilename, pBuffer, BufferSize), Flags);
+			InvalidateIndex(pFilename);
+			return Handle;
 		}
 		else
 		{
@@ -392,17 +554,24 @@ public:
 				// check all available directories
 				for(int i = 0; i < m_NumPaths; ++i)
 				{
+					if(!IndexMayContain(i, pFilename))
+						continue;
 					Handle = io_open(GetPath(i, pFilename, pBuffer, BufferSize), Flags);
 					if(Handle)
 						return Handle;
+					InvalidateIndex(pFilename);
 				}
 			}
 			else if(Type >= 0 && Type < m_NumPaths)
 			{
 				// check wanted directory
-				Handle = io_open(GetPath(Type, pFilename, pBuffer, BufferSize), Flags);
-				if(Handle)
-					return Handle;
+				if(IndexMayContain(Type, pFilename))
+				{
+					Handle = io_open(GetPath(Type, pFilename, pBuffer, BufferSize), Flags);
+					if(Handle)
+						return Handle;
+					InvalidateIndex(pFilename);
+				}
 			}
 		}
 
@@ -470,12 +639,57 @@ public:
 		return 0;
 	}
 
+	// same search as FindFileCallback, on the cached listings. m_IndexLock must be held
+	bool FindFileIndexed(int Type, const char *pFilename, const char *pPath, char *pBuffer, int BufferSize)
+	{
+		const CIndexedDir &Dir = IndexedDir(Type, pPath);
+		for(const auto &Entry : Dir.m_vEntries)
+		{
+			if(Entry.m_IsDir)
+			{
+				if(Entry.m_Name[0] == '.')
+					continue;
+
+				// search within the folder
+				char aPath[IO_MAX_PATH_LENGTH];
+				str_format(aPath, sizeof(aPath), "%s/%s", pPath, Entry.m_Name.c_str());
+				if(FindFileIndexed(Type, pFilename, aPath, pBuffer, BufferSize))
+					return true;
+			}
+			else if(!str_comp(Entry.m_Name.c_str(), pFilename))
+			{
+				// found the file = end
+				str_format(pBuffer, BufferSize, "%s/%s", pPath, pFilename);
+				return true;
+			}
+		}
+		return false;
+	}
+
 	bool FindFile(const char *pFilename, const char *pPath, int Type, char *pBuffer, int BufferSize) override
 	{
 		if(BufferSize < 1)
 			return false;
 
 		pBuffer[0] = 0;
+		if(m_UseIndex && IsIndexable(pPath))
+		{
+			std::lock_guard<std::mutex> Lock(m_IndexLock);
+			if(Type == TYPE_ALL)
+			{
+				for(int i = 0; i < m_NumPaths; ++i)
+				{
+					if(FindFileIndexed(i, pFilename, pPath, pBuffer, BufferSize))
+						return true;
+				}
+			}
+			else if(Type >= 0 && Type < m_NumPaths)
+			{
+				return FindFileIndexed(Type, pFilename, pPath, pBuffer, BufferSize);
+			}
+			return false;
+		}
+
 		char aBuf[IO_MAX_PATH_LENGTH];
 		CFindCBData Data;
 		Data.m_pStorage = this;
@@ -514,6 +728,10 @@ public:
 		bool Success = !fs_remove(aBuffer);
 		if(!Success)
 			dbg_msg("storage", "failed to remove: %s", aBuffer);
+		if(Type == TYPE_ABSOLUTE)
+			RefreshIndex();
+		else
+			InvalidateIndex(pFilename);
 		return Success;
 	}
 
@@ -541,6 +759,8 @@ public:
 		bool Success = !fs_rename(aOldBuffer, aNewBuffer);
 		if(!Success)
 			dbg_msg("storage", "failed to rename: %s -> %s", aOldBuffer, aNewBuffer);
+		InvalidateIndex(pOldFilename);
+		InvalidateIndex(pNewFilename);
 		return Success;
 	}
 
@@ -571,6 +791,7 @@ public:
 		bool Success = !fs_makedir(aBuffer);
 		if(!Success)
 			dbg_msg("storage", "failed to create folder: %s", aBuffer);
+		InvalidateIndex(pFoldername);
 		return Success;
 	}
 
@@ -40,6 +40,16 @@ public:
 	virtual bool RenameBinaryFile(const char *pOldFilename, const char *pNewFilename) = 0;
 	virtual const char *GetBinaryPath(const char *pFilename, char *pBuffer, unsigned BufferSize) = 0;
 
+	/*
+		The path index caches directory listings of the storage paths, so
+		relative files are resolved without probing every path. Changes
+		made around this interface are seen after RefreshIndex or once the
+		cached listing expires.
+	*/
+	virtual void SetIndexEnabled(bool Enabled) = 0;
+	virtual void RefreshIndex() = 0;
+	virtual void GetIndexStats(int *pHits, int *pMisses, int *pNumDirs) = 0;
+
 	static void StripPathAndExtension(const char *pFilename, char *pBuffer, int BufferSize);
 	static const char *FormatTmpPath(char *aBuf, unsigned BufSize, const char *pPath);
 };
@@ -200,6 +200,12 @@ public:
 
 	virtual void OnWindowResize() = 0;
 
+	// queues the glyphs that are missing for the text for rasterization in the background, returns true if all of them are ready
+	virtual bool PrepareGlyphs(const char *pText, float FontSize) = 0;
+
+	// counters of the layout cache used by TextEx
+	virtual void GetLayoutCacheStats(int64_t &Hits, int64_t &Misses, int &Entries) = 0;
+
 	virtual float GetGlyphOffsetX(int FontSize, char TextCharacter) = 0;
 };
 
@@ -208,6 +214,7 @@ class IEngineTextRender : public ITextRender
 	MACRO_INTERFACE("enginetextrender", 0)
 public:
 	virtual void Init() = 0;
+	virtual void Shutdown() = 0;
 };
 
 extern IEngineTextRender *CreateEngineTextRender();
@@ -1033,6 +1033,15 @@ void CChat::OnPrepareLines()
 		if(m_aLines[r].m_TextContainerIndex != -1 && !ForceRecreate)
 			continue;
 
+		// give the glyphs of new messages a moment to be rasterized in the background
+		if(m_aLines[r].m_YOffset[OffsetType] < 0.0f && Now < m_aLines[r].m_Time + time_freq() / 4)
+		{
+			bool Ready = TextRender()->PrepareGlyphs(m_aLines[r].m_aName, FontSize);
+			Ready &= TextRender()->PrepareGlyphs(m_aLines[r].m_aText, FontSize);
+			if(!Ready)
+				continue;
+		}
+
 		if(m_aLines[r].m_TextContainerIndex != -1)
 			TextRender()->DeleteTextContainer(m_aLines[r].m_TextContainerIndex);
 
@@ -1350,6 +1359,10 @@ void CChat::OnRender()
 		if(Now > m_aLines[r].m_Time + 16 * time_freq() && !m_PrevShowChat)
 			break;
 
+		// still waiting for its glyphs
+		if(m_aLines[r].m_YOffset[OffsetType] < 0.0f)
+			continue;
+
 		y -= m_aLines[r].m_YOffset[OffsetType];
 
 		// cut off if msgs waste too much space
@@ -333,27 +333,28 @@ CMapLayers::STileLayerVisuals::~STileLayerVisuals()
 	m_pBorderRight = NULL;
 }
 
-bool AddTile(std::vector<SGraphicTile> &vTmpTiles, std::vector<SGraphicTileTexureCoords> &vTmpTileTexCoords, bool As3DTextureCoord, unsigned char Index, unsigned char Flags, int x, int y, CMapItemGroup *pGroup, bool DoTextureCoords, bool FillSpeedup = false, int AngleRotate = -1)
+// writes the four vertices of a tile into the upload buffer, interleaved with their texture coordinates
+static void WriteTile(char *pDest, bool Textured, bool As3DTextureCoord, unsigned char Index, unsigned char Flags, int x, int y, bool FillSpeedup = false, int AngleRotate = -1)
 {
-	if(Index)
+	SGraphicTile Tile;
+	SGraphicTileTexureCoords TileTex;
+	if(FillSpeedup)
+		FillTmpTileSpeedup(&Tile, Textured ? &TileTex : nullptr, As3DTextureCoord, Flags, 0, x, y, 32.f, nullptr, AngleRotate);
+	else
+		FillTmpTile(&Tile, Textured ? &TileTex : nullptr, As3DTextureCoord, Flags, Index, x, y, 32.f, nullptr);
+
+	const vec2 *pPositions = &Tile.m_TopLeft;
+	const vec3 *pTexCoords = &TileTex.m_TexCoordTopLeft;
+	for(int i = 0; i < 4; ++i)
 	{
-		vTmpTiles.emplace_back();
-		SGraphicTile &Tile = vTmpTiles.back();
-		SGraphicTileTexureCoords *pTileTex = NULL;
-		if(DoTextureCoords)
+		mem_copy(pDest, &pPositions[i], sizeof(vec2));
+		pDest += sizeof(vec2);
+		if(Textured)
 		{
-			vTmpTileTexCoords.emplace_back();
-			SGraphicTileTexureCoords &TileTex = vTmpTileTexCoords.back();
-			pTileTex = &TileTex;
+			mem_copy(pDest, &pTexCoords[i], sizeof(vec3));
+			pDest += sizeof(vec3);
 		}
-		if(FillSpeedup)
-			FillTmpTileSpeedup(&Tile, pTileTex, As3DTextureCoord, Flags, 0, x, y, 32.f, pGroup, AngleRotate);
-		else
-			FillTmpTile(&Tile, pTileTex, As3DTextureCoord, Flags, Index, x, y, 32.f, pGroup);
-
-		return true;
 	}
-	return false;
 }
 
 struct STmpQuadVertexTextured
@@ -379,13 +380,266 @@ struct STmpQuadTextured
 	STmpQuadVertexTextured m_aVertices[4];
 };
 
-void mem_copy_special(void *pDest, void *pSource, size_t Size, size_t Count, size_t Steps)
+// the tiles of a layer are followed by copies of its border tiles, grouped by border
+enum
+{
+	SECTION_TILES = 0,
+	SECTION_CORNERS,
+	SECTION_TOP,
+	SECTION_BOTTOM,
+	SECTION_LEFT,
+	SECTION_RIGHT,
+	NUM_SECTIONS
+};
+
+CMapLayers::CLayerBuildJob::CLayerBuildJob(int Kind, int FirstVisuals, int Width, int Height, int NumOverlays, bool Textured, bool As3DTextureCoords) :
+	m_Kind(Kind),
+	m_FirstVisuals(FirstVisuals),
+	m_Width(Width),
+	m_Height(Height),
+	m_Textured(Textured),
+	m_As3DTextureCoords(As3DTextureCoords)
+{
+	m_vBuilt.resize(NumOverlays);
+}
+
+CMapLayers::CLayerBuildJob::~CLayerBuildJob()
+{
+	// results that were never uploaded
+	for(auto &Built : m_vBuilt)
+	{
+		delete Built.m_pTileVisuals;
+		free(Built.m_pUploadData);
+	}
+}
+
+void CMapLayers::CLayerBuildJob::Run()
+{
+	if(m_Kind == LAYER_QUADS)
+	{
+		BuildQuadLayer();
+		return;
+	}
+	for(int Overlay = 0; Overlay < (int)m_vBuilt.size(); ++Overlay)
+		BuildTileLayer(Overlay);
+}
+
+void CMapLayers::CLayerBuildJob::GetTile(int Overlay, int x, int y, unsigned char &Index, unsigned char &Flags, int &AngleRotate) const
+{
+	const int TileIndex = y * m_Width + x;
+	Flags = 0;
+	AngleRotate = -1;
+	switch(m_Kind)
+	{
+	case LAYER_SWITCH:
+	{
+		const CSwitchTile &Tile = ((const CSwitchTile *)m_vData.data())[TileIndex];
+		Index = Tile.m_Type;
+		if(Overlay == 0)
+		{
+			Flags = Tile.m_Flags;
+			if(Index == TILE_SWITCHTIMEDOPEN)
+				Index = 8;
+		}
+		else if(Overlay == 1)
+			Index = Tile.m_Number;
+		else if(Overlay == 2)
+			Index = Tile.m_Delay;
+		break;
+	}
+	case LAYER_TELE:
+	{
+		const CTeleTile &Tile = ((const CTeleTile *)m_vData.data())[TileIndex];
+		Index = Tile.m_Type;
+		if(Overlay == 1)
+		{
+			if(Index != TILE_TELECHECKIN && Index != TILE_TELECHECKINEVIL)
+				Index = Tile.m_Number;
+			else
+				Index = 0;
+		}
+		break;
+	}
+	case LAYER_SPEEDUP:
+	{
+		const CSpeedupTile &Tile = ((const CSpeedupTile *)m_vData.data())[TileIndex];
+		Index = Tile.m_Type;
+		AngleRotate = Tile.m_Angle;
+		if(Tile.m_Force == 0)
+			Index = 0;
+		else if(Overlay == 1)
+			Index = Tile.m_Force;
+		else if(Overlay == 2)
+			Index = Tile.m_MaxSpeed;
+		break;
+	}
+	case LAYER_TUNE:
+		Index = ((const CTuneTile *)m_vData.data())[TileIndex].m_Type;
+		break;
+	default:
+	{
+		const CTile &Tile = ((const CTile *)m_vData.data())[TileIndex];
+		Index = Tile.m_Index;
+		Flags = Tile.m_Flags;
+		break;
+	}
+	}
+}
+
+void CMapLayers::CLayerBuildJob::BuildTileLayer(int Overlay)
+{
+	SBuiltLayer &Built = m_vBuilt[Overlay];
+	Built.m_pTileVisuals = new STileLayerVisuals();
+	STileLayerVisuals &Visuals = *Built.m_pTileVisuals;
+	if(!Visuals.Init(m_Width, m_Height))
+		return;
+	Visuals.m_IsTextured = m_Textured;
+
+	auto BorderTile = [&](int x, int y, int &Section) -> STileLayerVisuals::STileVisual * {
+		if(x == 0 || x == m_Width - 1)
+		{
+			if(y == 0 || y == m_Height - 1)
+			{
+				Section = SECTION_CORNERS;
+				if(x == 0)
+					return y == 0 ? &Visuals.m_BorderTopLeft : &Visuals.m_BorderBottomLeft;
+				return y == 0 ? &Visuals.m_BorderTopRight : &Visuals.m_BorderBottomRight;
+			}
+			Section = x == 0 ? SECTION_LEFT : SECTION_RIGHT;
+			return x == 0 ? &Visuals.m_pBorderLeft[y - 1] : &Visuals.m_pBorderRight[y - 1];
+		}
+		if(y == 0 || y == m_Height - 1)
+		{
+			Section = y == 0 ? SECTION_TOP : SECTION_BOTTOM;
+			return y == 0 ? &Visuals.m_pBorderTop[x - 1] : &Visuals.m_pBorderBottom[x - 1];
+		}
+		return nullptr;
+	};
+
+	unsigned char Index;
+	unsigned char Flags;
+	int AngleRotate;
+	int Section;
+
+	// count the tiles first, so the upload buffer can be filled in place
+	int aCount[NUM_SECTIONS] = {0};
+	for(int y = 0; y < m_Height; ++y)
+	{
+		for(int x = 0; x < m_Width; ++x)
+		{
+			GetTile(Overlay, x, y, Index, Flags, AngleRotate);
+			if(!Index)
+				continue;
+			aCount[SECTION_TILES]++;
+			if(BorderTile(x, y, Section))
+				aCount[Section]++;
+		}
+	}
+	//append one kill tile to the gamelayer
+	if(m_Kind == LAYER_GAME)
+		aCount[SECTION_TILES]++;
+
+	int aNext[NUM_SECTIONS];
+	int NumTiles = 0;
+	for(int i = 0; i < NUM_SECTIONS; ++i)
+	{
+		aNext[i] = NumTiles;
+		NumTiles += aCount[i];
+	}
+	if(NumTiles == 0)
+		return;
+
+	const size_t TileDataSize = 4 * (sizeof(vec2) + (m_Textured ? sizeof(vec3) : 0));
+	Built.m_UploadDataSize = NumTiles * TileDataSize;
+	Built.m_pUploadData = (char *)malloc(Built.m_UploadDataSize);
+	Built.m_NumIndices = NumTiles * 6;
+
+	const bool AddAsSpeedup = m_Kind == LAYER_SPEEDUP && Overlay == 0;
+	for(int y = 0; y < m_Height; ++y)
+	{
+		for(int x = 0; x < m_Width; ++x)
+		{
+			GetTile(Overlay, x, y, Index, Flags, AngleRotate);
+
+			// empty tiles get the offset of the next tile as well
+			STileLayerVisuals::STileVisual &Visual = Visuals.m_pTilesOfLayer[y * m_Width + x];
+			Visual.SetIndexBufferByteOffset((offset_ptr32)(aNext[SECTION_TILES] * 6 * sizeof(unsigned int)));
+			STileLayerVisuals::STileVisual *pBorder = BorderTile(x, y, Section);
+			if(pBorder)
+				pBorder->SetIndexBufferByteOffset((offset_ptr32)(aNext[Section] * 6 * sizeof(unsigned int)));
+			if(!Index)
+				continue;
+
+			char *pTileData = Built.m_pUploadData + aNext[SECTION_TILES]++ * TileDataSize;
+			WriteTile(pTileData, m_Textured, m_As3DTextureCoords, Index, Flags, x, y, AddAsSpeedup, AngleRotate);
+			Visual.Draw(true);
+			if(pBorder)
+			{
+				mem_copy(Built.m_pUploadData + aNext[Section]++ * TileDataSize, pTileData, TileDataSize);
+				pBorder->Draw(true);
+			}
+		}
+	}
+
+	if(m_Kind == LAYER_GAME)
+	{
+		Visuals.m_BorderKillTile.SetIndexBufferByteOffset((offset_ptr32)(aNext[SECTION_TILES] * 6 * sizeof(unsigned int)));
+		WriteTile(Built.m_pUploadData + aNext[SECTION_TILES]++ * TileDataSize, m_Textured, m_As3DTextureCoords, TILE_DEATH, 0, 0, 0);
+		Visuals.m_BorderKillTile.Draw(true);
+	}
+}
+
+void CMapLayers::CLayerBuildJob::BuildQuadLayer()
 {
-	size_t CurStep = 0;
-	for(size_t i = 0; i < Count; ++i)
+	SBuiltLayer &Built = m_vBuilt[0];
+	const int NumQuads = m_Width;
+	if(NumQuads <= 0 || m_vData.size() < (size_t)NumQuads * sizeof(CQuad))
+		return;
+
+	Built.m_UploadDataSize = NumQuads * (m_Textured ? sizeof(STmpQuadTextured) : sizeof(STmpQuad));
+	Built.m_pUploadData = (char *)malloc(Built.m_UploadDataSize);
+	Built.m_NumIndices = NumQuads * 6;
+
+	STmpQuad *pTmpQuads = (STmpQuad *)Built.m_pUploadData;
+	STmpQuadTextured *pTmpQuadsTextured = (STmpQuadTextured *)Built.m_pUploadData;
+	const CQuad *pQuads = (const CQuad *)m_vData.data();
+	for(int i = 0; i < NumQuads; ++i)
 	{
-		mem_copy(((char *)pDest) + CurStep + i * Size, ((char *)pSource) + i * Size, Size);
-		CurStep += Steps;
+		const CQuad *q = &pQuads[i];
+		for(int j = 0; j < 4; ++j)
+		{
+			int QuadIDX = j;
+			if(j == 2)
+				QuadIDX = 3;
+			else if(j == 3)
+				QuadIDX = 2;
+			if(!m_Textured)
+			{
+				// ignore the conversion for the position coordinates
+				pTmpQuads[i].m_aVertices[j].m_X = (q->m_aPoints[QuadIDX].x);
+				pTmpQuads[i].m_aVertices[j].m_Y = (q->m_aPoints[QuadIDX].y);
+				pTmpQuads[i].m_aVertices[j].m_CenterX = (q->m_aPoints[4].x);
+				pTmpQuads[i].m_aVertices[j].m_CenterY = (q->m_aPoints[4].y);
+				pTmpQuads[i].m_aVertices[j].m_R = (unsigned char)q->m_aColors[QuadIDX].r;
+				pTmpQuads[i].m_aVertices[j].m_G = (unsigned char)q->m_aColors[QuadIDX].g;
+				pTmpQuads[i].m_aVertices[j].m_B = (unsigned char)q->m_aColors[QuadIDX].b;
+				pTmpQuads[i].m_aVertices[j].m_A = (unsigned char)q->m_aColors[QuadIDX].a;
+			}
+			else
+			{
+				// ignore the conversion for the position coordinates
+				pTmpQuadsTextured[i].m_aVertices[j].m_X = (q->m_aPoints[QuadIDX].x);
+				pTmpQuadsTextured[i].m_aVertices[j].m_Y = (q->m_aPoints[QuadIDX].y);
+				pTmpQuadsTextured[i].m_aVertices[j].m_CenterX = (q->m_aPoints[4].x);
+				pTmpQuadsTextured[i].m_aVertices[j].m_CenterY = (q->m_aPoints[4].y);
+				pTmpQuadsTextured[i].m_aVertices[j].m_U = fx2f(q->m_aTexcoords[QuadIDX].x);
+				pTmpQuadsTextured[i].m_aVertices[j].m_V = fx2f(q->m_aTexcoords[QuadIDX].y);
+				pTmpQuadsTextured[i].m_aVertices[j].m_R = (unsigned char)q->m_aColors[QuadIDX].r;
+				pTmpQuadsTextured[i].m_aVertices[j].m_G = (unsigned char)q->m_aColors[QuadIDX].g;
+				pTmpQuadsTextured[i].m_aVertices[j].m_B = (unsigned char)q->m_aColors[QuadIDX].b;
+				pTmpQuadsTextured[i].m_aVertices[j].m_A = (unsigned char)q->m_aColors[QuadIDX].a;
+			}
+		}
 	}
 }
 
@@ -414,6 +668,8 @@ void CMapLayers::OnMapLoad()
 {
 	if(!Graphics()->IsTileBufferingEnabled() && !Graphics()->IsQuadBufferingEnabled())
 		return;
+	// jobs of the previous map still running only write to their own data
+	m_vpLayerJobs.clear();
 	//clear everything and destroy all buffers
 	if(!m_vpTileLayerVisuals.empty())
 	{
@@ -436,24 +692,9 @@ void CMapLayers::OnMapLoad()
 		m_vpQuadLayerVisuals.clear();
 	}
 
+	// the visuals are created empty here and swapped for the built ones once their
+	// job is done, layers without a buffer container are skipped while rendering
 	bool PassedGameLayer = false;
-	//prepare all visuals for all tile layers
-	std::vector<SGraphicTile> vtmpTiles;
-	std::vector<SGraphicTileTexureCoords> vtmpTileTexCoords;
-	std::vector<SGraphicTile> vtmpBorderTopTiles;
-	std::vector<SGraphicTileTexureCoords> vtmpBorderTopTilesTexCoords;
-	std::vector<SGraphicTile> vtmpBorderLeftTiles;
-	std::vector<SGraphicTileTexureCoords> vtmpBorderLeftTilesTexCoords;
-	std::vector<SGraphicTile> vtmpBorderRightTiles;
-	std::vector<SGraphicTileTexureCoords> vtmpBorderRightTilesTexCoords;
-	std::vector<SGraphicTile> vtmpBorderBottomTiles;
-	std::vector<SGraphicTileTexureCoords> vtmpBorderBottomTilesTexCoords;
-	std::vector<SGraphicTile> vtmpBorderCorners;
-	std::vector<SGraphicTileTexureCoords> vtmpBorderCornersTexCoords;
-
-	std::vector<STmpQuad> vtmpQuads;
-	std::vector<STmpQuadTextured> vtmpQuadsTextured;
-
 	bool As3DTextureCoords = !Graphics()->HasTextureArrays();
 
 	for(int g = 0; g < m_pLayers->NumGroups(); g++)
@@ -470,35 +711,30 @@ void CMapLayers::OnMapLoad()
 		for(int l = 0; l < pGroup->m_NumLayers; l++)
 		{
 			CMapItemLayer *pLayer = m_pLayers->GetLayer(pGroup->m_StartLayer + l);
-			bool IsFrontLayer = false;
-			bool IsSwitchLayer = false;
-			bool IsTeleLayer = false;
-			bool IsSpeedupLayer = false;
-			bool IsTuneLayer = false;
-			bool IsGameLayer = false;
-			bool IsEntityLayer = false;
+			int Kind = CLayerBuildJob::LAYER_TILES;
 
 			if(pLayer == (CMapItemLayer *)m_pLayers->GameLayer())
 			{
-				IsGameLayer = true;
-				IsEntityLayer = true;
+				Kind = CLayerBuildJob::LAYER_GAME;
 				PassedGameLayer = true;
 			}
 
 			if(pLayer == (CMapItemLayer *)m_pLayers->FrontLayer())
-				IsEntityLayer = IsFrontLayer = true;
+				Kind = CLayerBuildJob::LAYER_FRONT;
 
 			if(pLayer == (CMapItemLayer *)m_pLayers->SwitchLayer())
-				IsEntityLayer = IsSwitchLayer = true;
+				Kind = CLayerBuildJob::LAYER_SWITCH;
 
 			if(pLayer == (CMapItemLayer *)m_pLayers->TeleLayer())
-				IsEntityLayer = IsTeleLayer = true;
+				Kind = CLayerBuildJob::LAYER_TELE;
 
 			if(pLayer == (CMapItemLayer *)m_pLayers->SpeedupLayer())
-				IsEntityLayer = IsSpeedupLayer = true;
+				Kind = CLayerBuildJob::LAYER_SPEEDUP;
 
 			if(pLayer == (CMapItemLayer *)m_pLayers->TuneLayer())
-				IsEntityLayer = IsTuneLayer = true;
+				Kind = CLayerBuildJob::LAYER_TUNE;
+
+			const bool IsEntityLayer = Kind != CLayerBuildJob::LAYER_TILES;
 
 			if(m_Type <= TYPE_BACKGROUND_FORCE)
 			{
@@ -526,30 +762,30 @@ void CMapLayers::OnMapLoad()
 				int DataIndex = 0;
 				unsigned int TileSize = 0;
 				int OverlayCount = 0;
-				if(IsFrontLayer)
+				if(Kind == CLayerBuildJob::LAYER_FRONT)
 				{
 					DataIndex = pTMap->m_Front;
 					TileSize = sizeof(CTile);
 				}
-				else if(IsSwitchLayer)
+				else if(Kind == CLayerBuildJob::LAYER_SWITCH)
 				{
 					DataIndex = pTMap->m_Switch;
 					TileSize = sizeof(CSwitchTile);
 					OverlayCount = 2;
 				}
-				else if(IsTeleLayer)
+				else if(Kind == CLayerBuildJob::LAYER_TELE)
 				{
 					DataIndex = pTMap->m_Tele;
 					TileSize = sizeof(CTeleTile);
 					OverlayCount = 1;
 				}
-				else if(IsSpeedupLayer)
+				else if(Kind == CLayerBuildJob::LAYER_SPEEDUP)
 				{
 					DataIndex = pTMap->m_Speedup;
 					TileSize = sizeof(CSpeedupTile);
 					OverlayCount = 2;
 				}
-				else if(IsTuneLayer)
+				else if(Kind == CLayerBuildJob::LAYER_TUNE)
 				{
 					DataIndex = pTMap->m_Tune;
 					TileSize = sizeof(CTuneTile);
@@ -564,390 +800,66 @@ void CMapLayers::OnMapLoad()
 
 				if(Size >= pTMap->m_Width * pTMap->m_Height * TileSize)
 				{
-					int CurOverlay = 0;
-					while(CurOverlay < OverlayCount + 1)
-					{
-						// We can later just count the tile layers to get the idx in the vector
+					// We can later just count the tile layers to get the idx in the vector
+					auto pJob = std::make_shared<CLayerBuildJob>(Kind, m_vpTileLayerVisuals.size(), pTMap->m_Width, pTMap->m_Height, OverlayCount + 1, DoTextureCoords, As3DTextureCoords);
+					if(pTMap->m_Width > 0 && pTMap->m_Height > 0)
+						pJob->m_vData.assign((char *)pTiles, (char *)pTiles + (size_t)pTMap->m_Width * pTMap->m_Height * TileSize);
+					for(int i = 0; i < OverlayCount + 1; ++i)
 						m_vpTileLayerVisuals.push_back(new STileLayerVisuals());
-						STileLayerVisuals &Visuals = *m_vpTileLayerVisuals.back();
-						if(!Visuals.Init(pTMap->m_Width, pTMap->m_Height))
-						{
-							++CurOverlay;
-							continue;
-						}
-						Visuals.m_IsTextured = DoTextureCoords;
-
-						vtmpTiles.clear();
-						vtmpTileTexCoords.clear();
-
-						vtmpBorderTopTiles.clear();
-						vtmpBorderLeftTiles.clear();
-						vtmpBorderRightTiles.clear();
-						vtmpBorderBottomTiles.clear();
-						vtmpBorderCorners.clear();
-						vtmpBorderTopTilesTexCoords.clear();
-						vtmpBorderLeftTilesTexCoords.clear();
-						vtmpBorderRightTilesTexCoords.clear();
-						vtmpBorderBottomTilesTexCoords.clear();
-						vtmpBorderCornersTexCoords.clear();
-
-						if(!DoTextureCoords)
-						{
-							vtmpTiles.reserve((size_t)pTMap->m_Width * pTMap->m_Height);
-							vtmpBorderTopTiles.reserve((size_t)pTMap->m_Width);
-							vtmpBorderBottomTiles.reserve((size_t)pTMap->m_Width);
-							vtmpBorderLeftTiles.reserve((size_t)pTMap->m_Height);
-							vtmpBorderRightTiles.reserve((size_t)pTMap->m_Height);
-							vtmpBorderCorners.reserve((size_t)4);
-						}
-						else
-						{
-							vtmpTileTexCoords.reserve((size_t)pTMap->m_Width * pTMap->m_Height);
-							vtmpBorderTopTilesTexCoords.reserve((size_t)pTMap->m_Width);
-							vtmpBorderBottomTilesTexCoords.reserve((size_t)pTMap->m_Width);
-							vtmpBorderLeftTilesTexCoords.reserve((size_t)pTMap->m_Height);
-							vtmpBorderRightTilesTexCoords.reserve((size_t)pTMap->m_Height);
-							vtmpBorderCornersTexCoords.reserve((size_t)4);
-						}
-
-						int x = 0;
-						int y = 0;
-						for(y = 0; y < pTMap->m_Height; ++y)
-						{
-							for(x = 0; x < pTMap->m_Width; ++x)
-							{
-								unsigned char Index = 0;
-								unsigned char Flags = 0;
-								int AngleRotate = -1;
-								if(IsEntityLayer)
-								{
-									if(IsGameLayer)
-									{
-										Index = ((CTile *)pTiles)[y * pTMap->m_Width + x].m_Index;
-										Flags = ((CTile *)pTiles)[y * pTMap->m_Width + x].m_Flags;
-									}
-									if(IsFrontLayer)
-									{
-										Index = ((CTile *)pTiles)[y * pTMap->m_Width + x].m_Index;
-										Flags = ((CTile *)pTiles)[y * pTMap->m_Width + x].m_Flags;
-									}
-									if(IsSwitchLayer)
-									{
-										Flags = 0;
-										Index = ((CSwitchTile *)pTiles)[y * pTMap->m_Width + x].m_Type;
-										if(CurOverlay == 0)
-										{
-											Flags = ((CSwitchTile *)pTiles)[y * pTMap->m_Width + x].m_Flags;
-											if(Index == TILE_SWITCHTIMEDOPEN)
-												Index = 8;
-										}
-										else if(CurOverlay == 1)
-											Index = ((CSwitchTile *)pTiles)[y * pTMap->m_Width + x].m_Number;
-										else if(CurOverlay == 2)
-											Index = ((CSwitchTile *)pTiles)[y * pTMap->m_Width + x].m_Delay;
-									}
-									if(IsTeleLayer)
-									{
-										Index = ((CTeleTile *)pTiles)[y * pTMap->m_Width + x].m_Type;
-										Flags = 0;
-										if(CurOverlay == 1)
-										{
-											if(Index != TILE_TELECHECKIN && Index != TILE_TELECHECKINEVIL)
-												Index = ((CTeleTile *)pTiles)[y * pTMap->m_Width + x].m_Number;
-											else
-												Index = 0;
-										}
-									}
-									if(IsSpeedupLayer)
-									{
-										Index = ((CSpeedupTile *)pTiles)[y * pTMap->m_Width + x].m_Type;
-										Flags = 0;
-										AngleRotate = ((CSpeedupTile *)pTiles)[y * pTMap->m_Width + x].m_Angle;
-										if(((CSpeedupTile *)pTiles)[y * pTMap->m_Width + x].m_Force == 0)
-											Index = 0;
-										else if(CurOverlay == 1)
-											Index = ((CSpeedupTile *)pTiles)[y * pTMap->m_Width + x].m_Force;
-										else if(CurOverlay == 2)
-											Index = ((CSpeedupTile *)pTiles)[y * pTMap->m_Width + x].m_MaxSpeed;
-									}
-									if(IsTuneLayer)
-									{
-										Index = ((CTuneTile *)pTiles)[y * pTMap->m_Width + x].m_Type;
-										Flags = 0;
-									}
-								}
-								else
-								{
-									Index = ((CTile *)pTiles)[y * pTMap->m_Width + x].m_Index;
-									Flags = ((CTile *)pTiles)[y * pTMap->m_Width + x].m_Flags;
-								}
-
-								//the amount of tiles handled before this tile
-								int TilesHandledCount = vtmpTiles.size();
-								Visuals.m_pTilesOfLayer[y * pTMap->m_Width + x].SetIndexBufferByteOffset((offset_ptr32)(TilesHandledCount * 6 * sizeof(unsigned int)));
-
-								bool AddAsSpeedup = false;
-								if(IsSpeedupLayer && CurOverlay == 0)
-									AddAsSpeedup = true;
-
-								if(AddTile(vtmpTiles, vtmpTileTexCoords, As3DTextureCoords, Index, Flags, x, y, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate))
-									Visuals.m_pTilesOfLayer[y * pTMap->m_Width + x].Draw(true);
-
-								//do the border tiles
-								if(x == 0)
-								{
-									if(y == 0)
-									{
-										Visuals.m_BorderTopLeft.SetIndexBufferByteOffset((offset_ptr32)(vtmpBorderCorners.size() * 6 * sizeof(unsigned int)));
-										if(AddTile(vtmpBorderCorners, vtmpBorderCornersTexCoords, As3DTextureCoords, Index, Flags, x, y, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate))
-											Visuals.m_BorderTopLeft.Draw(true);
-									}
-									else if(y == pTMap->m_Height - 1)
-									{
-										Visuals.m_BorderBottomLeft.SetIndexBufferByteOffset((offset_ptr32)(vtmpBorderCorners.size() * 6 * sizeof(unsigned int)));
-										if(AddTile(vtmpBorderCorners, vtmpBorderCornersTexCoords, As3DTextureCoords, Index, Flags, x, y, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate))
-											Visuals.m_BorderBottomLeft.Draw(true);
-									}
-									else
-									{
-										Visuals.m_pBorderLeft[y - 1].SetIndexBufferByteOffset((offset_ptr32)(vtmpBorderLeftTiles.size() * 6 * sizeof(unsigned int)));
-										if(AddTile(vtmpBorderLeftTiles, vtmpBorderLeftTilesTexCoords, As3DTextureCoords, Index, Flags, x, y, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate))
-											Visuals.m_pBorderLeft[y - 1].Draw(true);
-									}
-								}
-								else if(x == pTMap->m_Width - 1)
-								{
-									if(y == 0)
-									{
-										Visuals.m_BorderTopRight.SetIndexBufferByteOffset((offset_ptr32)(vtmpBorderCorners.size() * 6 * sizeof(unsigned int)));
-										if(AddTile(vtmpBorderCorners, vtmpBorderCornersTexCoords, As3DTextureCoords, Index, Flags, x, y, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate))
-											Visuals.m_BorderTopRight.Draw(true);
-									}
-									else if(y == pTMap->m_Height - 1)
-									{
-										Visuals.m_BorderBottomRight.SetIndexBufferByteOffset((offset_ptr32)(vtmpBorderCorners.size() * 6 * sizeof(unsigned int)));
-										if(AddTile(vtmpBorderCorners, vtmpBorderCornersTexCoords, As3DTextureCoords, Index, Flags, x, y, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate))
-											Visuals.m_BorderBottomRight.Draw(true);
-									}
-									else
-									{
-										Visuals.m_pBorderRight[y - 1].SetIndexBufferByteOffset((offset_ptr32)(vtmpBorderRightTiles.size() * 6 * sizeof(unsigned int)));
-										if(AddTile(vtmpBorderRightTiles, vtmpBorderRightTilesTexCoords, As3DTextureCoords, Index, Flags, x, y, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate))
-											Visuals.m_pBorderRight[y - 1].Draw(true);
-									}
-								}
-								else if(y == 0)
-								{
-									if(x > 0 && x < pTMap->m_Width - 1)
-									{
-										Visuals.m_pBorderTop[x - 1].SetIndexBufferByteOffset((offset_ptr32)(vtmpBorderTopTiles.size() * 6 * sizeof(unsigned int)));
-										if(AddTile(vtmpBorderTopTiles, vtmpBorderTopTilesTexCoords, As3DTextureCoords, Index, Flags, x, y, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate))
-											Visuals.m_pBorderTop[x - 1].Draw(true);
-									}
-								}
-								else if(y == pTMap->m_Height - 1)
-								{
-									if(x > 0 && x < pTMap->m_Width - 1)
-									{
-										Visuals.m_pBorderBottom[x - 1].SetIndexBufferByteOffset((offset_ptr32)(vtmpBorderBottomTiles.size() * 6 * sizeof(unsigned int)));
-										if(AddTile(vtmpBorderBottomTiles, vtmpBorderBottomTilesTexCoords, As3DTextureCoords, Index, Flags, x, y, pGroup, DoTextureCoords, AddAsSpeedup, AngleRotate))
-											Visuals.m_pBorderBottom[x - 1].Draw(true);
-									}
-								}
-							}
-						}
-
-						//append one kill tile to the gamelayer
-						if(IsGameLayer)
-						{
-							Visuals.m_BorderKillTile.SetIndexBufferByteOffset((offset_ptr32)(vtmpTiles.size() * 6 * sizeof(unsigned int)));
-							if(AddTile(vtmpTiles, vtmpTileTexCoords, As3DTextureCoords, TILE_DEATH, 0, 0, 0, pGroup, DoTextureCoords))
-								Visuals.m_BorderKillTile.Draw(true);
-						}
-
-						//add the border corners, then the borders and fix their byte offsets
-						int TilesHandledCount = vtmpTiles.size();
-						Visuals.m_BorderTopLeft.AddIndexBufferByteOffset(TilesHandledCount * 6 * sizeof(unsigned int));
-						Visuals.m_BorderTopRight.AddIndexBufferByteOffset(TilesHandledCount * 6 * sizeof(unsigned int));
-						Visuals.m_BorderBottomLeft.AddIndexBufferByteOffset(TilesHandledCount * 6 * sizeof(unsigned int));
-						Visuals.m_BorderBottomRight.AddIndexBufferByteOffset(TilesHandledCount * 6 * sizeof(unsigned int));
-						//add the Corners to the tiles
-						vtmpTiles.insert(vtmpTiles.end(), vtmpBorderCorners.begin(), vtmpBorderCorners.end());
-						vtmpTileTexCoords.insert(vtmpTileTexCoords.end(), vtmpBorderCornersTexCoords.begin(), vtmpBorderCornersTexCoords.end());
-
-						//now the borders
-						TilesHandledCount = vtmpTiles.size();
-						if(pTMap->m_Width > 2)
-						{
-							for(int i = 0; i < pTMap->m_Width - 2; ++i)
-							{
-								Visuals.m_pBorderTop[i].AddIndexBufferByteOffset(TilesHandledCount * 6 * sizeof(unsigned int));
-							}
-						}
-						vtmpTiles.insert(vtmpTiles.end(), vtmpBorderTopTiles.begin(), vtmpBorderTopTiles.end());
-						vtmpTileTexCoords.insert(vtmpTileTexCoords.end(), vtmpBorderTopTilesTexCoords.begin(), vtmpBorderTopTilesTexCoords.end());
-
-						TilesHandledCount = vtmpTiles.size();
-						if(pTMap->m_Width > 2)
-						{
-							for(int i = 0; i < pTMap->m_Width - 2; ++i)
-							{
-								Visuals.m_pBorderBottom[i].AddIndexBufferByteOffset(TilesHandledCount * 6 * sizeof(unsigned int));
-							}
-						}
-						vtmpTiles.insert(vtmpTiles.end(), vtmpBorderBottomTiles.begin(), vtmpBorderBottomTiles.end());
-						vtmpTileTexCoords.insert(vtmpTileTexCoords.end(), vtmpBorderBottomTilesTexCoords.begin(), vtmpBorderBottomTilesTexCoords.end());
-
-						TilesHandledCount = vtmpTiles.size();
-						if(pTMap->m_Height > 2)
-						{
-							for(int i = 0; i < pTMap->m_Height - 2; ++i)
-							{
-								Visuals.m_pBorderLeft[i].AddIndexBufferByteOffset(TilesHandledCount * 6 * sizeof(unsigned int));
-							}
-						}
-						vtmpTiles.insert(vtmpTiles.end(), vtmpBorderLeftTiles.begin(), vtmpBorderLeftTiles.end());
-						vtmpTileTexCoords.insert(vtmpTileTexCoords.end(), vtmpBorderLeftTilesTexCoords.begin(), vtmpBorderLeftTilesTexCoords.end());
-
-						TilesHandledCount = vtmpTiles.size();
-						if(pTMap->m_Height > 2)
-						{
-							for(int i = 0; i < pTMap->m_Height - 2; ++i)
-							{
-								Visuals.m_pBorderRight[i].AddIndexBufferByteOffset(TilesHandledCount * 6 * sizeof(unsigned int));
-							}
-						}
-						vtmpTiles.insert(vtmpTiles.end(), vtmpBorderRightTiles.begin(), vtmpBorderRightTiles.end());
-						vtmpTileTexCoords.insert(vtmpTileTexCoords.end(), vtmpBorderRightTilesTexCoords.begin(), vtmpBorderRightTilesTexCoords.end());
-
-						//setup params
-						float *pTmpTiles = (vtmpTiles.empty()) ? NULL : (float *)&vtmpTiles[0];
-						unsigned char *pTmpTileTexCoords = (vtmpTileTexCoords.empty()) ? NULL : (unsigned char *)&vtmpTileTexCoords[0];
-
-						Visuals.m_BufferContainerIndex = -1;
-						size_t UploadDataSize = vtmpTileTexCoords.size() * sizeof(SGraphicTileTexureCoords) + vtmpTiles.size() * sizeof(SGraphicTile);
-						if(UploadDataSize > 0)
-						{
-							char *pUploadData = (char *)malloc(sizeof(char) * UploadDataSize);
-
-							mem_copy_special(pUploadData, pTmpTiles, sizeof(vec2), vtmpTiles.size() * 4, (DoTextureCoords ? sizeof(vec3) : 0));
-							if(DoTextureCoords)
-							{
-								mem_copy_special(pUploadData + sizeof(vec2), pTmpTileTexCoords, sizeof(vec3), vtmpTiles.size() * 4, (DoTextureCoords ? (sizeof(vec2)) : 0));
-							}
-
-							// first create the buffer object
-							int BufferObjectIndex = Graphics()->CreateBufferObject(UploadDataSize, pUploadData, 0, true);
-
-							// then create the buffer container
-							SBufferContainerInfo ContainerInfo;
-							ContainerInfo.m_Stride = (DoTextureCoords ? (sizeof(float) * 2 + sizeof(vec3)) : 0);
-							ContainerInfo.m_VertBufferBindingIndex = BufferObjectIndex;
-							ContainerInfo.m_vAttributes.emplace_back();
-							SBufferContainerInfo::SAttribute *pAttr = &ContainerInfo.m_vAttributes.back();
-							pAttr->m_DataTypeCount = 2;
-							pAttr->m_Type = GRAPHICS_TYPE_FLOAT;
-							pAttr->m_Normalized = false;
-							pAttr->m_pOffset = 0;
-							pAttr->m_FuncType = 0;
-							if(DoTextureCoords)
-							{
-								ContainerInfo.m_vAttributes.emplace_back();
-								pAttr = &ContainerInfo.m_vAttributes.back();
-								pAttr->m_DataTypeCount = 3;
-								pAttr->m_Type = GRAPHICS_TYPE_FLOAT;
-								pAttr->m_Normalized = false;
-								pAttr->m_pOffset = (void *)(sizeof(vec2));
-								pAttr->m_FuncType = 0;
-							}
-
-							Visuals.m_BufferContainerIndex = Graphics()->CreateBufferContainer(&ContainerInfo);
-							// and finally inform the backend how many indices are required
-							Graphics()->IndicesNumRequiredNotify(vtmpTiles.size() * 6);
-						}
-
-						++CurOverlay;
-					}
+					m_vpLayerJobs.push_back(pJob);
+					Engine()->AddJob(pJob);
 				}
 			}
 			else if(pLayer->m_Type == LAYERTYPE_QUADS && Graphics()->IsQuadBufferingEnabled())
 			{
 				CMapItemLayerQuads *pQLayer = (CMapItemLayerQuads *)pLayer;
-
-				m_vpQuadLayerVisuals.push_back(new SQuadLayerVisuals());
-				SQuadLayerVisuals *pQLayerVisuals = m_vpQuadLayerVisuals.back();
-
 				bool Textured = (pQLayer->m_Image != -1);
 
-				vtmpQuads.clear();
-				vtmpQuadsTextured.clear();
-
-				if(Textured)
-					vtmpQuadsTextured.resize(pQLayer->m_NumQuads);
-				else
-					vtmpQuads.resize(pQLayer->m_NumQuads);
-
-				CQuad *pQuads = (CQuad *)m_pLayers->Map()->GetDataSwapped(pQLayer->m_Data);
-				for(int i = 0; i < pQLayer->m_NumQuads; ++i)
+				auto pJob = std::make_shared<CLayerBuildJob>(CLayerBuildJob::LAYER_QUADS, m_vpQuadLayerVisuals.size(), pQLayer->m_NumQuads, 0, 1, Textured, As3DTextureCoords);
+				if(pQLayer->m_NumQuads > 0)
 				{
-					CQuad *q = &pQuads[i];
-					for(int j = 0; j < 4; ++j)
-					{
-						int QuadIDX = j;
-						if(j == 2)
-							QuadIDX = 3;
-						else if(j == 3)
-							QuadIDX = 2;
-						if(!Textured)
-						{
-							// ignore the conversion for the position coordinates
-							vtmpQuads[i].m_aVertices[j].m_X = (q->m_aPoints[QuadIDX].x);
-							vtmpQuads[i].m_aVertices[j].m_Y = (q->m_aPoints[QuadIDX].y);
-							vtmpQuads[i].m_aVertices[j].m_CenterX = (q->m_aPoints[4].x);
-							vtmpQuads[i].m_aVertices[j].m_CenterY = (q->m_aPoints[4].y);
-							vtmpQuads[i].m_aVertices[j].m_R = (unsigned char)q->m_aColors[QuadIDX].r;
-							vtmpQuads[i].m_aVertices[j].m_G = (unsigned char)q->m_aColors[QuadIDX].g;
-							vtmpQuads[i].m_aVertices[j].m_B = (unsigned char)q->m_aColors[QuadIDX].b;
-							vtmpQuads[i].m_aVertices[j].m_A = (unsigned char)q->m_aColors[QuadIDX].a;
-						}
-						else
-						{
-							// ignore the conversion for the position coordinates
-							vtmpQuadsTextured[i].m_aVertices[j].m_X = (q->m_aPoints[QuadIDX].x);
-							vtmpQuadsTextured[i].m_aVertices[j].m_Y = (q->m_aPoints[QuadIDX].y);
-							vtmpQuadsTextured[i].m_aVertices[j].m_CenterX = (q->m_aPoints[4].x);
-							vtmpQuadsTextured[i].m_aVertices[j].m_CenterY = (q->m_aPoints[4].y);
-							vtmpQuadsTextured[i].m_aVertices[j].m_U = fx2f(q->m_aTexcoords[QuadIDX].x);
-							vtmpQuadsTextured[i].m_aVertices[j].m_V = fx2f(q->m_aTexcoords[QuadIDX].y);
-							vtmpQuadsTextured[i].m_aVertices[j].m_R = (unsigned char)q->m_aColors[QuadIDX].r;
-							vtmpQuadsTextured[i].m_aVertices[j].m_G = (unsigned char)q->m_aColors[QuadIDX].g;
-							vtmpQuadsTextured[i].m_aVertices[j].m_B = (unsigned char)q->m_aColors[QuadIDX].b;
-							vtmpQuadsTextured[i].m_aVertices[j].m_A = (unsigned char)q->m_aColors[QuadIDX].a;
-						}
-					}
+					CQuad *pQuads = (CQuad *)m_pLayers->Map()->GetDataSwapped(pQLayer->m_Data);
+					if(pQuads)
+						pJob->m_vData.assign((char *)pQuads, (char *)(pQuads + pQLayer->m_NumQuads));
 				}
+				m_vpQuadLayerVisuals.push_back(new SQuadLayerVisuals());
+				m_vpLayerJobs.push_back(pJob);
+				Engine()->AddJob(pJob);
+			}
+		}
+	}
+}
 
-				size_t UploadDataSize = 0;
-				if(Textured)
-					UploadDataSize = vtmpQuadsTextured.size() * sizeof(STmpQuadTextured);
-				else
-					UploadDataSize = vtmpQuads.size() * sizeof(STmpQuad);
+void CMapLayers::UploadFinishedLayers()
+{
+	for(auto it = m_vpLayerJobs.begin(); it != m_vpLayerJobs.end();)
+	{
+		CLayerBuildJob *pJob = it->get();
+		if(pJob->Status() != IJob::STATE_DONE)
+		{
+			++it;
+			continue;
+		}
 
-				if(UploadDataSize > 0)
+		const bool IsQuadLayer = pJob->m_Kind == CLayerBuildJob::LAYER_QUADS;
+		for(size_t Overlay = 0; Overlay < pJob->m_vBuilt.size(); ++Overlay)
+		{
+			CLayerBuildJob::SBuiltLayer &Built = pJob->m_vBuilt[Overlay];
+			int BufferContainerIndex = -1;
+			if(Built.m_pUploadData)
+			{
+				// first create the buffer object, the backend takes the upload data
+				int BufferObjectIndex = Graphics()->CreateBufferObject(Built.m_UploadDataSize, Built.m_pUploadData, 0, true);
+				Built.m_pUploadData = nullptr;
+
+				// then create the buffer container
+				SBufferContainerInfo ContainerInfo;
+				ContainerInfo.m_VertBufferBindingIndex = BufferObjectIndex;
+				ContainerInfo.m_vAttributes.emplace_back();
+				SBufferContainerInfo::SAttribute *pAttr = &ContainerInfo.m_vAttributes.back();
+				if(IsQuadLayer)
 				{
-					void *pUploadData = NULL;
-					if(Textured)
-						pUploadData = &vtmpQuadsTextured[0];
-					else
-						pUploadData = &vtmpQuads[0];
-					// create the buffer object
-					int BufferObjectIndex = Graphics()->CreateBufferObject(UploadDataSize, pUploadData, 0);
-					// then create the buffer container
-					SBufferContainerInfo ContainerInfo;
-					ContainerInfo.m_Stride = (Textured ? (sizeof(STmpQuadTextured) / 4) : (sizeof(STmpQuad) / 4));
-					ContainerInfo.m_VertBufferBindingIndex = BufferObjectIndex;
-					ContainerInfo.m_vAttributes.emplace_back();
-					SBufferContainerInfo::SAttribute *pAttr = &ContainerInfo.m_vAttributes.back();
+					ContainerInfo.m_Stride = (pJob->m_Textured ? (sizeof(STmpQuadTextured) / 4) : (sizeof(STmpQuad) / 4));
 					pAttr->m_DataTypeCount = 4;
 					pAttr->m_Type = GRAPHICS_TYPE_FLOAT;
 					pAttr->m_Normalized = false;
@@ -960,7 +872,7 @@ void CMapLayers::OnMapLoad()
 					pAttr->m_Normalized = true;
 					pAttr->m_pOffset = (void *)(sizeof(float) * 4);
 					pAttr->m_FuncType = 0;
-					if(Textured)
+					if(pJob->m_Textured)
 					{
 						ContainerInfo.m_vAttributes.emplace_back();
 						pAttr = &ContainerInfo.m_vAttributes.back();
@@ -970,13 +882,46 @@ void CMapLayers::OnMapLoad()
 						pAttr->m_pOffset = (void *)(sizeof(float) * 4 + sizeof(unsigned char) * 4);
 						pAttr->m_FuncType = 0;
 					}
-
-					pQLayerVisuals->m_BufferContainerIndex = Graphics()->CreateBufferContainer(&ContainerInfo);
-					// and finally inform the backend how many indices are required
-					Graphics()->IndicesNumRequiredNotify(pQLayer->m_NumQuads * 6);
 				}
+				else
+				{
+					ContainerInfo.m_Stride = (pJob->m_Textured ? (sizeof(float) * 2 + sizeof(vec3)) : 0);
+					pAttr->m_DataTypeCount = 2;
+					pAttr->m_Type = GRAPHICS_TYPE_FLOAT;
+					pAttr->m_Normalized = false;
+					pAttr->m_pOffset = 0;
+					pAttr->m_FuncType = 0;
+					if(pJob->m_Textured)
+					{
+						ContainerInfo.m_vAttributes.emplace_back();
+						pAttr = &ContainerInfo.m_vAttributes.back();
+						pAttr->m_DataTypeCount = 3;
+						pAttr->m_Type = GRAPHICS_TYPE_FLOAT;
+						pAttr->m_Normalized = false;
+						pAttr->m_pOffset = (void *)(sizeof(vec2));
+						pAttr->m_FuncType = 0;
+					}
+				}
+
+				BufferContainerIndex = Graphics()->CreateBufferContainer(&ContainerInfo);
+				// and finally inform the backend how many indices are required
+				Graphics()->IndicesNumRequiredNotify(Built.m_NumIndices);
+			}
+
+			if(IsQuadLayer)
+			{
+				m_vpQuadLayerVisuals[pJob->m_FirstVisuals]->m_BufferContainerIndex = BufferContainerIndex;
+			}
+			else
+			{
+				STileLayerVisuals *&pVisuals = m_vpTileLayerVisuals[pJob->m_FirstVisuals + Overlay];
+				delete pVisuals;
+				pVisuals = Built.m_pTileVisuals;
+				Built.m_pTileVisuals = nullptr;
+				pVisuals->m_BufferContainerIndex = BufferContainerIndex;
 			}
 		}
+		it = m_vpLayerJobs.erase(it);
 	}
 }
 
@@ -1533,6 +1478,8 @@ void CMapLayers::LayersOfGroupCount(CMapItemGroup *pGroup, int &TileLayerCount,
 
 void CMapLayers::OnRender()
 {
+	UploadFinishedLayers();
+
 	if(m_OnlineOnly && Client()->State() != IClient::STATE_ONLINE && Client()->State() != IClient::STATE_DEMOPLAYBACK)
 		return;
 
@@ -2,9 +2,12 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #ifndef GAME_CLIENT_COMPONENTS_MAPLAYERS_H
 #define GAME_CLIENT_COMPONENTS_MAPLAYERS_H
+#include <engine/shared/jobs.h>
+
 #include <game/client/component.h>
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #define INDEX_BUFFER_GROUP_WIDTH 12
@@ -128,6 +131,52 @@ class CMapLayers : public CComponent
 	};
 	std::vector<SQuadLayerVisuals *> m_vpQuadLayerVisuals;
 
+	// builds the vertex data of one map layer (with all its overlays) on the job pool,
+	// the buffers are created on the render thread by UploadFinishedLayers
+	class CLayerBuildJob : public IJob
+	{
+		void Run() override;
+		void BuildTileLayer(int Overlay);
+		void BuildQuadLayer();
+		void GetTile(int Overlay, int x, int y, unsigned char &Index, unsigned char &Flags, int &AngleRotate) const;
+
+	public:
+		enum
+		{
+			LAYER_TILES = 0,
+			LAYER_GAME,
+			LAYER_FRONT,
+			LAYER_SWITCH,
+			LAYER_TELE,
+			LAYER_SPEEDUP,
+			LAYER_TUNE,
+			LAYER_QUADS,
+		};
+
+		struct SBuiltLayer
+		{
+			STileLayerVisuals *m_pTileVisuals;
+			char *m_pUploadData;
+			size_t m_UploadDataSize;
+			unsigned int m_NumIndices;
+		};
+
+		CLayerBuildJob(int Kind, int FirstVisuals, int Width, int Height, int NumOverlays, bool Textured, bool As3DTextureCoords);
+		~CLayerBuildJob() override;
+
+		int m_Kind;
+		int m_FirstVisuals; // index of the first visuals in m_vpTileLayerVisuals or m_vpQuadLayerVisuals
+		int m_Width; // number of quads for quad layers
+		int m_Height;
+		bool m_Textured;
+		bool m_As3DTextureCoords;
+		std::vector<char> m_vData; // copy of the layer data, the map can be unloaded while the job runs
+		std::vector<SBuiltLayer> m_vBuilt; // one per overlay
+	};
+	std::vector<std::shared_ptr<CLayerBuildJob>> m_vpLayerJobs;
+
+	void UploadFinishedLayers();
+
 	virtual CCamera *GetCurCamera();
 
 	void LayersOfGroupCount(CMapItemGroup *pGroup, int &TileLayerCount, int &QuadLayerCount, bool &PassedGameLayer);
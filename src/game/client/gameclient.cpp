@@ -279,7 +279,7 @@ void CGameClient::OnInit()
 		else if(i == IMAGE_EXTRAS)
 			LoadExtrasSkin(g_Config.m_ClAssetExtras);
 		else
-			g_pData->m_aImages[i].m_Id = Graphics()->LoadTexture(g_pData->m_aImages[i].m_pFilename, IStorage::TYPE_ALL, CImageInfo::FORMAT_AUTO, 0);
+			g_pData->m_aImages[i].m_Id = Graphics()->LoadTextureAsync(g_pData->m_aImages[i].m_pFilename, IStorage::TYPE_ALL, CImageInfo::FORMAT_AUTO, 0);
 		m_Menus.RenderLoading(false);
 	}
 
@@ -496,6 +496,8 @@ void CGameClient::OnReset()
 	m_LastNewPredictedTick[0] = -1;
 	m_LastNewPredictedTick[1] = -1;
 
+	InvalidatePredictionCache();
+
 	m_LocalTuneZone[0] = 0;
 	m_LocalTuneZone[1] = 0;
 
@@ -813,6 +815,7 @@ void CGameClient::OnMessage(int MsgId, CUnpacker *pUnpacker, int Conn, bool Dumm
 			if(CCharacter *pChar = m_GameWorld.GetCharacterByID(pMsg->m_Victim))
 				pChar->ResetPrediction();
 			m_GameWorld.ReleaseHooked(pMsg->m_Victim);
+			InvalidatePredictionCache();
 		}
 	}
 }
@@ -1101,6 +1104,9 @@ void CGameClient::InvalidateSnapshot()
 
 void CGameClient::OnNewSnapshot()
 {
+	// the snapshot is the new base of the prediction
+	InvalidatePredictionCache();
+
 	auto &&Evolve = [this](CNetObj_Character *pCharacter, int Tick) {
 		CWorldCore TempWorld;
 		CCharacterCore TempCore = CCharacterCore();
@@ -1749,23 +1755,35 @@ void CGameClient::OnPredict()
 
 	// init
 	bool Dummy = g_Config.m_ClDummy ^ m_IsDummySwapping;
-	m_PredictedWorld.CopyWorld(&m_GameWorld);
+	const int GameTick = Client()->GameTick(g_Config.m_ClDummy);
+	const int PredTick = Client()->PredGameTick(g_Config.m_ClDummy);
+	const int DummyID = PredictDummy() ? m_PredictedDummyID : -1;
+	int FirstTick = GameTick + 1;
+	if(CanContinuePrediction(GameTick, PredTick, DummyID))
+	{
+		FirstTick = m_PredictionCache.m_PredTick + 1;
+	}
+	else
+	{
+		m_PredictedWorld.CopyWorld(&m_GameWorld);
 
-	// don't predict inactive players, or entities from other teams
-	for(int i = 0; i < MAX_CLIENTS; i++)
-		if(CCharacter *pChar = m_PredictedWorld.GetCharacterByID(i))
-			if((!m_Snap.m_aCharacters[i].m_Active && pChar->m_SnapTicks > 10) || IsOtherTeam(i))
-				pChar->Destroy();
+		// don't predict inactive players, or entities from other teams
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			if(CCharacter *pChar = m_PredictedWorld.GetCharacterByID(i))
+				if((!m_Snap.m_aCharacters[i].m_Active && pChar->m_SnapTicks > 10) || IsOtherTeam(i))
+					pChar->Destroy();
 
-	CProjectile *pProjNext = 0;
-	for(CProjectile *pProj = (CProjectile *)m_PredictedWorld.FindFirst(CGameWorld::ENTTYPE_PROJECTILE); pProj; pProj = pProjNext)
-	{
-		pProjNext = (CProjectile *)pProj->TypeNext();
-		if(IsOtherTeam(pProj->GetOwner()))
+		CProjectile *pProjNext = 0;
+		for(CProjectile *pProj = (CProjectile *)m_PredictedWorld.FindFirst(CGameWorld::ENTTYPE_PROJECTILE); pProj; pProj = pProjNext)
 		{
-			pProj->Destroy();
+			pProjNext = (CProjectile *)pProj->TypeNext();
+			if(IsOtherTeam(pProj->GetOwner()))
+			{
+				pProj->Destroy();
+			}
 		}
 	}
+	InvalidatePredictionCache();
 
 	CCharacter *pLocalChar = m_PredictedWorld.GetCharacterByID(m_Snap.m_LocalClientID);
 	if(!pLocalChar)
@@ -1775,7 +1793,7 @@ void CGameClient::OnPredict()
 		pDummyChar = m_PredictedWorld.GetCharacterByID(m_PredictedDummyID);
 
 	// predict
-	for(int Tick = Client()->GameTick(g_Config.m_ClDummy) + 1; Tick <= Client()->PredGameTick(g_Config.m_ClDummy); Tick++)
+	for(int Tick = FirstTick; Tick <= Client()->PredGameTick(g_Config.m_ClDummy); Tick++)
 	{
 		// fetch the previous characters
 		if(Tick == Client()->PredGameTick(g_Config.m_ClDummy))
@@ -1796,6 +1814,16 @@ void CGameClient::OnPredict()
 		CNetObj_PlayerInput *pDummyInputData = !pDummyChar ? 0 : (CNetObj_PlayerInput *)Client()->GetInput(Tick, m_IsDummySwapping ^ 1);
 		bool DummyFirst = pInputData && pDummyInputData && pDummyChar->GetCID() < pLocalChar->GetCID();
 
+		// remember the inputs the tick was predicted with
+		CPredictionInput &UsedInput = m_PredictionCache.m_aInputs[Tick % std::size(m_PredictionCache.m_aInputs)];
+		UsedInput.m_Tick = Tick;
+		UsedInput.m_HasInput = pInputData;
+		UsedInput.m_HasDummyInput = pDummyInputData;
+		if(pInputData)
+			UsedInput.m_Input = *pInputData;
+		if(pDummyInputData)
+			UsedInput.m_DummyInput = *pDummyInputData;
+
 		if(DummyFirst)
 			pDummyChar->OnDirectInput(pDummyInputData);
 		if(pInputData)
@@ -1858,6 +1886,18 @@ void CGameClient::OnPredict()
 		}
 	}
 
+	// allowing movement in freeze depends on the last predicted tick, so that can't be continued
+	if(g_Config.m_ClPredictFreeze != 2)
+	{
+		m_PredictionCache.m_Valid = true;
+		m_PredictionCache.m_GameTick = GameTick;
+		m_PredictionCache.m_PredTick = maximum(PredTick, GameTick);
+		m_PredictionCache.m_LocalClientID = m_Snap.m_LocalClientID;
+		m_PredictionCache.m_DummyID = DummyID;
+		m_PredictionCache.m_Dummy = g_Config.m_ClDummy;
+		m_PredictionCache.m_DummySwapping = m_IsDummySwapping;
+	}
+
 	// detect mispredictions of other players and make corrections smoother when possible
 	static vec2 s_aLastPos[MAX_CLIENTS] = {{0, 0}};
 	static bool s_aLastActive[MAX_CLIENTS] = {false};
@@ -1956,6 +1996,34 @@ void CGameClient::OnPredict()
 		m_Ghost.OnNewPredictedSnapshot();
 }
 
+bool CGameClient::CanContinuePrediction(int GameTick, int PredTick, int DummyID)
+{
+	const CPredictionCache &Cache = m_PredictionCache;
+	if(!Cache.m_Valid || !m_PredictedWorld.m_IsValidCopy || g_Config.m_ClPredictFreeze == 2)
+		return false;
+	if(Cache.m_GameTick != GameTick || Cache.m_PredTick > PredTick || Cache.m_LocalClientID != m_Snap.m_LocalClientID ||
+		Cache.m_DummyID != DummyID || Cache.m_Dummy != g_Config.m_ClDummy || Cache.m_DummySwapping != m_IsDummySwapping)
+		return false;
+
+	// the inputs of the already predicted ticks must not have changed
+	for(int Tick = GameTick + 1; Tick <= Cache.m_PredTick; Tick++)
+	{
+		const CPredictionInput &UsedInput = Cache.m_aInputs[Tick % std::size(Cache.m_aInputs)];
+		if(UsedInput.m_Tick != Tick)
+			return false;
+		const CNetObj_PlayerInput *pInput = (CNetObj_PlayerInput *)Client()->GetInput(Tick, m_IsDummySwapping);
+		if((pInput != nullptr) != UsedInput.m_HasInput || (pInput && mem_comp(pInput, &UsedInput.m_Input, sizeof(*pInput)) != 0))
+			return false;
+		if(DummyID >= 0 && m_PredictedWorld.GetCharacterByID(DummyID))
+		{
+			const CNetObj_PlayerInput *pDummyInput = (CNetObj_PlayerInput *)Client()->GetInput(Tick, m_IsDummySwapping ^ 1);
+			if((pDummyInput != nullptr) != UsedInput.m_HasDummyInput || (pDummyInput && mem_comp(pDummyInput, &UsedInput.m_DummyInput, sizeof(*pDummyInput)) != 0))
+				return false;
+		}
+	}
+	return true;
+}
+
 void CGameClient::OnActivateEditor()
 {
 	OnRelease();
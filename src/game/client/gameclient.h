@@ -183,6 +183,33 @@ private:
 	int m_PredictedTick;
 	int m_LastNewPredictedTick[NUM_DUMMIES];
 
+	/*
+		The predicted world is kept at the last predicted tick. As long as no new
+		snapshot arrived and the inputs of the predicted ticks stay the same, only
+		the ticks after it are simulated instead of everything from the game tick.
+	*/
+	struct CPredictionInput
+	{
+		int m_Tick;
+		bool m_HasInput;
+		bool m_HasDummyInput;
+		CNetObj_PlayerInput m_Input;
+		CNetObj_PlayerInput m_DummyInput;
+	};
+	struct CPredictionCache
+	{
+		bool m_Valid;
+		int m_GameTick;
+		int m_PredTick;
+		int m_LocalClientID;
+		int m_DummyID;
+		int m_Dummy;
+		bool m_DummySwapping;
+		CPredictionInput m_aInputs[200];
+	} m_PredictionCache;
+	void InvalidatePredictionCache() { m_PredictionCache.m_Valid = false; }
+	bool CanContinuePrediction(int GameTick, int PredTick, int DummyID);
+
 	int m_LastRoundStartTick;
 
 	int m_LastFlagCarrierRed;
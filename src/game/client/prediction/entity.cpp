@@ -5,6 +5,89 @@
 
 #include <game/collision.h>
 
+//////////////////////////////////////////////////
+// Entity pool
+//////////////////////////////////////////////////
+struct CFreeBlock
+{
+	CFreeBlock *m_pNext;
+};
+
+struct CPoolBucket
+{
+	size_t m_Size;
+	CFreeBlock *m_pFirst;
+};
+
+static CPoolBucket gs_aPoolBuckets[CEntityPool::NUM_BUCKETS];
+static int gs_NumPoolBuckets = 0;
+static int gs_NumHeapAllocations = 0;
+
+static CPoolBucket *PoolBucket(size_t Size)
+{
+	for(int i = 0; i < gs_NumPoolBuckets; i++)
+		if(gs_aPoolBuckets[i].m_Size == Size)
+			return &gs_aPoolBuckets[i];
+	if(gs_NumPoolBuckets == CEntityPool::NUM_BUCKETS)
+		return nullptr;
+	CPoolBucket *pBucket = &gs_aPoolBuckets[gs_NumPoolBuckets++];
+	pBucket->m_Size = Size;
+	pBucket->m_pFirst = nullptr;
+	return pBucket;
+}
+
+void *CEntityPool::Allocate(size_t Size)
+{
+	CPoolBucket *pBucket = PoolBucket(Size);
+	void *p;
+	if(pBucket && pBucket->m_pFirst)
+	{
+		p = pBucket->m_pFirst;
+		pBucket->m_pFirst = pBucket->m_pFirst->m_pNext;
+	}
+	else
+	{
+		p = malloc(maximum(Size, sizeof(CFreeBlock)));
+		gs_NumHeapAllocations++;
+	}
+	mem_zero(p, Size);
+	return p;
+}
+
+void CEntityPool::Free(void *pPtr, size_t Size)
+{
+	if(!pPtr)
+		return;
+	CPoolBucket *pBucket = PoolBucket(Size);
+	if(!pBucket)
+	{
+		free(pPtr);
+		return;
+	}
+	CFreeBlock *pBlock = (CFreeBlock *)pPtr;
+	pBlock->m_pNext = pBucket->m_pFirst;
+	pBucket->m_pFirst = pBlock;
+}
+
+void CEntityPool::Clear()
+{
+	for(int i = 0; i < gs_NumPoolBuckets; i++)
+	{
+		while(gs_aPoolBuckets[i].m_pFirst)
+		{
+			CFreeBlock *pBlock = gs_aPoolBuckets[i].m_pFirst;
+			gs_aPoolBuckets[i].m_pFirst = pBlock->m_pNext;
+			free(pBlock);
+		}
+	}
+	gs_NumPoolBuckets = 0;
+}
+
+int CEntityPool::NumHeapAllocations()
+{
+	return gs_NumHeapAllocations;
+}
+
 //////////////////////////////////////////////////
 // Entity
 //////////////////////////////////////////////////
@@ -6,24 +6,43 @@
 #include "gameworld.h"
 #include <base/vmath.h>
 
-#define MACRO_ALLOC_HEAP() \
+/*
+	Entity memory is recycled through a free list per object size, the
+	prediction copies the whole world every frame. Only used from the
+	client thread.
+*/
+class CEntityPool
+{
+public:
+	enum
+	{
+		NUM_BUCKETS = 8, // one per entity type is enough, other sizes use the heap
+	};
+
+	static void *Allocate(size_t Size);
+	static void Free(void *pPtr, size_t Size);
+	// releases the free lists, entities that are still alive can be freed later
+	static void Clear();
+	// allocations that couldn't be served from a free list
+	static int NumHeapAllocations();
+};
+
+#define MACRO_ALLOC_POOL() \
 public: \
 	void *operator new(size_t Size) \
 	{ \
-		void *p = malloc(Size); \
-		mem_zero(p, Size); \
-		return p; \
+		return CEntityPool::Allocate(Size); \
 	} \
-	void operator delete(void *pPtr) \
+	void operator delete(void *pPtr, size_t Size) \
 	{ \
-		free(pPtr); \
+		CEntityPool::Free(pPtr, Size); \
 	} \
 \
 private:
 
 class CEntity
 {
-	MACRO_ALLOC_HEAP()
+	MACRO_ALLOC_POOL()
 	friend class CGameWorld; // entity list handling
 	CEntity *m_pPrevTypeEntity;
 	CEntity *m_pNextTypeEntity;
@@ -1,12 +1,19 @@
+#include <atomic>
 #include <cinttypes>
+#include <cmath>
 #include <cstdio> // sscanf
+#include <memory>
+
+#include <base/math.h>
+#include <base/system.h>
 
 #include <engine/console.h>
+#include <engine/engine.h>
+#include <engine/shared/jobs.h>
 #include <engine/shared/linereader.h>
 #include <engine/storage.h>
 
 #include "auto_map.h"
-#include "editor.h"
 
 // Based on triple32inc from https://github.com/skeeto/hash-prospector/tree/79a6074062a84907df6e45b756134b74e2956760
 static uint32_t HashUInt32(uint32_t Num)
@@ -37,9 +44,11 @@ static int HashLocation(uint32_t Seed, uint32_t Run, uint32_t Rule, uint32_t X,
 	return Hash % HASH_MAX;
 }
 
-CAutoMapper::CAutoMapper(CEditor *pEditor)
+CAutoMapper::CAutoMapper(IStorage *pStorage, IConsole *pConsole, IEngine *pEngine)
 {
-	m_pEditor = pEditor;
+	m_pStorage = pStorage;
+	m_pConsole = pConsole;
+	m_pEngine = pEngine;
 	m_FileLoaded = false;
 }
 
@@ -47,7 +56,7 @@ void CAutoMapper::Load(const char *pTileName)
 {
 	char aPath[256];
 	str_format(aPath, sizeof(aPath), "editor/%s.rules", pTileName);
-	IOHANDLE RulesFile = m_pEditor->Storage()->OpenFile(aPath, IOFLAG_READ | IOFLAG_SKIP_BOM, IStorage::TYPE_ALL);
+	IOHANDLE RulesFile = m_pStorage->OpenFile(aPath, IOFLAG_READ | IOFLAG_SKIP_BOM, IStorage::TYPE_ALL);
 	if(!RulesFile)
 		return;
 
@@ -358,12 +367,14 @@ void CAutoMapper::Load(const char *pTileName)
 				}
 			}
 		}
+
+		Compile(&Config);
 	}
 
 	io_close(RulesFile);
 
 	str_format(aBuf, sizeof(aBuf), "loaded %s", aPath);
-	m_pEditor->Console()->Print(IConsole::OUTPUT_LEVEL_DEBUG, "editor", aBuf);
+	m_pConsole->Print(IConsole::OUTPUT_LEVEL_DEBUG, "editor", aBuf);
 
 	m_FileLoaded = true;
 }
@@ -376,168 +387,289 @@ const char *CAutoMapper::GetConfigName(int Index)
 	return m_vConfigs[Index].m_aName;
 }
 
-void CAutoMapper::ProceedLocalized(CLayerTiles *pLayer, int ConfigID, int Seed, int X, int Y, int Width, int Height)
+void CAutoMapper::Compile(CConfiguration *pConf)
 {
-	if(!m_FileLoaded || pLayer->m_Readonly || ConfigID < 0 || ConfigID >= (int)m_vConfigs.size())
-		return;
-
-	if(Width < 0)
-		Width = pLayer->m_Width;
-
-	if(Height < 0)
-		Height = pLayer->m_Height;
+	pConf->m_vCompiledRules.clear();
+	pConf->m_vCompiledPosRules.clear();
+	pConf->m_vFlaggedIndices.clear();
 
-	CConfiguration *pConf = &m_vConfigs[ConfigID];
+	for(auto &Run : pConf->m_vRuns)
+	{
+		Run.m_FirstCompiledRule = pConf->m_vCompiledRules.size();
+		for(const auto &IndexRule : Run.m_vIndexRules)
+		{
+			CCompiledRule Rule;
+			Rule.m_ID = IndexRule.m_ID;
+			Rule.m_Flag = IndexRule.m_Flag;
+			Rule.m_SkipEmpty = IndexRule.m_SkipEmpty;
+			Rule.m_SkipFull = IndexRule.m_SkipFull;
+			Rule.m_FirstPosRule = pConf->m_vCompiledPosRules.size();
+
+			// the hash is an integer, so comparing against the rounded up limit gives the same result
+			if(IndexRule.m_RandomProbability >= 1.0f)
+				Rule.m_RandomThreshold = -1;
+			else
+			{
+				const float Limit = HASH_MAX * IndexRule.m_RandomProbability;
+				Rule.m_RandomThreshold = Limit > 0.0f ? (int)std::ceil(Limit) : 0;
+			}
 
-	int CommitFromX = clamp(X + pConf->m_StartX, 0, pLayer->m_Width);
-	int CommitFromY = clamp(Y + pConf->m_StartY, 0, pLayer->m_Height);
-	int CommitToX = clamp(X + Width + pConf->m_EndX, 0, pLayer->m_Width);
-	int CommitToY = clamp(Y + Height + pConf->m_EndY, 0, pLayer->m_Height);
+			for(const auto &PosRule : IndexRule.m_vRules)
+			{
+				// rules without a value always hold
+				if(PosRule.m_Value != CPosRule::INDEX && PosRule.m_Value != CPosRule::NOTINDEX)
+					continue;
+
+				CCompiledPosRule Compiled;
+				Compiled.m_X = PosRule.m_X;
+				Compiled.m_Y = PosRule.m_Y;
+				Compiled.m_Index = PosRule.m_Value == CPosRule::INDEX;
+				Compiled.m_MatchOutside = false;
+				mem_zero(Compiled.m_aIDs, sizeof(Compiled.m_aIDs));
+				Compiled.m_FirstFlagged = pConf->m_vFlaggedIndices.size();
+				for(const auto &Index : PosRule.m_vIndexList)
+				{
+					// tiles outside of the layer are checked as index -1 without flags
+					if(Index.m_ID == -1 && (!Index.m_TestFlag || Index.m_Flag == 0))
+						Compiled.m_MatchOutside = true;
+					if(Index.m_ID < 0 || Index.m_ID > 255)
+						continue;
+					if(Index.m_TestFlag)
+						pConf->m_vFlaggedIndices.push_back(Index);
+					else
+						Compiled.m_aIDs[Index.m_ID / 32] |= 1u << (Index.m_ID % 32);
+				}
+				Compiled.m_NumFlagged = pConf->m_vFlaggedIndices.size() - Compiled.m_FirstFlagged;
+				pConf->m_vCompiledPosRules.push_back(Compiled);
+			}
 
-	int UpdateFromX = clamp(X + 3 * pConf->m_StartX, 0, pLayer->m_Width);
-	int UpdateFromY = clamp(Y + 3 * pConf->m_StartY, 0, pLayer->m_Height);
-	int UpdateToX = clamp(X + Width + 3 * pConf->m_EndX, 0, pLayer->m_Width);
-	int UpdateToY = clamp(Y + Height + 3 * pConf->m_EndY, 0, pLayer->m_Height);
+			Rule.m_NumPosRules = pConf->m_vCompiledPosRules.size() - Rule.m_FirstPosRule;
+			pConf->m_vCompiledRules.push_back(Rule);
+		}
+	}
+}
 
-	CLayerTiles *pUpdateLayer = new CLayerTiles(UpdateToX - UpdateFromX, UpdateToY - UpdateFromY);
+void CAutoMapper::ApplyRun(const CConfiguration *pConf, int RunID, const CTile *pRead, CTile *pWrite, int Width, int Height, int FromX, int FromY, int ToX, int ToY, int Seed, int SeedOffsetX, int SeedOffsetY)
+{
+	const CRun *pRun = &pConf->m_vRuns[RunID];
+	const CCompiledRule *pRules = pConf->m_vCompiledRules.data() + pRun->m_FirstCompiledRule;
+	const int NumRules = pRun->m_vIndexRules.size();
 
-	for(int y = UpdateFromY; y < UpdateToY; y++)
+	for(int y = FromY; y < ToY; y++)
 	{
-		for(int x = UpdateFromX; x < UpdateToX; x++)
+		for(int x = FromX; x < ToX; x++)
 		{
-			CTile *in = &pLayer->m_pTiles[y * pLayer->m_Width + x];
-			CTile *out = &pUpdateLayer->m_pTiles[(y - UpdateFromY) * pUpdateLayer->m_Width + x - UpdateFromX];
-			out->m_Index = in->m_Index;
-			out->m_Flags = in->m_Flags;
+			CTile *pTile = &pWrite[y * Width + x];
+
+			for(int i = 0; i < NumRules; ++i)
+			{
+				const CCompiledRule *pRule = &pRules[i];
+				if(pRule->m_SkipEmpty && pTile->m_Index == 0) // skip empty tiles
+					continue;
+				if(pRule->m_SkipFull && pTile->m_Index != 0) // skip full tiles
+					continue;
+
+				bool RespectRules = true;
+				const CCompiledPosRule *pPosRule = pConf->m_vCompiledPosRules.data() + pRule->m_FirstPosRule;
+				for(int j = 0; j < pRule->m_NumPosRules && RespectRules; ++j, ++pPosRule)
+				{
+					bool Match;
+					const int CheckX = x + pPosRule->m_X;
+					const int CheckY = y + pPosRule->m_Y;
+					if(CheckX >= 0 && CheckX < Width && CheckY >= 0 && CheckY < Height)
+					{
+						const CTile *pCheck = &pRead[CheckY * Width + CheckX];
+						Match = pPosRule->m_aIDs[pCheck->m_Index / 32] & (1u << (pCheck->m_Index % 32));
+						if(!Match)
+						{
+							const int CheckFlags = pCheck->m_Flags & (TILEFLAG_ROTATE | TILEFLAG_VFLIP | TILEFLAG_HFLIP);
+							for(int k = 0; k < pPosRule->m_NumFlagged; k++)
+							{
+								const CIndexInfo *pIndex = &pConf->m_vFlaggedIndices[pPosRule->m_FirstFlagged + k];
+								if(pCheck->m_Index == pIndex->m_ID && CheckFlags == pIndex->m_Flag)
+								{
+									Match = true;
+									break;
+								}
+							}
+						}
+					}
+					else
+						Match = pPosRule->m_MatchOutside;
+
+					RespectRules = pPosRule->m_Index ? Match : !Match;
+				}
+
+				if(RespectRules &&
+					(pRule->m_RandomThreshold < 0 || HashLocation(Seed, RunID, i, x + SeedOffsetX, y + SeedOffsetY) < pRule->m_RandomThreshold))
+				{
+					pTile->m_Index = pRule->m_ID;
+					pTile->m_Flags = pRule->m_Flag;
+				}
+			}
 		}
 	}
+}
 
-	Proceed(pUpdateLayer, ConfigID, Seed, UpdateFromX, UpdateFromY);
-
-	for(int y = CommitFromY; y < CommitToY; y++)
+// evaluates row bands of a run that reads from a copy of the tiles, so the bands are independent
+class CAutoMapper::CBandJob : public IJob
+{
+public:
+	struct CBands
 	{
-		for(int x = CommitFromX; x < CommitToX; x++)
+		const CConfiguration *m_pConf;
+		int m_RunID;
+		const CTile *m_pRead;
+		CTile *m_pWrite;
+		int m_Width;
+		int m_Height;
+		int m_FromX;
+		int m_FromY;
+		int m_ToX;
+		int m_ToY;
+		int m_Seed;
+		int m_SeedOffsetX;
+		int m_SeedOffsetY;
+		int m_NumBands;
+		std::atomic<int> m_NextBand{0};
+		std::atomic<int> m_NumDone{0};
+
+		void Work()
 		{
-			CTile *in = &pUpdateLayer->m_pTiles[(y - UpdateFromY) * pUpdateLayer->m_Width + x - UpdateFromX];
-			CTile *out = &pLayer->m_pTiles[y * pLayer->m_Width + x];
-			out->m_Index = in->m_Index;
-			out->m_Flags = in->m_Flags;
+			int Band;
+			while((Band = m_NextBand.fetch_add(1)) < m_NumBands)
+			{
+				const int FromY = m_FromY + Band * BAND_HEIGHT;
+				ApplyRun(m_pConf, m_RunID, m_pRead, m_pWrite, m_Width, m_Height, m_FromX, FromY, m_ToX, minimum(FromY + BAND_HEIGHT, m_ToY), m_Seed, m_SeedOffsetX, m_SeedOffsetY);
+				m_NumDone.fetch_add(1, std::memory_order_release);
+			}
 		}
+	};
+
+	CBandJob(std::shared_ptr<CBands> pBands) :
+		m_pBands(std::move(pBands)) {}
+
+private:
+	std::shared_ptr<CBands> m_pBands;
+
+	void Run() override { m_pBands->Work(); }
+};
+
+void CAutoMapper::ProceedRun(const CConfiguration *pConf, int RunID, CTile *pTiles, int Width, int Height, int FromX, int FromY, int ToX, int ToY, int Seed, int SeedOffsetX, int SeedOffsetY)
+{
+	if(FromX >= ToX || FromY >= ToY)
+		return;
+
+	// without a copy the rules see the tiles changed before, which only works in order
+	if(!pConf->m_vRuns[RunID].m_AutomapCopy)
+	{
+		ApplyRun(pConf, RunID, pTiles, pTiles, Width, Height, FromX, FromY, ToX, ToY, Seed, SeedOffsetX, SeedOffsetY);
+		return;
 	}
 
-	delete pUpdateLayer;
+	m_vReadTiles.assign(pTiles, pTiles + Width * Height);
+	const int NumBands = (ToY - FromY + BAND_HEIGHT - 1) / BAND_HEIGHT;
+	if(NumBands == 1 || !m_pEngine)
+	{
+		ApplyRun(pConf, RunID, m_vReadTiles.data(), pTiles, Width, Height, FromX, FromY, ToX, ToY, Seed, SeedOffsetX, SeedOffsetY);
+		return;
+	}
+
+	// the job pool helps with the bands, this thread takes them as well
+	auto pBands = std::make_shared<CBandJob::CBands>();
+	pBands->m_pConf = pConf;
+	pBands->m_RunID = RunID;
+	pBands->m_pRead = m_vReadTiles.data();
+	pBands->m_pWrite = pTiles;
+	pBands->m_Width = Width;
+	pBands->m_Height = Height;
+	pBands->m_FromX = FromX;
+	pBands->m_FromY = FromY;
+	pBands->m_ToX = ToX;
+	pBands->m_ToY = ToY;
+	pBands->m_Seed = Seed;
+	pBands->m_SeedOffsetX = SeedOffsetX;
+	pBands->m_SeedOffsetY = SeedOffsetY;
+	pBands->m_NumBands = NumBands;
+
+	const int NumJobs = minimum(NumBands, (int)MAX_BAND_JOBS) - 1;
+	for(int i = 0; i < NumJobs; i++)
+		m_pEngine->AddJob(std::make_shared<CBandJob>(pBands));
+	pBands->Work();
+	while(pBands->m_NumDone.load(std::memory_order_acquire) < NumBands)
+		thread_yield();
 }
 
-void CAutoMapper::Proceed(CLayerTiles *pLayer, int ConfigID, int Seed, int SeedOffsetX, int SeedOffsetY)
+void CAutoMapper::ProceedLocalized(CTile *pTiles, int LayerWidth, int LayerHeight, int ConfigID, int Seed, int X, int Y, int Width, int Height)
 {
-	if(!m_FileLoaded || pLayer->m_Readonly || ConfigID < 0 || ConfigID >= (int)m_vConfigs.size())
+	if(!m_FileLoaded || ConfigID < 0 || ConfigID >= (int)m_vConfigs.size())
 		return;
 
+	if(Width < 0)
+		Width = LayerWidth;
+
+	if(Height < 0)
+		Height = LayerHeight;
+
 	if(Seed == 0)
 		Seed = rand();
 
-	CConfiguration *pConf = &m_vConfigs[ConfigID];
+	const CConfiguration *pConf = &m_vConfigs[ConfigID];
+	const int NumRuns = pConf->m_vRuns.size();
+
+	// the last run changes the tiles whose rules read the edited ones, every run
+	// before it evaluates the tiles read by the next one, which read further out
+	const int CommitFromX = X - pConf->m_EndX;
+	const int CommitFromY = Y - pConf->m_EndY;
+	const int CommitToX = X + Width - pConf->m_StartX;
+	const int CommitToY = Y + Height - pConf->m_StartY;
+
+	const int UpdateFromX = clamp(CommitFromX + NumRuns * pConf->m_StartX, 0, LayerWidth);
+	const int UpdateFromY = clamp(CommitFromY + NumRuns * pConf->m_StartY, 0, LayerHeight);
+	const int UpdateToX = clamp(CommitToX + NumRuns * pConf->m_EndX, 0, LayerWidth);
+	const int UpdateToY = clamp(CommitToY + NumRuns * pConf->m_EndY, 0, LayerHeight);
+	const int UpdateWidth = UpdateToX - UpdateFromX;
+	const int UpdateHeight = UpdateToY - UpdateFromY;
+	if(UpdateWidth <= 0 || UpdateHeight <= 0)
+		return;
 
-	// for every run: copy tiles, automap, overwrite tiles
-	for(size_t h = 0; h < pConf->m_vRuns.size(); ++h)
-	{
-		CRun *pRun = &pConf->m_vRuns[h];
+	std::vector<CTile> vTiles(UpdateWidth * UpdateHeight);
+	for(int y = 0; y < UpdateHeight; y++)
+		mem_copy(&vTiles[y * UpdateWidth], &pTiles[(y + UpdateFromY) * LayerWidth + UpdateFromX], UpdateWidth * sizeof(CTile));
 
-		// don't make copy if it's requested
-		CLayerTiles *pReadLayer;
-		if(pRun->m_AutomapCopy)
-		{
-			pReadLayer = new CLayerTiles(pLayer->m_Width, pLayer->m_Height);
+	for(int h = 0; h < NumRuns; ++h)
+	{
+		const int Later = NumRuns - 1 - h;
+		const int FromX = clamp(CommitFromX + Later * pConf->m_StartX, 0, LayerWidth) - UpdateFromX;
+		const int FromY = clamp(CommitFromY + Later * pConf->m_StartY, 0, LayerHeight) - UpdateFromY;
+		const int ToX = clamp(CommitToX + Later * pConf->m_EndX, 0, LayerWidth) - UpdateFromX;
+		const int ToY = clamp(CommitToY + Later * pConf->m_EndY, 0, LayerHeight) - UpdateFromY;
+		ProceedRun(pConf, h, vTiles.data(), UpdateWidth, UpdateHeight, FromX, FromY, ToX, ToY, Seed, UpdateFromX, UpdateFromY);
+	}
 
-			for(int y = 0; y < pLayer->m_Height; y++)
-			{
-				for(int x = 0; x < pLayer->m_Width; x++)
-				{
-					CTile *in = &pLayer->m_pTiles[y * pLayer->m_Width + x];
-					CTile *out = &pReadLayer->m_pTiles[y * pLayer->m_Width + x];
-					out->m_Index = in->m_Index;
-					out->m_Flags = in->m_Flags;
-				}
-			}
-		}
-		else
+	for(int y = maximum(CommitFromY, 0); y < minimum(CommitToY, LayerHeight); y++)
+	{
+		for(int x = maximum(CommitFromX, 0); x < minimum(CommitToX, LayerWidth); x++)
 		{
-			pReadLayer = pLayer;
+			const CTile *pIn = &vTiles[(y - UpdateFromY) * UpdateWidth + x - UpdateFromX];
+			CTile *pOut = &pTiles[y * LayerWidth + x];
+			pOut->m_Index = pIn->m_Index;
+			pOut->m_Flags = pIn->m_Flags;
 		}
+	}
+}
 
-		// auto map
-		for(int y = 0; y < pLayer->m_Height; y++)
-		{
-			for(int x = 0; x < pLayer->m_Width; x++)
-			{
-				CTile *pTile = &(pLayer->m_pTiles[y * pLayer->m_Width + x]);
-				m_pEditor->m_Map.m_Modified = true;
-
-				for(size_t i = 0; i < pRun->m_vIndexRules.size(); ++i)
-				{
-					CIndexRule *pIndexRule = &pRun->m_vIndexRules[i];
-					if(pIndexRule->m_SkipEmpty && pTile->m_Index == 0) // skip empty tiles
-						continue;
-					if(pIndexRule->m_SkipFull && pTile->m_Index != 0) // skip full tiles
-						continue;
-
-					bool RespectRules = true;
-					for(size_t j = 0; j < pIndexRule->m_vRules.size() && RespectRules; ++j)
-					{
-						CPosRule *pRule = &pIndexRule->m_vRules[j];
-
-						int CheckIndex, CheckFlags;
-						int CheckX = x + pRule->m_X;
-						int CheckY = y + pRule->m_Y;
-						if(CheckX >= 0 && CheckX < pLayer->m_Width && CheckY >= 0 && CheckY < pLayer->m_Height)
-						{
-							int CheckTile = CheckY * pLayer->m_Width + CheckX;
-							CheckIndex = pReadLayer->m_pTiles[CheckTile].m_Index;
-							CheckFlags = pReadLayer->m_pTiles[CheckTile].m_Flags & (TILEFLAG_ROTATE | TILEFLAG_VFLIP | TILEFLAG_HFLIP);
-						}
-						else
-						{
-							CheckIndex = -1;
-							CheckFlags = 0;
-						}
+void CAutoMapper::Proceed(CTile *pTiles, int LayerWidth, int LayerHeight, int ConfigID, int Seed, int SeedOffsetX, int SeedOffsetY)
+{
+	if(!m_FileLoaded || ConfigID < 0 || ConfigID >= (int)m_vConfigs.size())
+		return;
 
-						if(pRule->m_Value == CPosRule::INDEX)
-						{
-							RespectRules = false;
-							for(auto &Index : pRule->m_vIndexList)
-							{
-								if(CheckIndex == Index.m_ID && (!Index.m_TestFlag || CheckFlags == Index.m_Flag))
-								{
-									RespectRules = true;
-									break;
-								}
-							}
-						}
-						else if(pRule->m_Value == CPosRule::NOTINDEX)
-						{
-							for(auto &Index : pRule->m_vIndexList)
-							{
-								if(CheckIndex == Index.m_ID && (!Index.m_TestFlag || CheckFlags == Index.m_Flag))
-								{
-									RespectRules = false;
-									break;
-								}
-							}
-						}
-					}
+	if(Seed == 0)
+		Seed = rand();
 
-					if(RespectRules &&
-						(pIndexRule->m_RandomProbability >= 1.0f || HashLocation(Seed, h, i, x + SeedOffsetX, y + SeedOffsetY) < HASH_MAX * pIndexRule->m_RandomProbability))
-					{
-						pTile->m_Index = pIndexRule->m_ID;
-						pTile->m_Flags = pIndexRule->m_Flag;
-					}
-				}
-			}
-		}
+	const CConfiguration *pConf = &m_vConfigs[ConfigID];
 
-		// clean-up
-		if(pRun->m_AutomapCopy && pReadLayer != pLayer)
-			delete pReadLayer;
-	}
+	// for every run: copy tiles, automap, overwrite tiles
+	for(size_t h = 0; h < pConf->m_vRuns.size(); ++h)
+		ProceedRun(pConf, h, pTiles, LayerWidth, LayerHeight, 0, 0, LayerWidth, LayerHeight, Seed, SeedOffsetX, SeedOffsetY);
 }
@@ -3,8 +3,12 @@
 
 #include <vector>
 
+#include <game/mapitems.h>
+
 class CAutoMapper
 {
+	friend class CAutoMapperTest;
+
 	struct CIndexInfo
 	{
 		int m_ID;
@@ -42,6 +46,30 @@ class CAutoMapper
 	{
 		std::vector<CIndexRule> m_vIndexRules;
 		bool m_AutomapCopy;
+		int m_FirstCompiledRule = 0;
+	};
+
+	// flat form of the rules that is evaluated for every tile
+	struct CCompiledPosRule
+	{
+		int m_X;
+		int m_Y;
+		bool m_Index; // INDEX or NOTINDEX
+		bool m_MatchOutside;
+		unsigned m_aIDs[256 / 32]; // indices that match with any flags
+		int m_FirstFlagged; // indices that only match with certain flags
+		int m_NumFlagged;
+	};
+
+	struct CCompiledRule
+	{
+		int m_ID;
+		int m_Flag;
+		int m_RandomThreshold; // -1 if the rule is always applied
+		bool m_SkipEmpty;
+		bool m_SkipFull;
+		int m_FirstPosRule;
+		int m_NumPosRules;
 	};
 
 	struct CConfiguration
@@ -52,14 +80,31 @@ class CAutoMapper
 		int m_StartY;
 		int m_EndX;
 		int m_EndY;
+
+		std::vector<CCompiledRule> m_vCompiledRules;
+		std::vector<CCompiledPosRule> m_vCompiledPosRules;
+		std::vector<CIndexInfo> m_vFlaggedIndices;
 	};
 
+	class CBandJob;
+
+	enum
+	{
+		BAND_HEIGHT = 32,
+		MAX_BAND_JOBS = 16,
+	};
+
+	static void Compile(CConfiguration *pConf);
+	static void ApplyRun(const CConfiguration *pConf, int RunID, const CTile *pRead, CTile *pWrite, int Width, int Height, int FromX, int FromY, int ToX, int ToY, int Seed, int SeedOffsetX, int SeedOffsetY);
+	void ProceedRun(const CConfiguration *pConf, int RunID, CTile *pTiles, int Width, int Height, int FromX, int FromY, int ToX, int ToY, int Seed, int SeedOffsetX, int SeedOffsetY);
+
 public:
-	CAutoMapper(class CEditor *pEditor);
+	// without an engine the bands are evaluated on the calling thread
+	CAutoMapper(class IStorage *pStorage, class IConsole *pConsole, class IEngine *pEngine);
 
 	void Load(const char *pTileName);
-	void ProceedLocalized(class CLayerTiles *pLayer, int ConfigID, int Seed = 0, int X = 0, int Y = 0, int Width = -1, int Height = -1);
-	void Proceed(class CLayerTiles *pLayer, int ConfigID, int Seed = 0, int SeedOffsetX = 0, int SeedOffsetY = 0);
+	void ProceedLocalized(CTile *pTiles, int LayerWidth, int LayerHeight, int ConfigID, int Seed = 0, int X = 0, int Y = 0, int Width = -1, int Height = -1);
+	void Proceed(CTile *pTiles, int LayerWidth, int LayerHeight, int ConfigID, int Seed = 0, int SeedOffsetX = 0, int SeedOffsetY = 0);
 
 	int ConfigNamesNum() const { return m_vConfigs.size(); }
 	const char *GetConfigName(int Index);
@@ -68,7 +113,10 @@ public:
 
 private:
 	std::vector<CConfiguration> m_vConfigs;
-	class CEditor *m_pEditor;
+	std::vector<CTile> m_vReadTiles;
+	class IStorage *m_pStorage;
+	class IConsole *m_pConsole;
+	class IEngine *m_pEngine;
 	bool m_FileLoaded;
 };
 
@@ -12,6 +12,7 @@
 
 #include <engine/client.h>
 #include <engine/console.h>
+#include <engine/engine.h>
 #include <engine/gfx/image_manipulation.h>
 #include <engine/graphics.h>
 #include <engine/input.h>
@@ -78,6 +79,18 @@ enum
 	BUTTON_CONTEXT = 1,
 };
 
+CEditorImage::CEditorImage(CEditor *pEditor) :
+	m_AutoMapper(pEditor->Storage(), pEditor->Console(), pEditor->Engine())
+{
+	m_pEditor = pEditor;
+	m_aName[0] = 0;
+	m_External = 0;
+	m_Width = 0;
+	m_Height = 0;
+	m_pData = nullptr;
+	m_Format = 0;
+}
+
 CEditorImage::~CEditorImage()
 {
 	m_pEditor->Graphics()->UnloadTexture(&m_Texture);
@@ -6310,6 +6323,7 @@ void CEditor::Init()
 	m_pClient = Kernel()->RequestInterface<IClient>();
 	m_pConfig = Kernel()->RequestInterface<IConfigManager>()->Values();
 	m_pConsole = Kernel()->RequestInterface<IConsole>();
+	m_pEngine = Kernel()->RequestInterface<IEngine>();
 	m_pGraphics = Kernel()->RequestInterface<IGraphics>();
 	m_pTextRender = Kernel()->RequestInterface<ITextRender>();
 	m_pStorage = Kernel()->RequestInterface<IStorage>();
@@ -272,18 +272,7 @@ class CEditorImage : public CImageInfo
 public:
 	CEditor *m_pEditor;
 
-	CEditorImage(CEditor *pEditor) :
-		m_AutoMapper(pEditor)
-	{
-		m_pEditor = pEditor;
-		m_aName[0] = 0;
-		m_External = 0;
-		m_Width = 0;
-		m_Height = 0;
-		m_pData = nullptr;
-		m_Format = 0;
-	}
-
+	CEditorImage(CEditor *pEditor);
 	~CEditorImage();
 
 	void AnalyseTileFlags();
@@ -674,6 +663,7 @@ class CEditor : public IEditor
 	class IClient *m_pClient;
 	class CConfig *m_pConfig;
 	class IConsole *m_pConsole;
+	class IEngine *m_pEngine;
 	class IGraphics *m_pGraphics;
 	class ITextRender *m_pTextRender;
 	class ISound *m_pSound;
@@ -699,6 +689,7 @@ public:
 	class IClient *Client() { return m_pClient; }
 	class CConfig *Config() { return m_pConfig; }
 	class IConsole *Console() { return m_pConsole; }
+	class IEngine *Engine() { return m_pEngine; }
 	class IGraphics *Graphics() { return m_pGraphics; }
 	class ISound *Sound() { return m_pSound; }
 	class ITextRender *TextRender() { return m_pTextRender; }
@@ -712,6 +703,7 @@ public:
 	{
 		m_pInput = nullptr;
 		m_pClient = nullptr;
+		m_pEngine = nullptr;
 		m_pGraphics = nullptr;
 		m_pTextRender = nullptr;
 		m_pSound = nullptr;
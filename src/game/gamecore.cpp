@@ -60,6 +60,28 @@ float VelocityRamp(float Value, float Start, float Range, float Curvature)
 	return 1.0f / powf(Curvature, (Value - Start) / Range);
 }
 
+// slack for the broad phase boxes, covers the rounding of the exact distance checks
+static const float BROADPHASE_MARGIN = 1.0f;
+
+void CWorldCore::GatherCharacters(CCharacterBatch *pBatch, const CCharacterCore *pSkip, vec2 Min, vec2 Max, int ForceID) const
+{
+	int Num = 0;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		const CCharacterCore *pCharCore = m_apCharacters[i];
+		if(!pCharCore || pCharCore == pSkip)
+			continue;
+		const vec2 Pos = pCharCore->m_Pos;
+		if(m_BroadPhase && i != ForceID && !(Pos.x >= Min.x && Pos.x <= Max.x && Pos.y >= Min.y && Pos.y <= Max.y))
+			continue;
+		pBatch->m_aIds[Num] = i;
+		pBatch->m_aX[Num] = Pos.x;
+		pBatch->m_aY[Num] = Pos.y;
+		Num++;
+	}
+	pBatch->m_Num = Num;
+}
+
 void CCharacterCore::Init(CWorldCore *pWorld, CCollision *pCollision, CTeamsCore *pTeams, std::map<int, std::vector<vec2>> *pTeleOuts)
 {
 	m_pWorld = pWorld;
@@ -84,7 +106,7 @@ void CCharacterCore::Reset()
 	m_HookTick = 0;
 	m_HookState = HOOK_IDLE;
 	SetHookedPlayer(-1);
-	m_AttachedPlayers.clear();
+	m_AttachedPlayers.reset();
 	m_Jumped = 0;
 	m_JumpedTotal = 0;
 	m_Jumps = 2;
@@ -278,11 +300,19 @@ void CCharacterCore::Tick(bool UseInput)
 		// Check against other players first
 		if(!this->m_NoHookHit && m_pWorld && m_Tuning.m_PlayerHooking)
 		{
+			// only characters close to the hook segment can be grabbed
+			const float Reach = PhysicalSize() + 2.0f + BROADPHASE_MARGIN;
+			CWorldCore::CCharacterBatch Batch;
+			m_pWorld->GatherCharacters(&Batch, this,
+				vec2(minimum(m_HookPos.x, NewPos.x) - Reach, minimum(m_HookPos.y, NewPos.y) - Reach),
+				vec2(maximum(m_HookPos.x, NewPos.x) + Reach, maximum(m_HookPos.y, NewPos.y) + Reach));
+
 			float Distance = 0.0f;
-			for(int i = 0; i < MAX_CLIENTS; i++)
+			for(int k = 0; k < Batch.m_Num; k++)
 			{
+				const int i = Batch.m_aIds[k];
 				CCharacterCore *pCharCore = m_pWorld->m_apCharacters[i];
-				if(!pCharCore || pCharCore == this || (!(m_Super || pCharCore->m_Super) && ((m_Id != -1 && !m_pTeams->CanCollide(i, m_Id)) || pCharCore->m_Solo || m_Solo)))
+				if((!(m_Super || pCharCore->m_Super) && ((m_Id != -1 && !m_pTeams->CanCollide(i, m_Id)) || pCharCore->m_Solo || m_Solo)))
 					continue;
 
 				vec2 ClosestPoint;
@@ -389,16 +419,20 @@ void CCharacterCore::Tick(bool UseInput)
 
 	if(m_pWorld)
 	{
-		for(int i = 0; i < MAX_CLIENTS; i++)
+		// characters further away can only interact through our hook
+		const float Reach = PhysicalSize() * 1.25f + BROADPHASE_MARGIN;
+		CWorldCore::CCharacterBatch Batch;
+		m_pWorld->GatherCharacters(&Batch, this, m_Pos - vec2(Reach, Reach), m_Pos + vec2(Reach, Reach), m_HookedPlayer);
+
+		for(int k = 0; k < Batch.m_Num; k++)
 		{
+			const int i = Batch.m_aIds[k];
 			CCharacterCore *pCharCore = m_pWorld->m_apCharacters[i];
-			if(!pCharCore)
-				continue;
 
 			//player *p = (player*)ent;
 			//if(pCharCore == this) // || !(p->flags&FLAG_ALIVE)
 
-			if(pCharCore == this || (m_Id != -1 && !m_pTeams->CanCollide(m_Id, i)))
+			if(m_Id != -1 && !m_pTeams->CanCollide(m_Id, i))
 				continue; // make sure that we don't nudge our self
 
 			if(!(m_Super || pCharCore->m_Super) && (m_Solo || pCharCore->m_Solo))
@@ -489,25 +523,41 @@ void CCharacterCore::Move()
 		float Distance = distance(m_Pos, NewPos);
 		if(Distance > 0)
 		{
-			int End = Distance + 1;
+			// collect the characters around the swept box that we can collide with once,
+			// nobody else moves while we step along the path
+			const float Reach = PhysicalSize() + BROADPHASE_MARGIN;
+			CWorldCore::CCharacterBatch Batch;
+			m_pWorld->GatherCharacters(&Batch, this,
+				vec2(minimum(m_Pos.x, NewPos.x) - Reach, minimum(m_Pos.y, NewPos.y) - Reach),
+				vec2(maximum(m_Pos.x, NewPos.x) + Reach, maximum(m_Pos.y, NewPos.y) + Reach));
+
+			int NumBlocking = 0;
+			for(int k = 0; k < Batch.m_Num; k++)
+			{
+				const int p = Batch.m_aIds[k];
+				const CCharacterCore *pCharCore = m_pWorld->m_apCharacters[p];
+				if((!(pCharCore->m_Super || m_Super) && (m_Solo || pCharCore->m_Solo || pCharCore->m_NoCollision || (m_Id != -1 && !m_pTeams->CanCollide(m_Id, p)))))
+					continue;
+				Batch.m_aX[NumBlocking] = Batch.m_aX[k];
+				Batch.m_aY[NumBlocking] = Batch.m_aY[k];
+				NumBlocking++;
+			}
+
+			int End = NumBlocking ? (int)(Distance + 1) : 0;
 			vec2 LastPos = m_Pos;
 			for(int i = 0; i < End; i++)
 			{
 				float a = i / Distance;
 				vec2 Pos = mix(m_Pos, NewPos, a);
-				for(int p = 0; p < MAX_CLIENTS; p++)
+				for(int k = 0; k < NumBlocking; k++)
 				{
-					CCharacterCore *pCharCore = m_pWorld->m_apCharacters[p];
-					if(!pCharCore || pCharCore == this)
-						continue;
-					if((!(pCharCore->m_Super || m_Super) && (m_Solo || pCharCore->m_Solo || pCharCore->m_NoCollision || (m_Id != -1 && !m_pTeams->CanCollide(m_Id, p)))))
-						continue;
-					float D = distance(Pos, pCharCore->m_Pos);
+					const vec2 OtherPos(Batch.m_aX[k], Batch.m_aY[k]);
+					float D = distance(Pos, OtherPos);
 					if(D < PhysicalSize() && D >= 0.0f)
 					{
 						if(a > 0.0f)
 							m_Pos = LastPos;
-						else if(distance(NewPos, pCharCore->m_Pos) > D)
+						else if(distance(NewPos, OtherPos) > D)
 							m_Pos = NewPos;
 						return;
 					}
@@ -625,7 +675,7 @@ void CCharacterCore::SetHookedPlayer(int HookedPlayer)
 			CCharacterCore *pCharCore = m_pWorld->m_apCharacters[m_HookedPlayer];
 			if(pCharCore)
 			{
-				pCharCore->m_AttachedPlayers.erase(m_Id);
+				pCharCore->m_AttachedPlayers.reset(m_Id);
 			}
 		}
 		if(HookedPlayer != -1 && m_Id != -1 && m_pWorld)
@@ -633,7 +683,7 @@ void CCharacterCore::SetHookedPlayer(int HookedPlayer)
 			CCharacterCore *pCharCore = m_pWorld->m_apCharacters[HookedPlayer];
 			if(pCharCore)
 			{
-				pCharCore->m_AttachedPlayers.insert(m_Id);
+				pCharCore->m_AttachedPlayers.set(m_Id);
 			}
 		}
 		m_HookedPlayer = HookedPlayer;
@@ -6,8 +6,8 @@
 #include <base/system.h>
 #include <base/vmath.h>
 
+#include <bitset>
 #include <map>
-#include <set>
 #include <vector>
 
 #include <engine/shared/protocol.h>
@@ -192,6 +192,7 @@ public:
 	{
 		mem_zero(m_apCharacters, sizeof(m_apCharacters));
 		m_pPrng = nullptr;
+		m_BroadPhase = true;
 	}
 
 	int RandomOr0(int BelowThis)
@@ -206,9 +207,26 @@ public:
 		return m_pPrng->RandomBits() % BelowThis;
 	}
 
+	// compact snapshot of the characters inside an area, ordered by id
+	struct CCharacterBatch
+	{
+		int m_Num;
+		int m_aIds[MAX_CLIENTS];
+		float m_aX[MAX_CLIENTS];
+		float m_aY[MAX_CLIENTS];
+	};
+
+	/*
+		Collects the characters whose position lies inside [Min, Max], except pSkip.
+		ForceID is always collected if it exists. The partner loops of the character
+		core only visit these, so the order (and thus the result) stays the same.
+	*/
+	void GatherCharacters(CCharacterBatch *pBatch, const class CCharacterCore *pSkip, vec2 Min, vec2 Max, int ForceID = -1) const;
+
 	CTuningParams m_Tuning[2];
 	class CCharacterCore *m_apCharacters[MAX_CLIENTS];
 	CPrng *m_pPrng;
+	bool m_BroadPhase; // false visits every character, only useful for comparisons
 
 	void InitSwitchers(int HighestSwitchNumber);
 	std::vector<SSwitchers> m_vSwitchers;
@@ -233,7 +251,7 @@ public:
 	int m_HookTick;
 	int m_HookState;
 	int m_HookedPlayer;
-	std::set<int> m_AttachedPlayers;
+	std::bitset<MAX_CLIENTS> m_AttachedPlayers;
 	void SetHookedPlayer(int HookedPlayer);
 
 	int m_ActiveWeapon;
@@ -917,8 +917,10 @@ void CCharacter::Snap(int SnappingClient)
 	bool AttachedHookInView = false;
 	if(PlayerAndHookNotInView)
 	{
-		for(const auto &AttachedPlayerID : m_Core.m_AttachedPlayers)
+		for(int AttachedPlayerID = 0; AttachedPlayerID < MAX_CLIENTS; AttachedPlayerID++)
 		{
+			if(!m_Core.m_AttachedPlayers.test(AttachedPlayerID))
+				continue;
 			CCharacter *OtherPlayer = GameServer()->GetPlayerChar(AttachedPlayerID);
 			if(OtherPlayer && OtherPlayer->m_Core.m_HookedPlayer == ID)
 			{
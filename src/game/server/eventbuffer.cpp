@@ -0,0 +1,114 @@
+#include "eventbuffer.h"
+
+#include <base/math.h>
+#include <base/system.h>
+
+#include <game/generated/protocol.h>
+
+#include <algorithm>
+
+CEventBuffer::CEventBuffer()
+{
+	m_GridWidth = 0;
+	m_GridHeight = 0;
+	m_vEvents.reserve(128);
+	Clear();
+}
+
+void *CEventBuffer::Create(int Type, int Size, int64_t Mask)
+{
+	if((int)m_vEvents.size() == MAX_EVENTS)
+	{
+		m_NumDropped++;
+		return 0;
+	}
+
+	// move on to the next chunk, allocate one if there is none big enough
+	if(m_CurrentChunk == (int)m_vChunks.size() || m_ChunkOffset + Size > m_vChunks[m_CurrentChunk].m_Size)
+	{
+		if(m_CurrentChunk < (int)m_vChunks.size())
+			m_CurrentChunk++;
+		m_ChunkOffset = 0;
+		if(m_CurrentChunk == (int)m_vChunks.size() || Size > m_vChunks[m_CurrentChunk].m_Size)
+		{
+			CChunk Chunk;
+			Chunk.m_Size = maximum(Size, (int)CHUNK_SIZE);
+			Chunk.m_pData = std::unique_ptr<char[]>(new char[Chunk.m_Size]);
+			m_vChunks.insert(m_vChunks.begin() + m_CurrentChunk, std::move(Chunk));
+		}
+	}
+
+	CEvent Event;
+	Event.m_Type = Type;
+	Event.m_Size = Size;
+	Event.m_pData = m_vChunks[m_CurrentChunk].m_pData.get() + m_ChunkOffset;
+	Event.m_ClientMask = Mask;
+	m_vEvents.push_back(Event);
+	m_ChunkOffset += Size;
+	m_IndexValid = false;
+	return Event.m_pData;
+}
+
+void CEventBuffer::Clear()
+{
+	m_vEvents.clear();
+	m_CurrentChunk = 0;
+	m_ChunkOffset = 0;
+	m_NumDropped = 0;
+	m_IndexValid = false;
+}
+
+void CEventBuffer::BuildIndex(int MapWidth, int MapHeight)
+{
+	m_GridWidth = ((MapWidth * 32) >> CELL_SHIFT) + 1;
+	m_GridHeight = ((MapHeight * 32) >> CELL_SHIFT) + 1;
+	const int NumCells = m_GridWidth * m_GridHeight;
+	const int NumEvents = m_vEvents.size();
+
+	// counting sort by cell, events outside of the map end up in the border cells
+	m_vEventCells.resize(NumEvents);
+	m_vCellStart.assign(NumCells + 1, 0);
+	for(int i = 0; i < NumEvents; i++)
+	{
+		const CNetEvent_Common *pEvent = (const CNetEvent_Common *)m_vEvents[i].m_pData;
+		const int CellX = clamp(pEvent->m_X >> CELL_SHIFT, 0, m_GridWidth - 1);
+		const int CellY = clamp(pEvent->m_Y >> CELL_SHIFT, 0, m_GridHeight - 1);
+		m_vEventCells[i] = CellY * m_GridWidth + CellX;
+		m_vCellStart[m_vEventCells[i] + 1]++;
+	}
+	for(int c = 0; c < NumCells; c++)
+		m_vCellStart[c + 1] += m_vCellStart[c];
+
+	std::vector<int> vInsert(m_vCellStart.begin(), m_vCellStart.end() - 1);
+	m_vCellEvents.resize(NumEvents);
+	for(int i = 0; i < NumEvents; i++)
+		m_vCellEvents[vInsert[m_vEventCells[i]]++] = i;
+
+	m_IndexValid = true;
+}
+
+void CEventBuffer::Query(int MapWidth, int MapHeight, vec2 Min, vec2 Max, std::vector<int> *pvResult)
+{
+	pvResult->clear();
+	if(m_vEvents.empty())
+		return;
+	if(!m_IndexValid || m_GridWidth != ((MapWidth * 32) >> CELL_SHIFT) + 1 || m_GridHeight != ((MapHeight * 32) >> CELL_SHIFT) + 1)
+		BuildIndex(MapWidth, MapHeight);
+
+	const float GridRight = (float)((m_GridWidth << CELL_SHIFT) - 1);
+	const float GridBottom = (float)((m_GridHeight << CELL_SHIFT) - 1);
+	const int MinX = (int)clamp(Min.x - 1.0f, 0.0f, GridRight) >> CELL_SHIFT;
+	const int MinY = (int)clamp(Min.y - 1.0f, 0.0f, GridBottom) >> CELL_SHIFT;
+	const int MaxX = (int)clamp(Max.x + 1.0f, 0.0f, GridRight) >> CELL_SHIFT;
+	const int MaxY = (int)clamp(Max.y + 1.0f, 0.0f, GridBottom) >> CELL_SHIFT;
+	if(MinX > MaxX || MinY > MaxY)
+		return;
+
+	for(int y = MinY; y <= MaxY; y++)
+	{
+		const int RowStart = m_vCellStart[y * m_GridWidth + MinX];
+		const int RowEnd = m_vCellStart[y * m_GridWidth + MaxX + 1];
+		pvResult->insert(pvResult->end(), m_vCellEvents.begin() + RowStart, m_vCellEvents.begin() + RowEnd);
+	}
+	std::sort(pvResult->begin(), pvResult->end());
+}
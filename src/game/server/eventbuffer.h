@@ -0,0 +1,73 @@
+#ifndef GAME_SERVER_EVENTBUFFER_H
+#define GAME_SERVER_EVENTBUFFER_H
+
+#include <base/vmath.h>
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+/*
+	Events of one tick. Their data is allocated from chunks that are kept
+	between ticks, so pointers returned by Create() stay valid until Clear().
+	Events are bucketed by grid cell on the first query after one was
+	created, because their position is only written after Create().
+*/
+class CEventBuffer
+{
+public:
+	enum
+	{
+		MAX_EVENTS = 0x10000, // events are snapped with their index as 16 bit id
+		CHUNK_SIZE = 128 * 64,
+		CELL_SHIFT = 9, // 512x512 units per grid cell
+	};
+
+	struct CEvent
+	{
+		int m_Type;
+		int m_Size;
+		char *m_pData;
+		int64_t m_ClientMask;
+	};
+
+private:
+	struct CChunk
+	{
+		std::unique_ptr<char[]> m_pData;
+		int m_Size;
+	};
+
+	std::vector<CEvent> m_vEvents;
+	std::vector<CChunk> m_vChunks;
+	int m_CurrentChunk;
+	int m_ChunkOffset;
+	int m_NumDropped;
+
+	bool m_IndexValid;
+	int m_GridWidth;
+	int m_GridHeight;
+	std::vector<int> m_vEventCells;
+	std::vector<int> m_vCellStart;
+	std::vector<int> m_vCellEvents;
+
+	void BuildIndex(int MapWidth, int MapHeight);
+
+public:
+	CEventBuffer();
+
+	// returns nullptr and counts the event as dropped if there are too many
+	void *Create(int Type, int Size, int64_t Mask);
+	void Clear();
+
+	int Num() const { return m_vEvents.size(); }
+	const CEvent &Get(int Index) const { return m_vEvents[Index]; }
+	int NumDropped() const { return m_NumDropped; }
+
+	// events in the grid cells that overlap the area, in creation order. The
+	// map size is in tiles, events outside of the map are in the border cells
+	void Query(int MapWidth, int MapHeight, vec2 Min, vec2 Max, std::vector<int> *pvResult);
+};
+
+#endif
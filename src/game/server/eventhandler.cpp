@@ -4,6 +4,7 @@
 
 #include "entity.h"
 #include "gamecontext.h"
+#include "player.h"
 
 #include <base/system.h>
 #include <base/vmath.h>
@@ -14,7 +15,10 @@
 CEventHandler::CEventHandler()
 {
 	m_pGameServer = 0;
-	Clear();
+	m_NumSnapDropped = 0;
+	m_ReportDropped = 0;
+	m_ReportSnapDropped = 0;
+	m_LastReport = 0;
 }
 
 void CEventHandler::SetGameServer(CGameContext *pGameServer)
@@ -22,45 +26,66 @@ void CEventHandler::SetGameServer(CGameContext *pGameServer)
 	m_pGameServer = pGameServer;
 }
 
-void *CEventHandler::Create(int Type, int Size, int64_t Mask)
+void CEventHandler::Clear()
 {
-	if(m_NumEvents == MAX_EVENTS)
-		return 0;
-	if(m_CurrentOffset + Size >= MAX_DATASIZE)
-		return 0;
+	m_ReportDropped += m_Buffer.NumDropped();
+	m_ReportSnapDropped += m_NumSnapDropped;
+	if((m_ReportDropped || m_ReportSnapDropped) && GameServer())
+	{
+		const int64_t Now = time_get();
+		if(!m_LastReport || Now - m_LastReport > REPORT_INTERVAL * time_freq())
+		{
+			char aBuf[128];
+			str_format(aBuf, sizeof(aBuf), "dropped %d events on creation and %d in snapshots (%d events this tick)", m_ReportDropped, m_ReportSnapDropped, m_Buffer.Num());
+			GameServer()->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "events", aBuf);
+			m_ReportDropped = 0;
+			m_ReportSnapDropped = 0;
+			m_LastReport = Now;
+		}
+	}
 
-	void *p = &m_aData[m_CurrentOffset];
-	m_aOffsets[m_NumEvents] = m_CurrentOffset;
-	m_aTypes[m_NumEvents] = Type;
-	m_aSizes[m_NumEvents] = Size;
-	m_aClientMasks[m_NumEvents] = Mask;
-	m_CurrentOffset += Size;
-	m_NumEvents++;
-	return p;
+	m_Buffer.Clear();
+	m_NumSnapDropped = 0;
 }
 
-void CEventHandler::Clear()
+void CEventHandler::SnapEvent(int Index)
 {
-	m_NumEvents = 0;
-	m_CurrentOffset = 0;
+	const CEventBuffer::CEvent &Event = m_Buffer.Get(Index);
+	void *d = GameServer()->Server()->SnapNewItem(Event.m_Type, Index, Event.m_Size);
+	if(d)
+		mem_copy(d, Event.m_pData, Event.m_Size);
+	else
+		m_NumSnapDropped++;
 }
 
 void CEventHandler::Snap(int SnappingClient)
 {
-	for(int i = 0; i < m_NumEvents; i++)
+	if(!m_Buffer.Num())
+		return;
+
+	const CPlayer *pPlayer = SnappingClient == SERVER_DEMO_CLIENT ? nullptr : GameServer()->m_apPlayers[SnappingClient];
+	if(!pPlayer || pPlayer->m_ShowAll)
 	{
-		if(SnappingClient == SERVER_DEMO_CLIENT || CmaskIsSet(m_aClientMasks[i], SnappingClient))
+		for(int i = 0; i < m_Buffer.Num(); i++)
 		{
-			CNetEvent_Common *ev = (CNetEvent_Common *)&m_aData[m_aOffsets[i]];
-			if(!NetworkClipped(GameServer(), SnappingClient, vec2(ev->m_X, ev->m_Y)))
-			{
-				int Type = m_aTypes[i];
-				int Size = m_aSizes[i];
-				const char *Data = &m_aData[m_aOffsets[i]];
-				void *d = GameServer()->Server()->SnapNewItem(Type, i, Size);
-				if(d)
-					mem_copy(d, Data, Size);
-			}
+			if(SnappingClient == SERVER_DEMO_CLIENT || CmaskIsSet(m_Buffer.Get(i).m_ClientMask, SnappingClient))
+				SnapEvent(i);
 		}
+		return;
+	}
+
+	// visit the cells covered by the view, then snap in creation order
+	const vec2 Min = pPlayer->m_ViewPos - pPlayer->m_ShowDistance;
+	const vec2 Max = pPlayer->m_ViewPos + pPlayer->m_ShowDistance;
+	m_Buffer.Query(GameServer()->Collision()->GetWidth(), GameServer()->Collision()->GetHeight(), Min, Max, &m_vVisible);
+
+	for(int i : m_vVisible)
+	{
+		const CEventBuffer::CEvent &Event = m_Buffer.Get(i);
+		if(!CmaskIsSet(Event.m_ClientMask, SnappingClient))
+			continue;
+		const CNetEvent_Common *pEvent = (const CNetEvent_Common *)Event.m_pData;
+		if(!NetworkClipped(GameServer(), SnappingClient, vec2(pEvent->m_X, pEvent->m_Y)))
+			SnapEvent(i);
 	}
-}
\ No newline at end of file
+}
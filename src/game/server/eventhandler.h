@@ -3,30 +3,34 @@
 #ifndef GAME_SERVER_EVENTHANDLER_H
 #define GAME_SERVER_EVENTHANDLER_H
 
+#include "eventbuffer.h"
+
 #include <stdint.h>
 
+#include <vector>
+
 class CEventHandler
 {
-	static const int MAX_EVENTS = 128;
-	static const int MAX_DATASIZE = 128 * 64;
+	CEventBuffer m_Buffer;
+	std::vector<int> m_vVisible;
 
-	int m_aTypes[MAX_EVENTS]; // TODO: remove some of these arrays
-	int m_aOffsets[MAX_EVENTS];
-	int m_aSizes[MAX_EVENTS];
-	int64_t m_aClientMasks[MAX_EVENTS];
-	char m_aData[MAX_DATASIZE];
+	// drops are summed up and reported at most every REPORT_INTERVAL seconds
+	static const int REPORT_INTERVAL = 10;
+	int m_NumSnapDropped;
+	int m_ReportDropped;
+	int m_ReportSnapDropped;
+	int64_t m_LastReport;
 
 	class CGameContext *m_pGameServer;
 
-	int m_CurrentOffset;
-	int m_NumEvents;
+	void SnapEvent(int Index);
 
 public:
 	CGameContext *GameServer() const { return m_pGameServer; }
 	void SetGameServer(CGameContext *pGameServer);
 
 	CEventHandler();
-	void *Create(int Type, int Size, int64_t Mask = -1LL);
+	void *Create(int Type, int Size, int64_t Mask = -1LL) { return m_Buffer.Create(Type, Size, Mask); }
 	void Clear();
 	void Snap(int SnappingClient);
 };
@@ -26,6 +26,8 @@ CGameWorld::CGameWorld()
 	m_ResetRequested = false;
 	for(auto &pFirstEntityType : m_apFirstEntityTypes)
 		pFirstEntityType = 0;
+	for(auto &State : m_aPlayerMapStates)
+		State.m_Unchanged = false;
 }
 
 CGameWorld::~CGameWorld()
@@ -174,46 +176,68 @@ void CGameWorld::UpdatePlayerMaps()
 	if(Server()->Tick() % g_Config.m_SvMapUpdateRate != 0)
 		return;
 
-	std::pair<float, int> Dist[MAX_CLIENTS];
+	// only the clients of this world see each other, the id maps of the
+	// other clients are updated by their own worlds
+	const int WorldID = GameServer()->GetWorldID();
+	int aWorldClients[MAX_CLIENTS];
+	int NumWorldClients = 0;
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
-		if(!Server()->ClientIngame(i))
-			continue;
+		if(Server()->ClientIngame(i) && Server()->GetClientWorldID(i) == WorldID && GameServer()->m_apPlayers[i])
+			aWorldClients[NumWorldClients++] = i;
+	}
+
+	float aDist[MAX_CLIENTS];
+	std::pair<float, int> Dist[MAX_CLIENTS];
+	for(int w = 0; w < NumWorldClients; w++)
+	{
+		const int i = aWorldClients[w];
 		int *pMap = Server()->GetIdMap(i);
 
 		// compute distances
-		for(int j = 0; j < MAX_CLIENTS; j++)
+		for(float &d : aDist)
+			d = 1e10;
+		CCharacter *SnapChar = GameServer()->GetPlayerChar(i);
+		for(int v = 0; v < NumWorldClients; v++)
 		{
-			Dist[j].second = j;
-			if(!Server()->ClientIngame(j) || !GameServer()->m_apPlayers[j])
-			{
-				Dist[j].first = 1e10;
-				continue;
-			}
+			const int j = aWorldClients[v];
 			CCharacter *ch = GameServer()->m_apPlayers[j]->GetCharacter();
 			if(!ch)
 			{
-				Dist[j].first = 1e9;
+				aDist[j] = 1e9;
 				continue;
 			}
 			// copypasted chunk from character.cpp Snap() follows
-			CCharacter *SnapChar = GameServer()->GetPlayerChar(i);
 			if(SnapChar && !SnapChar->m_Super &&
 				!GameServer()->m_apPlayers[i]->IsPaused() && GameServer()->m_apPlayers[i]->GetTeam() != TEAM_SPECTATORS &&
 				!ch->CanCollide(i) &&
-				(!GameServer()->m_apPlayers[i] ||
-					GameServer()->m_apPlayers[i]->GetClientVersion() == VERSION_VANILLA ||
+				(GameServer()->m_apPlayers[i]->GetClientVersion() == VERSION_VANILLA ||
 					(GameServer()->m_apPlayers[i]->GetClientVersion() >= VERSION_DDRACE &&
 						(GameServer()->m_apPlayers[i]->m_ShowOthers == SHOW_OTHERS_OFF))))
-				Dist[j].first = 1e8;
+				aDist[j] = 1e8;
 			else
-				Dist[j].first = 0;
+				aDist[j] = 0;
 
-			Dist[j].first += distance(GameServer()->m_apPlayers[i]->m_ViewPos, GameServer()->m_apPlayers[j]->GetCharacter()->m_Pos);
+			aDist[j] += distance(GameServer()->m_apPlayers[i]->m_ViewPos, ch->m_Pos);
 		}
 
 		// always send the player themselves
-		Dist[i].first = 0;
+		aDist[i] = 0;
+
+		// the map is a function of the distances and the previous map, if
+		// neither changed since an update that kept the map, this one keeps it too
+		CPlayerMapState &State = m_aPlayerMapStates[i];
+		if(State.m_Unchanged && mem_comp(State.m_aDist, aDist, sizeof(aDist)) == 0 && mem_comp(State.m_aMap, pMap, sizeof(State.m_aMap)) == 0)
+			continue;
+		mem_copy(State.m_aDist, aDist, sizeof(aDist));
+		int aPrevMap[VANILLA_MAX_CLIENTS];
+		mem_copy(aPrevMap, pMap, sizeof(aPrevMap));
+
+		for(int j = 0; j < MAX_CLIENTS; j++)
+		{
+			Dist[j].first = aDist[j];
+			Dist[j].second = j;
+		}
 
 		// compute reverse map
 		int rMap[MAX_CLIENTS];
@@ -254,6 +278,9 @@ void CGameWorld::UpdatePlayerMaps()
 				pMap[rMap[k]] = -1;
 		}
 		pMap[VANILLA_MAX_CLIENTS - 1] = -1; // player with empty name to say chat msgs
+
+		State.m_Unchanged = mem_comp(aPrevMap, pMap, sizeof(aPrevMap)) == 0;
+		mem_copy(State.m_aMap, pMap, sizeof(State.m_aMap));
 	}
 }
 
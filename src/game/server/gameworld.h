@@ -39,6 +39,15 @@ private:
 	class CConfig *m_pConfig;
 	class IServer *m_pServer;
 
+	// inputs and result of the last id map update of a viewer
+	struct CPlayerMapState
+	{
+		bool m_Unchanged; // the last update left the map as it was
+		float m_aDist[MAX_CLIENTS];
+		int m_aMap[VANILLA_MAX_CLIENTS];
+	};
+	CPlayerMapState m_aPlayerMapStates[MAX_CLIENTS];
+
 	void UpdatePlayerMaps();
 
 public:
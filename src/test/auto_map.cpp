@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/console.h>
+#include <engine/engine.h>
+#include <engine/shared/config.h>
+#include <engine/storage.h>
+#include <game/editor/auto_map.h>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+class CAutoMapperTest : public ::testing::Test
+{
+protected:
+	std::unique_ptr<IStorage> m_pStorage;
+	std::unique_ptr<IConsole> m_pConsole;
+	std::unique_ptr<IEngine> m_pEngine;
+	std::mt19937 m_Rng;
+
+	CAutoMapperTest()
+	{
+		m_pStorage = std::unique_ptr<IStorage>(CreateTempStorage("data"));
+		m_pConsole = std::unique_ptr<IConsole>(CreateConsole(CFGFLAG_CLIENT));
+		m_pEngine = std::unique_ptr<IEngine>(CreateTestEngine("Toutuo", 4));
+	}
+
+	static int ListRules(const char *pName, int IsDir, int StorageType, void *pUser)
+	{
+		std::vector<std::string> *pvNames = (std::vector<std::string> *)pUser;
+		const char *pEnd = str_endswith(pName, ".rules");
+		if(!IsDir && pEnd)
+			pvNames->emplace_back(pName, pEnd - pName);
+		return 0;
+	}
+
+	std::vector<std::string> RulesFiles()
+	{
+		std::vector<std::string> vNames;
+		m_pStorage->ListDirectory(IStorage::TYPE_ALL, "editor", ListRules, &vNames);
+		return vNames;
+	}
+
+	// runs that read their own writes depend on tiles outside of the commit region
+	static bool ReadsOwnWrites(const CAutoMapper &Mapper, int ConfigID)
+	{
+		for(const auto &Run : Mapper.m_vConfigs[ConfigID].m_vRuns)
+		{
+			if(!Run.m_AutomapCopy)
+				return true;
+		}
+		return false;
+	}
+
+	// the tiles whose rules read the edited ones, like in ProceedLocalized
+	static bool InCommitRegion(const CAutoMapper &Mapper, int ConfigID, int X, int Y, int Width, int Height, int TileX, int TileY)
+	{
+		const auto &Conf = Mapper.m_vConfigs[ConfigID];
+		return TileX >= X - Conf.m_EndX && TileX < X + Width - Conf.m_StartX &&
+		       TileY >= Y - Conf.m_EndY && TileY < Y + Height - Conf.m_StartY;
+	}
+
+	// blobs of solid tiles with some random indices and flags
+	std::vector<CTile> RandomLayer(int Width, int Height)
+	{
+		std::vector<CTile> vTiles(Width * Height);
+		for(int y = 0; y < Height; y++)
+		{
+			for(int x = 0; x < Width; x++)
+			{
+				CTile &Tile = vTiles[y * Width + x];
+				mem_zero(&Tile, sizeof(Tile));
+				Tile.m_Index = (y / 7 + x / 5 + m_Rng() % 3) % 3 ? 1 : 0;
+				if(m_Rng() % 13 == 0)
+					Tile.m_Index = m_Rng() % 256;
+				if(m_Rng() % 16 == 0)
+					Tile.m_Flags = m_Rng() % 16;
+			}
+		}
+		return vTiles;
+	}
+
+	static bool SameTile(const CTile &Tile1, const CTile &Tile2)
+	{
+		return Tile1.m_Index == Tile2.m_Index && Tile1.m_Flags == Tile2.m_Flags;
+	}
+};
+
+TEST_F(CAutoMapperTest, JobPoolMatchesSerial)
+{
+	const std::vector<std::string> vFiles = RulesFiles();
+	ASSERT_FALSE(vFiles.empty());
+	for(const auto &File : vFiles)
+	{
+		CAutoMapper Parallel(m_pStorage.get(), m_pConsole.get(), m_pEngine.get());
+		CAutoMapper Serial(m_pStorage.get(), m_pConsole.get(), nullptr);
+		Parallel.Load(File.c_str());
+		Serial.Load(File.c_str());
+		ASSERT_TRUE(Parallel.IsLoaded()) << File;
+		ASSERT_TRUE(Serial.IsLoaded()) << File;
+
+		for(int Config = 0; Config < Parallel.ConfigNamesNum(); Config++)
+		{
+			// several bands
+			const int Width = 20 + m_Rng() % 150;
+			const int Height = 100 + m_Rng() % 150;
+			const int Seed = 1 + m_Rng() % 100000;
+			std::vector<CTile> vParallel = RandomLayer(Width, Height);
+			std::vector<CTile> vSerial = vParallel;
+			Parallel.Proceed(vParallel.data(), Width, Height, Config, Seed);
+			Serial.Proceed(vSerial.data(), Width, Height, Config, Seed);
+
+			int NumDifferent = 0;
+			for(int i = 0; i < Width * Height; i++)
+				NumDifferent += !SameTile(vParallel[i], vSerial[i]);
+			EXPECT_EQ(NumDifferent, 0) << File << " " << Parallel.GetConfigName(Config);
+		}
+	}
+}
+
+TEST_F(CAutoMapperTest, LocalizedMatchesFull)
+{
+	const std::vector<std::string> vFiles = RulesFiles();
+	ASSERT_FALSE(vFiles.empty());
+	for(const auto &File : vFiles)
+	{
+		CAutoMapper Mapper(m_pStorage.get(), m_pConsole.get(), m_pEngine.get());
+		Mapper.Load(File.c_str());
+		ASSERT_TRUE(Mapper.IsLoaded()) << File;
+
+		for(int Config = 0; Config < Mapper.ConfigNamesNum(); Config++)
+		{
+			const int Width = 20 + m_Rng() % 100;
+			const int Height = 20 + m_Rng() % 100;
+			const int Seed = 1 + m_Rng() % 100000;
+			std::vector<CTile> vTiles = RandomLayer(Width, Height);
+			Mapper.Proceed(vTiles.data(), Width, Height, Config, Seed);
+
+			for(int Edit = 0; Edit < 4; Edit++)
+			{
+				const int X = m_Rng() % Width;
+				const int Y = m_Rng() % Height;
+				const int EditWidth = 1 + m_Rng() % 4;
+				const int EditHeight = 1 + m_Rng() % 4;
+				for(int y = Y; y < minimum(Y + EditHeight, Height); y++)
+				{
+					for(int x = X; x < minimum(X + EditWidth, Width); x++)
+						vTiles[y * Width + x].m_Index = m_Rng() % 3 ? 0 : (m_Rng() % 2 ? 1 : m_Rng() % 256);
+				}
+
+				const std::vector<CTile> vEdited = vTiles;
+				std::vector<CTile> vFull = vTiles;
+				Mapper.Proceed(vFull.data(), Width, Height, Config, Seed);
+				Mapper.ProceedLocalized(vTiles.data(), Width, Height, Config, Seed, X, Y, EditWidth, EditHeight);
+
+				// outside of the commit region nothing changes, inside it is only
+				// exact if every run reads from a copy of the layer
+				const bool CheckInside = !ReadsOwnWrites(Mapper, Config);
+				int NumWrong = 0;
+				for(int y = 0; y < Height; y++)
+				{
+					for(int x = 0; x < Width; x++)
+					{
+						const int i = y * Width + x;
+						if(!InCommitRegion(Mapper, Config, X, Y, EditWidth, EditHeight, x, y))
+							NumWrong += !SameTile(vTiles[i], vEdited[i]);
+						else if(CheckInside)
+							NumWrong += !SameTile(vTiles[i], vFull[i]);
+					}
+				}
+				EXPECT_EQ(NumWrong, 0) << File << " " << Mapper.GetConfigName(Config) << " edit " << Edit;
+			}
+		}
+	}
+}
@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
 
+#include <base/system.h>
 #include <engine/shared/compression.h>
+#include <game/prng.h>
+
+#include <vector>
 
 static const int DATA[] = {0, 1, -1, 32, 64, 256, -512, 12345, -123456, 1234567, 12345678, 123456789, 2147483647, (-2147483647 - 1)};
 static const int NUM = std::size(DATA);
@@ -82,3 +86,118 @@ TEST(CVariableInt, DecompressBufferTooSmall)
 	long CompressedSize = CVariableInt::Decompress(aCompressed, sizeof(aCompressed), aUncompressed, sizeof(aUncompressed));
 	ASSERT_EQ(CompressedSize, -1);
 }
+
+// mostly zeros and small values like a snapshot delta, with some of every packed size
+static int RandomDeltaInt(CPrng *pPrng)
+{
+	const unsigned Bits = pPrng->RandomBits();
+	switch(pPrng->RandomBits() % 8)
+	{
+	case 0:
+	case 1:
+	case 2: return 0;
+	case 3:
+	case 4: return (int)(Bits % 128) - 64;
+	case 5: return (int)(Bits % 20000) - 10000;
+	case 6: return (int)(Bits >> (Bits % 32));
+	default: return (int)Bits;
+	}
+}
+
+TEST(CVariableInt, FuzzCompressMatchesScalar)
+{
+	CPrng Prng;
+	uint64_t aSeed[2] = {1, 2};
+	Prng.Seed(aSeed);
+
+	for(int Round = 0; Round < 2000; Round++)
+	{
+		std::vector<int> vData(Prng.RandomBits() % 100);
+		for(int &Value : vData)
+			Value = RandomDeltaInt(&Prng);
+
+		const int SrcSize = vData.size() * sizeof(int);
+		const int DstSize = Round % 4 == 0 ? Prng.RandomBits() % (SrcSize + 1) : vData.size() * CVariableInt::MAX_BYTES_PACKED;
+		std::vector<unsigned char> vExpected(DstSize + 1), vActual(DstSize + 1);
+		const long ExpectedSize = CVariableInt::CompressScalar(vData.data(), SrcSize, vExpected.data(), DstSize);
+		const long ActualSize = CVariableInt::Compress(vData.data(), SrcSize, vActual.data(), DstSize);
+		ASSERT_EQ(ExpectedSize, ActualSize);
+		if(ExpectedSize >= 0)
+		{
+			ASSERT_EQ(mem_comp(vExpected.data(), vActual.data(), ExpectedSize), 0);
+
+			std::vector<int> vDecompressed(vData.size());
+			ASSERT_EQ(CVariableInt::Decompress(vActual.data(), ActualSize, vDecompressed.data(), SrcSize), SrcSize);
+			ASSERT_EQ(vDecompressed, vData);
+		}
+	}
+}
+
+TEST(CVariableInt, FuzzDecompressMatchesScalar)
+{
+	CPrng Prng;
+	uint64_t aSeed[2] = {3, 4};
+	Prng.Seed(aSeed);
+
+	for(int Round = 0; Round < 2000; Round++)
+	{
+		// random bytes, with the extend bit rare enough to hit the fast path
+		std::vector<unsigned char> vData(Prng.RandomBits() % 200);
+		const unsigned ExtendChance = 1 + Prng.RandomBits() % 64;
+		for(unsigned char &Byte : vData)
+		{
+			Byte = Prng.RandomBits() & 0x7F;
+			if(Prng.RandomBits() % ExtendChance == 0)
+				Byte |= 0x80;
+		}
+
+		const int DstSize = (Prng.RandomBits() % (vData.size() + 2)) * sizeof(int);
+		std::vector<int> vExpected(DstSize / sizeof(int) + 1), vActual(DstSize / sizeof(int) + 1);
+		const long ExpectedSize = CVariableInt::DecompressScalar(vData.data(), vData.size(), vExpected.data(), DstSize);
+		const long ActualSize = CVariableInt::Decompress(vData.data(), vData.size(), vActual.data(), DstSize);
+		ASSERT_EQ(ExpectedSize, ActualSize);
+		if(ExpectedSize >= 0)
+		{
+			ASSERT_EQ(mem_comp(vExpected.data(), vActual.data(), ExpectedSize), 0);
+		}
+	}
+}
+
+TEST(CVariableInt, DISABLED_BenchmarkCompress)
+{
+	CPrng Prng;
+	uint64_t aSeed[2] = {5, 6};
+	Prng.Seed(aSeed);
+
+	// deltas of moving characters: the position and velocity change, the rest of the item doesn't
+	std::vector<int> vData(22 * 64);
+	for(unsigned i = 0; i < vData.size(); i++)
+		vData[i] = i % 22 < 4 ? RandomDeltaInt(&Prng) : 0;
+	std::vector<unsigned char> vPacked(vData.size() * CVariableInt::MAX_BYTES_PACKED);
+	std::vector<int> vUnpacked(vData.size());
+	const int SrcSize = vData.size() * sizeof(int);
+
+	static const int ITERATIONS = 20000;
+	int64_t Start = time_get();
+	for(int i = 0; i < ITERATIONS; i++)
+		CVariableInt::CompressScalar(vData.data(), SrcSize, vPacked.data(), vPacked.size());
+	const int64_t CompressScalar = time_get() - Start;
+	Start = time_get();
+	long PackedSize = 0;
+	for(int i = 0; i < ITERATIONS; i++)
+		PackedSize = CVariableInt::Compress(vData.data(), SrcSize, vPacked.data(), vPacked.size());
+	const int64_t Compress = time_get() - Start;
+	Start = time_get();
+	for(int i = 0; i < ITERATIONS; i++)
+		CVariableInt::DecompressScalar(vPacked.data(), PackedSize, vUnpacked.data(), SrcSize);
+	const int64_t DecompressScalar = time_get() - Start;
+	Start = time_get();
+	for(int i = 0; i < ITERATIONS; i++)
+		CVariableInt::Decompress(vPacked.data(), PackedSize, vUnpacked.data(), SrcSize);
+	const int64_t Decompress = time_get() - Start;
+
+	const double Ms = 1000.0 / time_freq();
+	dbg_msg("benchmark", "compress: scalar %.2fms, vectorized %.2fms", CompressScalar * Ms, Compress * Ms);
+	dbg_msg("benchmark", "decompress: scalar %.2fms, vectorized %.2fms", DecompressScalar * Ms, Decompress * Ms);
+	EXPECT_EQ(vUnpacked, vData);
+}
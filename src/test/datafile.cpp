@@ -1,7 +1,11 @@
 #include "test.h"
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <memory>
+#include <string>
+#include <vector>
 
+#include <engine/engine.h>
 #include <engine/shared/datafile.h>
 #include <engine/storage.h>
 #include <game/mapitems_ex.h>
@@ -58,3 +62,301 @@ TEST(Datafile, ExtendedType)
 		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
 	}
 }
+
+TEST(Datafile, PreloadAndShareData)
+{
+	auto pStorage = std::unique_ptr<IStorage>(CreateLocalStorage());
+	auto pEngine = std::unique_ptr<IEngine>(CreateTestEngine("Toutuo", 4));
+	CTestInfo Info;
+
+	static const int NUM_DATA = 16;
+	std::vector<std::vector<int>> vvData(NUM_DATA);
+	{
+		CDataFileWriter Writer;
+		Writer.Open(pStorage.get(), Info.m_aFilename);
+		for(int i = 0; i < NUM_DATA; i++)
+		{
+			vvData[i].resize(1000 + i * 100);
+			for(unsigned j = 0; j < vvData[i].size(); j++)
+				vvData[i][j] = (i * 7 + j) % 13;
+			Writer.AddData(vvData[i].size() * sizeof(int), vvData[i].data());
+		}
+		Writer.Finish();
+	}
+
+	{
+		CDataFileReader aReaders[3];
+		ASSERT_TRUE(aReaders[0].Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL, true));
+		ASSERT_TRUE(aReaders[1].Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL, true));
+		ASSERT_TRUE(aReaders[2].Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL));
+		ASSERT_EQ(aReaders[0].NumData(), NUM_DATA);
+
+		std::vector<int> vIndices;
+		for(int i = 0; i < NUM_DATA; i++)
+			vIndices.push_back(i);
+		for(auto &Reader : aReaders)
+			Reader.PreloadData(pEngine.get(), vIndices);
+
+		for(int i = 0; i < NUM_DATA; i++)
+		{
+			for(auto &Reader : aReaders)
+			{
+				ASSERT_EQ(Reader.GetDataSize(i), (int)(vvData[i].size() * sizeof(int)));
+				ASSERT_TRUE(Reader.GetData(i));
+				EXPECT_EQ(mem_comp(Reader.GetData(i), vvData[i].data(), Reader.GetDataSize(i)), 0);
+			}
+			EXPECT_EQ(aReaders[0].GetData(i), aReaders[1].GetData(i));
+			EXPECT_NE(aReaders[0].GetData(i), aReaders[2].GetData(i));
+		}
+
+		// the other reader keeps its reference
+		aReaders[0].UnloadData(0);
+		EXPECT_EQ(mem_comp(aReaders[1].GetData(0), vvData[0].data(), aReaders[1].GetDataSize(0)), 0);
+		ASSERT_TRUE(aReaders[0].GetData(0));
+		EXPECT_EQ(aReaders[0].GetData(0), aReaders[1].GetData(0));
+	}
+
+	{
+		// closing while the jobs are still working
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL, true));
+		std::vector<int> vIndices;
+		for(int i = 0; i < NUM_DATA; i++)
+			vIndices.push_back(i);
+		Reader.PreloadData(pEngine.get(), vIndices);
+		Reader.Close();
+	}
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+}
+
+TEST(Datafile, FileReplacedWhileOpen)
+{
+	auto pStorage = std::unique_ptr<IStorage>(CreateLocalStorage());
+	CTestInfo Info;
+
+	static const int NUM_DATA = 8;
+	std::vector<std::vector<int>> vvData(NUM_DATA);
+	CMapItemTest ItemTest = {};
+	ItemTest.m_Version = CMapItemTest::CURRENT_VERSION;
+	ItemTest.m_Field3 = 1234;
+	{
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(pStorage.get(), Info.m_aFilename));
+		Writer.AddItem(MAPITEMTYPE_TEST, 0x8000, sizeof(ItemTest), &ItemTest);
+		for(int i = 0; i < NUM_DATA; i++)
+		{
+			vvData[i].resize(2000 + i * 100);
+			for(unsigned j = 0; j < vvData[i].size(); j++)
+				vvData[i][j] = (i * 11 + j) % 17;
+			Writer.AddData(vvData[i].size() * sizeof(int), vvData[i].data());
+		}
+		Writer.Finish();
+	}
+
+	{
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL));
+		ASSERT_TRUE(Reader.GetData(0));
+
+		// the map is rewritten with a shorter file, e.g. while the server reloads it
+		IOHANDLE File = pStorage->OpenFile(Info.m_aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		ASSERT_TRUE(File);
+		const char aGarbage[] = "not a datafile anymore";
+		io_write(File, aGarbage, sizeof(aGarbage));
+		io_close(File);
+
+		const CMapItemTest *pTest = (const CMapItemTest *)Reader.FindItem(MAPITEMTYPE_TEST, 0x8000);
+		ASSERT_TRUE(pTest);
+		EXPECT_EQ(pTest->m_Field3, ItemTest.m_Field3);
+		ASSERT_EQ(Reader.NumData(), NUM_DATA);
+		for(int i = 0; i < NUM_DATA; i++)
+		{
+			ASSERT_EQ(Reader.GetDataSize(i), (int)(vvData[i].size() * sizeof(int)));
+			ASSERT_TRUE(Reader.GetData(i));
+			EXPECT_EQ(mem_comp(Reader.GetData(i), vvData[i].data(), Reader.GetDataSize(i)), 0);
+		}
+	}
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+}
+
+TEST(Datafile, OpenFromMemory)
+{
+	auto pStorage = std::unique_ptr<IStorage>(CreateLocalStorage());
+	CTestInfo Info;
+
+	CMapItemTest ItemTest = {};
+	ItemTest.m_Version = CMapItemTest::CURRENT_VERSION;
+	ItemTest.m_Field3 = 4321;
+	std::vector<int> vData(3000);
+	for(unsigned i = 0; i < vData.size(); i++)
+		vData[i] = (i * 5) % 23;
+	{
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(pStorage.get(), Info.m_aFilename));
+		Writer.AddItem(MAPITEMTYPE_TEST, 0x8000, sizeof(ItemTest), &ItemTest);
+		Writer.AddData(vData.size() * sizeof(int), vData.data());
+		Writer.Finish();
+	}
+
+	void *pFileData;
+	unsigned FileSize;
+	ASSERT_TRUE(pStorage->ReadFile(Info.m_aFilename, IStorage::TYPE_ALL, &pFileData, &FileSize));
+
+	{
+		CDataFileReader FileReader;
+		CDataFileReader MemoryReader;
+		ASSERT_TRUE(FileReader.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL));
+		ASSERT_TRUE(MemoryReader.Open(Info.m_aFilename, pFileData, FileSize));
+
+		// the reader has its own copy of the buffer
+		mem_zero(pFileData, FileSize);
+		EXPECT_EQ(MemoryReader.Sha256(), FileReader.Sha256());
+		EXPECT_EQ(MemoryReader.Crc(), FileReader.Crc());
+		EXPECT_EQ(MemoryReader.MapSize(), FileReader.MapSize());
+		EXPECT_FALSE(MemoryReader.File());
+
+		const CMapItemTest *pTest = (const CMapItemTest *)MemoryReader.FindItem(MAPITEMTYPE_TEST, 0x8000);
+		ASSERT_TRUE(pTest);
+		EXPECT_EQ(pTest->m_Field3, ItemTest.m_Field3);
+		ASSERT_EQ(MemoryReader.NumData(), 1);
+		ASSERT_EQ(MemoryReader.GetDataSize(0), (int)(vData.size() * sizeof(int)));
+		EXPECT_EQ(mem_comp(MemoryReader.GetData(0), vData.data(), MemoryReader.GetDataSize(0)), 0);
+	}
+	free(pFileData);
+
+	{
+		CDataFileReader Reader;
+		const char aGarbage[] = "not a datafile";
+		EXPECT_FALSE(Reader.Open("garbage", aGarbage, sizeof(aGarbage)));
+		EXPECT_FALSE(Reader.IsOpen());
+	}
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+}
+
+static int CollectMap(const char *pName, int IsDir, int DirType, void *pUser)
+{
+	if(!IsDir && str_endswith(pName, ".map"))
+		static_cast<std::vector<std::string> *>(pUser)->push_back(std::string("data/maps/") + pName);
+	return 0;
+}
+
+TEST(Datafile, ParallelCompressionIsDeterministic)
+{
+	auto pStorage = std::unique_ptr<IStorage>(CreateLocalStorage());
+	CTestInfo Info;
+
+	static const int NUM_DATA = 32;
+	std::vector<std::vector<int>> vvData(NUM_DATA);
+	for(int i = 0; i < NUM_DATA; i++)
+	{
+		vvData[i].resize(500 + i * 250);
+		for(unsigned j = 0; j < vvData[i].size(); j++)
+			vvData[i][j] = (i * 31 + j * j) % 97;
+	}
+
+	const int aThreads[] = {1, 4};
+	char aaFilenames[2][IO_MAX_PATH_LENGTH];
+	std::vector<std::string> vFiles;
+	for(int t = 0; t < 2; t++)
+	{
+		str_format(aaFilenames[t], sizeof(aaFilenames[t]), "%s.%d", Info.m_aFilename, aThreads[t]);
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(pStorage.get(), aaFilenames[t]));
+		Writer.SetCompressionThreads(aThreads[t]);
+		for(int i = 0; i < NUM_DATA; i++)
+		{
+			// the writer copies the data, the buffer may change right after
+			std::vector<int> vCopy = vvData[i];
+			Writer.AddData(vCopy.size() * sizeof(int), vCopy.data(), i % 2 ? Z_BEST_COMPRESSION : Z_DEFAULT_COMPRESSION);
+			std::fill(vCopy.begin(), vCopy.end(), -1);
+		}
+		Writer.Finish();
+
+		IOHANDLE File = pStorage->OpenFile(aaFilenames[t], IOFLAG_READ, IStorage::TYPE_SAVE);
+		ASSERT_TRUE(File);
+		void *pData;
+		unsigned Size;
+		io_read_all(File, &pData, &Size);
+		io_close(File);
+		vFiles.emplace_back((const char *)pData, Size);
+		free(pData);
+	}
+	EXPECT_EQ(vFiles[0], vFiles[1]);
+
+	{
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage.get(), aaFilenames[1], IStorage::TYPE_ALL));
+		ASSERT_EQ(Reader.NumData(), NUM_DATA);
+		for(int i = 0; i < NUM_DATA; i++)
+		{
+			ASSERT_EQ(Reader.GetDataSize(i), (int)(vvData[i].size() * sizeof(int)));
+			EXPECT_EQ(mem_comp(Reader.GetData(i), vvData[i].data(), Reader.GetDataSize(i)), 0);
+		}
+	}
+
+	if(!HasFailure())
+	{
+		for(auto &aFilename : aaFilenames)
+			pStorage->RemoveFile(aFilename, IStorage::TYPE_SAVE);
+	}
+}
+
+TEST(Datafile, DISABLED_BenchmarkLoadMaps)
+{
+	auto pStorage = std::unique_ptr<IStorage>(CreateLocalStorage());
+	auto pEngine = std::unique_ptr<IEngine>(CreateTestEngine("Toutuo", 4));
+	std::vector<std::string> vMaps;
+	pStorage->ListDirectory(IStorage::TYPE_ALL, "data/maps", CollectMap, &vMaps);
+	ASSERT_FALSE(vMaps.empty());
+
+	// every map is used by several worlds
+	static const int WORLDS_PER_MAP = 3;
+	int64_t Bytes = 0;
+	int64_t aTimes[2];
+	for(int Preload = 0; Preload < 2; Preload++)
+	{
+		const int64_t Start = time_get();
+		std::vector<std::unique_ptr<CDataFileReader>> vpReaders;
+		for(int w = 0; w < WORLDS_PER_MAP; w++)
+		{
+			for(const auto &Map : vMaps)
+			{
+				vpReaders.push_back(std::make_unique<CDataFileReader>());
+				ASSERT_TRUE(vpReaders.back()->Open(pStorage.get(), Map.c_str(), IStorage::TYPE_ALL, Preload));
+				if(Preload)
+				{
+					std::vector<int> vIndices;
+					for(int i = 0; i < vpReaders.back()->NumData(); i++)
+						vIndices.push_back(i);
+					vpReaders.back()->PreloadData(pEngine.get(), vIndices);
+				}
+			}
+		}
+		for(auto &pReader : vpReaders)
+		{
+			for(int i = 0; i < pReader->NumData(); i++)
+			{
+				pReader->GetData(i);
+				if(!Preload)
+					Bytes += pReader->GetDataSize(i);
+			}
+		}
+		aTimes[Preload] = time_get() - Start;
+	}
+
+	const double Ms = 1000.0 / time_freq();
+	dbg_msg("benchmark", "%d maps, %d worlds each, %.1f MiB of data", (int)vMaps.size(), WORLDS_PER_MAP, Bytes / (1024.0 * 1024.0));
+	dbg_msg("benchmark", "load all data: serial %.2fms, preloaded and shared %.2fms", aTimes[0] * Ms, aTimes[1] * Ms);
+}
@@ -0,0 +1,208 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/engine.h>
+#include <engine/shared/demo.h>
+#include <engine/shared/network.h>
+#include <engine/shared/snapshot.h>
+#include <engine/storage.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+static const int NUM_TICKS = SERVER_TICK_SPEED * 60;
+
+// a minute of a few moving items with messages in between and a gap in the ticks
+static void RecordDemo(IStorage *pStorage, CSnapshotDelta *pSnapshotDelta, const char *pFilename)
+{
+	CDemoRecorder Recorder(pSnapshotDelta);
+	unsigned char aMapData[4] = {1, 2, 3, 4};
+	SHA256_DIGEST Sha256 = sha256(aMapData, sizeof(aMapData));
+	ASSERT_EQ(Recorder.Start(pStorage, nullptr, pFilename, "0.6 626fce9a778df4d4", "arena", &Sha256, 0, "client", sizeof(aMapData), aMapData), 0);
+
+	static char s_aSnapshot[CSnapshot::MAX_SIZE];
+	CSnapshotBuilder Builder;
+	for(int Tick = 100; Tick < 100 + NUM_TICKS; Tick++)
+	{
+		if(Tick > 1000 && Tick < 1040)
+			continue;
+
+		Builder.Init();
+		for(int i = 0; i < 16; i++)
+		{
+			// items come and go
+			if((Tick / 50 + i) % 7 == 0)
+				continue;
+			int *pItem = (int *)Builder.NewItem(1 + i % 3, i, 4 * sizeof(int));
+			pItem[0] = Tick * (i + 1);
+			pItem[1] = i * 32;
+			pItem[2] = (Tick / 10) % 5;
+			pItem[3] = i;
+		}
+		const int Size = Builder.Finish(s_aSnapshot);
+		Recorder.RecordSnapshot(Tick, s_aSnapshot, Size);
+
+		if(Tick % 17 == 0)
+		{
+			char aMessage[32];
+			str_format(aMessage, sizeof(aMessage), "message %d", Tick);
+			Recorder.RecordMessage(aMessage, str_length(aMessage) + 1);
+		}
+	}
+	Recorder.Stop();
+}
+
+class CPlaybackLog : public CDemoPlayer::IListener
+{
+public:
+	const CDemoPlayer *m_pPlayer = nullptr;
+	std::vector<std::string> m_vEvents;
+
+	void Add(const char *pType, const void *pData, int Size)
+	{
+		char aBuf[64];
+		str_format(aBuf, sizeof(aBuf), "%s %d %d:", pType, m_pPlayer->Info()->m_Info.m_CurrentTick, Size);
+		std::string Event = aBuf;
+		Event.append((const char *)pData, Size);
+		m_vEvents.push_back(Event);
+	}
+
+	void OnDemoPlayerSnapshot(void *pData, int Size) override { Add("snapshot", pData, Size); }
+	void OnDemoPlayerMessage(void *pData, int Size) override { Add("message", pData, Size); }
+};
+
+TEST(Demo, IndexedSeekMatchesKeyframeSeek)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	auto pStorage = std::unique_ptr<IStorage>(Info.CreateTestStorage());
+	ASSERT_TRUE(pStorage);
+	auto pEngine = std::unique_ptr<IEngine>(CreateTestEngine("Toutuo", 2));
+	CNetBase::Init();
+	CSnapshotDelta SnapshotDelta;
+	RecordDemo(pStorage.get(), &SnapshotDelta, "test.demo");
+
+	CPlaybackLog ScannedLog, IndexedLog;
+	CDemoPlayer Scanned(&SnapshotDelta);
+	CDemoPlayer Indexed(&SnapshotDelta);
+	ScannedLog.m_pPlayer = &Scanned;
+	IndexedLog.m_pPlayer = &Indexed;
+	Scanned.SetListener(&ScannedLog);
+	Indexed.SetListener(&IndexedLog);
+	ASSERT_EQ(Scanned.Load(pStorage.get(), nullptr, "test.demo", IStorage::TYPE_SAVE), 0);
+
+	// the first playback with an engine builds the index in the background
+	{
+		CDemoPlayer Player(&SnapshotDelta);
+		ASSERT_EQ(Player.Load(pStorage.get(), nullptr, "test.demo", IStorage::TYPE_SAVE, pEngine.get()), 0);
+		const int64_t Deadline = time_get() + 30 * time_freq();
+		while(!Player.IsIndexed() && time_get() < Deadline)
+			thread_yield();
+		ASSERT_TRUE(Player.IsIndexed());
+		Player.Stop();
+	}
+
+	ASSERT_EQ(Indexed.Load(pStorage.get(), nullptr, "test.demo", IStorage::TYPE_SAVE), 0);
+	EXPECT_FALSE(Scanned.IsIndexed());
+	ASSERT_TRUE(Indexed.IsIndexed());
+	EXPECT_EQ(Scanned.Info()->m_Info.m_FirstTick, Indexed.Info()->m_Info.m_FirstTick);
+	EXPECT_EQ(Scanned.Info()->m_Info.m_LastTick, Indexed.Info()->m_Info.m_LastTick);
+	EXPECT_GT(Indexed.Info()->m_SeekablePoints, Scanned.Info()->m_SeekablePoints);
+
+	Scanned.Play();
+	Indexed.Play();
+	const int aWantedTicks[] = {2000, 130, 1020, 1041, 2999, 777, 250, 1500, 3100};
+	for(int WantedTick : aWantedTicks)
+	{
+		ScannedLog.m_vEvents.clear();
+		IndexedLog.m_vEvents.clear();
+		Scanned.SetPos(WantedTick);
+		Indexed.SetPos(WantedTick);
+		EXPECT_EQ(Scanned.Info()->m_PreviousTick, Indexed.Info()->m_PreviousTick) << WantedTick;
+		EXPECT_EQ(Scanned.Info()->m_Info.m_CurrentTick, Indexed.Info()->m_Info.m_CurrentTick) << WantedTick;
+		EXPECT_EQ(Scanned.Info()->m_NextTick, Indexed.Info()->m_NextTick) << WantedTick;
+
+		// the index replays fewer ticks, the stored snapshot comes first
+		ASSERT_FALSE(IndexedLog.m_vEvents.empty());
+		ASSERT_LE(IndexedLog.m_vEvents.size(), ScannedLog.m_vEvents.size());
+		for(size_t i = 1; i < IndexedLog.m_vEvents.size(); i++)
+			EXPECT_EQ(IndexedLog.m_vEvents[i], ScannedLog.m_vEvents[ScannedLog.m_vEvents.size() - IndexedLog.m_vEvents.size() + i]) << WantedTick;
+
+		// both continue the same way until the end of the demo
+		ScannedLog.m_vEvents.clear();
+		IndexedLog.m_vEvents.clear();
+		Scanned.Update(false);
+		Indexed.Update(false);
+		EXPECT_FALSE(ScannedLog.m_vEvents.empty());
+		EXPECT_TRUE(ScannedLog.m_vEvents == IndexedLog.m_vEvents) << WantedTick;
+		Scanned.Unpause();
+		Indexed.Unpause();
+	}
+	Scanned.Stop();
+	Indexed.Stop();
+}
+
+static bool FileExists(IStorage *pStorage, const char *pFilename)
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_SAVE);
+	if(File)
+		io_close(File);
+	return File != 0;
+}
+
+TEST(Demo, PruneIndexDirectory)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	auto pStorage = std::unique_ptr<IStorage>(Info.CreateTestStorage());
+	ASSERT_TRUE(pStorage);
+	ASSERT_TRUE(pStorage->CreateFolder("demoindex", IStorage::TYPE_SAVE));
+
+	char aData[1000] = {0};
+	char aFilename[IO_MAX_PATH_LENGTH];
+	for(int i = 0; i < 6; i++)
+	{
+		str_format(aFilename, sizeof(aFilename), "demoindex/%08x.idx", i);
+		IOHANDLE File = pStorage->OpenFile(aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		ASSERT_TRUE(File);
+		io_write(File, aData, sizeof(aData));
+		io_close(File);
+	}
+	// unrelated files are left alone
+	IOHANDLE File = pStorage->OpenFile("demoindex/notes.txt", IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	io_write(File, aData, sizeof(aData));
+	io_close(File);
+
+	CDemoPlayer::PruneIndexDirectory(pStorage.get(), "demoindex/00000005.idx", 6000);
+	int Remaining = 0;
+	for(int i = 0; i < 6; i++)
+	{
+		str_format(aFilename, sizeof(aFilename), "demoindex/%08x.idx", i);
+		Remaining += FileExists(pStorage.get(), aFilename);
+	}
+	EXPECT_EQ(Remaining, 6);
+
+	CDemoPlayer::PruneIndexDirectory(pStorage.get(), "demoindex/00000005.idx", 2500);
+	Remaining = 0;
+	for(int i = 0; i < 6; i++)
+	{
+		str_format(aFilename, sizeof(aFilename), "demoindex/%08x.idx", i);
+		Remaining += FileExists(pStorage.get(), aFilename);
+	}
+	EXPECT_EQ(Remaining, 2);
+	EXPECT_TRUE(FileExists(pStorage.get(), "demoindex/00000005.idx"));
+	EXPECT_TRUE(FileExists(pStorage.get(), "demoindex/notes.txt"));
+
+	// the kept index stays even if it alone is too large
+	CDemoPlayer::PruneIndexDirectory(pStorage.get(), "demoindex/00000005.idx", 0);
+	EXPECT_TRUE(FileExists(pStorage.get(), "demoindex/00000005.idx"));
+	EXPECT_TRUE(FileExists(pStorage.get(), "demoindex/notes.txt"));
+	for(int i = 0; i < 5; i++)
+	{
+		str_format(aFilename, sizeof(aFilename), "demoindex/%08x.idx", i);
+		EXPECT_FALSE(FileExists(pStorage.get(), aFilename));
+	}
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <base/math.h>
+#include <base/system.h>
+#include <game/generated/protocol.h>
+#include <game/server/eventbuffer.h>
+
+#include <algorithm>
+#include <random>
+
+static CNetEvent_Common *CreateAt(CEventBuffer *pBuffer, int X, int Y)
+{
+	CNetEvent_Common *pEvent = (CNetEvent_Common *)pBuffer->Create(NETEVENTTYPE_EXPLOSION, sizeof(CNetEvent_Common), -1LL);
+	if(pEvent)
+	{
+		pEvent->m_X = X;
+		pEvent->m_Y = Y;
+	}
+	return pEvent;
+}
+
+TEST(EventBuffer, DropWhenFull)
+{
+	CEventBuffer Buffer;
+	for(int i = 0; i < CEventBuffer::MAX_EVENTS; i++)
+		ASSERT_TRUE(CreateAt(&Buffer, i, i));
+	EXPECT_EQ(Buffer.NumDropped(), 0);
+
+	EXPECT_FALSE(CreateAt(&Buffer, 0, 0));
+	EXPECT_FALSE(CreateAt(&Buffer, 0, 0));
+	EXPECT_EQ(Buffer.Num(), CEventBuffer::MAX_EVENTS);
+	EXPECT_EQ(Buffer.NumDropped(), 2);
+
+	Buffer.Clear();
+	EXPECT_EQ(Buffer.Num(), 0);
+	EXPECT_EQ(Buffer.NumDropped(), 0);
+	EXPECT_TRUE(CreateAt(&Buffer, 0, 0));
+}
+
+TEST(EventBuffer, DataStaysValid)
+{
+	CEventBuffer Buffer;
+	std::mt19937 Rng(1);
+	for(int Round = 0; Round < 3; Round++)
+	{
+		// mix small events with ones larger than a whole chunk
+		std::vector<int> vSizes;
+		for(int i = 0; i < 2000; i++)
+			vSizes.push_back(i % 500 == 7 ? CEventBuffer::CHUNK_SIZE * 2 + i : 8 + Rng() % 64);
+		for(int i = 0; i < (int)vSizes.size(); i++)
+		{
+			char *pData = (char *)Buffer.Create(i, vSizes[i], -1LL);
+			ASSERT_TRUE(pData);
+			mem_zero(pData, vSizes[i]);
+			pData[0] = (char)i;
+			pData[vSizes[i] - 1] = (char)(i + Round);
+		}
+		ASSERT_EQ(Buffer.Num(), (int)vSizes.size());
+		for(int i = 0; i < Buffer.Num(); i++)
+		{
+			const CEventBuffer::CEvent &Event = Buffer.Get(i);
+			EXPECT_EQ(Event.m_Type, i);
+			EXPECT_EQ(Event.m_Size, vSizes[i]);
+			EXPECT_EQ(Event.m_pData[0], (char)i);
+			EXPECT_EQ(Event.m_pData[vSizes[i] - 1], (char)(i + Round));
+		}
+		Buffer.Clear();
+	}
+}
+
+TEST(EventBuffer, QueryMatchesBruteForce)
+{
+	const int MapWidth = 300;
+	const int MapHeight = 200;
+	const int CellSize = 1 << CEventBuffer::CELL_SHIFT;
+	const float GridRight = (((MapWidth * 32) / CellSize) + 1) * CellSize - 1;
+	const float GridBottom = (((MapHeight * 32) / CellSize) + 1) * CellSize - 1;
+
+	CEventBuffer Buffer;
+	std::mt19937 Rng(2);
+	std::uniform_int_distribution<int> PosX(-1000, MapWidth * 32 + 1000);
+	std::uniform_int_distribution<int> PosY(-1000, MapHeight * 32 + 1000);
+	std::vector<vec2> vPos;
+	for(int i = 0; i < 3000; i++)
+	{
+		vPos.emplace_back(PosX(Rng), PosY(Rng));
+		CreateAt(&Buffer, vPos.back().x, vPos.back().y);
+	}
+
+	std::vector<int> vResult;
+	for(int q = 0; q < 200; q++)
+	{
+		// the index is rebuilt after events are added
+		if(q == 100)
+		{
+			for(int i = 0; i < 500; i++)
+			{
+				vPos.emplace_back(PosX(Rng), PosY(Rng));
+				CreateAt(&Buffer, vPos.back().x, vPos.back().y);
+			}
+		}
+
+		const vec2 Center(PosX(Rng), PosY(Rng));
+		const vec2 Distance(200 + Rng() % 1500, 200 + Rng() % 1000);
+		const vec2 Min = Center - Distance;
+		const vec2 Max = Center + Distance;
+		Buffer.Query(MapWidth, MapHeight, Min, Max, &vResult);
+
+		// creation order, no duplicates
+		EXPECT_TRUE(std::is_sorted(vResult.begin(), vResult.end()));
+		EXPECT_EQ(std::adjacent_find(vResult.begin(), vResult.end()), vResult.end());
+
+		std::vector<bool> vFound(vPos.size(), false);
+		for(int i : vResult)
+		{
+			ASSERT_GE(i, 0);
+			ASSERT_LT(i, (int)vPos.size());
+			vFound[i] = true;
+		}
+		for(int i = 0; i < (int)vPos.size(); i++)
+		{
+			const vec2 Pos = vPos[i];
+			const bool Inside = Pos.x >= Min.x && Pos.x <= Max.x && Pos.y >= Min.y && Pos.y <= Max.y;
+			if(Inside)
+			{
+				EXPECT_TRUE(vFound[i]) << "event " << i << " in view was culled";
+			}
+
+			// candidates come from the cells overlapping the view clamped to the
+			// grid only, the border cells also hold the events outside of the map
+			const bool InMap = Pos.x >= 0 && Pos.y >= 0 && Pos.x < MapWidth * 32 && Pos.y < MapHeight * 32;
+			const vec2 ClampedMin(clamp(Min.x, 0.0f, GridRight), clamp(Min.y, 0.0f, GridBottom));
+			const vec2 ClampedMax(clamp(Max.x, 0.0f, GridRight), clamp(Max.y, 0.0f, GridBottom));
+			const bool NearView = Pos.x >= ClampedMin.x - CellSize - 1 && Pos.x <= ClampedMax.x + CellSize + 1 && Pos.y >= ClampedMin.y - CellSize - 1 && Pos.y <= ClampedMax.y + CellSize + 1;
+			if(vFound[i] && InMap)
+			{
+				EXPECT_TRUE(NearView) << "event " << i << " far outside of the view";
+			}
+		}
+	}
+
+	// a view covering the whole map sees everything
+	Buffer.Query(MapWidth, MapHeight, vec2(-2000, -2000), vec2(MapWidth * 32 + 2000, MapHeight * 32 + 2000), &vResult);
+	EXPECT_EQ(vResult.size(), vPos.size());
+
+	Buffer.Clear();
+	Buffer.Query(MapWidth, MapHeight, vec2(-2000, -2000), vec2(MapWidth * 32 + 2000, MapHeight * 32 + 2000), &vResult);
+	EXPECT_TRUE(vResult.empty());
+}
@@ -0,0 +1,247 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/kernel.h>
+#include <engine/map.h>
+#include <engine/shared/datafile.h>
+#include <engine/storage.h>
+#include <game/collision.h>
+#include <game/gamecore.h>
+#include <game/layers.h>
+#include <game/mapitems.h>
+#include <game/teamscore.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+static const int ARENA_WIDTH = 64;
+static const int ARENA_HEIGHT = 40;
+static const int NUM_CHARACTERS = 32;
+
+class CArena
+{
+public:
+	CTestInfo m_Info;
+	std::unique_ptr<IStorage> m_pStorage;
+	std::unique_ptr<IKernel> m_pKernel;
+	std::unique_ptr<IEngineMap> m_pMap;
+	CLayers m_Layers;
+	CCollision m_Collision;
+
+	// solid borders, a few platforms and a nohook ceiling
+	bool Create()
+	{
+		m_pStorage = std::unique_ptr<IStorage>(m_Info.CreateTestStorage());
+		if(!m_pStorage)
+			return false;
+
+		std::vector<CTile> vTiles(ARENA_WIDTH * ARENA_HEIGHT);
+		mem_zero(vTiles.data(), vTiles.size() * sizeof(CTile));
+		for(int y = 0; y < ARENA_HEIGHT; y++)
+		{
+			for(int x = 0; x < ARENA_WIDTH; x++)
+			{
+				unsigned char Index = TILE_AIR;
+				if(y == 0)
+					Index = TILE_NOHOOK;
+				else if(x == 0 || y == ARENA_HEIGHT - 1 || x == ARENA_WIDTH - 1)
+					Index = TILE_SOLID;
+				else if((y == 12 && x > 8 && x < 24) || (y == 20 && x > 36 && x < 56) || (y == 28 && x > 16 && x < 40))
+					Index = TILE_SOLID;
+				vTiles[y * ARENA_WIDTH + x].m_Index = Index;
+			}
+		}
+
+		{
+			CDataFileWriter Writer;
+			if(!Writer.Open(m_pStorage.get(), "arena.map"))
+				return false;
+
+			CMapItemGroup Group;
+			mem_zero(&Group, sizeof(Group));
+			Group.m_Version = CMapItemGroup::CURRENT_VERSION;
+			Group.m_ParallaxX = 100;
+			Group.m_ParallaxY = 100;
+			Group.m_StartLayer = 0;
+			Group.m_NumLayers = 1;
+			Writer.AddItem(MAPITEMTYPE_GROUP, 0, sizeof(Group), &Group);
+
+			CMapItemLayerTilemap Layer;
+			mem_zero(&Layer, sizeof(Layer));
+			Layer.m_Layer.m_Type = LAYERTYPE_TILES;
+			Layer.m_Version = 3;
+			Layer.m_Width = ARENA_WIDTH;
+			Layer.m_Height = ARENA_HEIGHT;
+			Layer.m_Flags = TILESLAYERFLAG_GAME;
+			Layer.m_Image = -1;
+			Layer.m_ColorEnv = -1;
+			Layer.m_Data = Writer.AddData(vTiles.size() * sizeof(CTile), vTiles.data());
+			Layer.m_Tele = -1;
+			Layer.m_Speedup = -1;
+			Layer.m_Front = -1;
+			Layer.m_Switch = -1;
+			Layer.m_Tune = -1;
+			Writer.AddItem(MAPITEMTYPE_LAYER, 0, sizeof(Layer), &Layer);
+
+			Writer.Finish();
+		}
+
+		m_pMap = std::unique_ptr<IEngineMap>(CreateEngineMap());
+		if(!m_pMap->Load(m_pStorage.get(), "arena.map"))
+			return false;
+		m_pKernel = std::unique_ptr<IKernel>(IKernel::Create());
+		m_pKernel->RegisterInterface(static_cast<IMap *>(m_pMap.get()), false);
+		m_Layers.Init(m_pKernel.get());
+		m_Collision.Init(&m_Layers);
+		return true;
+	}
+
+	~CArena()
+	{
+		if(m_pMap)
+			m_pMap->Unload();
+		m_Info.m_DeleteTestStorageFilesOnSuccess = !::testing::Test::HasFailure();
+	}
+};
+
+class CRecordedGame
+{
+public:
+	CWorldCore m_World;
+	CTeamsCore m_Teams;
+	CCharacterCore m_aCores[NUM_CHARACTERS];
+
+	CRecordedGame(CCollision *pCollision, bool BroadPhase)
+	{
+		m_World.m_BroadPhase = BroadPhase;
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+		{
+			CCharacterCore &Core = m_aCores[i];
+			Core.Init(&m_World, pCollision, &m_Teams);
+			Core.m_Id = i;
+			Core.m_Pos = vec2((4 + (i % 16) * 3) * 32.0f + 16.0f, (6 + (i / 16) * 16) * 32.0f + 16.0f);
+			m_World.m_apCharacters[i] = &Core;
+		}
+
+		// cover the filters of the partner loops
+		m_Teams.Team(20, 1);
+		m_Teams.Team(21, 1);
+		m_aCores[3].m_Solo = true;
+		m_aCores[5].m_NoCollision = true;
+		m_aCores[7].m_Super = true;
+		m_aCores[9].m_NoHookHit = true;
+	}
+
+	// one server tick: all cores tick, then all move
+	void Tick(const CNetObj_PlayerInput *pInputs)
+	{
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+		{
+			m_aCores[i].m_Input = pInputs[i];
+			m_aCores[i].Tick(true);
+		}
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+		{
+			m_aCores[i].Move();
+			m_aCores[i].Quantize();
+		}
+	}
+};
+
+static std::vector<CNetObj_PlayerInput> RecordInputs(int NumTicks)
+{
+	unsigned Seed = 0x5eed1234;
+	auto Random = [&Seed](int BelowThis) {
+		Seed = Seed * 1103515245 + 12345;
+		return (int)((Seed >> 16) % BelowThis);
+	};
+
+	std::vector<CNetObj_PlayerInput> vInputs(NumTicks * NUM_CHARACTERS);
+	CNetObj_PlayerInput aCurrent[NUM_CHARACTERS];
+	mem_zero(aCurrent, sizeof(aCurrent));
+	for(int Tick = 0; Tick < NumTicks; Tick++)
+	{
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+		{
+			CNetObj_PlayerInput &Input = aCurrent[i];
+			if(Random(8) == 0)
+				Input.m_Direction = Random(3) - 1;
+			if(Random(6) == 0)
+			{
+				// aim at another tee most of the time to get hooks on players
+				const int Target = Random(NUM_CHARACTERS);
+				Input.m_TargetX = (Target - i) * 16 + Random(64) - 32;
+				Input.m_TargetY = Random(256) - 128;
+				if(Input.m_TargetX == 0 && Input.m_TargetY == 0)
+					Input.m_TargetY = -1;
+			}
+			if(Random(10) == 0)
+				Input.m_Jump = !Input.m_Jump;
+			if(Random(12) == 0)
+				Input.m_Hook = !Input.m_Hook;
+			vInputs[Tick * NUM_CHARACTERS + i] = Input;
+		}
+	}
+	return vInputs;
+}
+
+TEST(GameCore, BroadPhaseIsBitExact)
+{
+	CArena Arena;
+	ASSERT_TRUE(Arena.Create());
+
+	const int NumTicks = 50 * 60;
+	const std::vector<CNetObj_PlayerInput> vInputs = RecordInputs(NumTicks);
+
+	CRecordedGame Reference(&Arena.m_Collision, false);
+	CRecordedGame BroadPhase(&Arena.m_Collision, true);
+
+	int PlayerHooks = 0;
+	for(int Tick = 0; Tick < NumTicks; Tick++)
+	{
+		Reference.Tick(&vInputs[Tick * NUM_CHARACTERS]);
+		BroadPhase.Tick(&vInputs[Tick * NUM_CHARACTERS]);
+
+		for(int i = 0; i < NUM_CHARACTERS; i++)
+		{
+			const CCharacterCore &Expected = Reference.m_aCores[i];
+			const CCharacterCore &Actual = BroadPhase.m_aCores[i];
+			ASSERT_EQ(mem_comp(&Expected.m_Pos, &Actual.m_Pos, sizeof(vec2)), 0) << "tick " << Tick << " character " << i;
+			ASSERT_EQ(mem_comp(&Expected.m_Vel, &Actual.m_Vel, sizeof(vec2)), 0) << "tick " << Tick << " character " << i;
+			ASSERT_EQ(mem_comp(&Expected.m_HookPos, &Actual.m_HookPos, sizeof(vec2)), 0) << "tick " << Tick << " character " << i;
+			ASSERT_EQ(Expected.m_HookState, Actual.m_HookState);
+			ASSERT_EQ(Expected.m_HookTick, Actual.m_HookTick);
+			ASSERT_EQ(Expected.m_HookedPlayer, Actual.m_HookedPlayer);
+			ASSERT_EQ(Expected.m_AttachedPlayers, Actual.m_AttachedPlayers);
+			ASSERT_EQ(Expected.m_Jumped, Actual.m_Jumped);
+			ASSERT_EQ(Expected.m_TriggeredEvents, Actual.m_TriggeredEvents);
+			ASSERT_EQ(Expected.m_Colliding, Actual.m_Colliding);
+			if(Actual.m_TriggeredEvents & COREEVENT_HOOK_ATTACH_PLAYER)
+				PlayerHooks++;
+		}
+	}
+
+	// the replay has to exercise the partner loops
+	EXPECT_GT(PlayerHooks, 0);
+}
+
+TEST(GameCore, DISABLED_BroadPhaseBenchmark)
+{
+	CArena Arena;
+	ASSERT_TRUE(Arena.Create());
+
+	const int NumTicks = 50 * 60 * 5;
+	const std::vector<CNetObj_PlayerInput> vInputs = RecordInputs(NumTicks);
+
+	for(int BroadPhase = 0; BroadPhase < 2; BroadPhase++)
+	{
+		CRecordedGame Game(&Arena.m_Collision, BroadPhase);
+		auto Start = std::chrono::steady_clock::now();
+		for(int Tick = 0; Tick < NumTicks; Tick++)
+			Game.Tick(&vInputs[Tick * NUM_CHARACTERS]);
+		auto Duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - Start);
+		dbg_msg("benchmark", "broad phase %s: %d ticks of %d characters in %lld us", BroadPhase ? "on" : "off", NumTicks, NUM_CHARACTERS, (long long)Duration.count());
+	}
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/huffman.h>
+#include <game/prng.h>
+
+#include <memory>
+#include <vector>
+
+class Huffman : public ::testing::Test
+{
+protected:
+	std::unique_ptr<CHuffman> m_pHuffman;
+	CPrng m_Prng;
+
+	Huffman() :
+		m_pHuffman(std::make_unique<CHuffman>())
+	{
+		m_pHuffman->Init();
+		uint64_t aSeed[2] = {11, 12};
+		m_Prng.Seed(aSeed);
+	}
+
+	// mostly zeros and low bytes, like the packed ints of game packets
+	std::vector<unsigned char> RandomPacket(int Size)
+	{
+		std::vector<unsigned char> vData(Size);
+		for(unsigned char &Byte : vData)
+		{
+			const unsigned Bits = m_Prng.RandomBits();
+			Byte = Bits % 3 == 0 ? 0 : Bits % 5 == 0 ? (Bits >> 8) : (Bits >> 8) % 16;
+		}
+		return vData;
+	}
+};
+
+TEST_F(Huffman, Roundtrip)
+{
+	for(int Size = 0; Size < 300; Size++)
+	{
+		std::vector<unsigned char> vData = RandomPacket(Size);
+		unsigned char aCompressed[2048];
+		unsigned char aDecompressed[2048];
+		const int CompressedSize = m_pHuffman->Compress(vData.data(), vData.size(), aCompressed, sizeof(aCompressed));
+		ASSERT_GT(CompressedSize, 0);
+		ASSERT_EQ(m_pHuffman->Decompress(aCompressed, CompressedSize, aDecompressed, sizeof(aDecompressed)), Size);
+		ASSERT_EQ(mem_comp(aDecompressed, vData.data(), Size), 0);
+	}
+}
+
+TEST_F(Huffman, FuzzCompressMatchesReference)
+{
+	for(int Round = 0; Round < 3000; Round++)
+	{
+		std::vector<unsigned char> vData = RandomPacket(m_Prng.RandomBits() % 400);
+		const int OutputSize = Round % 3 == 0 ? 1 + m_Prng.RandomBits() % (vData.size() + 1) : 2048;
+		std::vector<unsigned char> vExpected(OutputSize), vActual(OutputSize);
+		const int ExpectedSize = m_pHuffman->CompressReference(vData.data(), vData.size(), vExpected.data(), OutputSize);
+		const int ActualSize = m_pHuffman->Compress(vData.data(), vData.size(), vActual.data(), OutputSize);
+		ASSERT_EQ(ExpectedSize, ActualSize);
+		if(ExpectedSize > 0)
+		{
+			ASSERT_EQ(mem_comp(vExpected.data(), vActual.data(), ExpectedSize), 0);
+		}
+	}
+}
+
+TEST_F(Huffman, FuzzDecompressMatchesReference)
+{
+	for(int Round = 0; Round < 3000; Round++)
+	{
+		std::vector<unsigned char> vInput;
+		if(Round % 2)
+		{
+			// valid streams, cut short or followed by garbage
+			std::vector<unsigned char> vData = RandomPacket(m_Prng.RandomBits() % 400);
+			vInput.resize(2048);
+			const int Size = m_pHuffman->Compress(vData.data(), vData.size(), vInput.data(), vInput.size());
+			ASSERT_GT(Size, 0);
+			vInput.resize(Round % 4 == 1 ? m_Prng.RandomBits() % (Size + 1) : Size + m_Prng.RandomBits() % 16);
+		}
+		else
+		{
+			vInput.resize(m_Prng.RandomBits() % 100);
+			for(unsigned char &Byte : vInput)
+				Byte = m_Prng.RandomBits();
+		}
+
+		const int OutputSize = Round % 3 == 0 ? m_Prng.RandomBits() % 64 : 2048;
+		std::vector<unsigned char> vExpected(OutputSize), vActual(OutputSize);
+		const int ExpectedSize = m_pHuffman->DecompressReference(vInput.data(), vInput.size(), vExpected.data(), OutputSize);
+		const int ActualSize = m_pHuffman->Decompress(vInput.data(), vInput.size(), vActual.data(), OutputSize);
+		ASSERT_EQ(ExpectedSize, ActualSize);
+		if(ExpectedSize > 0)
+		{
+			ASSERT_EQ(mem_comp(vExpected.data(), vActual.data(), ExpectedSize), 0);
+		}
+	}
+}
+
+TEST_F(Huffman, LongCodes)
+{
+	// fibonacci frequencies give codes longer than the fast paths support
+	unsigned aFrequencies[256];
+	for(int i = 0; i < 256; i++)
+		aFrequencies[i] = i < 2 ? 1 : i < 40 ? aFrequencies[i - 1] + aFrequencies[i - 2] : 1;
+	m_pHuffman->Init(aFrequencies);
+
+	std::vector<unsigned char> vData(256);
+	for(int i = 0; i < 256; i++)
+		vData[i] = i;
+	unsigned char aCompressed[4096];
+	unsigned char aDecompressed[256];
+	const int CompressedSize = m_pHuffman->Compress(vData.data(), vData.size(), aCompressed, sizeof(aCompressed));
+	ASSERT_GT(CompressedSize, 0);
+	EXPECT_EQ(CompressedSize, m_pHuffman->CompressReference(vData.data(), vData.size(), aCompressed, sizeof(aCompressed)));
+	ASSERT_EQ(m_pHuffman->Decompress(aCompressed, CompressedSize, aDecompressed, sizeof(aDecompressed)), 256);
+	EXPECT_EQ(mem_comp(aDecompressed, vData.data(), vData.size()), 0);
+}
+
+TEST_F(Huffman, DISABLED_Benchmark)
+{
+	static const int NUM_PACKETS = 256;
+	static const int ITERATIONS = 200;
+	std::vector<std::vector<unsigned char>> vPackets;
+	std::vector<std::vector<unsigned char>> vCompressed;
+	int TotalSize = 0;
+	for(int i = 0; i < NUM_PACKETS; i++)
+	{
+		vPackets.push_back(RandomPacket(100 + m_Prng.RandomBits() % 1000));
+		TotalSize += vPackets.back().size();
+		std::vector<unsigned char> vOutput(2048);
+		vOutput.resize(m_pHuffman->Compress(vPackets.back().data(), vPackets.back().size(), vOutput.data(), vOutput.size()));
+		vCompressed.push_back(vOutput);
+	}
+
+	unsigned char aBuffer[2048];
+	int64_t aTimes[4] = {0};
+	for(int Pass = 0; Pass < 4; Pass++)
+	{
+		const int64_t Start = time_get();
+		for(int i = 0; i < ITERATIONS; i++)
+		{
+			for(int p = 0; p < NUM_PACKETS; p++)
+			{
+				if(Pass == 0)
+					m_pHuffman->CompressReference(vPackets[p].data(), vPackets[p].size(), aBuffer, sizeof(aBuffer));
+				else if(Pass == 1)
+					m_pHuffman->Compress(vPackets[p].data(), vPackets[p].size(), aBuffer, sizeof(aBuffer));
+				else if(Pass == 2)
+					m_pHuffman->DecompressReference(vCompressed[p].data(), vCompressed[p].size(), aBuffer, sizeof(aBuffer));
+				else
+					m_pHuffman->Decompress(vCompressed[p].data(), vCompressed[p].size(), aBuffer, sizeof(aBuffer));
+			}
+		}
+		aTimes[Pass] = time_get() - Start;
+	}
+
+	// throughput in uncompressed MB/s
+	const double Megabytes = (double)TotalSize * ITERATIONS / (1024 * 1024);
+	auto Throughput = [&](int64_t Time) { return Megabytes / ((double)Time / time_freq()); };
+	dbg_msg("benchmark", "huffman compress: reference %.1f MB/s, table %.1f MB/s", Throughput(aTimes[0]), Throughput(aTimes[1]));
+	dbg_msg("benchmark", "huffman decompress: reference %.1f MB/s, table %.1f MB/s", Throughput(aTimes[2]), Throughput(aTimes[3]));
+}
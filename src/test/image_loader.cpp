@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/engine.h>
+#include <engine/gfx/image_loader.h>
+#include <engine/gfx/image_manipulation.h>
+#include <engine/shared/jobs.h>
+#include <engine/storage.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+struct SPngFiles
+{
+	IStorage *m_pStorage;
+	std::string m_Path;
+	std::vector<std::string> *m_pvFiles;
+};
+
+static int CollectPngs(const char *pName, int IsDir, int DirType, void *pUser)
+{
+	SPngFiles *pFiles = static_cast<SPngFiles *>(pUser);
+	if(IsDir)
+	{
+		if(pName[0] == '.')
+			return 0;
+		SPngFiles Sub = {pFiles->m_pStorage, pFiles->m_Path + "/" + pName, pFiles->m_pvFiles};
+		pFiles->m_pStorage->ListDirectory(IStorage::TYPE_ALL, Sub.m_Path.c_str(), CollectPngs, &Sub);
+	}
+	else if(str_endswith(pName, ".png"))
+		pFiles->m_pvFiles->push_back(pFiles->m_Path + "/" + pName);
+	return 0;
+}
+
+// like the texture loading job of the graphics
+class CDecodePng : public IJob
+{
+	IStorage *m_pStorage;
+	std::string m_Filename;
+
+	void Run() override
+	{
+		uint8_t *pData;
+		EImageFormat Format;
+		if(LoadPNGAsRGBA(m_pStorage, m_Filename.c_str(), IStorage::TYPE_ALL, m_Width, m_Height, pData, Format))
+		{
+			m_vPixels.assign(pData, pData + (size_t)m_Width * m_Height * 4);
+			free(pData);
+			m_Success = true;
+		}
+	}
+
+public:
+	CDecodePng(IStorage *pStorage, const std::string &Filename) :
+		m_pStorage(pStorage), m_Filename(Filename) {}
+
+	bool m_Success = false;
+	int m_Width = 0;
+	int m_Height = 0;
+	std::vector<uint8_t> m_vPixels;
+};
+
+// the synchronous path: CGraphics_Threaded::LoadPNG, then the conversion of LoadTextureRaw
+static bool DecodeSerial(IStorage *pStorage, const std::string &Filename, int &Width, int &Height, std::vector<uint8_t> &vPixels)
+{
+	IOHANDLE File = pStorage->OpenFile(Filename.c_str(), IOFLAG_READ, IStorage::TYPE_ALL);
+	if(!File)
+		return false;
+	TImageByteBuffer ByteBuffer(io_length(File));
+	io_read(File, ByteBuffer.data(), ByteBuffer.size());
+	io_close(File);
+
+	SImageByteBuffer ImageByteBuffer(&ByteBuffer);
+	uint8_t *pImage = nullptr;
+	EImageFormat Format;
+	if(!LoadPNG(ImageByteBuffer, Filename.c_str(), Width, Height, pImage, Format))
+		return false;
+	if((Format != IMAGE_FORMAT_RGB && Format != IMAGE_FORMAT_RGBA) || Width <= 0 || Height <= 0)
+	{
+		free(pImage);
+		return false;
+	}
+	vPixels.resize((size_t)Width * Height * 4);
+	ConvertToRGBA(vPixels.data(), pImage, Width, Height, Format == IMAGE_FORMAT_RGBA ? 4 : 3);
+	free(pImage);
+	return true;
+}
+
+static std::vector<std::string> DataPngs(IStorage *pStorage)
+{
+	std::vector<std::string> vFiles;
+	SPngFiles Files = {pStorage, "data", &vFiles};
+	pStorage->ListDirectory(IStorage::TYPE_ALL, "data", CollectPngs, &Files);
+	return vFiles;
+}
+
+static std::vector<std::shared_ptr<CDecodePng>> DecodeAll(IStorage *pStorage, IEngine *pEngine, const std::vector<std::string> &vFiles)
+{
+	std::vector<std::shared_ptr<CDecodePng>> vpJobs;
+	for(const auto &File : vFiles)
+	{
+		vpJobs.push_back(std::make_shared<CDecodePng>(pStorage, File));
+		if(pEngine)
+			pEngine->AddJob(vpJobs.back());
+		else
+			CJobPool::RunBlocking(vpJobs.back().get());
+	}
+	for(auto &pJob : vpJobs)
+	{
+		while(pJob->Status() != IJob::STATE_DONE)
+			thread_yield();
+	}
+	return vpJobs;
+}
+
+TEST(ImageLoader, ConvertToRGBA)
+{
+	const uint8_t aAlpha[] = {0, 128, 255};
+	const uint8_t aRgb[] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+	const uint8_t aRgba[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+	uint8_t aResult[12];
+
+	EXPECT_FALSE(ConvertToRGBA(aResult, aAlpha, 3, 1, 1));
+	const uint8_t aExpectedAlpha[] = {255, 255, 255, 0, 255, 255, 255, 128, 255, 255, 255, 255};
+	EXPECT_EQ(mem_comp(aResult, aExpectedAlpha, sizeof(aResult)), 0);
+
+	EXPECT_FALSE(ConvertToRGBA(aResult, aRgb, 1, 3, 3));
+	const uint8_t aExpectedRgb[] = {1, 2, 3, 255, 4, 5, 6, 255, 7, 8, 9, 255};
+	EXPECT_EQ(mem_comp(aResult, aExpectedRgb, sizeof(aResult)), 0);
+
+	EXPECT_TRUE(ConvertToRGBA(aResult, aRgba, 3, 1, 4));
+	EXPECT_EQ(mem_comp(aResult, aRgba, sizeof(aResult)), 0);
+}
+
+TEST(ImageLoader, ParallelDecodeMatchesSerial)
+{
+	auto pStorage = std::unique_ptr<IStorage>(CreateLocalStorage());
+	auto pEngine = std::unique_ptr<IEngine>(CreateTestEngine("Toutuo", 4));
+	std::vector<std::string> vFiles = DataPngs(pStorage.get());
+	ASSERT_FALSE(vFiles.empty());
+	if(vFiles.size() > 64)
+		vFiles.resize(64);
+	vFiles.push_back("data/does_not_exist.png");
+
+	auto vpParallel = DecodeAll(pStorage.get(), pEngine.get(), vFiles);
+	int NumDecoded = 0;
+	for(size_t i = 0; i < vFiles.size(); i++)
+	{
+		int Width = 0;
+		int Height = 0;
+		std::vector<uint8_t> vPixels;
+		const bool Success = DecodeSerial(pStorage.get(), vFiles[i], Width, Height, vPixels);
+		EXPECT_EQ(vpParallel[i]->m_Success, Success) << vFiles[i];
+		if(!Success)
+			continue;
+		NumDecoded++;
+		EXPECT_EQ(vpParallel[i]->m_Width, Width) << vFiles[i];
+		EXPECT_EQ(vpParallel[i]->m_Height, Height) << vFiles[i];
+		EXPECT_TRUE(vpParallel[i]->m_vPixels == vPixels) << vFiles[i];
+	}
+	EXPECT_GT(NumDecoded, 0);
+	EXPECT_FALSE(vpParallel.back()->m_Success);
+}
+
+TEST(ImageLoader, DISABLED_BenchmarkDecodeDataAssets)
+{
+	auto pStorage = std::unique_ptr<IStorage>(CreateLocalStorage());
+	const std::vector<std::string> vFiles = DataPngs(pStorage.get());
+	ASSERT_FALSE(vFiles.empty());
+
+	const int aThreads[] = {0, 2, 4};
+	for(int Threads : aThreads)
+	{
+		auto pEngine = Threads ? std::unique_ptr<IEngine>(CreateTestEngine("Toutuo", Threads)) : nullptr;
+		const int64_t Start = time_get();
+		auto vpJobs = DecodeAll(pStorage.get(), pEngine.get(), vFiles);
+		const int64_t Time = time_get() - Start;
+
+		int64_t Pixels = 0;
+		for(auto &pJob : vpJobs)
+			Pixels += (int64_t)pJob->m_Width * pJob->m_Height;
+		dbg_msg("benchmark", "%d pngs (%.1f MPixel), %d job threads: %.2fms", (int)vFiles.size(), Pixels / 1000000.0, Threads, Time * 1000.0 / time_freq());
+	}
+}
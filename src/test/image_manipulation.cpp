@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/gfx/image_manipulation.h>
+
+#include <vector>
+
+static std::vector<uint8_t> TestImage(int Width, int Height)
+{
+	std::vector<uint8_t> vImg(Width * Height * 4);
+	for(unsigned i = 0; i < vImg.size(); i++)
+		vImg[i] = (i * 37 + i / 4 * 11) % 256;
+	// plenty of fully transparent pixels, including at the unaligned tail
+	for(int i = 0; i < Width * Height; i += 3)
+		vImg[i * 4 + 3] = 0;
+	return vImg;
+}
+
+TEST(ImageManipulation, ClearTransparentPixels)
+{
+	// odd sizes so the scalar tail is covered too
+	const int Width = 13;
+	const int Height = 7;
+	std::vector<uint8_t> vImg = TestImage(Width, Height);
+	const std::vector<uint8_t> vOriginal = vImg;
+
+	ClearTransparentPixels(vImg.data(), Width, Height);
+	for(int i = 0; i < Width * Height; i++)
+	{
+		for(int c = 0; c < 4; c++)
+			EXPECT_EQ(vImg[i * 4 + c], vOriginal[i * 4 + 3] == 0 ? 0 : vOriginal[i * 4 + c]);
+	}
+}
+
+TEST(ImageManipulation, CopyOpaquePixels)
+{
+	const int Width = 13;
+	const int Height = 7;
+	const std::vector<uint8_t> vSrc = TestImage(Width, Height);
+	std::vector<uint8_t> vDest(vSrc.size(), 0xAA);
+
+	CopyOpaquePixels(vDest.data(), vSrc.data(), Width, Height);
+	for(int i = 0; i < Width * Height; i++)
+	{
+		for(int c = 0; c < 4; c++)
+			EXPECT_EQ(vDest[i * 4 + c], vSrc[i * 4 + 3] == 0 ? 0 : vSrc[i * 4 + c]);
+	}
+}
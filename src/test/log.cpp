@@ -0,0 +1,236 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <base/logger.h>
+#include <base/system.h>
+
+#include <thread>
+#include <vector>
+
+class Logger : public ::testing::Test
+{
+protected:
+	std::unique_ptr<ILogger> m_pLogger;
+	CTestInfo m_Info;
+	bool m_Delete = false;
+
+	void SetUp() override
+	{
+		IOHANDLE File = io_open(m_Info.m_aFilename, IOFLAG_WRITE);
+		ASSERT_TRUE(File);
+		m_pLogger = log_logger_file(File);
+	}
+
+	~Logger()
+	{
+		if(m_Delete)
+		{
+			fs_remove(m_Info.m_aFilename);
+		}
+	}
+
+	static void Log(ILogger *pLogger, LEVEL Level, const char *pLine)
+	{
+		CLogMessage Msg;
+		Msg.m_Level = Level;
+		Msg.m_HaveColor = false;
+		Msg.m_Color = LOG_COLOR{0, 0, 0};
+		Msg.m_aTimestamp[0] = 0;
+		Msg.m_TimestampLength = 0;
+		Msg.m_aSystem[0] = 0;
+		Msg.m_SystemLength = 0;
+		str_copy(Msg.m_aLine, pLine, sizeof(Msg.m_aLine));
+		Msg.m_LineLength = str_length(Msg.m_aLine);
+		Msg.m_LineMessageOffset = 0;
+		pLogger->Log(&Msg);
+	}
+
+	// finishes the logger and returns the written lines
+	std::vector<std::string> Finish()
+	{
+		m_pLogger.reset();
+
+		std::vector<std::string> vLines;
+		IOHANDLE File = io_open(m_Info.m_aFilename, IOFLAG_READ);
+		EXPECT_TRUE(File);
+		if(!File)
+			return vLines;
+		char *pData = io_read_all_str(File);
+		io_close(File);
+		EXPECT_TRUE(pData);
+		if(!pData)
+			return vLines;
+
+		const char *pLine = pData;
+		while(*pLine)
+		{
+			const char *pEnd = str_find(pLine, "\n");
+			EXPECT_TRUE(pEnd);
+			if(!pEnd)
+				break;
+			vLines.emplace_back(pLine, pEnd - pLine);
+			pLine = pEnd + 1;
+		}
+		free(pData);
+		m_Delete = true;
+		return vLines;
+	}
+};
+
+TEST_F(Logger, Empty)
+{
+	EXPECT_TRUE(Finish().empty());
+}
+
+TEST_F(Logger, Simple)
+{
+	Log(m_pLogger.get(), LEVEL_INFO, "a");
+	Log(m_pLogger.get(), LEVEL_INFO, "b");
+	std::vector<std::string> vLines = Finish();
+	ASSERT_EQ(vLines.size(), 2u);
+	EXPECT_EQ(vLines[0], "a");
+	EXPECT_EQ(vLines[1], "b");
+}
+
+TEST_F(Logger, ManyThreadsKeepOrder)
+{
+	static const int NUM_THREADS = 8;
+	static const int NUM_MESSAGES = 256;
+
+	std::vector<std::thread> vThreads;
+	for(int t = 0; t < NUM_THREADS; t++)
+	{
+		vThreads.emplace_back([this, t]() {
+			for(int i = 0; i < NUM_MESSAGES; i++)
+			{
+				char aLine[64];
+				str_format(aLine, sizeof(aLine), "%d %d", t, i);
+				Log(m_pLogger.get(), LEVEL_INFO, aLine);
+			}
+		});
+	}
+	for(auto &Thread : vThreads)
+		Thread.join();
+
+	std::vector<std::string> vLines = Finish();
+	ASSERT_EQ(vLines.size(), (size_t)NUM_THREADS * NUM_MESSAGES);
+	int aNext[NUM_THREADS] = {0};
+	for(const auto &Line : vLines)
+	{
+		int Thread, Message;
+		ASSERT_EQ(sscanf(Line.c_str(), "%d %d", &Thread, &Message), 2);
+		ASSERT_TRUE(Thread >= 0 && Thread < NUM_THREADS);
+		EXPECT_EQ(Message, aNext[Thread]);
+		aNext[Thread] = Message + 1;
+	}
+}
+
+TEST_F(Logger, DropsAreCounted)
+{
+	static const int NUM_MESSAGES = 20000;
+	char aLine[512];
+	mem_zero(aLine, sizeof(aLine));
+	for(unsigned i = 0; i < sizeof(aLine) - 1; i++)
+		aLine[i] = 'a';
+
+	const uint64_t DroppedBefore = log_dropped_messages();
+	for(int i = 0; i < NUM_MESSAGES; i++)
+		Log(m_pLogger.get(), LEVEL_INFO, aLine);
+
+	int Written = 0;
+	uint64_t Dropped = 0;
+	for(const auto &Line : Finish())
+	{
+		unsigned long long Count;
+		if(sscanf(Line.c_str(), "[%*[^]]][log]: dropped %llu", &Count) == 1)
+			Dropped += Count;
+		else
+			Written++;
+	}
+	EXPECT_EQ(Written + Dropped, (uint64_t)NUM_MESSAGES);
+	EXPECT_EQ(log_dropped_messages() - DroppedBefore, Dropped);
+}
+
+TEST_F(Logger, ManyLoggersOnOneThread)
+{
+	// more loggers than a thread has ring slots, alive at the same time so that
+	// they don't share addresses, and all of them gone before the next batch
+	for(int Batch = 0; Batch < 3; Batch++)
+	{
+		std::vector<std::unique_ptr<ILogger>> vpLoggers;
+		for(int i = 0; i < 8; i++)
+		{
+			char aFilename[IO_MAX_PATH_LENGTH];
+			str_format(aFilename, sizeof(aFilename), "%s.%d", m_Info.m_aFilename, i);
+			IOHANDLE File = io_open(aFilename, IOFLAG_WRITE);
+			ASSERT_TRUE(File);
+			vpLoggers.push_back(log_logger_file(File));
+			Log(vpLoggers.back().get(), LEVEL_INFO, "short-lived");
+		}
+		vpLoggers.clear();
+		for(int i = 0; i < 8; i++)
+		{
+			char aFilename[IO_MAX_PATH_LENGTH];
+			str_format(aFilename, sizeof(aFilename), "%s.%d", m_Info.m_aFilename, i);
+			fs_remove(aFilename);
+		}
+	}
+
+	const uint64_t DroppedBefore = log_dropped_messages();
+	Log(m_pLogger.get(), LEVEL_INFO, "a");
+	Log(m_pLogger.get(), LEVEL_INFO, "b");
+	EXPECT_EQ(log_dropped_messages(), DroppedBefore);
+	std::vector<std::string> vLines = Finish();
+	ASSERT_EQ(vLines.size(), 2u);
+	EXPECT_EQ(vLines[0], "a");
+	EXPECT_EQ(vLines[1], "b");
+}
+
+TEST_F(Logger, DropLessSevereKeepsWarnings)
+{
+	static const int NUM_ROUNDS = 20;
+	static const int NUM_INFOS = 1000;
+	static const int NUM_WARNINGS = 8;
+	char aLine[512];
+	mem_zero(aLine, sizeof(aLine));
+	for(unsigned i = 0; i < sizeof(aLine) - 1; i++)
+		aLine[i] = 'a';
+
+	log_set_drop_policy(LOG_DROP_LESS_SEVERE);
+	const uint64_t DroppedBefore = log_dropped_messages();
+	for(int Round = 0; Round < NUM_ROUNDS; Round++)
+	{
+		// fill the ring with info messages, warnings still fit into the reserved room
+		for(int i = 0; i < NUM_INFOS; i++)
+			Log(m_pLogger.get(), LEVEL_INFO, aLine);
+		for(int i = 0; i < NUM_WARNINGS; i++)
+		{
+			char aWarning[64];
+			str_format(aWarning, sizeof(aWarning), "warning %d %d", Round, i);
+			Log(m_pLogger.get(), LEVEL_WARN, aWarning);
+		}
+	}
+	const uint64_t Dropped = log_dropped_messages() - DroppedBefore;
+	log_set_drop_policy(LOG_DROP_NEWEST);
+
+	int Infos = 0;
+	std::vector<std::string> vWarnings;
+	for(const auto &Line : Finish())
+	{
+		if(str_startswith(Line.c_str(), "warning "))
+			vWarnings.push_back(Line);
+		else if(Line == aLine)
+			Infos++;
+	}
+	ASSERT_EQ(vWarnings.size(), (size_t)NUM_ROUNDS * NUM_WARNINGS);
+	for(int Round = 0; Round < NUM_ROUNDS; Round++)
+	{
+		for(int i = 0; i < NUM_WARNINGS; i++)
+		{
+			char aWarning[64];
+			str_format(aWarning, sizeof(aWarning), "warning %d %d", Round, i);
+			EXPECT_EQ(vWarnings[Round * NUM_WARNINGS + i], aWarning);
+		}
+	}
+	EXPECT_EQ(Infos + Dropped, (uint64_t)NUM_ROUNDS * NUM_INFOS);
+}
@@ -30,3 +30,91 @@ TEST(NameBan, Substring)
 	EXPECT_TRUE(IsNameBanned("abcxyzdef", vBans));
 	EXPECT_FALSE(IsNameBanned("abcdef", vBans));
 }
+
+TEST(NameBan, IndexUpdates)
+{
+	CNameBans Bans;
+	EXPECT_FALSE(Bans.IsBanned("abc"));
+	Bans.Ban("abc", 0, 0, "first");
+	Bans.Ban("xyz", 0, 1, "second");
+	ASSERT_TRUE(Bans.IsBanned("abc"));
+	EXPECT_STREQ(Bans.IsBanned("abc")->m_aReason, "first");
+	ASSERT_TRUE(Bans.IsBanned("fooXYZ"));
+	EXPECT_STREQ(Bans.IsBanned("fooXYZ")->m_aReason, "second");
+
+	Bans.Ban("abc", 1, 0, "changed");
+	ASSERT_TRUE(Bans.IsBanned("abd"));
+	EXPECT_STREQ(Bans.IsBanned("abd")->m_aReason, "changed");
+
+	Bans.Ban("xyz", 0, 0, "");
+	EXPECT_FALSE(Bans.IsBanned("fooxyz"));
+
+	EXPECT_TRUE(Bans.Unban("abc"));
+	EXPECT_FALSE(Bans.Unban("abc"));
+	EXPECT_FALSE(Bans.IsBanned("abc"));
+	EXPECT_TRUE(Bans.IsBanned("xyz"));
+	EXPECT_EQ(Bans.All().size(), 1u);
+}
+
+TEST(NameBan, IndexMatchesList)
+{
+	static const char *s_apParts[] = {"a", "b", "x", "y", "Ä", "ä", "o", "0", " ", "ab", "xy"};
+	unsigned Seed = 1;
+	auto Random = [&Seed](int Max) {
+		Seed = Seed * 1103515245 + 12345;
+		return (int)((Seed >> 16) % Max);
+	};
+	auto RandomName = [&](char *pBuf, int Size) {
+		pBuf[0] = '\0';
+		const int Parts = Random(7);
+		for(int i = 0; i < Parts; i++)
+			str_append(pBuf, s_apParts[Random(std::size(s_apParts))], Size);
+	};
+
+	std::vector<CNameBan> vBans;
+	CNameBans Bans;
+	for(int Round = 0; Round < 2000; Round++)
+	{
+		char aName[MAX_NAME_LENGTH];
+		RandomName(aName, sizeof(aName));
+		if(Random(4) == 0)
+		{
+			const int Distance = Random(4) - 1;
+			const int IsSubstring = Random(3) == 0;
+			char aReason[16];
+			str_format(aReason, sizeof(aReason), "%d", Round);
+			Bans.Ban(aName, Distance, IsSubstring, aReason);
+			bool Found = false;
+			for(auto &Ban : vBans)
+			{
+				if(str_comp(Ban.m_aName, aName) == 0)
+				{
+					Ban.m_Distance = Distance;
+					Ban.m_IsSubstring = IsSubstring;
+					str_copy(Ban.m_aReason, aReason, sizeof(Ban.m_aReason));
+					Found = true;
+				}
+			}
+			if(!Found)
+				vBans.emplace_back(aName, Distance, IsSubstring, aReason);
+		}
+		else if(Random(8) == 0)
+		{
+			Bans.Unban(aName);
+			for(size_t i = 0; i < vBans.size(); i++)
+			{
+				if(str_comp(vBans[i].m_aName, aName) == 0)
+					vBans.erase(vBans.begin() + i);
+			}
+		}
+
+		RandomName(aName, sizeof(aName));
+		const CNameBan *pExpected = IsNameBanned(aName, vBans);
+		const CNameBan *pActual = Bans.IsBanned(aName);
+		ASSERT_EQ(pExpected == nullptr, pActual == nullptr) << aName;
+		if(pExpected)
+		{
+			EXPECT_STREQ(pExpected->m_aReason, pActual->m_aReason) << aName;
+		}
+	}
+}
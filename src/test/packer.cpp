@@ -2,7 +2,10 @@
 #include <gtest/gtest.h>
 
 #include <base/system.h>
+#include <engine/message.h>
 #include <engine/shared/packer.h>
+#include <engine/shared/protocol.h>
+#include <engine/shared/protocol_ex.h>
 
 // pExpected is NULL if an error is expected
 static void ExpectAddString5(const char *pString, int Limit, const char *pExpected)
@@ -64,3 +67,38 @@ TEST(Packer, AddStringBroken)
 	ExpectAddString5("\x80\x80", 5, "�");
 	ExpectAddString5("\x80\x80", 6, 0);
 }
+
+static void ExpectNetData(int MsgID, bool System)
+{
+	CMsgPacker Msg(MsgID, System);
+	Msg.AddInt(1234);
+	Msg.AddString("payload", 0);
+
+	CUnpacker Unpacker;
+	Unpacker.Reset(Msg.NetData(), Msg.NetSize());
+	int Header = Unpacker.GetInt();
+	EXPECT_EQ(Header & 1, System ? 1 : 0);
+	if(MsgID < OFFSET_UUID)
+	{
+		EXPECT_EQ(Header >> 1, MsgID);
+	}
+	else
+	{
+		EXPECT_EQ(Header >> 1, 0);
+		CUuid Uuid = g_UuidManager.GetUuid(MsgID);
+		const CUuid *pUuid = (const CUuid *)Unpacker.GetRaw(sizeof(CUuid));
+		ASSERT_TRUE(pUuid);
+		EXPECT_EQ(*pUuid, Uuid);
+	}
+	EXPECT_EQ(Unpacker.GetInt(), 1234);
+	EXPECT_STREQ(Unpacker.GetString(), "payload");
+	EXPECT_FALSE(Unpacker.Error());
+}
+
+TEST(Packer, MsgNetData)
+{
+	ExpectNetData(NETMSG_INFO, true);
+	ExpectNetData(NETMSG_INFO, false);
+	ExpectNetData(100, false);
+	ExpectNetData(NETMSG_WHATIS, true);
+}
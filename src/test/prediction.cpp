@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <game/client/prediction/entities/character.h>
+#include <game/client/prediction/entities/laser.h>
+#include <game/client/prediction/entities/pickup.h>
+#include <game/client/prediction/entities/projectile.h>
+#include <game/client/prediction/entity.h>
+#include <game/client/prediction/gameworld.h>
+#include <game/client/projectile_data.h>
+#include <game/collision.h>
+#include <game/generated/protocol.h>
+
+#include <cstring>
+
+class CPooledBase
+{
+	MACRO_ALLOC_POOL()
+public:
+	virtual ~CPooledBase() = default;
+	int m_aData[5];
+};
+
+class CPooledDerived : public CPooledBase
+{
+public:
+	int m_aMore[13];
+};
+
+static bool IsZero(const void *pData, size_t Size)
+{
+	for(size_t i = 0; i < Size; i++)
+	{
+		if(((const unsigned char *)pData)[i])
+			return false;
+	}
+	return true;
+}
+
+TEST(EntityPool, ReuseZeroed)
+{
+	CEntityPool::Clear();
+	const size_t Size = 1000;
+	void *pFirst = CEntityPool::Allocate(Size);
+	ASSERT_TRUE(pFirst);
+	EXPECT_TRUE(IsZero(pFirst, Size));
+	memset(pFirst, 0xaa, Size);
+	CEntityPool::Free(pFirst, Size);
+
+	const int HeapAllocations = CEntityPool::NumHeapAllocations();
+	void *pSecond = CEntityPool::Allocate(Size);
+	EXPECT_EQ(pSecond, pFirst);
+	EXPECT_EQ(CEntityPool::NumHeapAllocations(), HeapAllocations);
+	EXPECT_TRUE(IsZero(pSecond, Size));
+
+	// the most recently freed block comes first, other sizes don't get it
+	void *pThird = CEntityPool::Allocate(Size);
+	EXPECT_NE(pThird, pSecond);
+	CEntityPool::Free(pSecond, Size);
+	CEntityPool::Free(pThird, Size);
+	void *pOther = CEntityPool::Allocate(Size / 2);
+	EXPECT_NE(pOther, pSecond);
+	EXPECT_NE(pOther, pThird);
+	EXPECT_EQ(CEntityPool::Allocate(Size), pThird);
+	EXPECT_EQ(CEntityPool::Allocate(Size), pSecond);
+
+	CEntityPool::Free(nullptr, Size);
+	CEntityPool::Free(pOther, Size / 2);
+	CEntityPool::Free(pSecond, Size);
+	CEntityPool::Free(pThird, Size);
+	CEntityPool::Clear();
+}
+
+TEST(EntityPool, SizedDelete)
+{
+	CEntityPool::Clear();
+
+	// the derived size is passed to the delete of the base class
+	CPooledBase *pBase = new CPooledDerived;
+	memset(static_cast<CPooledDerived *>(pBase)->m_aMore, 0xaa, sizeof(CPooledDerived::m_aMore));
+	delete pBase;
+
+	const int HeapAllocations = CEntityPool::NumHeapAllocations();
+	CPooledDerived *pDerived = new CPooledDerived;
+	EXPECT_EQ(pDerived, pBase);
+	EXPECT_EQ(CEntityPool::NumHeapAllocations(), HeapAllocations);
+	EXPECT_TRUE(IsZero(pDerived->m_aMore, sizeof(pDerived->m_aMore)));
+	EXPECT_TRUE(IsZero(pDerived->m_aData, sizeof(pDerived->m_aData)));
+
+	// a smaller object doesn't get the larger block
+	CPooledBase *pSmall = new CPooledBase;
+	delete pDerived;
+	CPooledBase *pSmall2 = new CPooledBase;
+	EXPECT_NE(pSmall2, pDerived);
+	delete pSmall;
+	delete pSmall2;
+	CEntityPool::Clear();
+}
+
+TEST(EntityPool, FallbackWhenOutOfBuckets)
+{
+	CEntityPool::Clear();
+	void *apBlocks[CEntityPool::NUM_BUCKETS];
+	for(int i = 0; i < CEntityPool::NUM_BUCKETS; i++)
+		apBlocks[i] = CEntityPool::Allocate(64 + i * 8);
+
+	// sizes beyond the buckets go to the heap every time, but work the same
+	const size_t Size = 2000;
+	for(int i = 0; i < 3; i++)
+	{
+		const int HeapAllocations = CEntityPool::NumHeapAllocations();
+		unsigned char *pData = (unsigned char *)CEntityPool::Allocate(Size);
+		ASSERT_TRUE(pData);
+		EXPECT_EQ(CEntityPool::NumHeapAllocations(), HeapAllocations + 1);
+		EXPECT_TRUE(IsZero(pData, Size));
+		memset(pData, 0xaa, Size);
+		CEntityPool::Free(pData, Size);
+	}
+
+	// the sizes that got a bucket are still recycled
+	for(int i = 0; i < CEntityPool::NUM_BUCKETS; i++)
+		CEntityPool::Free(apBlocks[i], 64 + i * 8);
+	const int HeapAllocations = CEntityPool::NumHeapAllocations();
+	for(int i = 0; i < CEntityPool::NUM_BUCKETS; i++)
+		EXPECT_EQ(CEntityPool::Allocate(64 + i * 8), apBlocks[i]);
+	EXPECT_EQ(CEntityPool::NumHeapAllocations(), HeapAllocations);
+	for(int i = 0; i < CEntityPool::NUM_BUCKETS; i++)
+		CEntityPool::Free(apBlocks[i], 64 + i * 8);
+	CEntityPool::Clear();
+}
+
+TEST(Prediction, DISABLED_BenchmarkCopyWorld)
+{
+	// entities are only constructed and copied, nothing reads the map
+	CCollision Collision;
+	CTuningParams aTuning[256]; // all tune zones, like CGameClient
+	CGameWorld World;
+	mem_zero(&World.m_WorldConfig, sizeof(World.m_WorldConfig));
+	World.m_WorldConfig.m_PredictWeapons = true;
+	World.m_GameTick = 1000;
+	World.m_GameTickSpeed = SERVER_TICK_SPEED;
+	World.m_pCollision = &Collision;
+	World.m_pTuningList = aTuning;
+
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		CNetObj_Character Char;
+		mem_zero(&Char, sizeof(Char));
+		Char.m_X = 100 + i * 64;
+		Char.m_Y = 200;
+		Char.m_Weapon = WEAPON_GUN;
+		World.InsertEntity(new CCharacter(&World, i, &Char));
+	}
+	for(int i = 0; i < 256; i++)
+	{
+		CProjectileData Proj;
+		mem_zero(&Proj, sizeof(Proj));
+		Proj.m_StartPos = vec2(100 + i * 16, 100);
+		Proj.m_StartVel = vec2(1, 0);
+		Proj.m_Type = i % 2 ? WEAPON_GRENADE : WEAPON_GUN;
+		Proj.m_StartTick = World.m_GameTick;
+		World.InsertEntity(new CProjectile(&World, i, &Proj));
+	}
+	for(int i = 0; i < 64; i++)
+	{
+		CNetObj_Laser Laser;
+		mem_zero(&Laser, sizeof(Laser));
+		Laser.m_X = 100 + i * 16;
+		Laser.m_Y = 300;
+		Laser.m_FromX = Laser.m_X - 50;
+		Laser.m_FromY = Laser.m_Y;
+		Laser.m_StartTick = World.m_GameTick;
+		World.InsertEntity(new CLaser(&World, 256 + i, &Laser));
+	}
+	for(int i = 0; i < 128; i++)
+	{
+		CNetObj_Pickup Pickup;
+		mem_zero(&Pickup, sizeof(Pickup));
+		Pickup.m_X = 100 + i * 32;
+		Pickup.m_Y = 400;
+		Pickup.m_Type = POWERUP_ARMOR;
+		World.InsertEntity(new CPickup(&World, 320 + i, &Pickup));
+	}
+
+	// like the prediction, which copies the world every frame
+	const int NUM_COPIES = 10000;
+	CGameWorld Predicted;
+	const int HeapAllocations = CEntityPool::NumHeapAllocations();
+	const int64_t Start = time_get();
+	for(int i = 0; i < NUM_COPIES; i++)
+		Predicted.CopyWorld(&World);
+	const int64_t Time = time_get() - Start;
+	EXPECT_TRUE(Predicted.m_IsValidCopy);
+	dbg_msg("benchmark", "%d world copies: %.3fms per copy, %d entity heap allocations",
+		NUM_COPIES, Time * 1000.0 / time_freq() / NUM_COPIES, CEntityPool::NumHeapAllocations() - HeapAllocations);
+}
@@ -1,9 +1,13 @@
 #include <gtest/gtest.h>
 #include <memory>
+#include <random>
+#include <vector>
 
+#include <engine/client/serverbrowser.h>
 #include <engine/client/serverbrowser_ping_cache.h>
 #include <engine/console.h>
 #include <engine/engine.h>
+#include <engine/friends.h>
 #include <engine/shared/config.h>
 #include <engine/storage.h>
 #include <test/test.h>
@@ -101,3 +105,177 @@ TEST(ServerBrowser, PingCache)
 		EXPECT_EQ(pEntries[1].m_Ping, 345);
 	}
 }
+
+class CFriendsNone : public IFriends
+{
+public:
+	void Init(bool Foes) override {}
+	int NumFriends() const override { return 0; }
+	const CFriendInfo *GetFriend(int Index) const override { return nullptr; }
+	int GetFriendState(const char *pName, const char *pClan) const override { return FRIEND_NO; }
+	bool IsFriend(const char *pName, const char *pClan, bool PlayersOnly) const override { return false; }
+	void AddFriend(const char *pName, const char *pClan) override {}
+	void RemoveFriend(const char *pName, const char *pClan) override {}
+};
+
+class CPingCacheNone : public IServerBrowserPingCache
+{
+public:
+	void Load() override {}
+	void CachePing(NETADDR Addr, int Ping) override {}
+	void GetPingCache(const CEntry **ppEntries, int *pNumEntries) override
+	{
+		*ppEntries = nullptr;
+		*pNumEntries = 0;
+	}
+};
+
+class CServerBrowserSortTest : public ::testing::Test
+{
+protected:
+	CConfig m_OldConfig;
+	std::unique_ptr<IConsole> m_pConsole;
+	CFriendsNone m_Friends;
+	CServerBrowser *m_pBrowser;
+	std::mt19937 m_Rng;
+
+	CServerBrowserSortTest()
+	{
+		m_OldConfig = g_Config;
+		m_pConsole = std::unique_ptr<IConsole>(CreateConsole(CFGFLAG_CLIENT));
+
+		// zeroed like the client that contains it
+		void *pMemory = malloc(sizeof(CServerBrowser));
+		mem_zero(pMemory, sizeof(CServerBrowser));
+		m_pBrowser = new(pMemory) CServerBrowser;
+		m_pBrowser->m_pConsole = m_pConsole.get();
+		m_pBrowser->m_pFriends = &m_Friends;
+		m_pBrowser->m_pPingCache = new CPingCacheNone;
+		m_pBrowser->m_ServerlistType = IServerBrowser::TYPE_INTERNET;
+	}
+
+	~CServerBrowserSortTest()
+	{
+		m_pBrowser->~CServerBrowser();
+		free(m_pBrowser);
+		g_Config = m_OldConfig;
+	}
+
+	static NETADDR Address(int i)
+	{
+		char aAddr[NETADDR_MAXSTRSIZE];
+		str_format(aAddr, sizeof(aAddr), "%d.%d.0.1:8303", 1 + i % 200, i / 200);
+		NETADDR Addr;
+		net_addr_from_str(&Addr, aAddr);
+		return Addr;
+	}
+
+	// few distinct values, so ties have to be broken like in the full sort
+	CServerInfo RandomInfo()
+	{
+		CServerInfo Info;
+		mem_zero(&Info, sizeof(Info));
+		str_format(Info.m_aName, sizeof(Info.m_aName), "server %d", (int)(m_Rng() % 20));
+		str_format(Info.m_aMap, sizeof(Info.m_aMap), "map%d", (int)(m_Rng() % 10));
+		str_format(Info.m_aGameType, sizeof(Info.m_aGameType), "mode%d", (int)(m_Rng() % 5));
+		Info.m_MaxClients = Info.m_MaxPlayers = 16;
+		Info.m_NumClients = Info.m_NumReceivedClients = m_Rng() % 17;
+		for(int c = 0; c < Info.m_NumClients; c++)
+		{
+			str_format(Info.m_aClients[c].m_aName, sizeof(Info.m_aClients[c].m_aName), "player%d", (int)(m_Rng() % 100));
+			Info.m_aClients[c].m_Score = m_Rng() % 10;
+			Info.m_aClients[c].m_Player = m_Rng() % 4 != 0;
+			Info.m_NumPlayers += Info.m_aClients[c].m_Player;
+		}
+		Info.m_Latency = m_Rng() % 400;
+		return Info;
+	}
+
+	void Add(int i)
+	{
+		const CServerInfo Info = RandomInfo();
+		m_pBrowser->Set(Address(i), IServerBrowser::SET_HTTPINFO, -1, &Info);
+	}
+
+	void SetInfo(int i)
+	{
+		CServerBrowser::CServerEntry *pEntry = m_pBrowser->Find(Address(i));
+		ASSERT_TRUE(pEntry);
+		m_pBrowser->SetInfo(pEntry, RandomInfo());
+	}
+
+	void SetLatency(int i)
+	{
+		m_pBrowser->SetLatency(Address(i), m_Rng() % 400);
+	}
+
+	std::vector<int> SortedList() const
+	{
+		return std::vector<int>(m_pBrowser->m_pSortedServerlist, m_pBrowser->m_pSortedServerlist + m_pBrowser->m_NumSortedServers);
+	}
+
+	void SortChanged() { m_pBrowser->SortChanged(); }
+	void Sort() { m_pBrowser->Sort(); }
+	int NumChanged() const { return m_pBrowser->m_vChangedServers.size(); }
+	bool ClientsSorted(int SortedIndex) const
+	{
+		const CServerInfo *pInfo = m_pBrowser->SortedGet(SortedIndex);
+		for(int c = 1; c < pInfo->m_NumReceivedClients; c++)
+		{
+			const CServerInfo::CClient &Prev = pInfo->m_aClients[c - 1];
+			const CServerInfo::CClient &Cur = pInfo->m_aClients[c];
+			if((!Prev.m_Player && Cur.m_Player) || (Prev.m_Player == Cur.m_Player && Prev.m_Score < Cur.m_Score))
+				return false;
+		}
+		return true;
+	}
+};
+
+TEST_F(CServerBrowserSortTest, IncrementalMatchesFullSort)
+{
+	const int aSorts[] = {IServerBrowser::SORT_NAME, IServerBrowser::SORT_PING, IServerBrowser::SORT_MAP, IServerBrowser::SORT_GAMETYPE, IServerBrowser::SORT_NUMPLAYERS};
+	enum
+	{
+		MAX_SERVERS = 400,
+	};
+	int NumServers = 0;
+	for(int SortType : aSorts)
+	{
+		for(int Order = 0; Order <= 2; Order++)
+		{
+			for(int FilterEmpty = 0; FilterEmpty <= 1; FilterEmpty++)
+			{
+				g_Config.m_BrSort = SortType;
+				g_Config.m_BrSortOrder = Order;
+				g_Config.m_BrFilterEmpty = FilterEmpty;
+				for(int i = 0; i < 20; i++)
+					Add(NumServers++);
+				Sort();
+
+				for(int Batch = 0; Batch < 30; Batch++)
+				{
+					// mostly small batches that are moved, sometimes large ones that are sorted from scratch
+					const int Updates = Batch % 10 == 9 ? NumServers : 1 + m_Rng() % 8;
+					for(int u = 0; u < Updates; u++)
+					{
+						const int Kind = m_Rng() % 8;
+						if(Kind == 0 && NumServers < MAX_SERVERS)
+							Add(NumServers++);
+						else if(Kind < 5)
+							SetInfo(m_Rng() % NumServers);
+						else
+							SetLatency(m_Rng() % NumServers);
+					}
+
+					SortChanged();
+					EXPECT_EQ(NumChanged(), 0);
+					const std::vector<int> vIncremental = SortedList();
+					Sort();
+					ASSERT_EQ(vIncremental, SortedList()) << "sort " << SortType << " order " << Order << " filter empty " << FilterEmpty << " batch " << Batch;
+					for(int i = 0; i < (int)vIncremental.size(); i++)
+						EXPECT_TRUE(ClientsSorted(i));
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <engine/server/snap_id_pool.h>
+
+#include <memory>
+#include <set>
+
+TEST(SnapIDPool, ReuseAfterTimeout)
+{
+	auto pPool = std::make_unique<CSnapIDPool>();
+	const int64_t Start = time_freq() * 1000;
+
+	int aIDs[3];
+	for(int &ID : aIDs)
+		ID = pPool->NewID(Start);
+	EXPECT_EQ(aIDs[0], 0);
+	EXPECT_EQ(aIDs[1], 1);
+	EXPECT_EQ(aIDs[2], 2);
+
+	pPool->FreeID(aIDs[1], Start);
+	EXPECT_EQ(pPool->InUsage(), 2);
+	EXPECT_EQ(pPool->Usage(), 3);
+
+	// still reserved shortly before the timeout
+	EXPECT_EQ(pPool->NewID(Start + time_freq() * 4), 3);
+	EXPECT_EQ(pPool->Usage(), 4);
+
+	// released afterwards
+	EXPECT_EQ(pPool->NewID(Start + time_freq() * 6), aIDs[1]);
+	EXPECT_EQ(pPool->Usage(), 4);
+	EXPECT_EQ(pPool->InUsage(), 4);
+	EXPECT_EQ(pPool->PeakUsage(), 4);
+}
+
+TEST(SnapIDPool, TimeoutIDs)
+{
+	auto pPool = std::make_unique<CSnapIDPool>();
+	const int64_t Start = time_freq() * 1000;
+
+	std::set<int> Freed;
+	for(int i = 0; i < 100; i++)
+	{
+		const int64_t Now = Start + time_freq() * i / 50;
+		int ID = pPool->NewID(Now);
+		pPool->FreeID(ID, Now);
+		Freed.insert(ID);
+	}
+	EXPECT_EQ(pPool->InUsage(), 0);
+	EXPECT_EQ(pPool->Usage(), 100);
+
+	pPool->TimeoutIDs();
+	EXPECT_EQ(pPool->Usage(), 0);
+	EXPECT_EQ(pPool->PeakUsage(), 100);
+	EXPECT_TRUE(Freed.count(pPool->NewID(Start + time_freq() * 2)));
+}
+
+TEST(SnapIDPool, Exhaust)
+{
+	auto pPool = std::make_unique<CSnapIDPool>();
+	const int64_t Start = time_freq() * 1000;
+
+	for(int i = 0; i < CSnapIDPool::MAX_IDS; i++)
+		ASSERT_EQ(pPool->NewID(Start), i);
+	EXPECT_EQ(pPool->NewID(Start), -1);
+
+	// a timed id only becomes available after the timeout
+	pPool->FreeID(123, Start);
+	EXPECT_EQ(pPool->NewID(Start + time_freq()), -1);
+	EXPECT_EQ(pPool->NewID(Start + time_freq() * 10), 123);
+	EXPECT_EQ(pPool->PeakUsage(), (int)CSnapIDPool::MAX_IDS);
+}
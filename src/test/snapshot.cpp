@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/snapshot.h>
+#include <game/prng.h>
+
+#include <vector>
+
+static int RandomItemInt(CPrng *pPrng)
+{
+	const unsigned Bits = pPrng->RandomBits();
+	switch(pPrng->RandomBits() % 4)
+	{
+	case 0: return 0;
+	case 1: return (int)(Bits % 128) - 64;
+	case 2: return (int)(Bits >> (Bits % 32));
+	default: return (int)Bits;
+	}
+}
+
+TEST(SnapshotDelta, FuzzDiffMatchesScalar)
+{
+	CPrng Prng;
+	uint64_t aSeed[2] = {7, 8};
+	Prng.Seed(aSeed);
+
+	for(int Round = 0; Round < 5000; Round++)
+	{
+		const int Size = Prng.RandomBits() % 40;
+		std::vector<int> vPast(Size), vCurrent(Size);
+		for(int i = 0; i < Size; i++)
+		{
+			vPast[i] = RandomItemInt(&Prng);
+			// unchanged items must be detected as such
+			vCurrent[i] = Round % 3 == 0 ? vPast[i] : RandomItemInt(&Prng);
+		}
+
+		std::vector<int> vExpected(Size), vActual(Size);
+		const int ExpectedNeeded = CSnapshotDelta::DiffItemScalar(vPast.data(), vCurrent.data(), vExpected.data(), Size);
+		const int ActualNeeded = CSnapshotDelta::DiffItem(vPast.data(), vCurrent.data(), vActual.data(), Size);
+		ASSERT_EQ(ExpectedNeeded, ActualNeeded);
+		ASSERT_EQ(vExpected, vActual);
+
+		int ExpectedRate = 0, ActualRate = 0;
+		std::vector<int> vExpectedUndiff(Size), vActualUndiff(Size);
+		CSnapshotDelta::UndiffItemScalar(vPast.data(), vActual.data(), vExpectedUndiff.data(), Size, &ExpectedRate);
+		CSnapshotDelta::UndiffItem(vPast.data(), vActual.data(), vActualUndiff.data(), Size, &ActualRate);
+		ASSERT_EQ(ExpectedRate, ActualRate);
+		ASSERT_EQ(vExpectedUndiff, vActualUndiff);
+		ASSERT_EQ(vActualUndiff, vCurrent);
+	}
+}
+
+TEST(SnapshotDelta, DISABLED_BenchmarkDiff)
+{
+	CPrng Prng;
+	uint64_t aSeed[2] = {9, 10};
+	Prng.Seed(aSeed);
+
+	// a character item is 22 ints
+	static const int SIZE = 22;
+	static const int ITERATIONS = 2000000;
+	int aPast[SIZE], aCurrent[SIZE], aDiff[SIZE], aOut[SIZE];
+	for(int i = 0; i < SIZE; i++)
+	{
+		aPast[i] = RandomItemInt(&Prng);
+		aCurrent[i] = i % 2 ? aPast[i] : RandomItemInt(&Prng);
+	}
+
+	int Needed = 0, Rate = 0;
+	int64_t Start = time_get();
+	for(int i = 0; i < ITERATIONS; i++)
+		Needed |= CSnapshotDelta::DiffItemScalar(aPast, aCurrent, aDiff, SIZE);
+	const int64_t DiffScalar = time_get() - Start;
+	Start = time_get();
+	for(int i = 0; i < ITERATIONS; i++)
+		Needed |= CSnapshotDelta::DiffItem(aPast, aCurrent, aDiff, SIZE);
+	const int64_t Diff = time_get() - Start;
+	Start = time_get();
+	for(int i = 0; i < ITERATIONS; i++)
+		CSnapshotDelta::UndiffItemScalar(aPast, aDiff, aOut, SIZE, &Rate);
+	const int64_t UndiffScalar = time_get() - Start;
+	Start = time_get();
+	for(int i = 0; i < ITERATIONS; i++)
+		CSnapshotDelta::UndiffItem(aPast, aDiff, aOut, SIZE, &Rate);
+	const int64_t Undiff = time_get() - Start;
+
+	const double Ms = 1000.0 / time_freq();
+	dbg_msg("benchmark", "diff: scalar %.2fms, vectorized %.2fms", DiffScalar * Ms, Diff * Ms);
+	dbg_msg("benchmark", "undiff: scalar %.2fms, vectorized %.2fms", UndiffScalar * Ms, Undiff * Ms);
+	EXPECT_NE(Needed, 0);
+	EXPECT_EQ(mem_comp(aOut, aCurrent, sizeof(aOut)), 0);
+}
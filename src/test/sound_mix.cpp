@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/client/sound_mix.h>
+#include <game/prng.h>
+
+#include <thread>
+#include <vector>
+
+static std::vector<short> RandomSamples(CPrng *pPrng, int Size)
+{
+	std::vector<short> vSamples(Size);
+	for(auto &Sample : vSamples)
+		Sample = (short)pPrng->RandomBits();
+	return vSamples;
+}
+
+TEST(SoundMix, FuzzMixVoiceMatchesScalar)
+{
+	CPrng Prng;
+	uint64_t aSeed[2] = {11, 12};
+	Prng.Seed(aSeed);
+
+	for(int Round = 0; Round < 5000; Round++)
+	{
+		const int Channels = 1 + Round % 2;
+		const unsigned Frames = Prng.RandomBits() % 40;
+		const int Offset = Prng.RandomBits() % 3; // unaligned input
+		const std::vector<short> vIn = RandomSamples(&Prng, (Frames + Offset) * Channels);
+		// volumes beyond 16 bit take the scalar path
+		const int Lvol = Round % 50 == 0 ? 0x7fff + Round : Prng.RandomBits() % 256;
+		const int Rvol = Round % 7 == 0 ? 0x7fff : Prng.RandomBits() % 256;
+
+		std::vector<int> vExpected(Frames * 2), vActual(Frames * 2);
+		for(unsigned i = 0; i < Frames * 2; i++)
+			vExpected[i] = vActual[i] = (int)(Prng.RandomBits() % 0x1000000) - 0x800000;
+		MixVoiceScalar(vExpected.data(), vIn.data() + Offset * Channels, Channels, Frames, Lvol, Rvol);
+		MixVoice(vActual.data(), vIn.data() + Offset * Channels, Channels, Frames, Lvol, Rvol);
+		ASSERT_EQ(vExpected, vActual) << "channels " << Channels << " frames " << Frames;
+	}
+}
+
+TEST(SoundMix, FuzzClampMatchesScalar)
+{
+	CPrng Prng;
+	uint64_t aSeed[2] = {13, 14};
+	Prng.Seed(aSeed);
+
+	for(int Round = 0; Round < 5000; Round++)
+	{
+		const unsigned Samples = Prng.RandomBits() % 40;
+		const int MasterVol = Prng.RandomBits() % 101;
+		std::vector<int> vIn(Samples);
+		for(auto &Value : vIn)
+		{
+			const unsigned Bits = Prng.RandomBits();
+			Value = Round % 2 ? (int)Bits : (int)(Bits % 0x2000000) - 0x1000000;
+		}
+
+		std::vector<short> vExpected(Samples), vActual(Samples);
+		ClampMixScalar(vExpected.data(), vIn.data(), Samples, MasterVol);
+		ClampMix(vActual.data(), vIn.data(), Samples, MasterVol);
+		ASSERT_EQ(vExpected, vActual) << "samples " << Samples << " volume " << MasterVol;
+
+		// at most one step off the integer formula that was used before
+		for(unsigned i = 0; i < Samples; i++)
+		{
+			if(vIn[i] > 0x7fffff || vIn[i] < -0x7fffff)
+				continue;
+			const int Old = clamp(((vIn[i] * MasterVol) / 101) >> 8, -0x7fff, 0x7fff);
+			ASSERT_LE(absolute(Old - vActual[i]), 1) << vIn[i] << " volume " << MasterVol;
+		}
+	}
+
+	const int aIn[8] = {0x7fffffff, -0x7fffffff, 0x1000000, -0x1000000, 256 * 101, -256 * 101, 0, 1};
+	short aOut[8];
+	ClampMix(aOut, aIn, 8, 100);
+	const short aExpected[8] = {0x7fff, -0x7fff, 0x7fff, -0x7fff, 100, -100, 0, 0};
+	EXPECT_EQ(mem_comp(aOut, aExpected, sizeof(aOut)), 0);
+}
+
+TEST(SoundMix, SpscQueueKeepsOrder)
+{
+	static const int NUM_ITEMS = 200000;
+	CSpscQueue<int, 64> Queue;
+	int Dummy;
+	EXPECT_FALSE(Queue.Pop(&Dummy));
+
+	std::thread Producer([&Queue]() {
+		for(int i = 0; i < NUM_ITEMS; i++)
+		{
+			while(!Queue.Push(i))
+				std::this_thread::yield();
+		}
+	});
+
+	int Expected = 0;
+	while(Expected < NUM_ITEMS)
+	{
+		int Item;
+		if(Queue.Pop(&Item))
+			ASSERT_EQ(Item, Expected++);
+		else
+			std::this_thread::yield();
+	}
+	Producer.join();
+	EXPECT_FALSE(Queue.Pop(&Dummy));
+
+	for(int i = 0; i < 64; i++)
+		EXPECT_TRUE(Queue.Push(i));
+	EXPECT_FALSE(Queue.Push(64));
+}
+
+TEST(SoundMix, DISABLED_Benchmark64Voices)
+{
+	CPrng Prng;
+	uint64_t aSeed[2] = {15, 16};
+	Prng.Seed(aSeed);
+
+	// one second of 64 concurrent voices in callbacks of 512 frames, a quarter of them stereo
+	static const int NUM_VOICES = 64;
+	static const unsigned FRAMES = 512;
+	static const int CALLBACKS = 48000 / FRAMES;
+	static const int ITERATIONS = 20;
+	std::vector<std::vector<short>> vvVoices;
+	for(int v = 0; v < NUM_VOICES; v++)
+		vvVoices.push_back(RandomSamples(&Prng, CALLBACKS * FRAMES * (v % 4 == 0 ? 2 : 1)));
+
+	std::vector<int> vMix(FRAMES * 2);
+	std::vector<short> vOut(FRAMES * 2), vOutScalar(FRAMES * 2);
+	int64_t aTime[2] = {0, 0};
+	for(int Vectorized = 0; Vectorized < 2; Vectorized++)
+	{
+		const int64_t Start = time_get();
+		for(int Iteration = 0; Iteration < ITERATIONS; Iteration++)
+		{
+			for(int Callback = 0; Callback < CALLBACKS; Callback++)
+			{
+				mem_zero(vMix.data(), vMix.size() * sizeof(int));
+				for(int v = 0; v < NUM_VOICES; v++)
+				{
+					const int Channels = v % 4 == 0 ? 2 : 1;
+					const short *pIn = vvVoices[v].data() + Callback * FRAMES * Channels;
+					if(Vectorized)
+						MixVoice(vMix.data(), pIn, Channels, FRAMES, 128 + v, 255 - v);
+					else
+						MixVoiceScalar(vMix.data(), pIn, Channels, FRAMES, 128 + v, 255 - v);
+				}
+				if(Vectorized)
+					ClampMix(vOut.data(), vMix.data(), FRAMES * 2, 100);
+				else
+					ClampMixScalar(vOutScalar.data(), vMix.data(), FRAMES * 2, 100);
+			}
+		}
+		aTime[Vectorized] = time_get() - Start;
+	}
+
+	const double Ms = 1000.0 / time_freq();
+	dbg_msg("benchmark", "%d voices, %d s of audio: scalar %.2fms, vectorized %.2fms", NUM_VOICES, ITERATIONS, aTime[0] * Ms, aTime[1] * Ms);
+	EXPECT_EQ(vOut, vOutScalar);
+}
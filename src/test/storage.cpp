@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <memory>
+
+#include <base/system.h>
+#include <engine/storage.h>
+#include <test/test.h>
+
+static void WriteFile(IStorage *pStorage, const char *pFilename)
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	io_write(File, "data", 4);
+	io_close(File);
+}
+
+static bool Exists(IStorage *pStorage, const char *pFilename)
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL);
+	if(File)
+		io_close(File);
+	return File != 0;
+}
+
+TEST(Storage, IndexFollowsChanges)
+{
+	CTestInfo Info;
+	auto pStorage = std::unique_ptr<IStorage>(Info.CreateTestStorage());
+	ASSERT_TRUE(pStorage);
+	pStorage->SetIndexEnabled(true);
+
+	ASSERT_TRUE(pStorage->CreateFolder("maps", IStorage::TYPE_SAVE));
+	ASSERT_TRUE(pStorage->CreateFolder("maps/sub", IStorage::TYPE_SAVE));
+	EXPECT_FALSE(Exists(pStorage.get(), "maps/sub/a.map"));
+
+	// writes through the storage are seen right away
+	WriteFile(pStorage.get(), "maps/sub/a.map");
+	EXPECT_TRUE(Exists(pStorage.get(), "maps/sub/a.map"));
+	EXPECT_FALSE(Exists(pStorage.get(), "maps/sub/b.map"));
+
+	char aBuf[IO_MAX_PATH_LENGTH];
+	EXPECT_TRUE(pStorage->FindFile("a.map", "maps", IStorage::TYPE_ALL, aBuf, sizeof(aBuf)));
+	EXPECT_STREQ(aBuf, "maps/sub/a.map");
+	EXPECT_FALSE(pStorage->FindFile("b.map", "maps", IStorage::TYPE_ALL, aBuf, sizeof(aBuf)));
+
+	ASSERT_TRUE(pStorage->RenameFile("maps/sub/a.map", "maps/b.map", IStorage::TYPE_SAVE));
+	EXPECT_FALSE(Exists(pStorage.get(), "maps/sub/a.map"));
+	EXPECT_TRUE(Exists(pStorage.get(), "maps/b.map"));
+
+	ASSERT_TRUE(pStorage->RemoveFile("maps/b.map", IStorage::TYPE_SAVE));
+	EXPECT_FALSE(Exists(pStorage.get(), "maps/b.map"));
+
+	// files created around the storage need a refresh
+	char aPath[IO_MAX_PATH_LENGTH];
+	str_format(aPath, sizeof(aPath), "%s/maps/c.map", Info.m_aFilename);
+	IOHANDLE File = io_open(aPath, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	io_close(File);
+	EXPECT_FALSE(Exists(pStorage.get(), "maps/c.map"));
+	pStorage->RefreshIndex();
+	EXPECT_TRUE(Exists(pStorage.get(), "maps/c.map"));
+
+	int Hits, Misses, NumDirs;
+	pStorage->GetIndexStats(&Hits, &Misses, &NumDirs);
+	EXPECT_GT(Hits, 0);
+	EXPECT_GT(Misses, 0);
+	EXPECT_EQ(NumDirs, 1);
+
+	// the test storage cleanup doesn't handle nested folders
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile("maps/c.map", IStorage::TYPE_SAVE);
+		pStorage->GetCompletePath(IStorage::TYPE_SAVE, "maps/sub", aPath, sizeof(aPath));
+		fs_removedir(aPath);
+		pStorage->GetCompletePath(IStorage::TYPE_SAVE, "maps", aPath, sizeof(aPath));
+		fs_removedir(aPath);
+		fs_removedir(Info.m_aFilename);
+	}
+}
+
+TEST(Storage, IndexDisabled)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	auto pStorage = std::unique_ptr<IStorage>(Info.CreateTestStorage());
+	ASSERT_TRUE(pStorage);
+
+	EXPECT_FALSE(Exists(pStorage.get(), "a.cfg"));
+	char aPath[IO_MAX_PATH_LENGTH];
+	str_format(aPath, sizeof(aPath), "%s/a.cfg", Info.m_aFilename);
+	IOHANDLE File = io_open(aPath, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	io_close(File);
+	EXPECT_TRUE(Exists(pStorage.get(), "a.cfg"));
+
+	int Hits, Misses, NumDirs;
+	pStorage->GetIndexStats(&Hits, &Misses, &NumDirs);
+	EXPECT_EQ(Hits + Misses + NumDirs, 0);
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <engine/client/text_atlas_cache.h>
+
+#include <cmath>
+#include <random>
+
+static const unsigned FONT_KEY = 0x1234abcd;
+
+static CAtlasCache MakeCache(int Dimensions)
+{
+	std::mt19937 Rng(Dimensions);
+	CAtlasCache Cache;
+	Cache.m_FontKey = FONT_KEY;
+	Cache.m_Dimensions = Dimensions;
+	for(int i = 0; i < 2; i++)
+	{
+		// mostly empty like a real atlas, so it actually compresses
+		Cache.m_avPixels[i].resize(Dimensions * Dimensions);
+		for(auto &Pixel : Cache.m_avPixels[i])
+			Pixel = Rng() % 8 == 0 ? Rng() % 256 : 0;
+		Cache.m_avSkyline[i].resize(Dimensions);
+		for(auto &Height : Cache.m_avSkyline[i])
+			Height = Rng() % (Dimensions + 1);
+	}
+	for(int i = 0; i < 50; i++)
+	{
+		CAtlasCache::SChar Char = {};
+		Char.m_FontSize = MIN_FONT_SIZE + i % (MAX_FONT_SIZE - MIN_FONT_SIZE + 1);
+		Char.m_Char.m_ID = 'a' + i;
+		Char.m_Char.m_Width = 0.5f + i;
+		Char.m_Char.m_AdvanceX = 0.25f * i;
+		Char.m_Char.m_aUVs[0] = i;
+		Char.m_Char.m_aUVs[1] = 2 * i;
+		Char.m_Char.m_aUVs[2] = i + 10;
+		Char.m_Char.m_aUVs[3] = Dimensions;
+		Char.m_Char.m_GlyphIndex = 1000 + i;
+		Cache.m_vChars.push_back(Char);
+	}
+	return Cache;
+}
+
+static bool RoundTrip(const CAtlasCache &Cache, int MinDimensions = 0)
+{
+	std::vector<unsigned char> vData;
+	if(!Cache.Serialize(&vData))
+		return false;
+	CAtlasCache Loaded;
+	return Loaded.Deserialize(vData.data(), vData.size(), FONT_KEY, MinDimensions);
+}
+
+TEST(TextAtlasCache, RoundTrip)
+{
+	const CAtlasCache Cache = MakeCache(256);
+	std::vector<unsigned char> vData;
+	ASSERT_TRUE(Cache.Serialize(&vData));
+
+	CAtlasCache Loaded;
+	ASSERT_TRUE(Loaded.Deserialize(vData.data(), vData.size(), FONT_KEY, 256));
+	EXPECT_EQ(Loaded.m_FontKey, FONT_KEY);
+	EXPECT_EQ(Loaded.m_Dimensions, 256);
+	for(int i = 0; i < 2; i++)
+	{
+		EXPECT_EQ(Loaded.m_avPixels[i], Cache.m_avPixels[i]);
+		EXPECT_EQ(Loaded.m_avSkyline[i], Cache.m_avSkyline[i]);
+	}
+	ASSERT_EQ(Loaded.m_vChars.size(), Cache.m_vChars.size());
+	for(size_t i = 0; i < Cache.m_vChars.size(); i++)
+	{
+		const CAtlasCache::SChar &Expected = Cache.m_vChars[i];
+		const CAtlasCache::SChar &Actual = Loaded.m_vChars[i];
+		EXPECT_EQ(Actual.m_FontSize, Expected.m_FontSize);
+		EXPECT_EQ(Actual.m_Char.m_ID, Expected.m_Char.m_ID);
+		EXPECT_EQ(Actual.m_Char.m_Width, Expected.m_Char.m_Width);
+		EXPECT_EQ(Actual.m_Char.m_AdvanceX, Expected.m_Char.m_AdvanceX);
+		EXPECT_EQ(Actual.m_Char.m_GlyphIndex, Expected.m_Char.m_GlyphIndex);
+		for(int j = 0; j < 4; j++)
+			EXPECT_EQ(Actual.m_Char.m_aUVs[j], Expected.m_Char.m_aUVs[j]);
+	}
+}
+
+TEST(TextAtlasCache, RejectMismatch)
+{
+	const CAtlasCache Cache = MakeCache(256);
+	std::vector<unsigned char> vData;
+	ASSERT_TRUE(Cache.Serialize(&vData));
+
+	CAtlasCache Loaded;
+	EXPECT_FALSE(Loaded.Deserialize(vData.data(), vData.size(), FONT_KEY + 1, 0));
+	// the atlas in memory is already larger
+	EXPECT_FALSE(Loaded.Deserialize(vData.data(), vData.size(), FONT_KEY, 512));
+	EXPECT_EQ(Loaded.m_Dimensions, 0);
+	EXPECT_TRUE(Loaded.m_vChars.empty());
+}
+
+TEST(TextAtlasCache, RejectTruncatedAndCorrupted)
+{
+	const CAtlasCache Cache = MakeCache(128);
+	std::vector<unsigned char> vData;
+	ASSERT_TRUE(Cache.Serialize(&vData));
+
+	CAtlasCache Loaded;
+	for(size_t Size : {(size_t)0, (size_t)10, vData.size() / 2, vData.size() - 1})
+		EXPECT_FALSE(Loaded.Deserialize(vData.data(), Size, FONT_KEY, 0)) << Size;
+
+	std::vector<unsigned char> vLonger = vData;
+	vLonger.push_back(0);
+	EXPECT_FALSE(Loaded.Deserialize(vLonger.data(), vLonger.size(), FONT_KEY, 0));
+
+	// the magic, and a byte of the compressed pixels
+	for(size_t Offset : {(size_t)0, (size_t)40})
+	{
+		std::vector<unsigned char> vCorrupted = vData;
+		vCorrupted[Offset] ^= 0x5a;
+		EXPECT_FALSE(Loaded.Deserialize(vCorrupted.data(), vCorrupted.size(), FONT_KEY, 0)) << Offset;
+	}
+	EXPECT_TRUE(Loaded.Deserialize(vData.data(), vData.size(), FONT_KEY, 0));
+}
+
+TEST(TextAtlasCache, RejectOutsideOfAtlas)
+{
+	const int Dimensions = 128;
+	ASSERT_TRUE(RoundTrip(MakeCache(Dimensions)));
+
+	for(int Height : {-1, Dimensions + 1})
+	{
+		CAtlasCache Cache = MakeCache(Dimensions);
+		Cache.m_avSkyline[1][Dimensions - 1] = Height;
+		EXPECT_FALSE(RoundTrip(Cache)) << Height;
+	}
+
+	for(int FontSize : {MIN_FONT_SIZE - 1, MAX_FONT_SIZE + 1, -100000})
+	{
+		CAtlasCache Cache = MakeCache(Dimensions);
+		Cache.m_vChars[3].m_FontSize = FontSize;
+		EXPECT_FALSE(RoundTrip(Cache)) << FontSize;
+	}
+
+	for(int i = 0; i < 4; i++)
+	{
+		for(float UV : {-1.0f, Dimensions + 1.0f, NAN})
+		{
+			CAtlasCache Cache = MakeCache(Dimensions);
+			Cache.m_vChars[7].m_Char.m_aUVs[i] = UV;
+			EXPECT_FALSE(RoundTrip(Cache)) << i << " " << UV;
+		}
+	}
+
+	// flipped rectangle
+	CAtlasCache Cache = MakeCache(Dimensions);
+	std::swap(Cache.m_vChars[5].m_Char.m_aUVs[0], Cache.m_vChars[5].m_Char.m_aUVs[2]);
+	EXPECT_FALSE(RoundTrip(Cache));
+}
@@ -1,45 +1,17 @@
 #include <algorithm>
+#include <atomic>
 #include <base/logger.h>
+#include <base/math.h>
 #include <base/system.h>
 #include <cstdint>
 #include <engine/gfx/image_manipulation.h>
 #include <engine/shared/datafile.h>
 #include <engine/storage.h>
 #include <game/mapitems.h>
+#include <string>
+#include <thread>
 #include <vector>
 
-void ClearTransparentPixels(uint8_t *pImg, int Width, int Height)
-{
-	for(int y = 0; y < Height; ++y)
-	{
-		for(int x = 0; x < Width; ++x)
-		{
-			int Index = y * Width * 4 + x * 4;
-			if(pImg[Index + 3] == 0)
-			{
-				pImg[Index + 0] = 0;
-				pImg[Index + 1] = 0;
-				pImg[Index + 2] = 0;
-			}
-		}
-	}
-}
-
-void CopyOpaquePixels(uint8_t *pDestImg, uint8_t *pSrcImg, int Width, int Height)
-{
-	for(int y = 0; y < Height; ++y)
-	{
-		for(int x = 0; x < Width; ++x)
-		{
-			int Index = y * Width * 4 + x * 4;
-			if(pSrcImg[Index + 3] > 0)
-				mem_copy(&pDestImg[Index], &pSrcImg[Index], sizeof(uint8_t) * 4);
-			else
-				mem_zero(&pDestImg[Index], sizeof(uint8_t) * 4);
-		}
-	}
-}
-
 void ClearPixelsTile(uint8_t *pImg, int Width, int Height, int TileIndex)
 {
 	int WTile = Width / 16;
@@ -48,16 +20,7 @@ void ClearPixelsTile(uint8_t *pImg, int Width, int Height, int TileIndex)
 	int yi = (TileIndex / 16) * HTile;
 
 	for(int y = yi; y < yi + HTile; ++y)
-	{
-		for(int x = xi; x < xi + WTile; ++x)
-		{
-			int Index = y * Width * 4 + x * 4;
-			pImg[Index + 0] = 0;
-			pImg[Index + 1] = 0;
-			pImg[Index + 2] = 0;
-			pImg[Index + 3] = 0;
-		}
-	}
+		mem_zero(&pImg[(y * Width + xi) * 4], WTile * 4);
 }
 
 void GetImageSHA256(uint8_t *pImgBuff, int ImgSize, int Width, int Height, char *pSHA256Str)
@@ -73,47 +36,22 @@ void GetImageSHA256(uint8_t *pImgBuff, int ImgSize, int Width, int Height, char
 	free(pNewImgBuff);
 }
 
-int main(int argc, const char **argv)
+static bool OptimizeMap(IStorage *pStorage, const char *pSourceFileName, const char *pDestFileName, int CompressionLevel, int CompressionThreads)
 {
-	CCmdlineFix CmdlineFix(&argc, &argv);
-	log_set_global_logger_default();
-
-	IStorage *pStorage = CreateStorage(IStorage::STORAGETYPE_BASIC, argc, argv);
-	if(!pStorage || argc <= 1 || argc > 3)
-	{
-		dbg_msg("map_optimize", "Invalid parameters or other unknown error.");
-		dbg_msg("map_optimize", "Usage: map_optimize <source map filepath> [<dest map filepath>]");
-		return -1;
-	}
-
-	char aFileName[IO_MAX_PATH_LENGTH];
-	if(argc == 3)
-	{
-		str_format(aFileName, sizeof(aFileName), "out/%s", argv[2]);
-
-		fs_makedir_rec_for(aFileName);
-	}
-	else
-	{
-		fs_makedir("out");
-		char aBuff[IO_MAX_PATH_LENGTH];
-		IStorage::StripPathAndExtension(argv[1], aBuff, sizeof(aBuff));
-		str_format(aFileName, sizeof(aFileName), "out/%s.map", aBuff);
-	}
-
 	CDataFileReader Reader;
-	if(!Reader.Open(pStorage, argv[1], IStorage::TYPE_ABSOLUTE))
+	if(!Reader.Open(pStorage, pSourceFileName, IStorage::TYPE_ABSOLUTE))
 	{
-		dbg_msg("map_optimize", "Failed to open source file.");
-		return -1;
+		dbg_msg("map_optimize", "Failed to open source file '%s'.", pSourceFileName);
+		return false;
 	}
 
 	CDataFileWriter Writer;
-	if(!Writer.Open(pStorage, aFileName, IStorage::TYPE_ABSOLUTE))
+	if(!Writer.Open(pStorage, pDestFileName, IStorage::TYPE_ABSOLUTE))
 	{
-		dbg_msg("map_optimize", "Failed to open target file.");
-		return -1;
+		dbg_msg("map_optimize", "Failed to open target file '%s'.", pDestFileName);
+		return false;
 	}
+	Writer.SetCompressionThreads(CompressionThreads);
 
 	int aImageFlags[64] = {
 		0,
@@ -306,7 +244,7 @@ int main(int argc, const char **argv)
 			}
 		}
 
-		Writer.AddData(Size, pPtr, Z_BEST_COMPRESSION);
+		Writer.AddData(Size, pPtr, CompressionLevel);
 
 		if(DeletePtr)
 			free(pPtr);
@@ -315,5 +253,96 @@ int main(int argc, const char **argv)
 	Reader.Close();
 	Writer.Finish();
 
+	return true;
+}
+
+static int ListMapsCallback(const char *pName, int IsDir, int DirType, void *pUser)
+{
+	if(!IsDir && str_endswith(pName, ".map"))
+		static_cast<std::vector<std::string> *>(pUser)->emplace_back(pName);
 	return 0;
 }
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	IStorage *pStorage = CreateStorage(IStorage::STORAGETYPE_BASIC, argc, argv);
+
+	int CompressionLevel = Z_BEST_COMPRESSION;
+	if(argc >= 3 && str_comp(argv[1], "-l") == 0)
+	{
+		CompressionLevel = clamp(str_toint(argv[2]), 0, 9);
+		argv[2] = argv[0];
+		argc -= 2;
+		argv += 2;
+	}
+
+	if(!pStorage || argc <= 1 || argc > 3)
+	{
+		dbg_msg("map_optimize", "Invalid parameters or other unknown error.");
+		dbg_msg("map_optimize", "Usage: map_optimize [-l <compression level>] <source map filepath> [<dest map filepath>]");
+		dbg_msg("map_optimize", "       map_optimize [-l <compression level>] <source directory> [<dest directory>]");
+		return -1;
+	}
+
+	if(!fs_is_dir(argv[1]))
+	{
+		char aFileName[IO_MAX_PATH_LENGTH];
+		if(argc == 3)
+		{
+			str_format(aFileName, sizeof(aFileName), "out/%s", argv[2]);
+
+			fs_makedir_rec_for(aFileName);
+		}
+		else
+		{
+			fs_makedir("out");
+			char aBuff[IO_MAX_PATH_LENGTH];
+			IStorage::StripPathAndExtension(argv[1], aBuff, sizeof(aBuff));
+			str_format(aFileName, sizeof(aFileName), "out/%s.map", aBuff);
+		}
+
+		return OptimizeMap(pStorage, argv[1], aFileName, CompressionLevel, 0) ? 0 : -1;
+	}
+
+	// directory mode: every map is optimized on its own thread, with the
+	// compression of a single map kept on that thread
+	std::vector<std::string> vMaps;
+	fs_listdir(argv[1], ListMapsCallback, 0, &vMaps);
+	std::sort(vMaps.begin(), vMaps.end());
+
+	char aDestDir[IO_MAX_PATH_LENGTH];
+	if(argc == 3)
+		str_format(aDestDir, sizeof(aDestDir), "out/%s", argv[2]);
+	else
+		str_copy(aDestDir, "out", sizeof(aDestDir));
+	fs_makedir_rec_for(aDestDir);
+	fs_makedir(aDestDir);
+
+	std::atomic<int> Next(0);
+	std::atomic<int> NumFailed(0);
+	auto &&Worker = [&]() {
+		for(int i = Next++; i < (int)vMaps.size(); i = Next++)
+		{
+			char aSource[IO_MAX_PATH_LENGTH];
+			char aDest[IO_MAX_PATH_LENGTH];
+			str_format(aSource, sizeof(aSource), "%s/%s", argv[1], vMaps[i].c_str());
+			str_format(aDest, sizeof(aDest), "%s/%s", aDestDir, vMaps[i].c_str());
+			if(!OptimizeMap(pStorage, aSource, aDest, CompressionLevel, 1))
+				NumFailed++;
+		}
+	};
+
+	const int NumThreads = minimum((int)vMaps.size(), maximum((int)std::thread::hardware_concurrency(), 1));
+	std::vector<std::thread> vThreads;
+	for(int i = 0; i < NumThreads - 1; i++)
+		vThreads.emplace_back(Worker);
+	Worker();
+	for(auto &Thread : vThreads)
+		Thread.join();
+
+	dbg_msg("map_optimize", "optimized %d of %d maps", (int)vMaps.size() - NumFailed.load(), (int)vMaps.size());
+	return NumFailed ? -1 : 0;
+}
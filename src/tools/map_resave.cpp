@@ -1,24 +1,26 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
 #include <base/system.h>
 #include <engine/shared/datafile.h>
 #include <engine/storage.h>
 
-int main(int argc, const char **argv)
-{
-	CCmdlineFix CmdlineFix(&argc, &argv);
-
-	IStorage *pStorage = CreateStorage(IStorage::STORAGETYPE_BASIC, argc, argv);
-	if(!pStorage || argc != 3)
-		return -1;
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
 
+static bool ResaveMap(IStorage *pStorage, const char *pSourceFileName, const char *pDestFileName, int CompressionLevel, int CompressionThreads)
+{
 	CDataFileReader Reader;
-	if(!Reader.Open(pStorage, argv[1], IStorage::TYPE_ABSOLUTE))
-		return -1;
+	if(!Reader.Open(pStorage, pSourceFileName, IStorage::TYPE_ABSOLUTE))
+		return false;
 
 	CDataFileWriter Writer;
-	if(!Writer.Open(pStorage, argv[2]))
-		return -1;
+	if(!Writer.Open(pStorage, pDestFileName, IStorage::TYPE_ABSOLUTE))
+		return false;
+	Writer.SetCompressionThreads(CompressionThreads);
 
 	// add all items
 	for(int Index = 0; Index < Reader.NumItems(); Index++)
@@ -39,10 +41,74 @@ int main(int argc, const char **argv)
 	{
 		void *pPtr = Reader.GetData(Index);
 		int Size = Reader.GetDataSize(Index);
-		Writer.AddData(Size, pPtr);
+		Writer.AddData(Size, pPtr, CompressionLevel);
 	}
 
 	Reader.Close();
 	Writer.Finish();
+	return true;
+}
+
+static int ListMapsCallback(const char *pName, int IsDir, int DirType, void *pUser)
+{
+	if(!IsDir && str_endswith(pName, ".map"))
+		static_cast<std::vector<std::string> *>(pUser)->emplace_back(pName);
 	return 0;
 }
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+
+	IStorage *pStorage = CreateStorage(IStorage::STORAGETYPE_BASIC, argc, argv);
+
+	int CompressionLevel = Z_DEFAULT_COMPRESSION;
+	if(argc >= 3 && str_comp(argv[1], "-l") == 0)
+	{
+		CompressionLevel = clamp(str_toint(argv[2]), 0, 9);
+		argv[2] = argv[0];
+		argc -= 2;
+		argv += 2;
+	}
+
+	if(!pStorage || argc != 3)
+		return -1;
+
+	if(!fs_is_dir(argv[1]))
+		return ResaveMap(pStorage, argv[1], argv[2], CompressionLevel, 0) ? 0 : -1;
+
+	// directory mode: resaves all maps of the source directory into the
+	// destination directory, one map per thread
+	std::vector<std::string> vMaps;
+	fs_listdir(argv[1], ListMapsCallback, 0, &vMaps);
+	std::sort(vMaps.begin(), vMaps.end());
+	fs_makedir_rec_for(argv[2]);
+	fs_makedir(argv[2]);
+
+	std::atomic<int> Next(0);
+	std::atomic<int> NumFailed(0);
+	auto &&Worker = [&]() {
+		for(int i = Next++; i < (int)vMaps.size(); i = Next++)
+		{
+			char aSource[IO_MAX_PATH_LENGTH];
+			char aDest[IO_MAX_PATH_LENGTH];
+			str_format(aSource, sizeof(aSource), "%s/%s", argv[1], vMaps[i].c_str());
+			str_format(aDest, sizeof(aDest), "%s/%s", argv[2], vMaps[i].c_str());
+			if(!ResaveMap(pStorage, aSource, aDest, CompressionLevel, 1))
+			{
+				dbg_msg("map_resave", "failed to resave '%s'", aSource);
+				NumFailed++;
+			}
+		}
+	};
+
+	const int NumThreads = minimum((int)vMaps.size(), maximum((int)std::thread::hardware_concurrency(), 1));
+	std::vector<std::thread> vThreads;
+	for(int i = 0; i < NumThreads - 1; i++)
+		vThreads.emplace_back(Worker);
+	Worker();
+	for(auto &Thread : vThreads)
+		Thread.join();
+
+	return NumFailed ? -1 : 0;
+}